@@ -0,0 +1,174 @@
+#pragma once
+
+#include <ros/serialization.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <tf2/buffer_core.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace rr {
+
+/**
+ * FNV-1a hash over everything a node produced during a replay. Two runs over the same bag with equal digests
+ * produced bit-identical output, which separates "got faster" from "got faster and changed behavior".
+ */
+class OutputDigest {
+  public:
+    void add(const void* data, size_t size);
+
+    template <typename T>
+    void addValue(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "hash the fields of non-trivial types individually");
+        add(&value, sizeof(T));
+    }
+
+    template <typename M>
+    void addMessage(const M& msg) {
+        buffer_.resize(ros::serialization::serializationLength(msg));
+        ros::serialization::OStream stream(buffer_.data(), buffer_.size());
+        ros::serialization::serialize(stream, msg);
+        add(buffer_.data(), buffer_.size());
+    }
+
+    uint64_t value() const {
+        return hash_;
+    }
+
+  private:
+    uint64_t hash_ = 14695981039346656037ULL;
+    std::vector<uint8_t> buffer_;
+};
+
+/**
+ * Command line shared by the replay benchmarks:
+ *   --bag FILE --topic TOPIC [--max_messages N] [--output FILE] [--per_message] [--param name=value ...]
+ * Benchmarks default their parameters to what the node's launch file sets; --param overrides them.
+ */
+struct ReplayOptions {
+    std::string bag;
+    std::string topic;
+    std::string output;        // JSON results file, stdout when empty
+    size_t max_messages = 0;   // zero replays the whole bag
+    bool per_message = false;  // include every message's processing time in the results
+    std::map<std::string, std::string> params;
+
+    // Fills in the options from argv, keeping topic as the default. Prints usage and returns false on bad arguments.
+    bool parse(int argc, char** argv);
+
+    // Overwrites value with the --param of the same name, if one was given, and records the value used
+    template <typename T>
+    void param(const std::string& name, T& value) {
+        auto it = params.find(name);
+        if (it != params.end()) {
+            std::istringstream(it->second) >> std::boolalpha >> value;
+        }
+        std::ostringstream used;
+        used << std::boolalpha << value;
+        params_used[name] = used.str();
+    }
+
+    std::map<std::string, std::string> params_used;
+};
+
+/**
+ * Keeps the measurements for one replay: processing time per message, peak resident memory while processing, and
+ * the output digest. Transforms from the bag's /tf and /tf_static are all loaded before the replay starts, so
+ * lookups at any message's stamp behave the same no matter how the bag interleaved them.
+ */
+class ReplayRecorder {
+  public:
+    ReplayRecorder(std::string name, const ReplayOptions& options);
+
+    // Loads every transform in the bag. Returns false if the bag could not be read.
+    bool loadTransforms();
+
+    void start() {
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void stop() {
+        latencies_ms_.push_back(
+              std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+    size_t messages() const {
+        return latencies_ms_.size();
+    }
+
+    const tf2::BufferCore& tf() const {
+        return *tf_;
+    }
+
+    OutputDigest& digest() {
+        return digest_;
+    }
+
+    // Resets the peak memory counter right before the first message is processed
+    void beginReplay();
+
+    // Writes the results as JSON and a one line summary to stderr. Returns false if nothing was replayed.
+    bool finish();
+
+  private:
+    std::string name_;
+    const ReplayOptions& options_;
+    std::unique_ptr<tf2::BufferCore> tf_;
+    OutputDigest digest_;
+    std::vector<double> latencies_ms_;
+    std::chrono::steady_clock::time_point start_;
+    long baseline_rss_kb_ = 0;
+    bool peak_reset_ = false;
+};
+
+template <typename M>
+using ReplayCallback = std::function<void(const boost::shared_ptr<const M>&, const tf2::BufferCore&)>;
+using DigestCallback = std::function<void(OutputDigest&)>;
+
+/**
+ * Feeds every message of type M on options.topic to process, in bag order and as fast as it will go, then has
+ * digest_output hash what processing produced. Only process is timed; deserialization and hashing are not. Returns
+ * a process exit code.
+ */
+template <typename M>
+int replayBag(const std::string& name, const ReplayOptions& options, const ReplayCallback<M>& process,
+              const DigestCallback& digest_output) {
+    ReplayRecorder recorder(name, options);
+    if (!recorder.loadTransforms()) {
+        return 1;
+    }
+
+    try {
+        rosbag::Bag bag(options.bag, rosbag::bagmode::Read);
+        rosbag::View view(bag, rosbag::TopicQuery(options.topic));
+        recorder.beginReplay();
+        for (const rosbag::MessageInstance& m : view) {
+            auto msg = m.instantiate<M>();
+            if (!msg) {
+                continue;
+            }
+            recorder.start();
+            process(msg, recorder.tf());
+            recorder.stop();
+            digest_output(recorder.digest());
+            if (options.max_messages > 0 && recorder.messages() >= options.max_messages) {
+                break;
+            }
+        }
+    } catch (const rosbag::BagException& e) {
+        std::fprintf(stderr, "could not read %s: %s\n", options.bag.c_str(), e.what());
+        return 1;
+    }
+    return recorder.finish() ? 0 : 1;
+}
+
+}  // namespace rr
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+namespace rr {
+
+/**
+ * An oriented box queried directly on a PointCloud2's x, y and z fields. One pass over the message counts the points
+ * inside and finds their centroid and the nearest of them, with no conversion to a pcl cloud and no intermediate
+ * clouds, so a query costs one read of each point.
+ *
+ * The box's limits are in its own frame, which is placed in the cloud's frame by setPose. Points with NaN coordinates
+ * are never inside.
+ */
+class CloudRegion {
+  public:
+    struct Stats {
+        size_t count = 0;
+
+        // The rest are only set when count > 0, in the cloud's frame unless noted
+        float centroid_x = 0, centroid_y = 0, centroid_z = 0;
+        float nearest_x = 0, nearest_y = 0, nearest_z = 0;  // point inside closest to the box's origin
+        float nearest_distance = 0;
+        float min_x = 0;  // smallest x of the points inside in the box's frame, how far ahead the first one is
+    };
+
+    CloudRegion(float min_x, float max_x, float min_y, float max_y,
+                float min_z = -std::numeric_limits<float>::infinity(),
+                float max_z = std::numeric_limits<float>::infinity());
+
+    // Origin and heading of the box in the cloud's frame, at the origin facing +x until set
+    void setPose(float x, float y, float yaw);
+
+    Stats query(const sensor_msgs::PointCloud2& cloud) const;
+
+    // Corners in the cloud's frame, counterclockwise from (min_x, min_y), for drawing the box
+    std::array<std::pair<float, float>, 4> corners() const;
+
+  private:
+    float min_x_, max_x_, min_y_, max_y_, min_z_, max_z_;
+    float origin_x_ = 0, origin_y_ = 0;
+    float cos_yaw_ = 1, sin_yaw_ = 0;
+};
+
+}  // namespace rr
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rr {
+
+/**
+ * Classifies bgr8 pixels by color with a lookup table indexed by the top bits of each channel. Each label is a range in
+ * HSV, HLS or BGR (OpenCV's 8 bit scaling, so hue is 0 to 180) compiled into the table once, so classifying a frame is
+ * one pass of table reads with no color conversion, and that one pass answers every label at once.
+ *
+ * Each table entry is decided by the center of its cell. At 6 bits per channel the table is 256 kB and a range edge
+ * moves by at most 2 levels of B, G or R; 5 bits gives a 32 kB table that stays in L1 at 4 levels.
+ */
+class ColorClassifier {
+  public:
+    enum ColorSpace { BGR, HSV, HLS };
+
+    static constexpr int max_labels = 8;
+
+    explicit ColorClassifier(int bits = 6);
+
+    /**
+     * Sets label, from 0 to max_labels - 1, to the colors within [lower, upper] in space, and rebuilds the table.
+     * Rebuilding takes a few milliseconds; frames classified meanwhile, from other threads, use the old table.
+     */
+    void setRange(int label, ColorSpace space, const cv::Scalar& lower, const cv::Scalar& upper);
+
+    // Label matches nothing until set again
+    void clearRange(int label);
+
+    /**
+     * @param bgr bgr8 image
+     * @param labels filled with a CV_8UC1 image the size of bgr, bit i of each pixel set when it has label i
+     */
+    void classify(const cv::Mat& bgr, cv::Mat& labels) const;
+
+    // Fills out with a mono8 mask, 255 where the pixels of labels have label. out may be a region of a larger image.
+    static void mask(const cv::Mat& labels, int label, cv::Mat& out);
+
+  private:
+    struct Range {
+        bool enabled = false;
+        ColorSpace space = BGR;
+        cv::Scalar lower;
+        cv::Scalar upper;
+    };
+
+    void rebuild();
+
+    const int bits_;
+
+    std::mutex mutex_;  // serializes changes to the ranges
+    std::array<Range, max_labels> ranges_;
+
+    // Swapped whole with std::atomic_load/atomic_store so classify never waits for a rebuild
+    std::shared_ptr<const std::vector<uint8_t>> table_;
+};
+
+}  // namespace rr
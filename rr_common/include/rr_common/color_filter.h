@@ -2,6 +2,7 @@
 
 #include <dynamic_reconfigure/server.h>
 #include <ros/ros.h>
+#include <rr_common/color_classifier.h>
 #include <rr_msgs/ColorFilterConfig.h>
 
 #include <opencv2/core/mat.hpp>
@@ -38,6 +39,9 @@ class ColorFilter {
     cv::Rect roi_;
     bool return_roi_only_;
 
+    // HSV and HLS ranges, compiled from lower_ and upper_ on reconfigure
+    ColorClassifier classifier_;
+
     bool configured_;
     std::unique_ptr<dynamic_reconfigure::Server<rr_msgs::ColorFilterConfig>> dsrv_;
     ros::Publisher debug_pub_;
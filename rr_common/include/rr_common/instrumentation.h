@@ -0,0 +1,169 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <std_msgs/Header.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace rr {
+
+/**
+ * Latency histogram with buckets that grow with the value, as in HdrHistogram: every power of two from 1 us to about
+ * a minute is split into 32 linear buckets, so any percentile is within about 3% of the true value while the whole
+ * histogram stays a fixed 6 kB. Larger values count in the last bucket, and the exact maximum is kept separately.
+ */
+class LatencyHistogram {
+  public:
+    void record(std::chrono::nanoseconds value);
+
+    uint64_t count() const {
+        return count_;
+    }
+
+    // In seconds, zero when empty
+    double percentile(double p) const;
+    double mean() const;
+    double max() const;
+
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+  private:
+    static constexpr int sub_bucket_bits = 5;
+    static constexpr int max_exponent = 26;  // 2^26 us is 67 s
+    static constexpr size_t bucket_count = (max_exponent - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<uint64_t, bucket_count> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t total_us_ = 0;
+    uint64_t max_us_ = 0;
+};
+
+/**
+ * A node's performance numbers, aggregated in-process and published as one diagnostic_msgs/DiagnosticStatus on
+ * /diagnostics once a period, covering only that period. Keys are "<kind>:<name>:<field>":
+ *   stage:<name>:{count,p50_ms,p99_ms,max_ms,deadline_ms}  time spent in a stage, e.g. one planning cycle
+ *   input:<topic>:{rate_hz,age_p50_ms,age_max_ms,dropped}  messages received, age of their stamp on arrival, and
+ *                                                          gaps in header.seq, i.e. messages the queue overwrote
+ *   output:<topic>:rate_hz                                 messages published
+ *   counter:<name>:count                                   anything else worth counting
+ * The status is a warning while a stage's p99 is over its deadline.
+ *
+ * Handles returned by stage(), input(), output() and counter() stay valid for the life of the NodeMetrics, are safe
+ * to use from any thread, and should be looked up once rather than per message.
+ */
+class NodeMetrics {
+  public:
+    class Stage {
+      public:
+        void record(std::chrono::nanoseconds duration);
+
+        // Cycle time the stage has to stay under, zero for none
+        void setDeadline(double seconds) {
+            deadline_ = seconds;
+        }
+
+      private:
+        friend class NodeMetrics;
+        std::mutex mutex_;
+        LatencyHistogram histogram_;
+        std::atomic<double> deadline_{ 0 };
+    };
+
+    class Input {
+      public:
+        // Counts a message and its age, and any messages missing before it going by header.seq
+        void received(const std_msgs::Header& header);
+
+        // For inputs without a header, or a stamp that is not the message's own
+        void received(const ros::Time& stamp);
+
+        // Messages the node discarded itself, e.g. because it was busy
+        void dropped(uint64_t count = 1) {
+            dropped_ += count;
+        }
+
+      private:
+        friend class NodeMetrics;
+        std::mutex mutex_;
+        LatencyHistogram age_;
+        uint64_t count_ = 0;
+        uint32_t last_seq_ = 0;
+        bool has_seq_ = false;  // a message had a seq, kept across windows unlike count_
+        std::atomic<uint64_t> dropped_{ 0 };
+    };
+
+    class Output {
+      public:
+        void published() {
+            count_++;
+        }
+
+      private:
+        friend class NodeMetrics;
+        std::atomic<uint64_t> count_{ 0 };
+    };
+
+    class Counter {
+      public:
+        void add(uint64_t count = 1) {
+            count_ += count;
+        }
+
+      private:
+        friend class NodeMetrics;
+        std::atomic<uint64_t> count_{ 0 };
+    };
+
+    // Publishes through nh every period seconds, as long as the node spins. Nodelets should pass their own name.
+    explicit NodeMetrics(ros::NodeHandle nh, const std::string& name = ros::this_node::getName(), double period = 1.0);
+
+    Stage& stage(const std::string& name);
+    Input& input(const std::string& topic);
+    Output& output(const std::string& topic);
+    Counter& counter(const std::string& name);
+
+  private:
+    std::string node_name_;
+    ros::Publisher diagnostics_pub_;
+    ros::WallTimer timer_;
+    ros::WallTime window_start_;
+
+    // guards the maps, not their contents
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Stage>> stages_;
+    std::map<std::string, std::unique_ptr<Input>> inputs_;
+    std::map<std::string, std::unique_ptr<Output>> outputs_;
+    std::map<std::string, std::unique_ptr<Counter>> counters_;
+
+    void publish();
+};
+
+// Records the time from its construction to its destruction in a stage
+class StageTimer {
+  public:
+    explicit StageTimer(NodeMetrics::Stage& stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer() {
+        stage_.record(std::chrono::steady_clock::now() - start_);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+  private:
+    NodeMetrics::Stage& stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace rr
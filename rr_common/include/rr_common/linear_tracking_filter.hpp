@@ -26,6 +26,15 @@ class LinearTrackingFilter {
         last_update_ = 0;
     }
 
+    LinearTrackingFilter(double init_val, double val_min, double val_max, double rate_min, double rate_max)
+          : val_(init_val)
+          , target_(init_val)
+          , val_min_(val_min)
+          , val_max_(val_max)
+          , rate_min_(rate_min)
+          , rate_max_(rate_max)
+          , last_update_(0) {}
+
     LinearTrackingFilter(const LinearTrackingFilter& t) = default;
 
     inline double GetValue() const {
@@ -21,6 +21,8 @@ class AnnealingOptimizer : public PlanningOptimizer<ctrl_dim> {
 
     explicit AnnealingOptimizer(const ros::NodeHandle& nh);
 
+    explicit AnnealingOptimizer(const Params& params);
+
     ~AnnealingOptimizer() = default;
 
     Controls<ctrl_dim> Optimize(const CostFunction<ctrl_dim>& cost_fn, const Controls<ctrl_dim>& init_controls,
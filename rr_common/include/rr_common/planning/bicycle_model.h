@@ -23,6 +23,15 @@ class BicycleModel {
     explicit BicycleModel(const ros::NodeHandle& nh, const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
                           const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
 
+    /**
+     * Constructor without the parameter server, for offline tools
+     * @param segment_size Number of path points rolled out per control point
+     * @param dt Time between consecutive path points
+     */
+    BicycleModel(double wheel_base, double max_lateral_accel, int segment_size, double dt,
+                 const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                 const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr);
+
     /**
      * roll out a trajectory through the world
      * @param control Control vector, interpretation depends on planning scenario
@@ -32,6 +41,14 @@ class BicycleModel {
 
     void RollOutPath(const Controls<2>& controls, TrajectoryRollout& rollout) const;
 
+    /**
+     * Calculate one timestep of "simulated" vehicle motion, holding the speed and
+     * steering of prev for dt. Bicycle-model forward kinematics happens here.
+     * @param prev Initial pose, speed and steering angle for the step
+     * @param next Out param for the resulting pose
+     */
+    void StepKinematics(const PathPoint& prev, Pose& next) const;
+
   private:
     /**
      * Calculate a desired speed from a steering angle based on
@@ -42,15 +59,6 @@ class BicycleModel {
      */
     [[nodiscard]] double SteeringToSpeed(double steer_angle) const;
 
-    /**
-     * Calculate one distance-step (not timestep) of "simulated" vehicle motion.
-     * Bicycle-model forward kinematics happens here.
-     * @param last_pose Initial (x,y,theta) for the distance step
-     * @param steer_angle Constant steering angle for the distance step
-     * @param pose Out param for the resulting pose
-     */
-    void StepKinematics(const PathPoint& prev, Pose& next) const;
-
     double wheel_base_;
     double max_lateral_accel_;
     int segment_size_;
@@ -19,11 +19,25 @@ class DistanceMap : public MapCostInterface {
   public:
     explicit DistanceMap(ros::NodeHandle nh);
 
+    /**
+     * Constructor without the parameter server, a map subscription or tf, for offline tools. Maps are given with
+     * SetMap and nothing is published.
+     */
+    DistanceMap(const Rectangle& hitbox, double cost_scaling_factor, double lethal_wall_inflation,
+                double nonlethal_wall_inflation);
+
     double DistanceCost(const Pose& pose) override;
 
+    /**
+     * Replace the map and rebuild the distance costs
+     * @param map_from_base Pose of the robot in the map's frame
+     */
+    void SetMap(const nav_msgs::OccupancyGridConstPtr& map_msg, const tf::Transform& map_from_base);
+
   private:
     std::pair<unsigned int, unsigned int> PoseToGridPosition(const rr::Pose& pose);
     void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
+    void BuildCostMap(const nav_msgs::OccupancyGrid& map_msg);
 
     ros::Subscriber map_sub;
     std::string robot_base_frame;
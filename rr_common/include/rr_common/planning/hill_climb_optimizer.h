@@ -11,8 +11,17 @@ namespace rr {
 template <int ctrl_dim>
 class HillClimbOptimizer : public PlanningOptimizer<ctrl_dim> {
   public:
+    struct Params {
+        int num_workers;
+        int num_restarts;
+        int local_optimum_tries;
+        Vector<ctrl_dim> neighbor_stddev;
+    };
+
     explicit HillClimbOptimizer(const ros::NodeHandle& nh);
 
+    explicit HillClimbOptimizer(const Params& params);
+
     Controls<ctrl_dim> Optimize(const CostFunction<ctrl_dim>& cost_fn, const Controls<ctrl_dim>& init_controls,
                                 const Matrix<ctrl_dim, 2>& ctrl_limits) override;
 
@@ -16,8 +16,20 @@ class InflationMap : public MapCostInterface {
   public:
     explicit InflationMap(ros::NodeHandle nh);
 
+    /**
+     * Constructor without the parameter server, a map subscription or tf, for offline tools. Maps are given with
+     * SetMap.
+     */
+    InflationMap(const Rectangle& hitbox, int lethal_threshold);
+
     double DistanceCost(const Pose& pose) override;
 
+    /**
+     * Replace the map
+     * @param map_from_base Pose of the robot in the map's frame
+     */
+    void SetMap(const nav_msgs::OccupancyGridConstPtr& map_msg, const tf::Transform& map_from_base);
+
   private:
     void SetMapMessage(const nav_msgs::OccupancyGridConstPtr& map_msg);
 
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <ros/time.h>
+
 #include "planner_types.hpp"
 
 namespace rr {
@@ -54,9 +56,15 @@ class MapCostInterface {
         accepting_updates_ = false;
     }
 
+    // Stamp of the sensor data the stored map was built from, zero if it did not come from a message
+    ros::Time GetMapStamp() const {
+        return map_stamp_;
+    }
+
   protected:
     bool updated_;            // set true when stored map data is updated
     bool accepting_updates_;  // only modify stored map data when this is true
+    ros::Time map_stamp_;
 };
 
 }  // namespace rr
@@ -31,15 +31,33 @@ class NearestPointCache : public MapCostInterface {
      */
     explicit NearestPointCache(ros::NodeHandle nh);
 
+    /**
+     * Constructor without the parameter server or a map subscription, for offline tools. Maps are given with SetMap.
+     */
+    NearestPointCache(const rr::Rectangle& map_limits, const rr::Rectangle& hitbox, double cache_resolution,
+                      double distance_decay_factor);
+
     double DistanceCost(const Pose& pose) override;
 
+    /**
+     * Replace the map with the given obstacle points, in the robot frame
+     */
+    void SetMap(const pcl::PointCloud<point_t>& cloud);
+
   private:
     /**
-     * Given a map, cache the nearest neighbors. Fill the cache outwards from locations containing obstacle points.
-     * @param map Point cloud map representation
+     * Allocate the cache once the limits and resolution are known
      */
+    void InitCache();
+
     void SetMapMessage(const sensor_msgs::PointCloud2ConstPtr& cloud);
 
+    /**
+     * Given a map in points_storage_, cache the nearest neighbors. Fill the cache outwards from locations containing
+     * obstacle points.
+     */
+    void BuildCache();
+
     /*
      * Caching system: map from discretized x, y location to its nearest neighbor in the map/obstacle point cloud
      */
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "planner_types.hpp"
+
+namespace rr {
+
+struct PathCostWeights {
+    double k_map_cost;
+    double k_speed;
+    double k_steering;
+    double k_angle;
+    double collision_penalty;
+};
+
+/**
+ * Cost of a rolled out path, shared by the planner node and offline tools so both score paths the same way. Later
+ * points are weighted slightly more, and a collision ends the path with a penalty for every point left.
+ * @param map_costs Per-point costs from a MapCostInterface, negative where the path collides
+ * @param max_speed Speed the path is rewarded for approaching
+ * @param extra_cost Cost terms that apply to the whole path, such as global path following
+ */
+inline double PathCost(const std::vector<PathPoint>& path, const std::vector<double>& map_costs,
+                       const PathCostWeights& weights, double max_speed, double extra_cost = 0) {
+    double cost = 0;
+    double inflator = 1;
+    double gamma = 1.01;
+    for (size_t i = 0; i < path.size(); ++i) {
+        cost *= gamma;
+        inflator *= gamma;
+        if (map_costs[i] >= 0) {
+            cost += weights.k_map_cost * map_costs[i];
+            cost += weights.k_speed * std::pow(max_speed - path[i].speed, 2);
+            cost += weights.k_steering * std::abs(path[i].steer);
+            cost += weights.k_angle * std::abs(path[i].pose.theta);
+        } else {
+            cost += weights.collision_penalty * (path.size() - i);
+            break;
+        }
+    }
+    cost += extra_cost;
+    return cost / inflator;
+}
+
+}  // namespace rr
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <eigen3/Eigen/Core>
+#include <limits>
+#include <vector>
+
+namespace rr {
+
+/*
+ * Comparison of a plan against a closed global path, without tf so that offline tools score plans the same way
+ * GlobalPath does. Points are (x, y) in the global path's frame.
+ */
+
+// Distance along path to each of its points, starting at 0
+inline std::vector<double> CumulativeDistances(const std::vector<Eigen::Vector2d>& path) {
+    std::vector<double> distances(path.empty() ? 0 : 1, 0.0);
+    for (size_t i = 1; i < path.size(); ++i) {
+        distances.push_back(distances.back() + (path[i] - path[i - 1]).norm());
+    }
+    return distances;
+}
+
+inline size_t ClosestPointIndex(const std::vector<Eigen::Vector2d>& path, const Eigen::Vector2d& point) {
+    auto closest = std::min_element(path.begin(), path.end(), [&](const Eigen::Vector2d& a, const Eigen::Vector2d& b) {
+        return (a - point).squaredNorm() < (b - point).squaredNorm();
+    });
+    return closest - path.begin();
+}
+
+/**
+ * The stretch of a closed path that starts at one of its points and is about as long as given, wrapping around the
+ * end of the path. Assumes length is shorter than the whole path.
+ * @param cum_dist CumulativeDistances of path
+ */
+inline std::vector<Eigen::Vector2d> PathSegment(const std::vector<Eigen::Vector2d>& path,
+                                                const std::vector<double>& cum_dist, size_t start, double length) {
+    double end_dist = std::fmod(cum_dist[start] + length, cum_dist.back());
+    size_t end = std::upper_bound(cum_dist.begin(), cum_dist.end(), end_dist) - cum_dist.begin();
+
+    std::vector<Eigen::Vector2d> segment;
+    if (start <= end) {
+        segment.assign(path.begin() + start, path.begin() + end);
+    } else {
+        segment.assign(path.begin() + start, path.end());
+        segment.insert(segment.end(), path.begin(), path.begin() + end);
+    }
+    return segment;
+}
+
+// follows the pseudocode found in https://en.wikipedia.org/wiki/Dynamic_time_warping
+inline double DtwDistance(const std::vector<Eigen::Vector2d>& path1, const std::vector<Eigen::Vector2d>& path2,
+                          int w) {
+    int n = path1.size();
+    int m = path2.size();
+
+    std::vector<std::vector<double>> dtw(n + 1, std::vector<double>(m + 1, std::numeric_limits<double>::infinity()));
+    w = std::max(w, std::abs(n - m));  // adapt window size
+    dtw[0][0] = 0;
+
+    for (int i = 1; i < n + 1; i++) {
+        for (int j = std::max(1, i - w); j < std::min(m, i + w) + 1; j++) {
+            double cost = (path1[i - 1] - path2[j - 1]).norm();
+            dtw[i][j] = cost + std::min({ dtw[i - 1][j], dtw[i][j - 1], dtw[i - 1][j - 1] });
+        }
+    }
+
+    return dtw[n][m];
+}
+
+/**
+ * DTW distance between a plan and the stretch of global path of the same length, starting at the global path point
+ * closest to the start of the plan
+ * @param start ClosestPointIndex of the plan's first point, which only depends on where the robot is
+ * @param dtw_window_factor Fraction of the longer sequence that points may be matched across
+ */
+inline double GlobalPathDeviation(const std::vector<Eigen::Vector2d>& global_path,
+                                  const std::vector<double>& global_cum_dist, size_t start,
+                                  const std::vector<Eigen::Vector2d>& plan, double dtw_window_factor) {
+    std::vector<double> plan_cum_dist = CumulativeDistances(plan);
+    double plan_length = plan_cum_dist.empty() ? 0.0 : plan_cum_dist.back();
+    std::vector<Eigen::Vector2d> segment = PathSegment(global_path, global_cum_dist, start, plan_length);
+
+    int window = (int)(dtw_window_factor * std::max(segment.size(), plan.size()));
+    return DtwDistance(segment, plan, window);
+}
+
+}  // namespace rr
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ros/time.h>
+
+#include <cstdint>
+#include <string>
+
+namespace rr {
+
+/**
+ * Stage tracing for following one sensor sample through the pipeline to the actuators.
+ *
+ * Messages derived from a sensor sample keep its header stamp (the origin), so every stage can tell how old the
+ * data it is working on is. A TraceSpan covers one stage's work on one sample. Spans are buffered per thread without
+ * locks and a background thread writes them out in the Chrome trace JSON format, which chrome://tracing and
+ * https://ui.perfetto.dev open directly. Spans sharing an origin are linked by flow arrows in Perfetto, and each one
+ * records how old its origin was when the stage started.
+ *
+ * Tracing is off unless startTracing() is given a file or RR_TRACE_DIR is set, in which case each node writes
+ * $RR_TRACE_DIR/<node name>.<pid>.json. util/merge_traces.py combines the files of one run into a single trace.
+ */
+
+// Starts tracing if RR_TRACE_DIR is set. node_name is usually ros::this_node::getName().
+void startTracing(const std::string& node_name);
+
+// Starts tracing to output_path, overwriting it
+void startTracing(const std::string& node_name, const std::string& output_path);
+
+// Writes out the remaining spans and closes the trace. Also done at exit.
+void stopTracing();
+
+bool tracingEnabled();
+
+/**
+ * Records the time from its construction to its destruction as one stage, with origin being the stamp of the sensor
+ * sample being processed. A zero origin records the span without linking it to others. name must outlive the
+ * process, i.e. be a string literal.
+ */
+class TraceSpan {
+  public:
+    TraceSpan(const char* name, const ros::Time& origin);
+
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // For stages that only learn which sample they are working on partway through
+    void setOrigin(const ros::Time& origin);
+
+  private:
+    const char* name_;
+    int64_t start_ns_;      // wall clock, negative when tracing is off
+    int64_t ros_start_ns_;  // ROS clock, which origins are on
+    int64_t origin_ns_;
+};
+
+}  // namespace rr
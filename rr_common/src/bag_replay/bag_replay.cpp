@@ -0,0 +1,204 @@
+#include <geometry_msgs/TransformStamped.h>
+#include <tf2_msgs/TFMessage.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <rr_common/bag_replay.h>
+
+namespace rr {
+
+namespace {
+
+// Reads a "Vm..." line of /proc/self/status in kB, or 0 where procfs is not available
+long procStatusKb(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    const size_t length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0 && line.size() > length && line[length] == ':') {
+            return std::atol(line.c_str() + length + 1);
+        }
+    }
+    return 0;
+}
+
+// Writing 5 to clear_refs resets VmHWM to the current RSS (Linux 4.0 and later)
+bool resetPeakRss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.close();
+    return !clear_refs.fail();
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s --bag FILE [--topic TOPIC] [--max_messages N] [--output FILE] [--per_message]\n"
+                 "          [--param name=value ...]\n",
+                 program);
+}
+
+}  // namespace
+
+void OutputDigest::add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+    }
+}
+
+bool ReplayOptions::parse(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--bag" && has_value) {
+            bag = argv[++i];
+        } else if (arg == "--topic" && has_value) {
+            topic = argv[++i];
+        } else if (arg == "--max_messages" && has_value) {
+            max_messages = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--output" && has_value) {
+            output = argv[++i];
+        } else if (arg == "--per_message") {
+            per_message = true;
+        } else if (arg == "--param" && has_value) {
+            std::string assignment = argv[++i];
+            size_t equals = assignment.find('=');
+            if (equals == std::string::npos) {
+                usage(argv[0]);
+                return false;
+            }
+            params[assignment.substr(0, equals)] = assignment.substr(equals + 1);
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (bag.empty() || topic.empty()) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+ReplayRecorder::ReplayRecorder(std::string name, const ReplayOptions& options)
+      : name_(std::move(name)), options_(options) {
+    // Nodes log with throttling macros, which need ros::Time even though no master is involved
+    ros::Time::init();
+}
+
+bool ReplayRecorder::loadTransforms() {
+    try {
+        rosbag::Bag bag(options_.bag, rosbag::bagmode::Read);
+
+        // Keep every transform in the bag, so nothing ages out of the cache before the replay asks for it
+        rosbag::View whole_bag(bag);
+        tf_ = std::make_unique<tf2::BufferCore>(whole_bag.getEndTime() - whole_bag.getBeginTime() + ros::Duration(1));
+
+        rosbag::View view(bag, rosbag::TopicQuery(std::vector<std::string>{ "/tf", "/tf_static" }));
+        for (const rosbag::MessageInstance& m : view) {
+            auto tf_msg = m.instantiate<tf2_msgs::TFMessage>();
+            if (!tf_msg) {
+                continue;
+            }
+            const bool is_static = m.getTopic() == "/tf_static";
+            for (const geometry_msgs::TransformStamped& transform : tf_msg->transforms) {
+                tf_->setTransform(transform, "bag", is_static);
+            }
+        }
+    } catch (const rosbag::BagException& e) {
+        std::fprintf(stderr, "could not read %s: %s\n", options_.bag.c_str(), e.what());
+        return false;
+    }
+    return true;
+}
+
+void ReplayRecorder::beginReplay() {
+    peak_reset_ = resetPeakRss();
+    baseline_rss_kb_ = procStatusKb("VmRSS");
+    latencies_ms_.clear();
+}
+
+bool ReplayRecorder::finish() {
+    const long peak_rss_kb = procStatusKb("VmHWM");
+    if (latencies_ms_.empty()) {
+        std::fprintf(stderr, "%s: no messages on %s in %s\n", name_.c_str(), options_.topic.c_str(),
+                     options_.bag.c_str());
+        return false;
+    }
+
+    std::vector<double> sorted = latencies_ms_;
+    std::sort(sorted.begin(), sorted.end());
+    const double total_ms = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    char digest[17];
+    std::snprintf(digest, sizeof(digest), "%016" PRIx64, digest_.value());
+
+    std::ofstream file;
+    if (!options_.output.empty()) {
+        file.open(options_.output);
+    }
+    std::ostream& out = options_.output.empty() ? std::cout : file;
+    out.precision(6);
+    out << "{\n";
+    out << "  \"benchmark\": " << jsonString(name_) << ",\n";
+    out << "  \"bag\": " << jsonString(options_.bag) << ",\n";
+    out << "  \"topic\": " << jsonString(options_.topic) << ",\n";
+    out << "  \"messages\": " << sorted.size() << ",\n";
+    out << "  \"total_ms\": " << total_ms << ",\n";
+    out << "  \"mean_ms\": " << total_ms / sorted.size() << ",\n";
+    out << "  \"p50_ms\": " << percentile(sorted, 0.5) << ",\n";
+    out << "  \"p90_ms\": " << percentile(sorted, 0.9) << ",\n";
+    out << "  \"p99_ms\": " << percentile(sorted, 0.99) << ",\n";
+    out << "  \"max_ms\": " << sorted.back() << ",\n";
+    out << "  \"baseline_rss_kb\": " << baseline_rss_kb_ << ",\n";
+    out << "  \"peak_rss_kb\": " << peak_rss_kb << ",\n";
+    out << "  \"peak_rss_is_replay_only\": " << (peak_reset_ ? "true" : "false") << ",\n";
+    out << "  \"output_digest\": \"" << digest << "\",\n";
+    out << "  \"params\": {";
+    for (auto it = options_.params_used.begin(); it != options_.params_used.end(); ++it) {
+        out << (it == options_.params_used.begin() ? "" : ",") << "\n    " << jsonString(it->first) << ": "
+            << jsonString(it->second);
+    }
+    out << "\n  }";
+    if (options_.per_message) {
+        out << ",\n  \"per_message_ms\": [";
+        for (size_t i = 0; i < latencies_ms_.size(); i++) {
+            out << (i == 0 ? "" : ", ") << latencies_ms_[i];
+        }
+        out << "]";
+    }
+    out << "\n}\n";
+
+    std::fprintf(stderr, "%s: %zu messages, p50 %.3f ms, p99 %.3f ms, peak rss %ld kB, digest %s\n", name_.c_str(),
+                 sorted.size(), percentile(sorted, 0.5), percentile(sorted, 0.99), peak_rss_kb, digest);
+    return true;
+}
+
+}  // namespace rr
@@ -0,0 +1,84 @@
+#include <ros/assert.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <rr_common/cloud_region.h>
+
+namespace rr {
+
+CloudRegion::CloudRegion(float min_x, float max_x, float min_y, float max_y, float min_z, float max_z)
+      : min_x_(min_x), max_x_(max_x), min_y_(min_y), max_y_(max_y), min_z_(min_z), max_z_(max_z) {
+    ROS_ASSERT(min_x <= max_x && min_y <= max_y && min_z <= max_z);
+}
+
+void CloudRegion::setPose(float x, float y, float yaw) {
+    origin_x_ = x;
+    origin_y_ = y;
+    cos_yaw_ = std::cos(yaw);
+    sin_yaw_ = std::sin(yaw);
+}
+
+CloudRegion::Stats CloudRegion::query(const sensor_msgs::PointCloud2& cloud) const {
+    Stats stats;
+    const size_t size = static_cast<size_t>(cloud.width) * cloud.height;
+    if (size == 0) {
+        return stats;
+    }
+
+    // Sums in double, since a float sum of a full scan loses the centroid's low bits
+    double sum_x = 0, sum_y = 0, sum_z = 0;
+    float nearest_squared = std::numeric_limits<float>::infinity();
+    stats.min_x = std::numeric_limits<float>::infinity();
+
+    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud, "x");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud, "y");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud, "z");
+    for (size_t i = 0; i < size; i++, ++iter_x, ++iter_y, ++iter_z) {
+        const float x = *iter_x;
+        const float y = *iter_y;
+        const float z = *iter_z;
+
+        // Into the box's frame; every comparison with NaN is false, so NaN points fall out here
+        const float dx = x - origin_x_;
+        const float dy = y - origin_y_;
+        const float local_x = dx * cos_yaw_ + dy * sin_yaw_;
+        const float local_y = -dx * sin_yaw_ + dy * cos_yaw_;
+        if (!(local_x >= min_x_ && local_x <= max_x_ && local_y >= min_y_ && local_y <= max_y_ && z >= min_z_ &&
+              z <= max_z_)) {
+            continue;
+        }
+
+        stats.count++;
+        sum_x += x;
+        sum_y += y;
+        sum_z += z;
+        stats.min_x = std::min(stats.min_x, local_x);
+        const float distance_squared = dx * dx + dy * dy + z * z;
+        if (distance_squared < nearest_squared) {
+            nearest_squared = distance_squared;
+            stats.nearest_x = x;
+            stats.nearest_y = y;
+            stats.nearest_z = z;
+        }
+    }
+
+    if (stats.count == 0) {
+        stats.min_x = 0;
+        return stats;
+    }
+    stats.centroid_x = static_cast<float>(sum_x / stats.count);
+    stats.centroid_y = static_cast<float>(sum_y / stats.count);
+    stats.centroid_z = static_cast<float>(sum_z / stats.count);
+    stats.nearest_distance = std::sqrt(nearest_squared);
+    return stats;
+}
+
+std::array<std::pair<float, float>, 4> CloudRegion::corners() const {
+    auto toCloud = [this](float x, float y) {
+        return std::make_pair(origin_x_ + x * cos_yaw_ - y * sin_yaw_, origin_y_ + x * sin_yaw_ + y * cos_yaw_);
+    };
+    return { toCloud(min_x_, min_y_), toCloud(max_x_, min_y_), toCloud(max_x_, max_y_), toCloud(min_x_, max_y_) };
+}
+
+}  // namespace rr
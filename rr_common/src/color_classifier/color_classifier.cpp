@@ -0,0 +1,102 @@
+#include <ros/assert.h>
+
+#include <opencv2/imgproc.hpp>
+#include <rr_common/color_classifier.h>
+
+namespace rr {
+
+ColorClassifier::ColorClassifier(int bits) : bits_(bits) {
+    ROS_ASSERT(bits >= 4 && bits <= 8);
+    rebuild();
+}
+
+void ColorClassifier::setRange(int label, ColorSpace space, const cv::Scalar& lower, const cv::Scalar& upper) {
+    ROS_ASSERT(label >= 0 && label < max_labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ranges_[label].enabled = true;
+    ranges_[label].space = space;
+    ranges_[label].lower = lower;
+    ranges_[label].upper = upper;
+    rebuild();
+}
+
+void ColorClassifier::clearRange(int label) {
+    ROS_ASSERT(label >= 0 && label < max_labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ranges_[label].enabled = false;
+    rebuild();
+}
+
+void ColorClassifier::rebuild() {
+    const int levels = 1 << bits_;
+    const int shift = 8 - bits_;
+    const int half_cell = (1 << shift) / 2;
+
+    // The center of every cell as one row of pixels, in table order
+    cv::Mat centers(1, levels * levels * levels, CV_8UC3);
+    auto* center = centers.ptr<cv::Vec3b>();
+    for (int b = 0; b < levels; b++) {
+        for (int g = 0; g < levels; g++) {
+            for (int r = 0; r < levels; r++) {
+                *center++ = cv::Vec3b((b << shift) + half_cell, (g << shift) + half_cell, (r << shift) + half_cell);
+            }
+        }
+    }
+
+    auto table = std::make_shared<std::vector<uint8_t>>(centers.cols, 0);
+    std::array<cv::Mat, 3> converted;  // centers in each color space, converted when a range first needs it
+    cv::Mat inside;
+    for (int label = 0; label < max_labels; label++) {
+        const Range& range = ranges_[label];
+        if (!range.enabled) {
+            continue;
+        }
+
+        cv::Mat& colors = converted[range.space];
+        if (colors.empty()) {
+            if (range.space == HSV) {
+                cv::cvtColor(centers, colors, cv::COLOR_BGR2HSV);
+            } else if (range.space == HLS) {
+                cv::cvtColor(centers, colors, cv::COLOR_BGR2HLS);
+            } else {
+                colors = centers;
+            }
+        }
+
+        cv::inRange(colors, range.lower, range.upper, inside);
+        const uint8_t bit = 1 << label;
+        const auto* in_range = inside.ptr<uint8_t>();
+        for (size_t i = 0; i < table->size(); i++) {
+            if (in_range[i]) {
+                (*table)[i] |= bit;
+            }
+        }
+    }
+
+    std::atomic_store(&table_, std::shared_ptr<const std::vector<uint8_t>>(std::move(table)));
+}
+
+void ColorClassifier::classify(const cv::Mat& bgr, cv::Mat& labels) const {
+    CV_Assert(bgr.type() == CV_8UC3);
+    const auto table = std::atomic_load(&table_);
+    const uint8_t* lookup = table->data();
+    const int bits = bits_;
+    const int shift = 8 - bits_;
+
+    labels.create(bgr.size(), CV_8UC1);
+    for (int row = 0; row < bgr.rows; row++) {
+        const uint8_t* pixel = bgr.ptr<uint8_t>(row);
+        uint8_t* label = labels.ptr<uint8_t>(row);
+        for (int col = 0; col < bgr.cols; col++, pixel += 3) {
+            label[col] = lookup[((pixel[0] >> shift) << (2 * bits)) | ((pixel[1] >> shift) << bits) |
+                                (pixel[2] >> shift)];
+        }
+    }
+}
+
+void ColorClassifier::mask(const cv::Mat& labels, int label, cv::Mat& out) {
+    cv::bitwise_and(labels, cv::Scalar(1 << label), out);
+    cv::compare(out, 0, out, cv::CMP_NE);
+}
+
+}  // namespace rr
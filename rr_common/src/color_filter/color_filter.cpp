@@ -76,14 +76,10 @@ cv::Mat ColorFilter::Filter(const cv::Mat& in_img_full) {
         cv::Mat cvt_img;
         cv::cvtColor(input_resized_roi, cvt_img, CV_BGR2GRAY);
         cv::inRange(cvt_img, cv::Vec<int, 1>(lower_[0]), cv::Vec<int, 1>(upper_[0]), processed_roi);
-    } else if (color_space_ == HSV) {
-        cv::Mat cvt_img;
-        cv::cvtColor(input_resized_roi, cvt_img, CV_BGR2HSV);
-        cv::inRange(cvt_img, lower_, upper_, processed_roi);
-    } else if (color_space_ == HLS) {
-        cv::Mat cvt_img;
-        cv::cvtColor(input_resized_roi, cvt_img, CV_BGR2HLS);
-        cv::inRange(cvt_img, lower_, upper_, processed_roi);
+    } else if (color_space_ == HSV || color_space_ == HLS) {
+        cv::Mat labels;
+        classifier_.classify(input_resized_roi, labels);
+        ColorClassifier::mask(labels, 0, processed_roi);
     }
 
     // Step 4: apply dilation and erosion
@@ -134,6 +130,9 @@ void ColorFilter::ReconfigureCallback(const rr_msgs::ColorFilterConfig& config,
     roi_ = cv::Rect(config.roi_col_min, config.roi_row_min, width, height);
 
     color_space_ = config.mode;
+    if (color_space_ == HSV || color_space_ == HLS) {
+        classifier_.setRange(0, color_space_ == HSV ? ColorClassifier::HSV : ColorClassifier::HLS, lower_, upper_);
+    }
 
     dilation_ = config.dilation;
     erosion_ = config.erosion;
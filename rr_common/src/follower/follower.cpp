@@ -8,13 +8,9 @@ void pidCallback(std_msgs::Float64 pidSpeed) {
     speed_pub.publish(outputSpeed);
 }
 void mapCallback(const sensor_msgs::PointCloud2ConstPtr& map) {
-    pcl::PCLPointCloud2 pcl_pc2;
-    pcl_conversions::toPCL(*map, pcl_pc2);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-    pcl::fromPCLPointCloud2(pcl_pc2, *cloud);
     rr_msgs::speedPtr speedMSG(new rr_msgs::speed);
     rr_msgs::steeringPtr steerMSG(new rr_msgs::steering);
-    if (cloud->empty()) {
+    if (map->width * map->height == 0) {
         ROS_WARN("environment map pointcloud is empty");
         speedMSG->speed = 0;
         steerMSG->angle = 0;
@@ -22,35 +18,13 @@ void mapCallback(const sensor_msgs::PointCloud2ConstPtr& map) {
         steer_pub.publish(steerMSG);
         return;
     }
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_filtered(new pcl::PointCloud<pcl::PointXYZ>);
-
-    // Bounds the x-dimension
-    pcl::PassThrough<pcl::PointXYZ> passLimitX;
-    passLimitX.setInputCloud(cloud);
-    passLimitX.setFilterFieldName("x");
-    passLimitX.setFilterLimits(MIN_FRONT_VISION, MAX_FRONT_VISION);
-    passLimitX.filter(*cloud_filtered);
-
-    // Bounds the y-dimension
-    pcl::PassThrough<pcl::PointXYZ> passLimitY;
-    passLimitY.setInputCloud(cloud_filtered);
-    passLimitY.setFilterFieldName("y");
-    passLimitY.setFilterLimits(MIN_SIDE_VISION, MAX_SIDE_VISION);
-    passLimitY.filter(*cloud_filtered);
-
-    // Finds closest point
-    float minX = INT_MAX;
-    for (pcl::PointXYZ point : cloud_filtered->points) {
-        if (point.x < minX) {
-            minX = point.x;
-        }
-    }
 
-    if (cloud_filtered->points.size() != 0) {  // computes the average distance away
-                                               //        avgX = avgX / cloud_filtered->points.size();
-                                               //        ROS_INFO_STREAM("Average X = " << avgX);
-        ROS_INFO_STREAM("Min X = " << minX);
+    // Bounds x and y and finds the closest point in one pass over the message
+    const rr::CloudRegion::Stats stats = vision_region->query(*map);
+    const float minX = stats.min_x;
 
+    if (stats.count != 0) {
+        ROS_DEBUG_STREAM("Min X = " << minX << ", " << stats.count << " points, centroid y = " << stats.centroid_y);
     } else {  // Nothing in bounding box
         ROS_INFO_STREAM("Nothing in bounding box");
         speedMSG->speed = 0;
@@ -74,15 +48,12 @@ void mapCallback(const sensor_msgs::PointCloud2ConstPtr& map) {
     // Publishes a visual representation of the bounding box
     geometry_msgs::PolygonStamped visionBox;
     visionBox.header.frame_id = "base_footprint";
-    visionBox.polygon.points = std::vector<geometry_msgs::Point32>(4);
-    visionBox.polygon.points[0].x = MIN_FRONT_VISION;
-    visionBox.polygon.points[0].y = MIN_SIDE_VISION;
-    visionBox.polygon.points[1].x = MAX_FRONT_VISION;
-    visionBox.polygon.points[1].y = MIN_SIDE_VISION;
-    visionBox.polygon.points[2].x = MAX_FRONT_VISION;
-    visionBox.polygon.points[2].y = MAX_SIDE_VISION;
-    visionBox.polygon.points[3].x = MIN_FRONT_VISION;
-    visionBox.polygon.points[3].y = MAX_SIDE_VISION;
+    for (const auto& corner : vision_region->corners()) {
+        geometry_msgs::Point32 point;
+        point.x = corner.first;
+        point.y = corner.second;
+        visionBox.polygon.points.push_back(point);
+    }
     visonBox_pub.publish(visionBox);
 }
 int main(int argc, char** argv) {
@@ -102,6 +73,9 @@ int main(int argc, char** argv) {
     nhp.param("FOLLOWER_SPEED", FOLLOWER_SPEED, 1.0f);
     nhp.param("INPUT_CLOUD_TOPIC", obstacleCloudTopic, string("/map"));
 
+    vision_region = std::make_unique<rr::CloudRegion>(MIN_FRONT_VISION, MAX_FRONT_VISION, MIN_SIDE_VISION,
+                                                      MAX_SIDE_VISION);
+
     nhp.param("topic_from_plant", topic_from_plant, string("/state"));
     nhp.param("setpoint_topic", setpoint_topic, string("/setpoint"));
     nhp.param("topic_from_controller", topic_from_controller, string("/control_effort"));
@@ -3,18 +3,16 @@
 
 #include <geometry_msgs/Point32.h>
 #include <geometry_msgs/PolygonStamped.h>
-#include <pcl/PCLPointCloud2.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/point_cloud.h>
-#include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
+#include <rr_common/cloud_region.h>
 #include <rr_msgs/speed.h>
 #include <rr_msgs/steering.h>
+#include <sensor_msgs/PointCloud2.h>
 #include <std_msgs/Float64.h>
 
+#include <memory>
 #include <string>
 
-#include "flann/flann.hpp"
 float MIN_FRONT_VISION;
 float MAX_FRONT_VISION;
 float GOAL_DIST;
@@ -27,6 +25,8 @@ std::string topic_from_plant;
 std::string setpoint_topic;
 std::string topic_from_controller;
 
+std::unique_ptr<rr::CloudRegion> vision_region;
+
 ros::Publisher speed_pub, steer_pub, pid_speed_pub, pid_setpoint_pub, visonBox_pub;
 
 #endif  // RR_COMMON_FOLLOWER_H
@@ -10,6 +10,8 @@
 #include <pcl/point_cloud.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
+#include <rr_common/instrumentation.h>
+#include <rr_common/tracing.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <sensor_msgs/image_encodings.h>
@@ -22,14 +24,22 @@ using namespace std;
 using uchar = unsigned char;
 
 map<string, ros::Publisher> cloud_pubs;
+
+std::unique_ptr<rr::NodeMetrics> metrics;
+map<string, rr::NodeMetrics::Input*> image_inputs;
+map<string, rr::NodeMetrics::Output*> cloud_outputs;
+rr::NodeMetrics::Stage* convert_stage;
 double pxPerMeter;
 
 pcl::PointCloud<pcl::PointXYZ>::Ptr cloud;
 
 void transformedImageCB(const sensor_msgs::ImageConstPtr& msg, const string& topic) {
+    image_inputs[topic]->received(msg->header);
     if (cloud_pubs[topic].getNumSubscribers() == 0) {
         return;
     }
+    rr::TraceSpan span("image_pcl_converter", msg->header.stamp);
+    rr::StageTimer timer(*convert_stage);
 
     cv_bridge::CvImageConstPtr cv_ptr;
     try {
@@ -67,10 +77,12 @@ void transformedImageCB(const sensor_msgs::ImageConstPtr& msg, const string& top
     cloud_msg.header.frame_id = "base_footprint";
     cloud_msg.header.stamp = msg->header.stamp;
     cloud_pubs[topic].publish(cloud_msg);
+    cloud_outputs[topic]->published();
 }
 
 int main(int argc, char** argv) {
     ros::init(argc, argv, "image_pcl_converter");
+    rr::startTracing(ros::this_node::getName());
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
 
@@ -80,6 +92,9 @@ int main(int argc, char** argv) {
 
     cloud.reset(new pcl::PointCloud<pcl::PointXYZ>);
 
+    metrics = std::make_unique<rr::NodeMetrics>(nh);
+    convert_stage = &metrics->stage("convert");
+
     vector<string> topics;
     boost::split(topics, topicsConcat, boost::is_any_of(" ,"));
     vector<ros::Subscriber> image_subs;
@@ -87,12 +102,15 @@ int main(int argc, char** argv) {
         if (topic.size() == 0)
             continue;
 
+        string newTopic = topic + "_cloud";
+        image_inputs[topic] = &metrics->input(topic);
+        cloud_outputs[topic] = &metrics->output(newTopic);
+
         auto bound_callback = boost::bind(transformedImageCB, _1, topic);
         auto sub = nh.subscribe<sensor_msgs::Image>(topic, 1, bound_callback);
         image_subs.push_back(sub);
 
         ROS_INFO_STREAM("image_pcl_converter subscribed to " << topic);
-        string newTopic = topic + "_cloud";
         ROS_INFO_STREAM("Creating new topic " << newTopic);
         cloud_pubs[topic] = nh.advertise<sensor_msgs::PointCloud2>(newTopic, 1);
     }
@@ -1,6 +1,8 @@
 #include <cv_bridge/cv_bridge.h>
 #include <ros/ros.h>
 #include <rr_common/CameraGeometry.h>
+#include <rr_common/instrumentation.h>
+#include <rr_common/tracing.h>
 #include <sensor_msgs/Image.h>
 
 #include <boost/algorithm/string.hpp>
@@ -26,6 +28,11 @@ Mat transform_matrix;
 
 map<string, Publisher> transform_pubs;
 
+std::unique_ptr<rr::NodeMetrics> metrics;
+map<string, rr::NodeMetrics::Input*> image_inputs;
+map<string, rr::NodeMetrics::Output*> transform_outputs;
+rr::NodeMetrics::Stage* transform_stage;
+
 /*
  * Start with a horizontal line on the groud at dmin meters horizonally in front of the
  * camera. It fills half the camera's FOV, from the center to the right edge. Then back
@@ -83,10 +90,14 @@ void setTransformFromGeometry() {
 }
 
 void TransformImage(const sensor_msgs::ImageConstPtr& msg, string& topic) {
+    image_inputs[topic]->received(msg->header);
+
     // if no one is listening or the transform is undefined, give up
     if (transform_pubs[topic].getNumSubscribers() == 0 || transform_matrix.empty()) {
         return;
     }
+    rr::TraceSpan span("image_transform", msg->header.stamp);
+    rr::StageTimer timer(*transform_stage);
 
     cv_bridge::CvImagePtr cv_ptr;
     cv_ptr = cv_bridge::toCvCopy(msg, "mono8");
@@ -105,10 +116,12 @@ void TransformImage(const sensor_msgs::ImageConstPtr& msg, string& topic) {
     cv_ptr->image = outimage;
     cv_ptr->toImageMsg(outmsg);
     transform_pubs[topic].publish(outmsg);
+    transform_outputs[topic]->published();
 }
 
 int main(int argc, char** argv) {
     init(argc, argv, "image_transform");
+    rr::startTracing(this_node::getName());
     NodeHandle nh;
     NodeHandle pnh("~");
 
@@ -151,15 +164,20 @@ int main(int argc, char** argv) {
     vector<string> topics;
     boost::split(topics, topicsConcat, boost::is_any_of(" ,"));
     vector<Subscriber> transform_subs;
+    metrics = std::make_unique<rr::NodeMetrics>(nh);
+    transform_stage = &metrics->stage("transform");
     ROS_INFO_STREAM("Found " << topics.size() << " topics in param.");
     for (const string& topic : topics) {
         if (topic.size() == 0) {
             continue;
         }
 
+        string newTopic(topic + "_transformed");
+        image_inputs[topic] = &metrics->input(topic);
+        transform_outputs[topic] = &metrics->output(newTopic);
+
         transform_subs.push_back(nh.subscribe<sensor_msgs::Image>(topic, 1, boost::bind(TransformImage, _1, topic)));
         ROS_INFO_STREAM("Image_transform subscribed to " << topic);
-        string newTopic(topic + "_transformed");
         ROS_INFO_STREAM("Creating new topic " << newTopic);
         transform_pubs[topic] = nh.advertise<sensor_msgs::Image>(newTopic, 1);
     }
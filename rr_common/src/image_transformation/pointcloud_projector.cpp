@@ -8,6 +8,8 @@
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
 #include <rr_common/CameraGeometry.h>
+#include <rr_common/instrumentation.h>
+#include <rr_common/tracing.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/PointCloud2.h>
 
@@ -26,12 +28,19 @@ class PointCloudProjector : public nodelet::Nodelet {
     int downsample_factor_;
     bool cam_geom_ready_;
     std::thread load_info_thread_;
+    std::unique_ptr<rr::NodeMetrics> metrics_;
+    rr::NodeMetrics::Input* image_input_;
+    rr::NodeMetrics::Stage* project_stage_;
+    rr::NodeMetrics::Output* cloud_output_;
 
     void ImageCallback(const sensor_msgs::ImageConstPtr& msg) {
+        image_input_->received(msg->header);
         if (!cam_geom_ready_) {
             NODELET_INFO("Pointcloud projector waiting for camera geometry load");
             return;
         }
+        rr::TraceSpan span("pointcloud_projector", msg->header.stamp);
+        rr::StageTimer timer(*project_stage_);
 
         const cv::Mat cv_img = cv_bridge::toCvShare(msg, "mono8")->image;
 
@@ -64,11 +73,13 @@ class PointCloudProjector : public nodelet::Nodelet {
         out->header.frame_id = "base_footprint";
         out->header.stamp = msg->header.stamp;
         pointcloud_pub_.publish(out);
+        cloud_output_->published();
     }
 
     void onInit() override {
         auto node_handle = getNodeHandle();
         auto nh_private = getPrivateNodeHandle();
+        rr::startTracing(getName());  // once per process, so nodelets sharing a manager share its trace
 
         image_transport::ImageTransport image_transport(node_handle);
 
@@ -99,6 +110,11 @@ class PointCloudProjector : public nodelet::Nodelet {
             cam_geom_ready_ = true;
         });
 
+        metrics_ = std::make_unique<rr::NodeMetrics>(node_handle, getName());
+        image_input_ = &metrics_->input(image_topic_in);
+        project_stage_ = &metrics_->stage("project");
+        cloud_output_ = &metrics_->output(pointcloud_topic_out);
+
         detection_image_sub_ = image_transport.subscribe(image_topic_in, 1, &PointCloudProjector::ImageCallback, this);
 
         pointcloud_pub_ = node_handle.advertise<sensor_msgs::PointCloud2>(pointcloud_topic_out, 1);
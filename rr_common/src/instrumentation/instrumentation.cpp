@@ -0,0 +1,217 @@
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <rr_common/instrumentation.h>
+
+namespace rr {
+
+namespace {
+
+diagnostic_msgs::KeyValue keyValue(const std::string& key, const char* format, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), format, value);
+    diagnostic_msgs::KeyValue kv;
+    kv.key = key;
+    kv.value = buffer;
+    return kv;
+}
+
+template <typename T>
+T& findOrAdd(std::map<std::string, std::unique_ptr<T>>& items, const std::string& name) {
+    auto& item = items[name];
+    if (!item) {
+        item = std::make_unique<T>();
+    }
+    return *item;
+}
+
+}  // namespace
+
+size_t LatencyHistogram::bucketIndex(uint64_t us) {
+    us = std::min<uint64_t>(us, (uint64_t{ 1 } << max_exponent) - 1);
+    if (us < (uint64_t{ 1 } << sub_bucket_bits)) {
+        return us;
+    }
+    const int msb = 63 - __builtin_clzll(us);
+    const int shift = msb - sub_bucket_bits;
+    return (static_cast<size_t>(shift + 1) << sub_bucket_bits) + ((us >> shift) - (uint64_t{ 1 } << sub_bucket_bits));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < (size_t{ 1 } << sub_bucket_bits)) {
+        return index;
+    }
+    const int shift = static_cast<int>(index >> sub_bucket_bits) - 1;
+    const uint64_t mantissa = (index & ((size_t{ 1 } << sub_bucket_bits) - 1)) + (uint64_t{ 1 } << sub_bucket_bits);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) {
+    const auto us = static_cast<uint64_t>(std::max<int64_t>(0, value.count() / 1000));
+    buckets_[bucketIndex(us)]++;
+    count_++;
+    total_us_ += us;
+    max_us_ = std::max(max_us_, us);
+}
+
+double LatencyHistogram::percentile(double p) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; i++) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max_us_) * 1e-6;
+        }
+    }
+    return max();
+}
+
+double LatencyHistogram::mean() const {
+    return count_ > 0 ? total_us_ * 1e-6 / count_ : 0;
+}
+
+double LatencyHistogram::max() const {
+    return max_us_ * 1e-6;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < bucket_count; i++) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    total_us_ += other.total_us_;
+    max_us_ = std::max(max_us_, other.max_us_);
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    total_us_ = 0;
+    max_us_ = 0;
+}
+
+void NodeMetrics::Stage::record(std::chrono::nanoseconds duration) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    histogram_.record(duration);
+}
+
+void NodeMetrics::Input::received(const std_msgs::Header& header) {
+    // roscpp and rospy publishers number their messages, so a jump means some never made it through the queue. Zero
+    // is what nodelets passing pointers leave there.
+    if (header.seq != 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (has_seq_ && header.seq > last_seq_ + 1) {
+            dropped_ += header.seq - last_seq_ - 1;
+        }
+        last_seq_ = header.seq;
+        has_seq_ = true;
+    }
+    received(header.stamp);
+}
+
+void NodeMetrics::Input::received(const ros::Time& stamp) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count_++;
+    if (!stamp.isZero()) {
+        age_.record(std::chrono::nanoseconds((ros::Time::now() - stamp).toNSec()));
+    }
+}
+
+NodeMetrics::NodeMetrics(ros::NodeHandle nh, const std::string& name, double period)
+      : node_name_(name), window_start_(ros::WallTime::now()) {
+    diagnostics_pub_ = nh.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+    timer_ = nh.createWallTimer(ros::WallDuration(period), [this](const ros::WallTimerEvent&) { publish(); });
+}
+
+NodeMetrics::Stage& NodeMetrics::stage(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findOrAdd(stages_, name);
+}
+
+NodeMetrics::Input& NodeMetrics::input(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findOrAdd(inputs_, topic);
+}
+
+NodeMetrics::Output& NodeMetrics::output(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findOrAdd(outputs_, topic);
+}
+
+NodeMetrics::Counter& NodeMetrics::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findOrAdd(counters_, name);
+}
+
+void NodeMetrics::publish() {
+    const auto now = ros::WallTime::now();
+    const double window = std::max(1e-6, (now - window_start_).toSec());
+    window_start_ = now;
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.name = node_name_;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    LatencyHistogram histogram;
+    for (auto& [name, stage] : stages_) {
+        const double deadline = stage->deadline_;
+        {
+            std::lock_guard<std::mutex> stage_lock(stage->mutex_);
+            histogram = stage->histogram_;
+            stage->histogram_.reset();
+        }
+        const std::string prefix = "stage:" + name + ":";
+        status.values.push_back(keyValue(prefix + "count", "%.0f", histogram.count()));
+        status.values.push_back(keyValue(prefix + "p50_ms", "%.3f", histogram.percentile(0.5) * 1000));
+        status.values.push_back(keyValue(prefix + "p99_ms", "%.3f", histogram.percentile(0.99) * 1000));
+        status.values.push_back(keyValue(prefix + "max_ms", "%.3f", histogram.max() * 1000));
+        if (deadline > 0) {
+            status.values.push_back(keyValue(prefix + "deadline_ms", "%.3f", deadline * 1000));
+            if (histogram.percentile(0.99) > deadline) {
+                status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+                status.message += (status.message.empty() ? "" : ", ") + name + " over deadline";
+            }
+        }
+    }
+
+    for (auto& [topic, input] : inputs_) {
+        uint64_t count;
+        {
+            std::lock_guard<std::mutex> input_lock(input->mutex_);
+            count = input->count_;
+            histogram = input->age_;
+            input->count_ = 0;
+            input->age_.reset();
+        }
+        const std::string prefix = "input:" + topic + ":";
+        status.values.push_back(keyValue(prefix + "rate_hz", "%.2f", count / window));
+        status.values.push_back(keyValue(prefix + "age_p50_ms", "%.3f", histogram.percentile(0.5) * 1000));
+        status.values.push_back(keyValue(prefix + "age_max_ms", "%.3f", histogram.max() * 1000));
+        status.values.push_back(keyValue(prefix + "dropped", "%.0f", input->dropped_.exchange(0)));
+    }
+
+    for (auto& [topic, output] : outputs_) {
+        status.values.push_back(keyValue("output:" + topic + ":rate_hz", "%.2f", output->count_.exchange(0) / window));
+    }
+
+    for (auto& [name, counter] : counters_) {
+        status.values.push_back(keyValue("counter:" + name + ":count", "%.0f", counter->count_.exchange(0)));
+    }
+
+    if (status.message.empty()) {
+        status.message = "OK";
+    }
+
+    diagnostic_msgs::DiagnosticArray array;
+    array.header.stamp = ros::Time::now();
+    array.status.push_back(std::move(status));
+    diagnostics_pub_.publish(array);
+}
+
+}  // namespace rr
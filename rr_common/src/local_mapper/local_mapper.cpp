@@ -6,6 +6,8 @@
 #include <ros/ros.h>
 #include <rr_common/CameraGeometry.h>
 #include <rr_common/RelativePoseHistoryClient.h>
+#include <rr_common/instrumentation.h>
+#include <rr_common/tracing.h>
 #include <sensor_msgs/PointCloud2.h>
 
 #include <deque>
@@ -30,7 +32,16 @@ pcl::VoxelGrid<pcl::PointXYZ> filter;
 ros::Duration time_horizon;
 std::vector<geometry_msgs::Point> in_frame_polygon;
 
+std::unique_ptr<rr::NodeMetrics> metrics;
+rr::NodeMetrics::Input* obstacles_input;
+rr::NodeMetrics::Stage* build_stage;
+rr::NodeMetrics::Output* map_output;
+
 void obstacles_callback(const sensor_msgs::PointCloud2::ConstPtr& msg) {
+    rr::TraceSpan span("local_mapper", msg->header.stamp);
+    obstacles_input->received(msg->header);
+    rr::StageTimer timer(*build_stage);
+
     // populate new source pair
     auto& new_source = sources.emplace_front();
     pcl::fromROSMsg<pcl::PointXYZ>(*msg, new_source.cloud);
@@ -113,10 +124,12 @@ void obstacles_callback(const sensor_msgs::PointCloud2::ConstPtr& msg) {
     map_msg.header.stamp = sources.front().time;  // use time from most recent included point cloud
     map_msg.header.frame_id = "base_footprint";
     map_publisher.publish(map_msg);
+    map_output->published();
 }
 
 int main(int argc, char** argv) {
     ros::init(argc, argv, "local_mapper");
+    rr::startTracing(ros::this_node::getName());
 
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
@@ -159,6 +172,11 @@ int main(int argc, char** argv) {
     in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w2)));
     in_frame_polygon.push_back(std::get<1>(camera_geometry.ProjectToWorld(horizon_row, w1)));
 
+    metrics = std::make_unique<rr::NodeMetrics>(nh);
+    obstacles_input = &metrics->input(obstacles_topic);
+    build_stage = &metrics->stage("build_map");
+    map_output = &metrics->output("/local_map");
+
     auto sub1 = nh.subscribe(obstacles_topic, 1, obstacles_callback);
     auto sub2 = pose_history.RegisterCallback(nh);
 
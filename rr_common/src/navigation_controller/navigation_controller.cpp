@@ -19,6 +19,10 @@ ros::Publisher speedPub;
 int state;
 double planSpeed, speed;
 double planSteering, steering;
+
+// Commands taken from the planner keep its stamps, which are those of the sensor data they were planned from
+ros::Time planSpeedStamp, speedStamp;
+ros::Time planSteeringStamp, steeringStamp;
 bool raceStarted;
 int finishLineCrosses;
 
@@ -34,6 +38,7 @@ void updateState() {
         case WAITING_FOR_START:
             speed = 0.0;
             steering = 0.0;
+            speedStamp = steeringStamp = ros::Time();
             if (raceStarted) {
                 state = RUNNING_PLANNER;
                 startTime = ros::Time::now();
@@ -50,15 +55,20 @@ void updateState() {
                     speed = planSpeed;
                 }
                 steering = planSteering;
+                speedStamp = planSpeedStamp;
+                steeringStamp = planSteeringStamp;
             }
             break;
         case FINISHED:
             speed = 0.0;  //@note: -1 brakes, 0 coasts
+            speedStamp = ros::Time();
             // Continue steering until we have stopped moving.
             if (ros::Time::now() - finishTime > ros::Duration(steeringAfterFinishTime)) {
                 steering = 0.0;
+                steeringStamp = ros::Time();
             } else {
                 steering = planSteering;
+                steeringStamp = planSteeringStamp;
             }
             break;
         default:
@@ -69,10 +79,12 @@ void updateState() {
 
 void planSpeedCB(const rr_msgs::speed::ConstPtr &speed_msg) {
     planSpeed = speed_msg->speed;
+    planSpeedStamp = speed_msg->header.stamp;
 }
 
 void planSteerCB(const rr_msgs::steering::ConstPtr &steer_msg) {
     planSteering = steer_msg->angle;
+    planSteeringStamp = steer_msg->header.stamp;
 }
 
 void startLightCB(const std_msgs::Bool::ConstPtr &bool_msg) {
@@ -126,14 +138,15 @@ int main(int argc, char **argv) {
         updateState();
         // ROS_INFO("Nav Mux = %d, crosses = %d", state, finishLineCrosses);
 
+        // Commands the controller decides on itself are stamped with the time they are sent
         rr_msgs::speed speedMsg;
         speedMsg.speed = speed;
-        speedMsg.header.stamp = ros::Time::now();
+        speedMsg.header.stamp = speedStamp.isZero() ? ros::Time::now() : speedStamp;
         speedPub.publish(speedMsg);
 
         rr_msgs::steering steerMsg;
         steerMsg.angle = steering;
-        steerMsg.header.stamp = ros::Time::now();
+        steerMsg.header.stamp = steeringStamp.isZero() ? ros::Time::now() : steeringStamp;
         steerPub.publish(steerMsg);
         ROS_INFO("Current state: %d", state);
 
@@ -23,6 +23,10 @@ AnnealingOptimizer<ctrl_dim>::AnnealingOptimizer(const ros::NodeHandle& nh)
     }
 }
 
+template <int ctrl_dim>
+AnnealingOptimizer<ctrl_dim>::AnnealingOptimizer(const Params& params)
+      : params_(params), uniform_01_(0, 1), rand_gen_(42) {}
+
 template <int ctrl_dim>
 double AnnealingOptimizer<ctrl_dim>::GetTemperature(unsigned int t) {
     return std::exp(t * std::log(params_.temperature_end) / params_.annealing_steps);
@@ -13,6 +13,16 @@ BicycleModel::BicycleModel(const ros::NodeHandle& nh, const std::shared_ptr<rr::
     speed_model_ = speed_model_ptr;
 }
 
+BicycleModel::BicycleModel(double wheel_base, double max_lateral_accel, int segment_size, double dt,
+                           const std::shared_ptr<rr::LinearTrackingFilter>& steer_model_ptr,
+                           const std::shared_ptr<rr::LinearTrackingFilter>& speed_model_ptr)
+      : wheel_base_(wheel_base)
+      , max_lateral_accel_(max_lateral_accel)
+      , segment_size_(segment_size)
+      , dt_(dt)
+      , steering_model_(steer_model_ptr)
+      , speed_model_(speed_model_ptr) {}
+
 void BicycleModel::RollOutPath(const Controls<1>& controls, TrajectoryRollout& rollout) const {
     const size_t path_size = 1 + (segment_size_ * controls.cols());
     if (rollout.path.size() != path_size) {
@@ -29,6 +29,18 @@ DistanceMap::DistanceMap(ros::NodeHandle nh)
     std::tie(inscribed_circle_radius, inscribed_circle_origin) = hit_box.getForwardInscribedCircle();
 }
 
+DistanceMap::DistanceMap(const Rectangle& hitbox, double cost_scaling_factor, double lethal_wall_inflation,
+                         double nonlethal_wall_inflation)
+      : distance_cost_map()
+      , hit_box(hitbox)
+      , cost_scaling_factor(cost_scaling_factor)
+      , nonlethal_wall_inflation(nonlethal_wall_inflation)
+      , lethal_wall_inflation(lethal_wall_inflation)
+      , publish_distance_map(false)
+      , publish_inscribed_circle(false) {
+    std::tie(inscribed_circle_radius, inscribed_circle_origin) = hit_box.getForwardInscribedCircle();
+}
+
 double DistanceMap::DistanceCost(const rr::Pose& pose) {
     auto [mx, my] = this->PoseToGridPosition(pose);
 
@@ -56,11 +68,21 @@ void DistanceMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid
         ROS_ERROR_STREAM(ex.what());
     }
 
-    mapMetaData = map_msg->info;
+    map_stamp_ = map_msg->header.stamp;
+    BuildCostMap(*map_msg);
+}
+
+void DistanceMap::SetMap(const nav_msgs::OccupancyGridConstPtr& map_msg, const tf::Transform& map_from_base) {
+    transform.setData(map_from_base);
+    BuildCostMap(*map_msg);
+}
+
+void DistanceMap::BuildCostMap(const nav_msgs::OccupancyGrid& map_msg) {
+    mapMetaData = map_msg.info;
 
     // Turn occupancy grid to distance map in meters
     cv::Mat distance_map(mapMetaData.width, mapMetaData.height, CV_8UC1);
-    memcpy(distance_map.data, map_msg->data.data(), map_msg->data.size() * sizeof(uint8_t));
+    memcpy(distance_map.data, map_msg.data.data(), map_msg.data.size() * sizeof(uint8_t));
     cv::inRange(distance_map, 99, 254, distance_map);  // costmap2d::NO_INFORMATION is counted as FREE
     cv::bitwise_not(distance_map, distance_map);
 
@@ -103,7 +125,7 @@ void DistanceMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid
     if (publish_inscribed_circle && inscribed_circle_pub.getNumSubscribers() > 0) {
         geometry_msgs::PolygonStamped circle;
         circle.polygon.points = std::vector<geometry_msgs::Point32>(16);
-        circle.header.frame_id = map_msg->header.frame_id;
+        circle.header.frame_id = map_msg.header.frame_id;
         tf::Pose w_pose =
               transform * tf::Pose(tf::createQuaternionFromYaw(0), tf::Vector3(inscribed_circle_origin, 0, 0));
 
@@ -25,6 +25,13 @@ HillClimbOptimizer<ctrl_dim>::HillClimbOptimizer(const ros::NodeHandle& nh) {
     }
 }
 
+template <int ctrl_dim>
+HillClimbOptimizer<ctrl_dim>::HillClimbOptimizer(const Params& params)
+      : num_workers_(params.num_workers)
+      , num_restarts_(params.num_restarts)
+      , neighbor_stddev_(params.neighbor_stddev)
+      , local_optimum_tries_(params.local_optimum_tries) {}
+
 template <int ctrl_dim>
 Controls<ctrl_dim> HillClimbOptimizer<ctrl_dim>::Optimize(const CostFunction<ctrl_dim>& cost_fn,
                                                           const Controls<ctrl_dim>& init_controls,
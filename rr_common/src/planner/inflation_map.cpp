@@ -11,6 +11,9 @@ InflationMap::InflationMap(ros::NodeHandle nh)
     assertions::getParam(nh, "lethal_threshold", lethal_threshold, { assertions::greater(0), assertions::less(256) });
 }
 
+InflationMap::InflationMap(const Rectangle& hitbox, int lethal_threshold)
+      : map(), hit_box(hitbox), lethal_threshold(lethal_threshold) {}
+
 double InflationMap::DistanceCost(const rr::Pose& rr_pose) {
     const tf::Pose pose(tf::createQuaternionFromYaw(rr_pose.theta), tf::Vector3(rr_pose.x, rr_pose.y, 0));
     tf::Pose world_Pose = transform * pose;
@@ -36,6 +39,7 @@ void InflationMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid
     }
 
     map = map_msg;
+    map_stamp_ = map_msg->header.stamp;
 
     try {
         listener->waitForTransform(map_msg->header.frame_id, "/base_footprint", ros::Time(0), ros::Duration(.05));
@@ -47,4 +51,14 @@ void InflationMap::SetMapMessage(const boost::shared_ptr<nav_msgs::OccupancyGrid
     updated_ = true;
 }
 
+void InflationMap::SetMap(const nav_msgs::OccupancyGridConstPtr& map_msg, const tf::Transform& map_from_base) {
+    if (!accepting_updates_) {
+        return;
+    }
+
+    map = map_msg;
+    transform.setData(map_from_base);
+    updated_ = true;
+}
+
 }  // namespace rr
@@ -0,0 +1,827 @@
+/**
+ * Headless kinematic simulator for closed-loop planner testing. The car is a bicycle model whose steering and speed
+ * follow the planner's commands through the same rate limits the planner assumes, driving on a track loaded from one
+ * of rr_gazebo's track images or from a centerline trajectory, against opponents replayed from trajectory files. Each
+ * planning cycle raycasts a laser scan from the true pose, builds the planner's map from it, optimizes and applies the
+ * result, all in lock-step, so a run goes as fast as the CPU allows instead of at gazebo's pace.
+ *
+ * Usage:
+ *   rosrun rr_common kinematic_sim (--track_image FILE --track_size W H [--track_pose X Y YAW] [--line_threshold N]
+ *                                   | --track_csv FILE --track_width W)
+ *                                  [--opponent FILE]... [--opponent_delay S] [--opponent_size L W]
+ *                                  [--vehicle iarrc|evgp] [--map obstacle_points|inflation_map|distance_map]
+ *                                  [--start X Y YAW] [--laps N] [--max_time S] [--plan_period S]
+ *                                  [--beams N] [--range M] [--resolution M] [--lap_radius M] [--log FILE] [--csv]
+ *
+ * Trajectory files are the ones rr_gazebo's opponent controller plays, with a t,x,y,z,q0,q1,q2,q3 header, and loop
+ * over their duration the same way. The vehicle presets follow rr_iarrc/conf/planner_obstacle_avoidance.yaml and
+ * rr_evgp/conf/planner_sim.yaml. The global path cost term is built from the centerline of --track_csv; a track image
+ * has no centerline, so runs on one plan without it.
+ */
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <rr_common/planning/annealing_optimizer.h>
+#include <rr_common/planning/bicycle_model.h>
+#include <rr_common/planning/distance_map.h>
+#include <rr_common/planning/hill_climb_optimizer.h>
+#include <rr_common/planning/inflation_map.h>
+#include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/path_cost.h>
+#include <rr_common/planning/path_matching.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <opencv2/imgcodecs.hpp>
+#include <rr_common/linear_tracking_filter.hpp>
+#include <sstream>
+#include <string>
+
+namespace {
+
+constexpr int ctrl_dim = 2;
+constexpr double physics_dt = 0.01;
+constexpr double min_lap_distance = 10.0;  // meters driven before coming back to the start counts as a lap
+
+using Cloud = pcl::PointCloud<pcl::PointXYZ>;
+using Clock = std::chrono::steady_clock;
+
+struct VehicleConfig {
+    double wheel_base;
+    double max_lateral_accel;
+    int segment_size;
+    double segment_dt;
+    int n_segments;
+    rr::LinearTrackingFilter steer;
+    rr::LinearTrackingFilter speed;
+    double steering_gain;
+    rr::Rectangle hitbox;
+    rr::Rectangle map_limits;  // extent of the local map, in the robot frame
+    double map_resolution;
+    std::string map;
+    rr::PathCostWeights weights;
+    double k_global_path_cost;
+    std::string optimizer;
+};
+
+VehicleConfig iarrcConfig() {
+    return VehicleConfig{ 0.485,
+                          2.5,
+                          20,
+                          0.05,
+                          3,
+                          rr::LinearTrackingFilter(0, -0.44, 0.44, -1.2, 1.2),
+                          rr::LinearTrackingFilter(0, -1.0, 1.5, -6.0, 6.0),
+                          1.1,
+                          rr::Rectangle(-0.17, 0.62, -0.15, 0.15),
+                          rr::Rectangle(-5, 10, -7.5, 7.5),
+                          0.05,
+                          "obstacle_points",
+                          rr::PathCostWeights{ 1.0, 0.2, 0.0, 0.5, 1000 },
+                          0,
+                          "annealing" };
+}
+
+VehicleConfig evgpConfig() {
+    return VehicleConfig{ 0.97,
+                          7.0,
+                          25,
+                          0.02,
+                          7,
+                          rr::LinearTrackingFilter(0, -0.25, 0.25, -2.0, 2.0),
+                          rr::LinearTrackingFilter(0, -2.0, 25.0, -35.0, 30.0),
+                          1.4,
+                          rr::Rectangle(-0.2, 1.6, -0.8, 0.8),
+                          rr::Rectangle(-43.75, 43.75, -43.75, 43.75),
+                          0.25,
+                          "distance_map",
+                          rr::PathCostWeights{ 20, 2, 0.01, 0, 100000 },
+                          5,
+                          "hill_climbing" };
+}
+
+struct Options {
+    std::string track_image;
+    double track_width_m = 0;
+    double track_height_m = 0;
+    rr::Pose track_pose{ 0, 0, 0 };
+    int line_threshold = 200;
+    std::string track_csv;
+    double track_width = 0;
+    std::vector<std::string> opponents;
+    double opponent_delay = 0;
+    double opponent_length = 1.8;
+    double opponent_width = 1.2;
+    std::string vehicle = "iarrc";
+    std::string map;
+    bool has_start = false;
+    rr::Pose start{ 0, 0, 0 };
+    int laps = 10;
+    double max_time = 600;
+    double plan_period = 1.0 / 30;
+    int beams = 360;
+    double range = 10;
+    double resolution = 0.05;
+    double lap_radius = 2.0;
+    std::string log;
+    bool csv = false;
+};
+
+struct Result {
+    std::vector<double> lap_times;
+    std::vector<double> plan_ms;
+    int collisions = 0;
+    int no_path = 0;
+    double distance = 0;
+    double sim_time = 0;
+    double wall_time = 0;
+};
+
+// Static obstacles of the whole track as a world frame occupancy grid
+class World {
+  public:
+    void allocate(double min_x, double min_y, double max_x, double max_y, double resolution) {
+        resolution_ = resolution;
+        origin_x_ = min_x;
+        origin_y_ = min_y;
+        width_ = std::max(1, static_cast<int>(std::ceil((max_x - min_x) / resolution)));
+        height_ = std::max(1, static_cast<int>(std::ceil((max_y - min_y) / resolution)));
+        cells_.assign(static_cast<size_t>(width_) * height_, 0);
+    }
+
+    void mark(double x, double y) {
+        int mx, my;
+        if (cell(x, y, mx, my)) {
+            cells_[my * width_ + mx] = 1;
+        }
+    }
+
+    void markSegment(double x0, double y0, double x1, double y1) {
+        const int n = std::max(1, static_cast<int>(std::ceil(std::hypot(x1 - x0, y1 - y0) / (resolution_ / 2))));
+        for (int i = 0; i <= n; i++) {
+            const double t = static_cast<double>(i) / n;
+            mark(x0 + t * (x1 - x0), y0 + t * (y1 - y0));
+        }
+    }
+
+    // Everything off the grid is free, so a car that leaves the track drives on without walls
+    bool occupied(double x, double y) const {
+        int mx, my;
+        return cell(x, y, mx, my) && cells_[my * width_ + mx];
+    }
+
+    // Distance to the first occupied cell along the ray, or range if there is none
+    double raycast(double x, double y, double angle, double range) const {
+        const double step = resolution_ / 2;
+        const double dx = std::cos(angle) * step;
+        const double dy = std::sin(angle) * step;
+        const int n = static_cast<int>(range / step);
+        for (int i = 0; i <= n; i++) {
+            if (occupied(x + i * dx, y + i * dy)) {
+                return i * step;
+            }
+        }
+        return range;
+    }
+
+  private:
+    bool cell(double x, double y, int& mx, int& my) const {
+        mx = static_cast<int>(std::floor((x - origin_x_) / resolution_));
+        my = static_cast<int>(std::floor((y - origin_y_) / resolution_));
+        return mx >= 0 && my >= 0 && mx < width_ && my < height_;
+    }
+
+    double resolution_ = 1;
+    double origin_x_ = 0;
+    double origin_y_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> cells_;
+};
+
+struct TrajectoryPoint {
+    double t;
+    rr::Pose pose;
+};
+
+// Reads a t,x,y,z,q0,q1,q2,q3 trajectory, with the quaternion in x, y, z, w order
+bool loadTrajectory(const std::string& path, std::vector<TrajectoryPoint>& trajectory) {
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "could not read %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        double t, x, y, z, qx, qy, qz, qw;
+        if (fields >> t >> x >> y >> z >> qx >> qy >> qz >> qw) {
+            const double yaw = std::atan2(2 * (qw * qz + qx * qy), 1 - 2 * (qy * qy + qz * qz));
+            trajectory.push_back({ t, rr::Pose(x, y, yaw) });
+        }
+    }
+    if (trajectory.size() < 2) {
+        std::fprintf(stderr, "%s has fewer than two points\n", path.c_str());
+        return false;
+    }
+    std::sort(trajectory.begin(), trajectory.end(),
+              [](const TrajectoryPoint& a, const TrajectoryPoint& b) { return a.t < b.t; });
+    return true;
+}
+
+double wrapAngle(double angle) {
+    return std::atan2(std::sin(angle), std::cos(angle));
+}
+
+// A rectangular car replaying a trajectory, holding its first pose until it starts and looping once it ends
+class Opponent {
+  public:
+    Opponent(std::vector<TrajectoryPoint> trajectory, double delay, double length, double width)
+          : trajectory_(std::move(trajectory)), delay_(delay), half_length_(length / 2), half_width_(width / 2) {}
+
+    void update(double t) {
+        const double start = trajectory_.front().t;
+        const double duration = trajectory_.back().t - start;
+        double local = std::max(0.0, t - delay_);
+        if (duration > 0) {
+            local = std::fmod(local, duration);
+        }
+        local += start;
+
+        auto next = std::upper_bound(trajectory_.begin(), trajectory_.end(), local,
+                                     [](double time, const TrajectoryPoint& p) { return time < p.t; });
+        if (next == trajectory_.begin() || next == trajectory_.end()) {
+            pose_ = next == trajectory_.end() ? trajectory_.back().pose : trajectory_.front().pose;
+            return;
+        }
+        const TrajectoryPoint& a = *(next - 1);
+        const TrajectoryPoint& b = *next;
+        const double s = b.t > a.t ? (local - a.t) / (b.t - a.t) : 0;
+        pose_.x = a.pose.x + s * (b.pose.x - a.pose.x);
+        pose_.y = a.pose.y + s * (b.pose.y - a.pose.y);
+        pose_.theta = a.pose.theta + s * wrapAngle(b.pose.theta - a.pose.theta);
+    }
+
+    bool contains(double x, double y) const {
+        double lx, ly;
+        toLocal(x, y, lx, ly);
+        return std::abs(lx) <= half_length_ && std::abs(ly) <= half_width_;
+    }
+
+    // Distance along the ray to the footprint, by slab intersection in the opponent's frame, or range if it misses
+    double raycast(double x, double y, double angle, double range) const {
+        double ox, oy;
+        toLocal(x, y, ox, oy);
+        const double dx = std::cos(angle - pose_.theta);
+        const double dy = std::sin(angle - pose_.theta);
+
+        double t_min = 0;
+        double t_max = range;
+        const double origin[2] = { ox, oy };
+        const double direction[2] = { dx, dy };
+        const double half[2] = { half_length_, half_width_ };
+        for (int axis = 0; axis < 2; axis++) {
+            if (std::abs(direction[axis]) < 1e-12) {
+                if (std::abs(origin[axis]) > half[axis]) {
+                    return range;
+                }
+                continue;
+            }
+            double t0 = (-half[axis] - origin[axis]) / direction[axis];
+            double t1 = (half[axis] - origin[axis]) / direction[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            t_min = std::max(t_min, t0);
+            t_max = std::min(t_max, t1);
+            if (t_min > t_max) {
+                return range;
+            }
+        }
+        return t_min;
+    }
+
+    const rr::Pose& pose() const {
+        return pose_;
+    }
+
+  private:
+    void toLocal(double x, double y, double& lx, double& ly) const {
+        const double c = std::cos(pose_.theta);
+        const double s = std::sin(pose_.theta);
+        lx = c * (x - pose_.x) + s * (y - pose_.y);
+        ly = -s * (x - pose_.x) + c * (y - pose_.y);
+    }
+
+    std::vector<TrajectoryPoint> trajectory_;
+    double delay_;
+    double half_length_;
+    double half_width_;
+    rr::Pose pose_{ 0, 0, 0 };
+};
+
+/**
+ * Track images are textures on a plane of the given size centered at the given pose, as in rr_gazebo's worlds, with
+ * the first row at the plane's +y edge. Painted lines are brighter than the asphalt, and every pixel above the
+ * threshold marks the cell it falls in.
+ */
+bool loadTrackImage(const Options& options, World& world) {
+    cv::Mat image = cv::imread(options.track_image, cv::IMREAD_GRAYSCALE);
+    if (image.empty()) {
+        std::fprintf(stderr, "could not read %s\n", options.track_image.c_str());
+        return false;
+    }
+
+    const double half_diagonal = std::hypot(options.track_width_m, options.track_height_m) / 2;
+    world.allocate(options.track_pose.x - half_diagonal, options.track_pose.y - half_diagonal,
+                   options.track_pose.x + half_diagonal, options.track_pose.y + half_diagonal, options.resolution);
+
+    const double pixel_x = options.track_width_m / image.cols;
+    const double pixel_y = options.track_height_m / image.rows;
+    const double c = std::cos(options.track_pose.theta);
+    const double s = std::sin(options.track_pose.theta);
+    for (int row = 0; row < image.rows; row++) {
+        const auto* pixel = image.ptr<uint8_t>(row);
+        const double ly = options.track_height_m / 2 - (row + 0.5) * pixel_y;
+        for (int col = 0; col < image.cols; col++) {
+            if (pixel[col] > options.line_threshold) {
+                const double lx = (col + 0.5) * pixel_x - options.track_width_m / 2;
+                world.mark(options.track_pose.x + c * lx - s * ly, options.track_pose.y + s * lx + c * ly);
+            }
+        }
+    }
+    return true;
+}
+
+// Walls on both sides of a centerline trajectory, closed into a loop when its ends are within a track width
+bool loadTrackCsv(const Options& options, World& world, std::vector<TrajectoryPoint>& centerline) {
+    if (!loadTrajectory(options.track_csv, centerline)) {
+        return false;
+    }
+
+    const double margin = options.track_width + options.range;
+    double min_x = centerline.front().pose.x, max_x = min_x;
+    double min_y = centerline.front().pose.y, max_y = min_y;
+    for (const auto& p : centerline) {
+        min_x = std::min(min_x, p.pose.x);
+        max_x = std::max(max_x, p.pose.x);
+        min_y = std::min(min_y, p.pose.y);
+        max_y = std::max(max_y, p.pose.y);
+    }
+    world.allocate(min_x - margin, min_y - margin, max_x + margin, max_y + margin, options.resolution);
+
+    const size_t n = centerline.size();
+    const auto& first = centerline.front().pose;
+    const auto& last = centerline.back().pose;
+    const bool closed = std::hypot(last.x - first.x, last.y - first.y) < options.track_width;
+
+    std::vector<std::pair<double, double>> left, right;
+    for (size_t i = 0; i < n; i++) {
+        const auto& prev = centerline[i > 0 ? i - 1 : (closed ? n - 1 : 0)].pose;
+        const auto& next = centerline[i + 1 < n ? i + 1 : (closed ? 0 : n - 1)].pose;
+        const double heading = std::atan2(next.y - prev.y, next.x - prev.x);
+        const double nx = -std::sin(heading) * options.track_width / 2;
+        const double ny = std::cos(heading) * options.track_width / 2;
+        const auto& p = centerline[i].pose;
+        left.emplace_back(p.x + nx, p.y + ny);
+        right.emplace_back(p.x - nx, p.y - ny);
+    }
+    for (const auto* wall : { &left, &right }) {
+        for (size_t i = 0; i + 1 < n; i++) {
+            world.markSegment((*wall)[i].first, (*wall)[i].second, (*wall)[i + 1].first, (*wall)[i + 1].second);
+        }
+        if (closed) {
+            world.markSegment(wall->back().first, wall->back().second, wall->front().first, wall->front().second);
+        }
+    }
+    return true;
+}
+
+// Scan hits as a robot frame cloud, like the obstacle clouds the planner subscribes to
+Cloud scan(const World& world, const std::vector<Opponent>& opponents, const rr::Pose& pose, const Options& options) {
+    Cloud cloud;
+    for (int i = 0; i < options.beams; i++) {
+        const double bearing = -M_PI + 2 * M_PI * i / options.beams;
+        const double angle = pose.theta + bearing;
+        double distance = world.raycast(pose.x, pose.y, angle, options.range);
+        for (const auto& opponent : opponents) {
+            distance = std::min(distance, opponent.raycast(pose.x, pose.y, angle, distance));
+        }
+        if (distance < options.range) {
+            cloud.push_back(pcl::PointXYZ(distance * std::cos(bearing), distance * std::sin(bearing), 0));
+        }
+    }
+    return cloud;
+}
+
+// Rasterizes a robot frame cloud into a grid covering the local map, with the grid frame equal to the robot frame
+nav_msgs::OccupancyGridPtr rasterize(const Cloud& cloud, const VehicleConfig& config) {
+    const rr::Rectangle& limits = config.map_limits;
+    const double resolution = config.map_resolution;
+    nav_msgs::OccupancyGridPtr grid(new nav_msgs::OccupancyGrid);
+    grid->header.frame_id = "base_footprint";
+    grid->info.resolution = resolution;
+    grid->info.width = static_cast<unsigned int>(std::round((limits.max_x - limits.min_x) / resolution));
+    grid->info.height = static_cast<unsigned int>(std::round((limits.max_y - limits.min_y) / resolution));
+    grid->info.origin.position.x = limits.min_x;
+    grid->info.origin.position.y = limits.min_y;
+    grid->info.origin.orientation.w = 1;
+    grid->data.assign(grid->info.width * grid->info.height, 0);
+
+    for (const auto& p : cloud) {
+        auto mx = static_cast<int>(std::floor((p.x - limits.min_x) / resolution));
+        auto my = static_cast<int>(std::floor((p.y - limits.min_y) / resolution));
+        if (mx >= 0 && my >= 0 && mx < static_cast<int>(grid->info.width) && my < static_cast<int>(grid->info.height)) {
+            grid->data[my * grid->info.width + mx] = 100;
+        }
+    }
+    return grid;
+}
+
+std::unique_ptr<rr::MapCostInterface> makeMap(const std::string& type, const VehicleConfig& config) {
+    if (type == "obstacle_points") {
+        return std::make_unique<rr::NearestPointCache>(config.map_limits, config.hitbox, 0.2, 1.5);
+    } else if (type == "inflation_map") {
+        return std::make_unique<rr::InflationMap>(config.hitbox, 50);
+    } else if (type == "distance_map") {
+        return std::make_unique<rr::DistanceMap>(config.hitbox, 5.0, 0.3, 0.6);
+    }
+    return nullptr;
+}
+
+void setMap(rr::MapCostInterface& map, const std::string& type, const Cloud& cloud, const VehicleConfig& config) {
+    if (type == "obstacle_points") {
+        static_cast<rr::NearestPointCache&>(map).SetMap(cloud);
+        return;
+    }
+    tf::Transform map_from_base;
+    map_from_base.setIdentity();
+    if (type == "inflation_map") {
+        static_cast<rr::InflationMap&>(map).SetMap(rasterize(cloud, config), map_from_base);
+    } else {
+        static_cast<rr::DistanceMap&>(map).SetMap(rasterize(cloud, config), map_from_base);
+    }
+}
+
+std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> makeOptimizer(const VehicleConfig& config) {
+    if (config.optimizer == "annealing") {
+        rr::AnnealingOptimizer<ctrl_dim>::Params params;
+        params.annealing_steps = 1000;
+        params.temperature_end = 0.1;
+        params.stddev_start << 0.2, 0.5;
+        params.acceptance_scale = 0.02;
+        return std::make_unique<rr::AnnealingOptimizer<ctrl_dim>>(params);
+    }
+    rr::HillClimbOptimizer<ctrl_dim>::Params params;
+    params.num_workers = 5;
+    params.num_restarts = 5;
+    params.local_optimum_tries = 30;
+    params.neighbor_stddev << 0.015, 1.0;
+    return std::make_unique<rr::HillClimbOptimizer<ctrl_dim>>(params);
+}
+
+// GlobalPath's cost with the true pose in place of tf, against the centerline
+class CenterlineCost {
+  public:
+    explicit CenterlineCost(const std::vector<TrajectoryPoint>& centerline) {
+        for (const auto& p : centerline) {
+            points_.emplace_back(p.pose.x, p.pose.y);
+        }
+        cum_dist_ = rr::CumulativeDistances(points_);
+    }
+
+    // Once per planning cycle, like GlobalPath::PreProcess
+    void setPose(const rr::Pose& pose) {
+        pose_ = pose;
+        if (points_.size() >= 2) {
+            start_ = rr::ClosestPointIndex(points_, Eigen::Vector2d(pose.x, pose.y));
+        }
+    }
+
+    double operator()(const std::vector<rr::PathPoint>& plan) const {
+        if (points_.size() < 2) {
+            return 0.0;
+        }
+
+        const double c = std::cos(pose_.theta);
+        const double s = std::sin(pose_.theta);
+        std::vector<Eigen::Vector2d> sample(plan.size());
+        std::transform(plan.begin(), plan.end(), sample.begin(), [&](const rr::PathPoint& p) {
+            return Eigen::Vector2d(pose_.x + c * p.pose.x - s * p.pose.y, pose_.y + s * p.pose.x + c * p.pose.y);
+        });
+        return rr::GlobalPathDeviation(points_, cum_dist_, start_, sample, dtw_window_factor);
+    }
+
+  private:
+    static constexpr double dtw_window_factor = 0.25;  // global_path_cost/dtw_window_factor in planner_sim.yaml
+
+    std::vector<Eigen::Vector2d> points_;
+    std::vector<double> cum_dist_;
+    rr::Pose pose_{ 0, 0, 0 };
+    size_t start_ = 0;
+};
+
+// Samples the hitbox outline at the world's resolution, which is enough to catch one cell thick lines
+bool inCollision(const World& world, const std::vector<Opponent>& opponents, const rr::Rectangle& hitbox,
+                 const rr::Pose& pose, double resolution) {
+    const double c = std::cos(pose.theta);
+    const double s = std::sin(pose.theta);
+    auto hit = [&](double lx, double ly) {
+        const double x = pose.x + c * lx - s * ly;
+        const double y = pose.y + s * lx + c * ly;
+        return world.occupied(x, y) ||
+               std::any_of(opponents.begin(), opponents.end(), [&](const Opponent& o) { return o.contains(x, y); });
+    };
+    const int nx = std::max(1, static_cast<int>(std::ceil((hitbox.max_x - hitbox.min_x) / resolution)));
+    const int ny = std::max(1, static_cast<int>(std::ceil((hitbox.max_y - hitbox.min_y) / resolution)));
+    for (int i = 0; i <= nx; i++) {
+        const double lx = hitbox.min_x + (hitbox.max_x - hitbox.min_x) * i / nx;
+        if (hit(lx, hitbox.min_y) || hit(lx, hitbox.max_y)) {
+            return true;
+        }
+    }
+    for (int i = 0; i <= ny; i++) {
+        const double ly = hitbox.min_y + (hitbox.max_y - hitbox.min_y) * i / ny;
+        if (hit(hitbox.min_x, ly) || hit(hitbox.max_x, ly)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Result simulate(const Options& options, const VehicleConfig& config, const std::string& map_type, const World& world,
+                const std::vector<TrajectoryPoint>& centerline, std::vector<Opponent>& opponents, std::FILE* log) {
+    Result result;
+    auto map = makeMap(map_type, config);
+    auto optimizer = makeOptimizer(config);
+
+    // The planner's view of the car, reset to the true state every cycle as the effector tracker would
+    auto steer_model = std::make_shared<rr::LinearTrackingFilter>(config.steer);
+    auto speed_model = std::make_shared<rr::LinearTrackingFilter>(config.speed);
+    rr::BicycleModel vehicle(config.wheel_base, config.max_lateral_accel, config.segment_size, config.segment_dt,
+                             steer_model, speed_model);
+    // The true car moves by the same kinematics, stepped at the physics rate
+    rr::BicycleModel truth(config.wheel_base, config.max_lateral_accel, config.segment_size, physics_dt, steer_model,
+                           speed_model);
+    CenterlineCost global_path_cost(centerline);
+
+    rr::LinearTrackingFilter steer = config.steer;
+    rr::LinearTrackingFilter speed = config.speed;
+    rr::Pose pose = options.start;
+
+    const double max_speed = speed_model->GetValMax();
+    rr::CostFunction<ctrl_dim> cost_fn = [&](const rr::Controls<ctrl_dim>& controls) -> double {
+        rr::TrajectoryRollout rollout;
+        vehicle.RollOutPath(controls, rollout);
+        double global_path_costs = config.k_global_path_cost > 0 ? global_path_cost(rollout.path) : 0.0;
+        return rr::PathCost(rollout.path, map->DistanceCost(rollout.path), config.weights, max_speed,
+                            config.k_global_path_cost * global_path_costs);
+    };
+
+    rr::Matrix<ctrl_dim, 2> ctrl_limits;
+    ctrl_limits.row(0) << steer_model->GetValMin(), steer_model->GetValMax();
+    ctrl_limits.row(1) << speed_model->GetValMin(), speed_model->GetValMax();
+
+    rr::Controls<ctrl_dim> controls(ctrl_dim, config.n_segments);
+    controls.setZero();
+
+    double t = 0;
+    double next_plan = 0;
+    double lap_start = 0;
+    double lap_distance = 0;
+    bool colliding = false;
+    const auto wall_start = Clock::now();
+    while (t < options.max_time && static_cast<int>(result.lap_times.size()) < options.laps) {
+        for (auto& opponent : opponents) {
+            opponent.update(t);
+        }
+
+        if (t >= next_plan) {
+            next_plan += options.plan_period;
+            steer_model->Reset(steer.GetValue(), t);
+            speed_model->Reset(speed.GetValue(), t);
+
+            const auto plan_start = Clock::now();
+            setMap(*map, map_type, scan(world, opponents, pose, options), config);
+            global_path_cost.setPose(pose);
+            controls = optimizer->Optimize(cost_fn, controls, ctrl_limits);
+            result.plan_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - plan_start).count());
+
+            // Like the planner node, a plan that collides keeps the previous command
+            rr::TrajectoryRollout rollout;
+            vehicle.RollOutPath(controls, rollout);
+            std::vector<double> map_costs = map->DistanceCost(rollout.path);
+            if (std::any_of(map_costs.begin(), map_costs.end(), [](double c) { return c < 0; })) {
+                result.no_path++;
+            } else {
+                speed.SetTarget(rollout.apply_speed);
+                steer.SetTarget(rollout.apply_steering * config.steering_gain);
+            }
+        }
+
+        steer.UpdateRawDT(physics_dt);
+        speed.UpdateRawDT(physics_dt);
+        truth.StepKinematics(rr::PathPoint{ pose, steer.GetValue(), speed.GetValue(), t }, pose);
+        pose.theta = wrapAngle(pose.theta);
+        t += physics_dt;
+        lap_distance += std::abs(speed.GetValue()) * physics_dt;
+        result.distance += std::abs(speed.GetValue()) * physics_dt;
+
+        // A contact counts once however long it lasts
+        const bool hit = inCollision(world, opponents, config.hitbox, pose, options.resolution);
+        if (hit && !colliding) {
+            result.collisions++;
+        }
+        colliding = hit;
+
+        if (lap_distance > min_lap_distance &&
+            std::hypot(pose.x - options.start.x, pose.y - options.start.y) < options.lap_radius) {
+            result.lap_times.push_back(t - lap_start);
+            lap_start = t;
+            lap_distance = 0;
+        }
+
+        if (log) {
+            std::fprintf(log, "%.3f,%.3f,%.3f,%.4f,%.3f,%.4f,%d\n", t, pose.x, pose.y, pose.theta, speed.GetValue(),
+                         steer.GetValue(), hit ? 1 : 0);
+        }
+    }
+    result.sim_time = t;
+    result.wall_time = std::chrono::duration<double>(Clock::now() - wall_start).count();
+    return result;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+double mean(const std::vector<double>& values) {
+    return values.empty() ? 0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+void printResult(const Options& options, const Result& r) {
+    const double best_lap = r.lap_times.empty() ? 0 : *std::min_element(r.lap_times.begin(), r.lap_times.end());
+    const double mean_speed = r.sim_time > 0 ? r.distance / r.sim_time : 0;
+    const double real_time_factor = r.wall_time > 0 ? r.sim_time / r.wall_time : 0;
+    if (options.csv) {
+        std::printf("laps,mean_lap_s,best_lap_s,collisions,no_path,plan_p50_ms,plan_p99_ms,mean_speed,sim_s,wall_s,"
+                    "real_time_factor\n");
+        std::printf("%zu,%.3f,%.3f,%d,%d,%.3f,%.3f,%.3f,%.2f,%.2f,%.2f\n", r.lap_times.size(), mean(r.lap_times),
+                    best_lap, r.collisions, r.no_path, percentile(r.plan_ms, 0.5), percentile(r.plan_ms, 0.99),
+                    mean_speed, r.sim_time, r.wall_time, real_time_factor);
+        return;
+    }
+    for (size_t i = 0; i < r.lap_times.size(); i++) {
+        std::printf("lap %-3zu %8.2f s\n", i + 1, r.lap_times[i]);
+    }
+    std::printf("laps              %zu (mean %.2f s, best %.2f s)\n", r.lap_times.size(), mean(r.lap_times), best_lap);
+    std::printf("collisions        %d\n", r.collisions);
+    std::printf("no path           %d of %zu plans\n", r.no_path, r.plan_ms.size());
+    std::printf("planning          p50 %.2f ms, p99 %.2f ms\n", percentile(r.plan_ms, 0.5),
+                percentile(r.plan_ms, 0.99));
+    std::printf("mean speed        %.2f m/s\n", mean_speed);
+    std::printf("time              %.1f s simulated in %.1f s, %.1fx real time\n", r.sim_time, r.wall_time,
+                real_time_factor);
+}
+
+int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s (--track_image FILE --track_size W H [--track_pose X Y YAW] [--line_threshold N]\n"
+                 "          | --track_csv FILE --track_width W)\n"
+                 "          [--opponent FILE]... [--opponent_delay S] [--opponent_size L W]\n"
+                 "          [--vehicle iarrc|evgp] [--map obstacle_points|inflation_map|distance_map]\n"
+                 "          [--start X Y YAW] [--laps N] [--max_time S] [--plan_period S]\n"
+                 "          [--beams N] [--range M] [--resolution M] [--lap_radius M] [--log FILE] [--csv]\n"
+                 "the global path cost term needs the centerline of --track_csv and is left out on a --track_image\n",
+                 program);
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto values = [&](int n) { return i + n < argc; };
+        if (arg == "--track_image" && values(1)) {
+            options.track_image = argv[++i];
+        } else if (arg == "--track_size" && values(2)) {
+            options.track_width_m = std::atof(argv[++i]);
+            options.track_height_m = std::atof(argv[++i]);
+        } else if (arg == "--track_pose" && values(3)) {
+            options.track_pose.x = std::atof(argv[++i]);
+            options.track_pose.y = std::atof(argv[++i]);
+            options.track_pose.theta = std::atof(argv[++i]);
+        } else if (arg == "--line_threshold" && values(1)) {
+            options.line_threshold = std::atoi(argv[++i]);
+        } else if (arg == "--track_csv" && values(1)) {
+            options.track_csv = argv[++i];
+        } else if (arg == "--track_width" && values(1)) {
+            options.track_width = std::atof(argv[++i]);
+        } else if (arg == "--opponent" && values(1)) {
+            options.opponents.emplace_back(argv[++i]);
+        } else if (arg == "--opponent_delay" && values(1)) {
+            options.opponent_delay = std::atof(argv[++i]);
+        } else if (arg == "--opponent_size" && values(2)) {
+            options.opponent_length = std::atof(argv[++i]);
+            options.opponent_width = std::atof(argv[++i]);
+        } else if (arg == "--vehicle" && values(1)) {
+            options.vehicle = argv[++i];
+        } else if (arg == "--map" && values(1)) {
+            options.map = argv[++i];
+        } else if (arg == "--start" && values(3)) {
+            options.has_start = true;
+            options.start.x = std::atof(argv[++i]);
+            options.start.y = std::atof(argv[++i]);
+            options.start.theta = std::atof(argv[++i]);
+        } else if (arg == "--laps" && values(1)) {
+            options.laps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max_time" && values(1)) {
+            options.max_time = std::atof(argv[++i]);
+        } else if (arg == "--plan_period" && values(1)) {
+            options.plan_period = std::max(physics_dt, std::atof(argv[++i]));
+        } else if (arg == "--beams" && values(1)) {
+            options.beams = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--range" && values(1)) {
+            options.range = std::atof(argv[++i]);
+        } else if (arg == "--resolution" && values(1)) {
+            options.resolution = std::atof(argv[++i]);
+        } else if (arg == "--lap_radius" && values(1)) {
+            options.lap_radius = std::atof(argv[++i]);
+        } else if (arg == "--log" && values(1)) {
+            options.log = argv[++i];
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (options.vehicle != "iarrc" && options.vehicle != "evgp") {
+        return usage(argv[0]);
+    }
+    const VehicleConfig config = options.vehicle == "evgp" ? evgpConfig() : iarrcConfig();
+    const std::string map_type = options.map.empty() ? config.map : options.map;
+    if (!makeMap(map_type, config) || options.resolution <= 0) {
+        return usage(argv[0]);
+    }
+
+    World world;
+    std::vector<TrajectoryPoint> centerline;
+    if (!options.track_image.empty() && options.track_width_m > 0 && options.track_height_m > 0) {
+        if (!loadTrackImage(options, world)) {
+            return 1;
+        }
+    } else if (!options.track_csv.empty() && options.track_width > 0) {
+        if (!loadTrackCsv(options, world, centerline)) {
+            return 1;
+        }
+    } else {
+        return usage(argv[0]);
+    }
+
+    // Without a start pose, start on the centerline facing along it
+    if (!options.has_start && !centerline.empty()) {
+        const rr::Pose& first = centerline[0].pose;
+        const rr::Pose& second = centerline[1].pose;
+        options.start = rr::Pose(first.x, first.y, std::atan2(second.y - first.y, second.x - first.x));
+    }
+
+    std::vector<Opponent> opponents;
+    for (const auto& path : options.opponents) {
+        std::vector<TrajectoryPoint> trajectory;
+        if (!loadTrajectory(path, trajectory)) {
+            return 1;
+        }
+        opponents.emplace_back(std::move(trajectory), options.opponent_delay, options.opponent_length,
+                               options.opponent_width);
+    }
+
+    std::FILE* log = nullptr;
+    if (!options.log.empty()) {
+        log = std::fopen(options.log.c_str(), "w");
+        if (!log) {
+            std::fprintf(stderr, "could not write %s\n", options.log.c_str());
+            return 1;
+        }
+        std::fprintf(log, "t,x,y,theta,speed,steer,collision\n");
+    }
+
+    printResult(options, simulate(options, config, map_type, world, centerline, opponents, log));
+    if (log) {
+        std::fclose(log);
+    }
+    return 0;
+}
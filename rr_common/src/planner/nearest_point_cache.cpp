@@ -9,7 +9,26 @@ namespace rr {
 NearestPointCache::NearestPointCache(ros::NodeHandle nh)
       : points_storage_(), map_limits_(ros::NodeHandle(nh, "map_limits")), hitbox_(ros::NodeHandle(nh, "hitbox")) {
     assertions::getParam(nh, "cache_resolution", cache_resolution_, { assertions::greater(0.0) });
+    InitCache();
 
+    std::string obstacle_cloud_topic;
+    assertions::getParam(nh, "input_cloud_topic", obstacle_cloud_topic);
+    map_sub_ = nh.subscribe(obstacle_cloud_topic, 1, &NearestPointCache::SetMapMessage, this);
+
+    assertions::getParam(nh, "distance_decay_factor", dist_decay_, { assertions::greater(0.0) });
+}
+
+NearestPointCache::NearestPointCache(const rr::Rectangle& map_limits, const rr::Rectangle& hitbox,
+                                     double cache_resolution, double distance_decay_factor)
+      : points_storage_()
+      , cache_resolution_(cache_resolution)
+      , map_limits_(map_limits)
+      , dist_decay_(distance_decay_factor)
+      , hitbox_(hitbox) {
+    InitCache();
+}
+
+void NearestPointCache::InitCache() {
     cache_size_x_ = static_cast<int>((map_limits_.max_x - map_limits_.min_x) / cache_resolution_);
     cache_size_y_ = static_cast<int>((map_limits_.max_y - map_limits_.min_y) / cache_resolution_);
 
@@ -26,12 +45,6 @@ NearestPointCache::NearestPointCache(ros::NodeHandle nh)
     double half_x = (hitbox_.max_x - hitbox_.min_x) / 2.;
     double half_y = (hitbox_.max_y - hitbox_.min_y) / 2.;
     hitbox_corner_dist_ = std::sqrt(half_x * half_x + half_y * half_y);
-
-    std::string obstacle_cloud_topic;
-    assertions::getParam(nh, "input_cloud_topic", obstacle_cloud_topic);
-    map_sub_ = nh.subscribe(obstacle_cloud_topic, 1, &NearestPointCache::SetMapMessage, this);
-
-    assertions::getParam(nh, "distance_decay_factor", dist_decay_, { assertions::greater(0.0) });
 }
 
 inline double dist(const NearestPointCache::point_t& p1, const NearestPointCache::point_t& p2) {
@@ -47,7 +60,20 @@ void NearestPointCache::SetMapMessage(const sensor_msgs::PointCloud2ConstPtr& cl
 
     points_storage_.clear();
     pcl::fromROSMsg(*cloud_msg, points_storage_);
+    map_stamp_ = cloud_msg->header.stamp;
+    BuildCache();
+}
+
+void NearestPointCache::SetMap(const pcl::PointCloud<point_t>& cloud) {
+    if (!accepting_updates_) {
+        return;
+    }
+
+    points_storage_ = cloud;
+    BuildCache();
+}
 
+void NearestPointCache::BuildCache() {
     // remove points in collision with robot
     std::remove_if(points_storage_.begin(), points_storage_.end(),
                    [this](const auto& point) { return hitbox_.PointInside(point.x, point.y); });
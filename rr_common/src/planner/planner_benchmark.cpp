@@ -0,0 +1,425 @@
+/**
+ * Offline planner benchmark. Runs the optimizers and map cost implementations against synthetic obstacle layouts
+ * and maps pulled out of bag files, then reports planning latency percentiles, candidate paths scored per second and
+ * the cost of the chosen path. Nothing here talks to a ROS master, so it runs anywhere the package builds.
+ *
+ * Usage:
+ *   rosrun rr_common planner_benchmark [--iterations N] [--optimizer annealing|hill_climbing|all]
+ *                                      [--map obstacle_points|inflation_map|distance_map|all]
+ *                                      [--bag FILE [--cloud_topic TOPIC] [--grid_topic TOPIC] [--max_bag_maps N]]
+ *                                      [--no_synthetic] [--csv]
+ *
+ * Vehicle, cost and optimizer settings follow rr_iarrc/conf/planner_obstacle_avoidance.yaml so the numbers are
+ * comparable to what the car runs.
+ */
+
+#include <nav_msgs/OccupancyGrid.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <rr_common/planning/annealing_optimizer.h>
+#include <rr_common/planning/bicycle_model.h>
+#include <rr_common/planning/distance_map.h>
+#include <rr_common/planning/hill_climb_optimizer.h>
+#include <rr_common/planning/inflation_map.h>
+#include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/path_cost.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <rr_common/linear_tracking_filter.hpp>
+#include <string>
+
+namespace {
+
+constexpr int ctrl_dim = 2;
+constexpr int n_segments = 3;
+
+using Cloud = pcl::PointCloud<pcl::PointXYZ>;
+using Clock = std::chrono::steady_clock;
+
+// Extent of synthetic maps and of the nearest point cache, in the robot frame
+const rr::Rectangle map_limits(-5, 10, -7.5, 7.5);
+const rr::Rectangle hitbox(-0.17, 0.62, -0.15, 0.15);
+constexpr double grid_resolution = 0.05;
+constexpr double point_spacing = 0.05;
+
+const rr::PathCostWeights cost_weights{ 1.0, 0.2, 0.0, 0.5, 1000 };
+
+struct Scenario {
+    std::string name;
+    Cloud cloud;                        // obstacles in the robot frame
+    nav_msgs::OccupancyGridPtr grid;    // the same obstacles as an occupancy grid
+    tf::Transform map_from_base;        // robot pose in the grid's frame
+};
+
+struct Options {
+    int iterations = 200;
+    std::string optimizer = "all";
+    std::string map = "all";
+    std::string bag;
+    std::string cloud_topic = "/current_obstacles";
+    std::string grid_topic = "/local_mapper/costmap/costmap";
+    int max_bag_maps = 20;
+    bool synthetic = true;
+    bool csv = false;
+};
+
+struct Result {
+    std::vector<double> latencies_ms;
+    std::vector<double> final_costs;
+    size_t candidates = 0;
+    double optimize_seconds = 0;
+    double map_build_ms = 0;
+    int collisions = 0;
+};
+
+void addSegment(Cloud& cloud, double x0, double y0, double x1, double y1) {
+    int n = std::max(1, static_cast<int>(std::ceil(std::hypot(x1 - x0, y1 - y0) / point_spacing)));
+    for (int i = 0; i <= n; i++) {
+        double t = static_cast<double>(i) / n;
+        cloud.push_back(pcl::PointXYZ(x0 + t * (x1 - x0), y0 + t * (y1 - y0), 0));
+    }
+}
+
+void addCone(Cloud& cloud, double x, double y) {
+    constexpr double radius = 0.15;
+    constexpr int n = 12;
+    for (int i = 0; i < n; i++) {
+        double angle = 2 * M_PI * i / n;
+        cloud.push_back(pcl::PointXYZ(x + radius * std::cos(angle), y + radius * std::sin(angle), 0));
+    }
+}
+
+// Rasterizes a robot frame cloud into a grid covering map_limits, with the grid frame equal to the robot frame
+nav_msgs::OccupancyGridPtr rasterize(const Cloud& cloud) {
+    nav_msgs::OccupancyGridPtr grid(new nav_msgs::OccupancyGrid);
+    grid->header.frame_id = "base_footprint";
+    grid->info.resolution = grid_resolution;
+    grid->info.width = static_cast<unsigned int>(std::round((map_limits.max_x - map_limits.min_x) / grid_resolution));
+    grid->info.height = static_cast<unsigned int>(std::round((map_limits.max_y - map_limits.min_y) / grid_resolution));
+    grid->info.origin.position.x = map_limits.min_x;
+    grid->info.origin.position.y = map_limits.min_y;
+    grid->info.origin.orientation.w = 1;
+    grid->data.assign(grid->info.width * grid->info.height, 0);
+
+    for (const auto& p : cloud) {
+        auto mx = static_cast<int>(std::floor((p.x - map_limits.min_x) / grid_resolution));
+        auto my = static_cast<int>(std::floor((p.y - map_limits.min_y) / grid_resolution));
+        if (mx >= 0 && my >= 0 && mx < static_cast<int>(grid->info.width) && my < static_cast<int>(grid->info.height)) {
+            grid->data[my * grid->info.width + mx] = 100;
+        }
+    }
+    return grid;
+}
+
+Scenario makeScenario(const std::string& name, Cloud cloud) {
+    Scenario scenario;
+    scenario.name = name;
+    scenario.grid = rasterize(cloud);
+    scenario.cloud = std::move(cloud);
+    scenario.map_from_base.setIdentity();
+    return scenario;
+}
+
+std::vector<Scenario> syntheticScenarios() {
+    std::vector<Scenario> scenarios;
+
+    Cloud corridor;
+    addSegment(corridor, -1, 1.5, 10, 1.5);
+    addSegment(corridor, -1, -1.5, 10, -1.5);
+    scenarios.push_back(makeScenario("corridor", corridor));
+
+    Cloud slalom;
+    addSegment(slalom, -1, 2.5, 10, 2.5);
+    addSegment(slalom, -1, -2.5, 10, -2.5);
+    for (int i = 1; i <= 4; i++) {
+        addCone(slalom, 2.0 * i, (i % 2 == 0) ? -0.7 : 0.7);
+    }
+    scenarios.push_back(makeScenario("slalom", slalom));
+
+    Cloud cone_field;
+    std::mt19937 rand_gen(7);
+    std::uniform_real_distribution<double> cone_x(1.5, 10), cone_y(-4, 4);
+    for (int i = 0; i < 25; i++) {
+        addCone(cone_field, cone_x(rand_gen), cone_y(rand_gen));
+    }
+    scenarios.push_back(makeScenario("cone_field", cone_field));
+
+    Cloud dead_end;
+    addSegment(dead_end, -1, 1.5, 5, 1.5);
+    addSegment(dead_end, -1, -1.5, 5, -1.5);
+    addSegment(dead_end, 5, -1.5, 5, 1.5);
+    scenarios.push_back(makeScenario("dead_end", dead_end));
+
+    return scenarios;
+}
+
+// Local costmaps roll with the robot, so the robot is taken to be at the grid's center
+Scenario scenarioFromGrid(const std::string& name, const nav_msgs::OccupancyGridPtr& grid) {
+    Scenario scenario;
+    scenario.name = name;
+    scenario.grid = grid;
+
+    const auto& info = grid->info;
+    double center_x = info.origin.position.x + info.width * info.resolution / 2;
+    double center_y = info.origin.position.y + info.height * info.resolution / 2;
+    scenario.map_from_base = tf::Transform(tf::createIdentityQuaternion(), tf::Vector3(center_x, center_y, 0));
+
+    for (unsigned int my = 0; my < info.height; my++) {
+        for (unsigned int mx = 0; mx < info.width; mx++) {
+            auto cost = static_cast<uint8_t>(grid->data[my * info.width + mx]);
+            if (cost >= 99 && cost <= 254) {
+                scenario.cloud.push_back(pcl::PointXYZ(info.origin.position.x + (mx + 0.5) * info.resolution - center_x,
+                                                       info.origin.position.y + (my + 0.5) * info.resolution - center_y,
+                                                       0));
+            }
+        }
+    }
+    return scenario;
+}
+
+// Obstacle clouds are assumed to already be in the robot frame, as /current_obstacles is
+Scenario scenarioFromCloud(const std::string& name, const sensor_msgs::PointCloud2& msg) {
+    Cloud cloud;
+    pcl::fromROSMsg(msg, cloud);
+    return makeScenario(name, cloud);
+}
+
+std::vector<Scenario> bagScenarios(const Options& options) {
+    std::vector<Scenario> scenarios;
+    rosbag::Bag bag(options.bag, rosbag::bagmode::Read);
+    rosbag::View view(bag, rosbag::TopicQuery({ options.cloud_topic, options.grid_topic }));
+
+    // Spread the maps taken over the whole bag instead of the first few seconds
+    size_t stride = std::max<size_t>(1, view.size() / std::max(1, options.max_bag_maps));
+    size_t index = 0;
+    for (const rosbag::MessageInstance& m : view) {
+        if (index++ % stride != 0 || static_cast<int>(scenarios.size()) >= options.max_bag_maps) {
+            continue;
+        }
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), "@%.1f", (m.getTime() - view.getBeginTime()).toSec());
+        if (auto grid = m.instantiate<nav_msgs::OccupancyGrid>()) {
+            scenarios.push_back(scenarioFromGrid("bag_grid" + std::string(stamp), grid));
+        } else if (auto cloud = m.instantiate<sensor_msgs::PointCloud2>()) {
+            scenarios.push_back(scenarioFromCloud("bag_cloud" + std::string(stamp), *cloud));
+        }
+    }
+    return scenarios;
+}
+
+std::unique_ptr<rr::MapCostInterface> makeMap(const std::string& type, const Scenario& scenario, double& build_ms) {
+    auto start = Clock::now();
+    std::unique_ptr<rr::MapCostInterface> map;
+    if (type == "obstacle_points") {
+        auto cache = std::make_unique<rr::NearestPointCache>(map_limits, hitbox, 0.2, 1.5);
+        start = Clock::now();
+        cache->SetMap(scenario.cloud);
+        map = std::move(cache);
+    } else if (type == "inflation_map") {
+        auto inflation = std::make_unique<rr::InflationMap>(hitbox, 50);
+        start = Clock::now();
+        inflation->SetMap(scenario.grid, scenario.map_from_base);
+        map = std::move(inflation);
+    } else if (type == "distance_map") {
+        auto distance = std::make_unique<rr::DistanceMap>(hitbox, 5.0, 0.1, 0.3);
+        start = Clock::now();
+        distance->SetMap(scenario.grid, scenario.map_from_base);
+        map = std::move(distance);
+    }
+    build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return map;
+}
+
+std::unique_ptr<rr::PlanningOptimizer<ctrl_dim>> makeOptimizer(const std::string& type) {
+    if (type == "annealing") {
+        rr::AnnealingOptimizer<ctrl_dim>::Params params;
+        params.annealing_steps = 1000;
+        params.temperature_end = 0.1;
+        params.stddev_start << 0.2, 0.5;
+        params.acceptance_scale = 0.02;
+        return std::make_unique<rr::AnnealingOptimizer<ctrl_dim>>(params);
+    } else if (type == "hill_climbing") {
+        rr::HillClimbOptimizer<ctrl_dim>::Params params;
+        params.num_workers = 4;
+        params.num_restarts = 5;
+        params.local_optimum_tries = 30;
+        params.neighbor_stddev << 0.05, 0.3;
+        return std::make_unique<rr::HillClimbOptimizer<ctrl_dim>>(params);
+    }
+    return nullptr;
+}
+
+Result run(const Scenario& scenario, const std::string& map_type, const std::string& optimizer_type, int iterations) {
+    Result result;
+    auto map = makeMap(map_type, scenario, result.map_build_ms);
+    auto optimizer = makeOptimizer(optimizer_type);
+
+    auto steer_model = std::make_shared<rr::LinearTrackingFilter>(0, -0.44, 0.44, -1.2, 1.2);
+    auto speed_model = std::make_shared<rr::LinearTrackingFilter>(1.0, -1.0, 1.5, -6.0, 6.0);
+    rr::BicycleModel vehicle(0.485, 2.5, 20, 0.05, steer_model, speed_model);
+
+    const double max_speed = speed_model->GetValMax();
+    std::atomic<size_t> candidates(0);
+    rr::CostFunction<ctrl_dim> cost_fn = [&](const rr::Controls<ctrl_dim>& controls) -> double {
+        candidates++;
+        rr::TrajectoryRollout rollout;
+        vehicle.RollOutPath(controls, rollout);
+        return rr::PathCost(rollout.path, map->DistanceCost(rollout.path), cost_weights, max_speed);
+    };
+
+    rr::Matrix<ctrl_dim, 2> ctrl_limits;
+    ctrl_limits.row(0) << steer_model->GetValMin(), steer_model->GetValMax();
+    ctrl_limits.row(1) << speed_model->GetValMin(), speed_model->GetValMax();
+
+    // Warm start from the previous plan like the planner node does
+    rr::Controls<ctrl_dim> controls(ctrl_dim, n_segments);
+    controls.setZero();
+    for (int i = 0; i < iterations; i++) {
+        candidates = 0;
+        auto start = Clock::now();
+        controls = optimizer->Optimize(cost_fn, controls, ctrl_limits);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        result.latencies_ms.push_back(seconds * 1000);
+        result.optimize_seconds += seconds;
+        result.candidates += candidates;
+
+        rr::TrajectoryRollout rollout;
+        vehicle.RollOutPath(controls, rollout);
+        std::vector<double> map_costs = map->DistanceCost(rollout.path);
+        result.final_costs.push_back(rr::PathCost(rollout.path, map_costs, cost_weights, max_speed));
+        if (std::any_of(map_costs.begin(), map_costs.end(), [](double c) { return c < 0; })) {
+            result.collisions++;
+        }
+    }
+    return result;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+double mean(const std::vector<double>& values) {
+    return values.empty() ? 0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+void printResult(const Options& options, const std::string& scenario, const std::string& map,
+                 const std::string& optimizer, const Result& r) {
+    double p50 = percentile(r.latencies_ms, 0.5);
+    double p99 = percentile(r.latencies_ms, 0.99);
+    double rate = r.optimize_seconds > 0 ? r.candidates / r.optimize_seconds : 0;
+    double collision_rate = r.latencies_ms.empty() ? 0 : static_cast<double>(r.collisions) / r.latencies_ms.size();
+    if (options.csv) {
+        std::printf("%s,%s,%s,%.3f,%.3f,%.0f,%.4f,%.3f,%.3f\n", scenario.c_str(), map.c_str(), optimizer.c_str(), p50,
+                    p99, rate, mean(r.final_costs), collision_rate, r.map_build_ms);
+    } else {
+        std::printf("%-18s %-16s %-14s %9.2f %9.2f %12.0f %12.4f %6.1f%% %9.2f\n", scenario.c_str(), map.c_str(),
+                    optimizer.c_str(), p50, p99, rate, mean(r.final_costs), 100 * collision_rate, r.map_build_ms);
+    }
+    std::fflush(stdout);
+}
+
+std::vector<std::string> expand(const std::string& choice, const std::vector<std::string>& all) {
+    return choice == "all" ? all : std::vector<std::string>{ choice };
+}
+
+int usage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [--iterations N] [--optimizer annealing|hill_climbing|all]\n"
+                 "          [--map obstacle_points|inflation_map|distance_map|all]\n"
+                 "          [--bag FILE [--cloud_topic TOPIC] [--grid_topic TOPIC] [--max_bag_maps N]]\n"
+                 "          [--no_synthetic] [--csv]\n",
+                 program);
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--iterations" && has_value) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--optimizer" && has_value) {
+            options.optimizer = argv[++i];
+        } else if (arg == "--map" && has_value) {
+            options.map = argv[++i];
+        } else if (arg == "--bag" && has_value) {
+            options.bag = argv[++i];
+        } else if (arg == "--cloud_topic" && has_value) {
+            options.cloud_topic = argv[++i];
+        } else if (arg == "--grid_topic" && has_value) {
+            options.grid_topic = argv[++i];
+        } else if (arg == "--max_bag_maps" && has_value) {
+            options.max_bag_maps = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--no_synthetic") {
+            options.synthetic = false;
+        } else if (arg == "--csv") {
+            options.csv = true;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    const auto maps = expand(options.map, { "obstacle_points", "inflation_map", "distance_map" });
+    const auto optimizers = expand(options.optimizer, { "annealing", "hill_climbing" });
+    for (const auto& map : maps) {
+        if (map != "obstacle_points" && map != "inflation_map" && map != "distance_map") {
+            return usage(argv[0]);
+        }
+    }
+    for (const auto& optimizer : optimizers) {
+        if (!makeOptimizer(optimizer)) {
+            return usage(argv[0]);
+        }
+    }
+
+    std::vector<Scenario> scenarios;
+    if (options.synthetic) {
+        scenarios = syntheticScenarios();
+    }
+    if (!options.bag.empty()) {
+        try {
+            auto recorded = bagScenarios(options);
+            std::move(recorded.begin(), recorded.end(), std::back_inserter(scenarios));
+        } catch (const rosbag::BagException& e) {
+            std::fprintf(stderr, "could not read %s: %s\n", options.bag.c_str(), e.what());
+            return 1;
+        }
+    }
+    if (scenarios.empty()) {
+        std::fprintf(stderr, "no scenarios to run\n");
+        return 1;
+    }
+
+    if (options.csv) {
+        std::printf("scenario,map,optimizer,p50_ms,p99_ms,candidates_per_s,mean_cost,collision_rate,map_build_ms\n");
+    } else {
+        std::printf("%-18s %-16s %-14s %9s %9s %12s %12s %7s %9s\n", "scenario", "map", "optimizer", "p50 ms", "p99 ms",
+                    "cand/s", "mean cost", "coll", "build ms");
+    }
+
+    for (const auto& scenario : scenarios) {
+        for (const auto& map : maps) {
+            for (const auto& optimizer : optimizers) {
+                printResult(options, scenario.name, map, optimizer, run(scenario, map, optimizer, options.iterations));
+            }
+        }
+    }
+    return 0;
+}
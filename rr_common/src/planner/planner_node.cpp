@@ -3,6 +3,7 @@
 #include <pcl/PCLPointCloud2.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <ros/ros.h>
+#include <rr_common/instrumentation.h>
 #include <rr_common/planning/annealing_optimizer.h>
 #include <rr_common/planning/bicycle_model.h>
 #include <rr_common/planning/distance_map.h>
@@ -12,6 +13,8 @@
 #include <rr_common/planning/inflation_map.h>
 #include <rr_common/planning/map_cost_interface.h>
 #include <rr_common/planning/nearest_point_cache.h>
+#include <rr_common/planning/path_cost.h>
+#include <rr_common/tracing.h>
 #include <rr_msgs/speed.h>
 #include <rr_msgs/steering.h>
 #include <visualization_msgs/Marker.h>
@@ -51,17 +54,24 @@ reverse_state_t reverse_state;
 double steering_gain;
 double viz_path_scale;
 
-double total_planning_time;
-size_t total_plans;
+std::unique_ptr<rr::NodeMetrics> g_metrics;
+rr::NodeMetrics::Counter* g_collisions;
+rr::NodeMetrics::Counter* g_reversals;
+rr::NodeMetrics::Output* g_plan_output;
 
 void update_messages(double speed, double angle) {
-    auto now = ros::Time::now();
+    // Commands carry the stamp of the sensor data behind the map they were planned on, so everything downstream can
+    // tell how old that data is, or the time they are sent if the map has no stamp
+    ros::Time origin = g_map_cost_interface->GetMapStamp();
+    if (origin.isZero()) {
+        origin = ros::Time::now();
+    }
 
     speed_message->speed = speed;
-    speed_message->header.stamp = now;
+    speed_message->header.stamp = origin;
 
     steer_message->angle = angle;
-    steer_message->header.stamp = now;
+    steer_message->header.stamp = origin;
 }
 
 void publish_path_viz(const std::vector<rr::PathPoint>& path_rollout) {
@@ -101,6 +111,7 @@ void publish_path_viz(const std::vector<rr::PathPoint>& path_rollout) {
 
 void generatePath() {
     auto max_speed = g_speed_model->GetValMax();
+    const rr::PathCostWeights path_cost_weights{ k_map_cost_, k_speed_, k_steering_, k_angle_, collision_penalty_ };
 
     rr::CostFunction<ctrl_dim> cost_fn = [&](const rr::Controls<ctrl_dim>& controls) -> double {
         rr::TrajectoryRollout rollout;
@@ -109,24 +120,7 @@ void generatePath() {
 
         std::vector<double> map_costs = g_map_cost_interface->DistanceCost(path);
         double global_path_costs = g_global_path_cost->CalculateCost(path);
-        double cost = 0;
-        double inflator = 1;
-        double gamma = 1.01;
-        for (size_t i = 0; i < rollout.path.size(); ++i) {
-            cost *= gamma;
-            inflator *= gamma;
-            if (map_costs[i] >= 0) {
-                cost += k_map_cost_ * map_costs[i];
-                cost += k_speed_ * std::pow(max_speed - path[i].speed, 2);
-                cost += k_steering_ * std::abs(path[i].steer);
-                cost += k_angle_ * std::abs(path[i].pose.theta);
-            } else {
-                cost += collision_penalty_ * (path.size() - i);
-                break;
-            }
-        }
-        cost += k_global_path_cost_ * global_path_costs;
-        return cost / inflator;
+        return rr::PathCost(path, map_costs, path_cost_weights, max_speed, k_global_path_cost_ * global_path_costs);
     };
 
     rr::Matrix<ctrl_dim, 2> ctrl_limits;
@@ -179,8 +173,10 @@ void generatePath() {
 
     if (REVERSE == reverse_state) {
         update_messages(reverse_speed, 0);
+        g_reversals->add();
         ROS_WARN_STREAM("Planner reversing");
     } else if (plan.has_collision) {
+        g_collisions->add();
         ROS_WARN_STREAM("Planner: no path found but not reversing; reusing previous message");
     } else {
         g_speed_model->Update(plan.rollout.apply_speed, now.toSec());
@@ -189,6 +185,7 @@ void generatePath() {
 
     speed_pub.publish(speed_message);
     steer_pub.publish(steer_message);
+    g_plan_output->published();
 
     if (viz_pub.getNumSubscribers() > 0) {
         publish_path_viz(plan.rollout.path);
@@ -197,6 +194,7 @@ void generatePath() {
 
 int main(int argc, char** argv) {
     ros::init(argc, argv, "planner");
+    rr::startTracing(ros::this_node::getName());
 
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
@@ -265,8 +263,15 @@ int main(int argc, char** argv) {
     g_effector_tracker =
           std::make_unique<rr::EffectorTracker>(ros::NodeHandle(nhp, "effector_tracker"), speed_message, steer_message);
 
-    total_planning_time = 0;
-    total_plans = 0;
+    // Planning has to finish within one cycle of the loop below
+    constexpr double loop_rate = 30;
+    g_metrics = std::make_unique<rr::NodeMetrics>(nh);
+    rr::NodeMetrics::Stage& planning_stage = g_metrics->stage("planning");
+    planning_stage.setDeadline(1.0 / loop_rate);
+    rr::NodeMetrics::Input& map_input = g_metrics->input("map");
+    g_plan_output = &g_metrics->output("plan");
+    g_collisions = &g_metrics->counter("no_path");
+    g_reversals = &g_metrics->counter("reversing");
 
     g_steer_model->Reset(0, ros::Time::now().toSec());
     g_speed_model->Reset(0, ros::Time::now().toSec());
@@ -275,7 +280,7 @@ int main(int argc, char** argv) {
 
     ROS_INFO("planner initialized");
 
-    ros::Rate rate(30);
+    ros::Rate rate(loop_rate);
     while (ros::ok()) {
         rate.sleep();
         ros::spinOnce();
@@ -284,17 +289,13 @@ int main(int argc, char** argv) {
         g_speed_model->Update(g_effector_tracker->getSpeed(), ros::Time::now().toSec());
 
         if (g_map_cost_interface->IsMapUpdated()) {
-            auto start = ros::WallTime::now();
+            map_input.received(g_map_cost_interface->GetMapStamp());
+            rr::TraceSpan span("planner", g_map_cost_interface->GetMapStamp());
+            rr::StageTimer timer(planning_stage);
 
             g_global_path_cost->PreProcess();
             generatePath();
             g_map_cost_interface->SetMapStale();
-
-            double seconds = (ros::WallTime::now() - start).toSec();
-            total_planning_time += seconds;
-            total_plans++;
-            double sec_avg = total_planning_time / total_plans;
-            ROS_INFO("PlanningOptimizer took %0.1fms, average %0.2fms", seconds * 1000, sec_avg * 1000);
         }
     }
 
@@ -9,6 +9,8 @@
 #include <pcl_conversions/pcl_conversions.h>
 #include <pcl_ros/transforms.h>
 #include <ros/ros.h>
+#include <rr_common/instrumentation.h>
+#include <rr_common/tracing.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <tf/transform_listener.h>
 
@@ -18,7 +20,8 @@ using cloud_ptr_t = pcl::PointCloud<pcl::PointXYZ>::Ptr;
 std::map<std::string, sensor_msgs::PointCloud2ConstPtr> cache;
 bool has_new_info;
 
-void cloudCallback(const sensor_msgs::PointCloud2ConstPtr& msg, std::string topic) {
+void cloudCallback(const sensor_msgs::PointCloud2ConstPtr& msg, std::string topic, rr::NodeMetrics::Input* input) {
+    input->received(msg->header);
     cache[topic] = msg;
     has_new_info = true;
 }
@@ -38,6 +41,7 @@ std::vector<std::string> split(const std::string& s, char delim) {
 
 int main(int argc, char** argv) {
     ros::init(argc, argv, "pointcloud_combiner");
+    rr::startTracing(ros::this_node::getName());
 
     ros::NodeHandle nh;
     ros::NodeHandle nh_private("~");
@@ -54,14 +58,17 @@ int main(int argc, char** argv) {
     auto topics = split(sourceList, ' ');
 
     std::vector<ros::Subscriber> partial_Subscribers;
+    rr::NodeMetrics metrics(nh);
 
     for (const auto& topic : topics) {
-        partial_Subscribers.push_back(
-              nh.subscribe<sensor_msgs::PointCloud2>(topic, 1, boost::bind(cloudCallback, _1, topic)));
+        partial_Subscribers.push_back(nh.subscribe<sensor_msgs::PointCloud2>(
+              topic, 1, boost::bind(cloudCallback, _1, topic, &metrics.input(topic))));
         ROS_INFO_STREAM("Mapper subscribed to " << topic);
     }
 
     auto combo_pub = nh.advertise<sensor_msgs::PointCloud2>(publishName, 1);
+    rr::NodeMetrics::Stage& combine_stage = metrics.stage("combine");
+    rr::NodeMetrics::Output& combo_output = metrics.output(publishName);
 
     // set up point reduction filter
     pcl::VoxelGrid<pcl::PointXYZ> filterVG;
@@ -76,6 +83,9 @@ int main(int argc, char** argv) {
         ros::spinOnce();
 
         if (has_new_info) {
+            rr::TraceSpan span("pointcloud_combiner", ros::Time());
+            rr::StageTimer timer(combine_stage);
+            ros::Time newest_stamp;
             combo_cloud->clear();
 
             for (std::pair<std::string, sensor_msgs::PointCloud2ConstPtr> entry_pair :
@@ -85,6 +95,7 @@ int main(int argc, char** argv) {
                 }
 
                 const auto& cloud_msg = *(entry_pair.second);
+                newest_stamp = std::max(newest_stamp, cloud_msg.header.stamp);
 
                 // convert from message to pcl pointcloud
                 pcl::PCLPointCloud2 pcl_pc2;
@@ -105,6 +116,8 @@ int main(int argc, char** argv) {
                 *(combo_cloud) += *transformed;
             }
 
+            span.setOrigin(newest_stamp);
+
             // make 2D
             for (auto& pt : combo_cloud->points) {
                 pt.z = 0;
@@ -118,9 +131,10 @@ int main(int argc, char** argv) {
                 pcl_conversions::fromPCL(combo_pc2, msg);
 
                 msg.header.frame_id = combinedFrame;
-                msg.header.stamp = ros::Time::now();
+                msg.header.stamp = newest_stamp;  // like the local mapper, the time of the most recent source
 
                 combo_pub.publish(msg);
+                combo_output.published();
             } else {
                 ROS_INFO("pointcloud empty");
             }
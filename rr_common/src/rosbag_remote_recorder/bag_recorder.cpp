@@ -0,0 +1,236 @@
+#include "bag_recorder.h"
+
+#include <sys/statvfs.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+namespace rr {
+
+namespace {
+
+std::string dateString() {
+    char buffer[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d-%H-%M-%S", std::localtime(&now));
+    return buffer;
+}
+
+uint64_t freeSpace(const std::string& path) {
+    const auto slash = path.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    struct statvfs stats;
+    if (statvfs(directory.c_str(), &stats) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(stats.f_bavail) * stats.f_frsize;
+}
+
+}  // namespace
+
+BagRecorder::BagRecorder(ros::NodeHandle nh, const Options& options) : options_(options) {
+    for (const std::string& name : options_.topics) {
+        auto topic = std::make_unique<Topic>();
+        topic->name = name;
+        auto rate = options_.max_rates.find(name);
+        if (rate != options_.max_rates.end() && rate->second > 0) {
+            topic->min_interval = ros::Duration(1.0 / rate->second);
+        }
+
+        Topic* topic_ptr = topic.get();
+        boost::function<void(const ros::MessageEvent<const topic_tools::ShapeShifter>&)> callback =
+              [this, topic_ptr](const ros::MessageEvent<const topic_tools::ShapeShifter>& event) {
+                  received(*topic_ptr, event);
+              };
+        topic->subscriber = nh.subscribe<topic_tools::ShapeShifter>(name, 100, callback);
+        topics_.push_back(std::move(topic));
+    }
+
+    writer_ = std::thread(&BagRecorder::run, this);
+}
+
+BagRecorder::~BagRecorder() {
+    for (auto& topic : topics_) {
+        topic->subscriber.shutdown();
+    }
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    changed_.notify_one();
+    writer_.join();
+}
+
+void BagRecorder::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recording_ = true;
+    }
+    changed_.notify_one();
+}
+
+void BagRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!recording_) {
+            return;
+        }
+        recording_ = false;
+        stop_time_ = ros::Time::now();
+    }
+    changed_.notify_one();
+}
+
+bool BagRecorder::recording() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return recording_;
+}
+
+void BagRecorder::received(Topic& topic, const ros::MessageEvent<const topic_tools::ShapeShifter>& event) {
+    const ros::Time now = ros::Time::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!topic.min_interval.isZero() && now - topic.last_queued < topic.min_interval) {
+        return;
+    }
+    if (!recording_ && options_.preroll <= 0) {
+        return;
+    }
+
+    const auto& message = event.getConstMessage();
+
+    /*
+     * While idle the queue holds the preroll after whatever a stopped bag has yet to write. It is trimmed to the
+     * preroll time, then by its oldest messages until the new one fits, so the moments right before start() are the
+     * ones kept when the preroll is more than the queue can hold.
+     */
+    if (!recording_) {
+        const ros::Time preroll_start = now - ros::Duration(options_.preroll);
+        auto oldest = std::find_if(queue_.begin(), queue_.end(),
+                                   [this](const QueuedMessage& queued) { return queued.time > stop_time_; });
+        while (oldest != queue_.end() &&
+               (oldest->time < preroll_start || queue_bytes_ + message->size() > options_.queue_size)) {
+            if (oldest->time >= preroll_start) {
+                preroll_evicted_++;
+            }
+            queue_bytes_ -= oldest->message->size();
+            oldest = queue_.erase(oldest);
+        }
+    }
+
+    if (queue_bytes_ + message->size() > options_.queue_size) {
+        if (recording_) {
+            dropped_++;
+        } else {
+            preroll_evicted_++;
+        }
+        return;
+    }
+    topic.last_queued = now;
+    queue_.push_back({ &topic.name, now, message, event.getConnectionHeaderPtr() });
+    queue_bytes_ += message->size();
+
+    if (recording_) {
+        changed_.notify_one();
+    }
+}
+
+void BagRecorder::run() {
+    bool open = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        changed_.wait(lock, [&] { return shutdown_ || recording_ != open || (open && !queue_.empty()); });
+
+        if (dropped_ > 0) {
+            ROS_WARN("[BagRecorder] Dropped %lu messages, the disk is not keeping up", dropped_);
+            dropped_ = 0;
+        }
+
+        if (recording_ && !open) {
+            if (preroll_evicted_ > 0) {
+                ROS_INFO("[BagRecorder] Preroll limited by queue_size, %lu older messages were left out",
+                         preroll_evicted_);
+                preroll_evicted_ = 0;
+            }
+            const bool separate = !options_.prefix.empty() && options_.prefix.back() != '/';
+            base_name_ = options_.prefix + (separate ? "_" : "") + dateString();
+            split_index_ = 0;
+            lock.unlock();
+            open = openBag();
+            lock.lock();
+            if (!open) {
+                recording_ = false;
+            }
+            continue;
+        }
+
+        if (open && !queue_.empty() && (recording_ || queue_.front().time <= stop_time_)) {
+            QueuedMessage queued = std::move(queue_.front());
+            queue_.pop_front();
+            queue_bytes_ -= queued.message->size();
+            lock.unlock();
+
+            try {
+                bag_.write(*queued.topic, queued.time, queued.message, queued.connection_header);
+            } catch (const rosbag::BagException& e) {
+                ROS_ERROR_STREAM("[BagRecorder] Writing " << *queued.topic << " failed: " << e.what());
+            }
+            if (options_.max_size > 0 && bag_.getSize() > options_.max_size) {
+                closeBag();
+                split_index_++;
+                open = openBag();
+            }
+
+            lock.lock();
+            if (!open) {
+                recording_ = false;
+            }
+            continue;
+        }
+
+        if (open && !recording_) {
+            lock.unlock();
+            closeBag();
+            lock.lock();
+            open = false;
+        }
+
+        if (shutdown_ && !open) {
+            return;
+        }
+    }
+}
+
+bool BagRecorder::openBag() {
+    bag_path_ = base_name_ + "_" + std::to_string(split_index_) + ".bag";
+
+    const uint64_t free_space = freeSpace(bag_path_);
+    if (free_space < options_.min_space) {
+        ROS_ERROR("[BagRecorder] Not recording %s, only %lu MB free", bag_path_.c_str(), free_space / (1024 * 1024));
+        return false;
+    }
+
+    // Written as .active until closed, as rosbag record does
+    try {
+        bag_.open(bag_path_ + ".active", rosbag::bagmode::Write);
+    } catch (const rosbag::BagException& e) {
+        ROS_ERROR("[BagRecorder] Failed to open %s: %s", bag_path_.c_str(), e.what());
+        return false;
+    }
+    bag_.setCompression(options_.compression);
+    bag_.setChunkThreshold(options_.chunk_size);
+    ROS_INFO("[BagRecorder] Recording to %s", bag_path_.c_str());
+    return true;
+}
+
+void BagRecorder::closeBag() {
+    bag_.close();
+    if (std::rename((bag_path_ + ".active").c_str(), bag_path_.c_str()) != 0) {
+        ROS_ERROR("[BagRecorder] Failed to rename %s.active", bag_path_.c_str());
+    }
+    ROS_INFO("[BagRecorder] Closed %s", bag_path_.c_str());
+}
+
+}  // namespace rr
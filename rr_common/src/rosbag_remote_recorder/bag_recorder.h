@@ -0,0 +1,98 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <topic_tools/shape_shifter.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rr {
+
+/**
+ * Records topics to bag files that are opened and closed on demand, without restarting the node. Topics are
+ * subscribed once, up front, so nothing is lost to subscribing when a recording starts, and the last few seconds
+ * before the start can be kept and written too.
+ *
+ * Callbacks only queue the serialized message they were given; a writer thread does all the file work. When the
+ * queue is full while recording, new messages are dropped and counted, so a slow disk never backs up into the
+ * subscriptions or the nodes publishing to them. While idle, the oldest of the preroll makes room instead.
+ */
+class BagRecorder {
+  public:
+    struct Options {
+        std::vector<std::string> topics;
+        std::string prefix;      // path and start of the file names, followed by the date
+        uint64_t max_size = 0;   // bytes in a file before continuing in the next, 0 for no limit
+        uint64_t min_space = 0;  // free bytes on the disk needed to start a file
+        rosbag::CompressionType compression = rosbag::compression::Uncompressed;
+        uint32_t chunk_size = 768 * 1024;         // compressed as a unit
+        size_t queue_size = 256 * 1024 * 1024;    // message bytes waiting to be written
+        double preroll = 0;                       // seconds of messages before start() that are recorded
+        std::map<std::string, double> max_rates;  // Hz, for topics that need not be recorded at full rate
+    };
+
+    BagRecorder(ros::NodeHandle nh, const Options& options);
+
+    // Finishes writing and closes the current bag, if any
+    ~BagRecorder();
+
+    // Starts a new bag, unless one is being recorded or still being written after stop()
+    void start();
+
+    // Closes the bag once the messages received before now are written to it
+    void stop();
+
+    bool recording() const;
+
+  private:
+    struct Topic {
+        std::string name;
+        ros::Duration min_interval;
+        ros::Time last_queued;
+        ros::Subscriber subscriber;
+    };
+
+    struct QueuedMessage {
+        const std::string* topic;
+        ros::Time time;
+        boost::shared_ptr<const topic_tools::ShapeShifter> message;
+        boost::shared_ptr<ros::M_string> connection_header;
+    };
+
+    void received(Topic& topic, const ros::MessageEvent<const topic_tools::ShapeShifter>& event);
+
+    // Writer thread
+    void run();
+    bool openBag();
+    void closeBag();
+
+    Options options_;
+    std::vector<std::unique_ptr<Topic>> topics_;
+
+    mutable std::mutex mutex_;  // guards everything up to the writer thread's own state
+    std::condition_variable changed_;
+    std::deque<QueuedMessage> queue_;
+    size_t queue_bytes_ = 0;
+    uint64_t dropped_ = 0;          // while recording, because the writer fell behind
+    uint64_t preroll_evicted_ = 0;  // while idle, to keep the newest of a preroll larger than the queue
+    bool recording_ = false;
+    ros::Time stop_time_;
+    bool shutdown_ = false;
+
+    // Only used by the writer thread
+    rosbag::Bag bag_;
+    std::string base_name_;
+    std::string bag_path_;
+    int split_index_ = 0;
+
+    std::thread writer_;
+};
+
+}  // namespace rr
@@ -0,0 +1,285 @@
+#include <ros/console.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <rr_common/tracing.h>
+#include <thread>
+#include <vector>
+
+namespace rr {
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    int64_t start_ns;
+    int64_t duration_ns;
+    int64_t origin_ns;
+    int64_t origin_age_ns;
+};
+
+/*
+ * Spans recorded by one thread, waiting for the writer thread. Only the owning thread pushes and only the writer
+ * drains, so the two indices are all the synchronization needed. A full ring drops new spans rather than block the
+ * stage being traced.
+ */
+class TraceRing {
+  public:
+    static constexpr uint64_t capacity = 4096;
+
+    explicit TraceRing(long tid) : tid(tid) {}
+
+    void push(const TraceEvent& event) {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == capacity) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events_[head % capacity] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void drain(const F& consume) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            consume(events_[tail % capacity]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    uint64_t takeDropped() {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+    const long tid;
+
+  private:
+    std::array<TraceEvent, capacity> events_;
+    std::atomic<uint64_t> head_{ 0 };
+    std::atomic<uint64_t> tail_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
+
+int64_t wallNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+          .count();
+}
+
+// Chrome trace timestamps are microseconds, printed with the nanoseconds as decimals
+void printMicros(FILE* file, int64_t ns) {
+    std::fprintf(file, "%" PRId64 ".%03d", ns / 1000, static_cast<int>(ns % 1000));
+}
+
+class TraceWriter {
+  public:
+    ~TraceWriter() {
+        stop();
+    }
+
+    void start(const std::string& node_name, const std::string& output_path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        file_ = std::fopen(output_path.c_str(), "w");
+        if (!file_) {
+            ROS_ERROR_STREAM("Tracing: could not open " << output_path);
+            return;
+        }
+        pid_ = static_cast<long>(getpid());
+        node_name_ = node_name;
+
+        // The JSON array format lets the closing bracket be missing, so a node that dies still leaves a usable trace
+        std::fputs("[\n", file_);
+        writeProcessName();
+        std::fputs(",\n", file_);
+
+        running_ = true;
+        enabled.store(true, std::memory_order_release);
+        thread_ = std::thread(&TraceWriter::run, this);
+        ROS_INFO_STREAM("Tracing to " << output_path);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            enabled.store(false);
+            running_ = false;
+        }
+
+        // Spans that saw tracing enabled are still being pushed, wait for them so the last drain gets every one
+        while (recording_.load() != 0) {
+            std::this_thread::yield();
+        }
+        wake_.notify_all();
+        thread_.join();
+
+        flush();
+
+        // Every entry is followed by a comma, replace the last one to close the array
+        std::fseek(file_, -2, SEEK_END);
+        std::fputs("\n]\n", file_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    void record(const TraceEvent& event) {
+        // Sequentially consistent with stop(), so either it sees this push in flight or this sees tracing disabled
+        recording_.fetch_add(1);
+        if (enabled.load()) {
+            thread_local std::shared_ptr<TraceRing> ring;
+            if (!ring) {
+                ring = std::make_shared<TraceRing>(static_cast<long>(syscall(SYS_gettid)));
+                std::lock_guard<std::mutex> lock(rings_mutex_);
+                rings_.push_back(ring);
+            }
+            ring->push(event);
+        }
+        recording_.fetch_sub(1);
+    }
+
+    std::atomic<bool> enabled{ false };
+
+  private:
+    std::atomic<int> recording_{ 0 };  // calls to record() in progress
+
+    std::mutex mutex_;  // guards running_
+    std::condition_variable wake_;
+    bool running_ = false;
+    std::thread thread_;
+
+    // Rings stay here after their thread exits so nothing it recorded is lost
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<TraceRing>> rings_;
+
+    // Only touched by the writer thread, or by stop() once it has joined
+    FILE* file_ = nullptr;
+    long pid_ = 0;
+    std::string node_name_;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            wake_.wait_for(lock, std::chrono::milliseconds(250));
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    void flush() {
+        std::vector<std::shared_ptr<TraceRing>> rings;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings = rings_;
+        }
+
+        uint64_t dropped = 0;
+        for (const auto& ring : rings) {
+            ring->drain([this, &ring](const TraceEvent& event) { writeEvent(event, ring->tid); });
+            dropped += ring->takeDropped();
+        }
+        std::fflush(file_);
+
+        if (dropped > 0) {
+            ROS_WARN_STREAM("Tracing: dropped " << dropped << " spans, the writer is falling behind");
+        }
+    }
+
+    void writeEvent(const TraceEvent& event, long tid) {
+        std::fprintf(file_, R"({"name":"%s","cat":"rr","ph":"X","ts":)", event.name);
+        printMicros(file_, event.start_ns);
+        std::fputs(R"(,"dur":)", file_);
+        printMicros(file_, event.duration_ns);
+        std::fprintf(file_, R"(,"pid":%ld,"tid":%ld)", pid_, tid);
+        if (event.origin_ns != 0) {
+            // Perfetto draws a flow through every span bound to the same id, i.e. every stage of one sample
+            std::fprintf(file_, R"(,"bind_id":"0x%)" PRIx64 R"(","flow_in":true,"flow_out":true)",
+                         static_cast<uint64_t>(event.origin_ns));
+            std::fprintf(file_, R"(,"args":{"origin":%.6f,"origin_age_ms":%.3f})", event.origin_ns * 1e-9,
+                         event.origin_age_ns * 1e-6);
+        }
+        std::fputs("},\n", file_);
+    }
+
+    void writeProcessName() {
+        std::fprintf(file_, R"({"name":"process_name","ph":"M","pid":%ld,"args":{"name":"%s"}})", pid_,
+                     node_name_.c_str());
+    }
+};
+
+TraceWriter& writer() {
+    static TraceWriter instance;
+    return instance;
+}
+
+}  // namespace
+
+void startTracing(const std::string& node_name) {
+    const char* dir = std::getenv("RR_TRACE_DIR");
+    if (!dir || *dir == '\0') {
+        return;
+    }
+
+    std::string file_name = node_name;
+    if (!file_name.empty() && file_name.front() == '/') {
+        file_name.erase(0, 1);
+    }
+    for (char& c : file_name) {
+        if (c == '/') {
+            c = '_';
+        }
+    }
+    startTracing(node_name, std::string(dir) + "/" + file_name + "." + std::to_string(getpid()) + ".json");
+}
+
+void startTracing(const std::string& node_name, const std::string& output_path) {
+    writer().start(node_name, output_path);
+}
+
+void stopTracing() {
+    writer().stop();
+}
+
+bool tracingEnabled() {
+    return writer().enabled.load(std::memory_order_relaxed);
+}
+
+TraceSpan::TraceSpan(const char* name, const ros::Time& origin)
+      : name_(name), start_ns_(-1), ros_start_ns_(0), origin_ns_(origin.toNSec()) {
+    if (tracingEnabled()) {
+        start_ns_ = wallNs();
+        ros_start_ns_ = ros::Time::now().toNSec();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (start_ns_ < 0 || !tracingEnabled()) {
+        return;
+    }
+    TraceEvent event{ name_, start_ns_, wallNs() - start_ns_, origin_ns_, 0 };
+    if (origin_ns_ != 0) {
+        event.origin_age_ns = ros_start_ns_ - origin_ns_;
+    }
+    writer().record(event);
+}
+
+void TraceSpan::setOrigin(const ros::Time& origin) {
+    origin_ns_ = origin.toNSec();
+}
+
+}  // namespace rr
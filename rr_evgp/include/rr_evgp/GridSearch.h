@@ -0,0 +1,53 @@
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+#include <opencv2/core/types.hpp>
+#include <optional>
+#include <vector>
+
+namespace rr {
+
+/*
+ * Least cost 8-connected path search over a grid. Stepping into a cell costs its value in the cost grid (plus a
+ * constant step cost). The search graph is kept as flat g-cost and parent index arrays, and the path is only
+ * built once the goal is reached.
+ */
+class GridSearch {
+  public:
+    enum class Mode {
+        DIJKSTRA,
+        ASTAR,  // Chebyshev distance times the smallest possible step cost, so still optimal
+    };
+
+    static const unsigned char FREE_SPACE = 0;
+    static const unsigned char OBSTACLE_SPACE = 255;
+
+    /*
+     * @param obstacleGrid CV_8UC1, FREE_SPACE or OBSTACLE_SPACE per cell
+     * @param costGrid CV_32FC1 non-negative cost of entering each cell, same size as obstacleGrid
+     * @param stepCost constant cost added to every step
+     */
+    GridSearch(const cv::Mat& obstacleGrid, const cv::Mat& costGrid, Mode mode = Mode::ASTAR, float stepCost = 0.0f);
+
+    // Points from the cell after start up to and including goal. Empty if there is no path.
+    std::vector<cv::Point> search(const cv::Point& start, const cv::Point& goal);
+
+    // Closest free cell to initPoint by breadth first search, if there is one
+    std::optional<cv::Point> getNearestFreePointBFS(const cv::Point& initPoint) const;
+
+  private:
+    cv::Mat obstacleGrid_;
+    cv::Mat costGrid_;
+    Mode mode_;
+    float stepCost_;
+    float minStepCost_;
+
+    // reused between searches
+    std::vector<float> gCost_;
+    std::vector<int> parent_;
+
+    bool isValidPoint(const cv::Point& pt) const;
+    float heuristic(int index, const cv::Point& goal) const;
+};
+
+}  // namespace rr
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <costmap_2d/costmap_2d.h>
+#include <sensor_msgs/LaserScan.h>
+
+#include <vector>
+
+namespace rr {
+
+/*
+ * Per-cell binary Bayes filter over laser scans, the state behind BinaryBayesFilterObstacleLayer. Each scan ray
+ * lowers the occupancy probability of the cells it passes through and raises it for obstacle_depth past the hit.
+ * Needs no ROS, so bag replays can drive it with a plain costmap_2d::Costmap2D.
+ */
+class BinaryBayesFilter {
+  public:
+    struct Params {
+        double prob_false_pos;
+        double prob_false_neg;
+        double prob_grid_prior;
+        double max_confidence;
+        double scan_range;
+        double obstacle_depth;  // assumed thickness of an observed obstacle point. Ray-trace this much farther
+    };
+
+    explicit BinaryBayesFilter(const Params& params);
+
+    // Pose of the lidar relative to the robot base
+    void setLidarOffset(double x, double y, double yaw);
+
+    /*
+     * Takes scan as the one to apply next, with the robot at (robot_x, robot_y, robot_yaw) in the grid frame, and
+     * grows the bounds to cover every cell it can touch.
+     */
+    void setScan(const sensor_msgs::LaserScanConstPtr& scan, const costmap_2d::Costmap2D& grid, double robot_x,
+                 double robot_y, double robot_yaw, double* min_x, double* min_y, double* max_x, double* max_y);
+
+    // Applies the current scan inside the cell bounds and writes the probabilities there into grid's costs
+    void updateCosts(costmap_2d::Costmap2D& grid, int min_cell_x, int min_cell_y, int max_cell_x, int max_cell_y);
+
+    // Resizes the probability grid to match grid, keeping the cells both have in common
+    void matchSize(const costmap_2d::Costmap2D& grid);
+
+    bool hasScan() const {
+        return scan_ != nullptr;
+    }
+
+  private:
+    Params params_;
+
+    std::vector<double> probs_;
+    std::vector<char> updates_;
+    sensor_msgs::LaserScanConstPtr scan_;
+    double lidar_x_;
+    double lidar_y_;
+    double lidar_yaw_;
+    double lidar_offset_x_;
+    double lidar_offset_y_;
+    double lidar_offset_yaw_;
+    unsigned int last_grid_size_x_;
+    unsigned int last_grid_size_y_;
+    double last_origin_x_;
+    double last_origin_y_;
+};
+
+}  // namespace rr
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <opencv2/core/mat.hpp>
+
+namespace rr {
+
+/*
+ * Zhang-Suen thinning of every nonzero region in a CV_8UC1 image, followed by staircase removal so the skeleton is
+ * 8-connected and one pixel wide. Returns an image the size of grid_in holding the skeleton.
+ */
+cv::Mat thinObstacles(const cv::Mat& grid_in);
+
+/*
+ * Removes branches shorter than min_branch_length (in pixels) from a skeleton made by thinObstacles.
+ */
+cv::Mat removeSmallBranches(const cv::Mat& img, const int min_branch_length);
+
+}  // namespace rr
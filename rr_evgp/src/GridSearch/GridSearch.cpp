@@ -0,0 +1,133 @@
+#include <rr_evgp/GridSearch.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <opencv2/core.hpp>
+#include <queue>
+
+namespace rr {
+
+namespace {
+
+const cv::Point kNeighborOffsets[] = { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 },
+                                       { 1, 0 },   { -1, 1 }, { 0, 1 },  { 1, 1 } };
+
+struct OpenEntry {
+    float f;  // g + heuristic
+    float g;  // g when pushed, stale if the cell has been reached cheaper since
+    int index;
+    bool operator>(const OpenEntry& other) const {
+        return f > other.f;
+    }
+};
+
+}  // namespace
+
+GridSearch::GridSearch(const cv::Mat& obstacleGrid, const cv::Mat& costGrid, Mode mode, float stepCost)
+      : obstacleGrid_(obstacleGrid), costGrid_(costGrid), mode_(mode), stepCost_(stepCost) {
+    CV_Assert(obstacleGrid_.type() == CV_8UC1 && costGrid_.type() == CV_32FC1 &&
+              obstacleGrid_.size() == costGrid_.size());
+
+    // the cheapest cell that can be stepped into bounds every step, which keeps the heuristic admissible
+    double minCost = 0.0;
+    cv::minMaxLoc(costGrid_, &minCost, nullptr, nullptr, nullptr, obstacleGrid_ == FREE_SPACE);
+    minStepCost_ = std::max(0.0f, static_cast<float>(minCost)) + stepCost_;
+}
+
+bool GridSearch::isValidPoint(const cv::Point& pt) const {
+    return pt.x >= 0 && pt.y >= 0 && pt.x < obstacleGrid_.cols && pt.y < obstacleGrid_.rows &&
+           obstacleGrid_.at<uchar>(pt) == FREE_SPACE;
+}
+
+float GridSearch::heuristic(int index, const cv::Point& goal) const {
+    if (mode_ == Mode::DIJKSTRA) {
+        return 0.0f;
+    }
+    int dx = std::abs(index % obstacleGrid_.cols - goal.x);
+    int dy = std::abs(index / obstacleGrid_.cols - goal.y);
+    return minStepCost_ * std::max(dx, dy);
+}
+
+std::vector<cv::Point> GridSearch::search(const cv::Point& start, const cv::Point& goal) {
+    if (!isValidPoint(start) || !isValidPoint(goal)) {
+        return {};
+    }
+
+    const int cols = obstacleGrid_.cols;
+    const int numCells = obstacleGrid_.rows * cols;
+    gCost_.assign(numCells, std::numeric_limits<float>::infinity());
+    parent_.assign(numCells, -1);
+
+    // no decrease-key, a cell is pushed again when it gets cheaper and the old entry is skipped when popped
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+    const int startIndex = start.y * cols + start.x;
+    const int goalIndex = goal.y * cols + goal.x;
+    gCost_[startIndex] = 0.0f;
+    open.push({ heuristic(startIndex, goal), 0.0f, startIndex });
+
+    while (!open.empty()) {
+        OpenEntry current = open.top();
+        open.pop();
+        if (current.g > gCost_[current.index]) {
+            continue;
+        }
+
+        if (current.index == goalIndex) {
+            std::vector<cv::Point> path;
+            for (int index = goalIndex; index != startIndex; index = parent_[index]) {
+                path.emplace_back(index % cols, index / cols);
+            }
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+
+        const cv::Point pt(current.index % cols, current.index / cols);
+        for (const cv::Point& offset : kNeighborOffsets) {
+            const cv::Point next = pt + offset;
+            if (!isValidPoint(next)) {
+                continue;
+            }
+            const int nextIndex = next.y * cols + next.x;
+            const float g = current.g + costGrid_.at<float>(next) + stepCost_;
+            if (g < gCost_[nextIndex]) {
+                gCost_[nextIndex] = g;
+                parent_[nextIndex] = current.index;
+                open.push({ g + heuristic(nextIndex, goal), g, nextIndex });
+            }
+        }
+    }
+    return {};  // no path found
+}
+
+// BFS from initPoint to find a free space nearby
+std::optional<cv::Point> GridSearch::getNearestFreePointBFS(const cv::Point& initPoint) const {
+    const cv::Rect rect(cv::Point(), obstacleGrid_.size());
+    if (!rect.contains(initPoint)) {
+        return std::nullopt;
+    }
+
+    std::queue<cv::Point> queue;
+    std::vector<bool> visited(obstacleGrid_.total(), false);
+    queue.push(initPoint);
+    visited[initPoint.y * obstacleGrid_.cols + initPoint.x] = true;
+
+    while (!queue.empty()) {
+        cv::Point currPoint = queue.front();
+        queue.pop();
+        if (obstacleGrid_.at<uchar>(currPoint) == FREE_SPACE) {
+            return currPoint;
+        }
+
+        for (const cv::Point& offset : kNeighborOffsets) {
+            cv::Point newPt = currPoint + offset;
+            if (rect.contains(newPt) && !visited[newPt.y * obstacleGrid_.cols + newPt.x]) {
+                visited[newPt.y * obstacleGrid_.cols + newPt.x] = true;
+                queue.push(newPt);
+            }
+        }
+    }
+    return std::nullopt;  // the whole grid is obstacles
+}
+
+}  // namespace rr
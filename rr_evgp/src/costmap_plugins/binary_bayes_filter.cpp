@@ -0,0 +1,175 @@
+#include <ros/console.h>
+#include <rr_evgp/binary_bayes_filter.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace rr {
+
+BinaryBayesFilter::BinaryBayesFilter(const Params& params)
+      : params_(params)
+      , lidar_x_(0)
+      , lidar_y_(0)
+      , lidar_yaw_(0)
+      , lidar_offset_x_(0)
+      , lidar_offset_y_(0)
+      , lidar_offset_yaw_(0)
+      , last_grid_size_x_(0)
+      , last_grid_size_y_(0)
+      , last_origin_x_(0)
+      , last_origin_y_(0) {}
+
+void BinaryBayesFilter::setLidarOffset(double x, double y, double yaw) {
+    lidar_offset_x_ = x;
+    lidar_offset_y_ = y;
+    lidar_offset_yaw_ = yaw;
+}
+
+void BinaryBayesFilter::setScan(const sensor_msgs::LaserScanConstPtr& scan, const costmap_2d::Costmap2D& grid,
+                                double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y,
+                                double* max_x, double* max_y) {
+    lidar_x_ = robot_x + (lidar_offset_x_ * std::cos(robot_yaw) - lidar_offset_y_ * std::sin(robot_yaw));
+    lidar_y_ = robot_y + (lidar_offset_x_ * std::sin(robot_yaw) + lidar_offset_y_ * std::cos(robot_yaw));
+    lidar_yaw_ = robot_yaw + lidar_offset_yaw_;
+
+    scan_ = scan;
+    double resolution = grid.getResolution();
+
+    double angle = scan_->angle_min;
+    for (double range : scan_->ranges) {
+        if (std::isinf(range)) {
+            range = params_.scan_range;
+        }
+        double wx = lidar_x_ + range * std::cos(lidar_yaw_ + angle);
+        double wy = lidar_y_ + range * std::sin(lidar_yaw_ + angle);
+        angle += scan_->angle_increment;
+
+        double fudge = 2 * resolution;
+        if (wx - fudge < *min_x)
+            *min_x = std::max(grid.getOriginX(), wx - fudge);
+        if (wx + fudge > *max_x)
+            *max_x = std::min(grid.getOriginX() + grid.getSizeInMetersX(), wx + fudge);
+        if (wy - fudge < *min_y)
+            *min_y = std::max(grid.getOriginY(), wy - fudge);
+        if (wy + fudge > *max_y)
+            *max_y = std::min(grid.getOriginY() + grid.getSizeInMetersY(), wy + fudge);
+    }
+}
+
+void BinaryBayesFilter::updateCosts(costmap_2d::Costmap2D& master_grid, int min_cell_x, int min_cell_y,
+                                    int max_cell_x, int max_cell_y) {
+    if (!scan_) {
+        return;
+    }
+
+    const double resolution = master_grid.getResolution();
+    const double world_min_x = master_grid.getOriginX();
+    const double world_max_x = world_min_x + master_grid.getSizeInMetersX();
+    const double world_min_y = master_grid.getOriginY();
+    const double world_max_y = world_min_y + master_grid.getSizeInMetersY();
+
+    for (int mx = min_cell_x; mx < max_cell_x; mx++) {
+        for (int my = min_cell_y; my < max_cell_y; my++) {
+            updates_[master_grid.getIndex(mx, my)] = -1;
+        }
+    }
+
+    double angle = scan_->angle_min;
+    for (double raw_range : scan_->ranges) {
+        bool is_hit = (!std::isinf(raw_range) && raw_range <= params_.scan_range);
+        double clear_range = is_hit ? raw_range : params_.scan_range;
+        double obstacle_range = clear_range + params_.obstacle_depth;
+        double wx = lidar_x_ + obstacle_range * std::cos(lidar_yaw_ + angle);
+        double wy = lidar_y_ + obstacle_range * std::sin(lidar_yaw_ + angle);
+
+        if (wx < world_min_x || wx >= world_max_x || wy < world_min_y || wy >= world_max_y) {
+            ROS_WARN_THROTTLE(1.0, "trying to scan outside the map");
+            continue;
+        }
+
+        const double step_size = resolution * 0.25;
+        const double step_x = step_size * std::cos(lidar_yaw_ + angle);
+        const double step_y = step_size * std::sin(lidar_yaw_ + angle);
+        int mx, my;
+        double d = 0;
+        double march_x = lidar_x_;
+        double march_y = lidar_y_;
+        while (d < clear_range) {
+            master_grid.worldToMapNoBounds(march_x, march_y, mx, my);
+            updates_[master_grid.getIndex(mx, my)] = 0;
+            d += step_size;
+            march_x += step_x;
+            march_y += step_y;
+        }
+        if (is_hit) {
+            do {
+                master_grid.worldToMapNoBounds(march_x, march_y, mx, my);
+                updates_[master_grid.getIndex(mx, my)] = 1;
+                d += step_size;
+                march_x += step_x;
+                march_y += step_y;
+            } while (d <= obstacle_range);
+        }
+
+        angle += scan_->angle_increment;
+    }
+
+    uint8_t* costmap_data = master_grid.getCharMap();
+    for (int mx = min_cell_x; mx < max_cell_x; mx++) {
+        for (int my = min_cell_y; my < max_cell_y; my++) {
+            const auto i = master_grid.getIndex(mx, my);
+            const char update = updates_[i];
+
+            if (update >= 0) {
+                double p_prior = probs_[i];
+                if (update > 0) {  // hit
+                    double p_occupied = (1.0 - params_.prob_false_neg) * p_prior;
+                    double p_empty = params_.prob_false_pos * (1.0 - p_prior);
+                    probs_[i] = std::min(p_occupied / (p_occupied + p_empty), params_.max_confidence);
+                } else {  // cleared
+                    double p_occupied = params_.prob_false_neg * p_prior;
+                    double p_empty = (1.0 - params_.prob_false_pos) * (1.0 - p_prior);
+                    probs_[i] = std::max(p_occupied / (p_occupied + p_empty), 1.0 - params_.max_confidence);
+                }
+            }
+
+            costmap_data[i] = static_cast<uint8_t>(probs_[i] * 255);
+        }
+    }
+}
+
+void BinaryBayesFilter::matchSize(const costmap_2d::Costmap2D& master_grid) {
+    if (last_grid_size_x_ == master_grid.getSizeInCellsX() && last_grid_size_y_ == master_grid.getSizeInCellsY() &&
+        last_origin_x_ == master_grid.getOriginX() && last_origin_y_ == master_grid.getOriginY()) {
+        return;
+    }
+
+    std::vector<double> new_probs(master_grid.getSizeInCellsX() * master_grid.getSizeInCellsY(),
+                                  params_.prob_grid_prior);
+    int old_origin_new_mx, old_origin_new_my;
+    master_grid.worldToMapNoBounds(last_origin_x_, last_origin_y_, old_origin_new_mx, old_origin_new_my);
+    int new_start_x = std::max(0, old_origin_new_mx);
+    int new_start_y = std::max(0, old_origin_new_my);
+    int old_start_x = std::max(0, -old_origin_new_mx);
+    int old_start_y = std::max(0, -old_origin_new_my);
+    int old_end_x = std::min(last_grid_size_x_, -old_origin_new_mx + master_grid.getSizeInCellsX());
+    int old_end_y = std::min(last_grid_size_y_, -old_origin_new_my + master_grid.getSizeInCellsY());
+
+    if (old_end_x > old_start_x && old_end_y > old_start_y) {
+        for (int old_my = old_start_y, new_my = new_start_y; old_my < old_end_y; old_my++, new_my++) {
+            size_t old_i = old_my * last_grid_size_x_;
+            size_t new_i = new_my * master_grid.getSizeInCellsX();
+            std::copy(probs_.begin() + old_i + old_start_x, probs_.begin() + old_i + old_end_x,
+                      new_probs.begin() + new_i + new_start_x);
+        }
+    }
+
+    probs_ = std::move(new_probs);
+    last_grid_size_x_ = master_grid.getSizeInCellsX();
+    last_grid_size_y_ = master_grid.getSizeInCellsY();
+    last_origin_x_ = master_grid.getOriginX();
+    last_origin_y_ = master_grid.getOriginY();
+    updates_.resize(probs_.size());
+}
+
+}  // namespace rr
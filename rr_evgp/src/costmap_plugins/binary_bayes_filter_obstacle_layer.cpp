@@ -4,10 +4,14 @@
 #include <parameter_assertions/assertions.h>
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
+#include <rr_common/instrumentation.h>
+#include <rr_evgp/binary_bayes_filter.h>
 #include <sensor_msgs/LaserScan.h>
 #include <tf2/utils.h>
 #include <tf2_ros/transform_listener.h>
 
+#include <atomic>
+
 namespace rr {
 
 class BinaryBayesFilterObstacleLayer : public costmap_2d::Layer {
@@ -22,17 +26,23 @@ class BinaryBayesFilterObstacleLayer : public costmap_2d::Layer {
 
         assertions::Assertion<double> assert_is_prob([](double x) { return x > 0 && x < 1; }, "probability in (0, 1) "
                                                                                               "range");
-        assertions::getParam(private_nh, "prob_false_pos", prob_false_pos_, { assert_is_prob });
-        assertions::getParam(private_nh, "prob_false_neg", prob_false_neg_, { assert_is_prob });
-        assertions::getParam(private_nh, "prob_grid_prior", prob_grid_prior_, { assert_is_prob });
-        assertions::getParam(private_nh, "max_confidence", max_prob_, { assert_is_prob });
-        assertions::getParam(private_nh, "scan_range", scan_range_, { assertions::greater<double>(0) });
-        assertions::getParam(private_nh, "obstacle_depth", obstacle_depth_, { assertions::greater<double>(0) });
+        BinaryBayesFilter::Params params{};
+        assertions::getParam(private_nh, "prob_false_pos", params.prob_false_pos, { assert_is_prob });
+        assertions::getParam(private_nh, "prob_false_neg", params.prob_false_neg, { assert_is_prob });
+        assertions::getParam(private_nh, "prob_grid_prior", params.prob_grid_prior, { assert_is_prob });
+        assertions::getParam(private_nh, "max_confidence", params.max_confidence, { assert_is_prob });
+        assertions::getParam(private_nh, "scan_range", params.scan_range, { assertions::greater<double>(0) });
+        assertions::getParam(private_nh, "obstacle_depth", params.obstacle_depth, { assertions::greater<double>(0) });
+        filter_ = std::make_unique<BinaryBayesFilter>(params);
 
         std::string scan_topic;
         assertions::getParam(private_nh, "scan_topic", scan_topic);
         scan_sub_ = global_nh.subscribe(scan_topic, 1, &BinaryBayesFilterObstacleLayer::scanCB, this);
 
+        metrics_ = std::make_unique<NodeMetrics>(private_nh, ros::this_node::getName() + "/" + getName());
+        scan_input_ = &metrics_->input(scan_topic);
+        update_stage_ = &metrics_->stage("update_costs");
+
         std::string lidar_frame, robot_base_frame;
         assertions::getParam(private_nh, "lidar_frame", lidar_frame);
         assertions::getParam(costmap_nh, "robot_base_frame", robot_base_frame);
@@ -44,11 +54,9 @@ class BinaryBayesFilterObstacleLayer : public costmap_2d::Layer {
         }
 
         auto transform_stamped = tf_->lookupTransform(robot_base_frame, lidar_frame, ros::Time(0), ros::Duration(1.0));
-        lidar_offset_x_ = transform_stamped.transform.translation.x;
-        lidar_offset_y_ = transform_stamped.transform.translation.y;
-        lidar_offset_yaw_ = tf2::getYaw(transform_stamped.transform.rotation);
+        filter_->setLidarOffset(transform_stamped.transform.translation.x, transform_stamped.transform.translation.y,
+                                tf2::getYaw(transform_stamped.transform.rotation));
 
-        last_grid_size_x_ = last_grid_size_y_ = last_origin_x_ = last_origin_y_ = 0;
         current_ = true;
     }
 
@@ -62,152 +70,22 @@ class BinaryBayesFilterObstacleLayer : public costmap_2d::Layer {
             matchSize();
         }
 
-        lidar_x_ = robot_x + (lidar_offset_x_ * std::cos(robot_yaw) - lidar_offset_y_ * std::sin(robot_yaw));
-        lidar_y_ = robot_y + (lidar_offset_x_ * std::sin(robot_yaw) + lidar_offset_y_ * std::cos(robot_yaw));
-        lidar_yaw_ = robot_yaw + lidar_offset_yaw_;
-
-        scan_ = most_recent_scan_;
-        auto* costmap = layered_costmap_->getCostmap();
-        double resolution = costmap->getResolution();
-
-        double angle = scan_->angle_min;
-        for (double range : scan_->ranges) {
-            if (std::isinf(range)) {
-                range = scan_range_;
-            }
-            double wx = lidar_x_ + range * std::cos(lidar_yaw_ + angle);
-            double wy = lidar_y_ + range * std::sin(lidar_yaw_ + angle);
-            angle += scan_->angle_increment;
-
-            double fudge = 2 * resolution;
-            if (wx - fudge < *min_x)
-                *min_x = std::max(costmap->getOriginX(), wx - fudge);
-            if (wx + fudge > *max_x)
-                *max_x = std::min(costmap->getOriginX() + costmap->getSizeInMetersX(), wx + fudge);
-            if (wy - fudge < *min_y)
-                *min_y = std::max(costmap->getOriginY(), wy - fudge);
-            if (wy + fudge > *max_y)
-                *max_y = std::min(costmap->getOriginY() + costmap->getSizeInMetersY(), wy + fudge);
-        }
+        filter_->setScan(most_recent_scan_, *layered_costmap_->getCostmap(), robot_x, robot_y, robot_yaw, min_x, min_y,
+                         max_x, max_y);
+        scan_applied_ = true;
     }
 
     void updateCosts(costmap_2d::Costmap2D& master_grid, int min_cell_x, int min_cell_y, int max_cell_x,
                      int max_cell_y) override {
-        if (!enabled_ || !scan_) {
+        if (!enabled_) {
             return;
         }
-
-        const double resolution = master_grid.getResolution();
-        const double world_min_x = master_grid.getOriginX();
-        const double world_max_x = world_min_x + master_grid.getSizeInMetersX();
-        const double world_min_y = master_grid.getOriginY();
-        const double world_max_y = world_min_y + master_grid.getSizeInMetersY();
-
-        for (int mx = min_cell_x; mx < max_cell_x; mx++) {
-            for (int my = min_cell_y; my < max_cell_y; my++) {
-                updates_[master_grid.getIndex(mx, my)] = -1;
-            }
-        }
-
-        double angle = scan_->angle_min;
-        for (double raw_range : scan_->ranges) {
-            bool is_hit = (!std::isinf(raw_range) && raw_range <= scan_range_);
-            double clear_range = is_hit ? raw_range : scan_range_;
-            double obstacle_range = clear_range + obstacle_depth_;
-            double wx = lidar_x_ + obstacle_range * std::cos(lidar_yaw_ + angle);
-            double wy = lidar_y_ + obstacle_range * std::sin(lidar_yaw_ + angle);
-
-            if (wx < world_min_x || wx >= world_max_x || wy < world_min_y || wy >= world_max_y) {
-                ROS_WARN_THROTTLE(1.0, "trying to scan outside the map");
-                continue;
-            }
-
-            const double step_size = resolution * 0.25;
-            const double step_x = step_size * std::cos(lidar_yaw_ + angle);
-            const double step_y = step_size * std::sin(lidar_yaw_ + angle);
-            int mx, my;
-            double d = 0;
-            double march_x = lidar_x_;
-            double march_y = lidar_y_;
-            while (d < clear_range) {
-                master_grid.worldToMapNoBounds(march_x, march_y, mx, my);
-                updates_[master_grid.getIndex(mx, my)] = 0;
-                d += step_size;
-                march_x += step_x;
-                march_y += step_y;
-            }
-            if (is_hit) {
-                do {
-                    master_grid.worldToMapNoBounds(march_x, march_y, mx, my);
-                    updates_[master_grid.getIndex(mx, my)] = 1;
-                    d += step_size;
-                    march_x += step_x;
-                    march_y += step_y;
-                } while (d <= obstacle_range);
-            }
-
-            angle += scan_->angle_increment;
-        }
-
-        uint8_t* costmap_data = master_grid.getCharMap();
-        for (int mx = min_cell_x; mx < max_cell_x; mx++) {
-            for (int my = min_cell_y; my < max_cell_y; my++) {
-                const auto i = master_grid.getIndex(mx, my);
-                const char update = updates_[i];
-
-                if (update >= 0) {
-                    double p_prior = probs_[i];
-                    if (update > 0) {  // hit
-                        double p_occupied = (1.0 - prob_false_neg_) * p_prior;
-                        double p_empty = prob_false_pos_ * (1.0 - p_prior);
-                        probs_[i] = std::min(p_occupied / (p_occupied + p_empty), max_prob_);
-                    } else {  // cleared
-                        double p_occupied = prob_false_neg_ * p_prior;
-                        double p_empty = (1.0 - prob_false_pos_) * (1.0 - p_prior);
-                        probs_[i] = std::max(p_occupied / (p_occupied + p_empty), 1.0 - max_prob_);
-                    }
-                }
-
-                costmap_data[i] = static_cast<uint8_t>(probs_[i] * 255);
-            }
-        }
-    }
-
-    void matchSize(const costmap_2d::Costmap2D& master_grid) {
-        if (last_grid_size_x_ == master_grid.getSizeInCellsX() && last_grid_size_y_ == master_grid.getSizeInCellsY() &&
-            last_origin_x_ == master_grid.getOriginX() && last_origin_y_ == master_grid.getOriginY()) {
-            return;
-        }
-
-        std::vector<double> new_probs(master_grid.getSizeInCellsX() * master_grid.getSizeInCellsY(), prob_grid_prior_);
-        int old_origin_new_mx, old_origin_new_my;
-        master_grid.worldToMapNoBounds(last_origin_x_, last_origin_y_, old_origin_new_mx, old_origin_new_my);
-        int new_start_x = std::max(0, old_origin_new_mx);
-        int new_start_y = std::max(0, old_origin_new_my);
-        int old_start_x = std::max(0, -old_origin_new_mx);
-        int old_start_y = std::max(0, -old_origin_new_my);
-        int old_end_x = std::min(last_grid_size_x_, -old_origin_new_mx + master_grid.getSizeInCellsX());
-        int old_end_y = std::min(last_grid_size_y_, -old_origin_new_my + master_grid.getSizeInCellsY());
-
-        if (old_end_x > old_start_x && old_end_y > old_start_y) {
-            for (int old_my = old_start_y, new_my = new_start_y; old_my < old_end_y; old_my++, new_my++) {
-                size_t old_i = old_my * last_grid_size_x_;
-                size_t new_i = new_my * master_grid.getSizeInCellsX();
-                std::copy(probs_.begin() + old_i + old_start_x, probs_.begin() + old_i + old_end_x,
-                          new_probs.begin() + new_i + new_start_x);
-            }
-        }
-
-        probs_ = std::move(new_probs);
-        last_grid_size_x_ = master_grid.getSizeInCellsX();
-        last_grid_size_y_ = master_grid.getSizeInCellsY();
-        last_origin_x_ = master_grid.getOriginX();
-        last_origin_y_ = master_grid.getOriginY();
-        updates_.resize(probs_.size());
+        StageTimer timer(*update_stage_);
+        filter_->updateCosts(master_grid, min_cell_x, min_cell_y, max_cell_x, max_cell_y);
     }
 
     void matchSize() override {
-        matchSize(*layered_costmap_->getCostmap());
+        filter_->matchSize(*layered_costmap_->getCostmap());
     }
 
   private:
@@ -216,32 +94,22 @@ class BinaryBayesFilterObstacleLayer : public costmap_2d::Layer {
     }
 
     void scanCB(const sensor_msgs::LaserScanConstPtr& msg) {
+        scan_input_->received(msg->header);
+        // Scans arriving faster than the costmap updates replace each other unused
+        if (most_recent_scan_ && !scan_applied_) {
+            scan_input_->dropped();
+        }
         most_recent_scan_ = msg;
+        scan_applied_ = false;
     }
 
-    // state
-    std::vector<double> probs_;
-    std::vector<char> updates_;
+    std::unique_ptr<BinaryBayesFilter> filter_;
     sensor_msgs::LaserScanConstPtr most_recent_scan_;
-    sensor_msgs::LaserScanConstPtr scan_;
-    double lidar_x_;
-    double lidar_y_;
-    double lidar_yaw_;
-    double lidar_offset_x_;
-    double lidar_offset_y_;
-    double lidar_offset_yaw_;
-    unsigned int last_grid_size_x_;
-    unsigned int last_grid_size_y_;
-    double last_origin_x_;
-    double last_origin_y_;
-
-    // params
-    double prob_false_pos_;
-    double prob_false_neg_;
-    double prob_grid_prior_;
-    double max_prob_;
-    double scan_range_;
-    double obstacle_depth_;  // assumed thickness of an observed obstacle point. Ray-trace this much farther
+    std::atomic<bool> scan_applied_{ false };
+
+    std::unique_ptr<NodeMetrics> metrics_;
+    NodeMetrics::Input* scan_input_;
+    NodeMetrics::Stage* update_stage_;
 
     std::unique_ptr<dynamic_reconfigure::Server<costmap_2d::GenericPluginConfig>> dsrv_;
     ros::Subscriber scan_sub_;
@@ -5,14 +5,15 @@
 #include <parameter_assertions/assertions.h>
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
-#include <rr_evgp/UniformCostSearch.h>
+#include <rr_evgp/GridSearch.h>
 
 #include <opencv2/opencv.hpp>
+#include <optional>
 
 /*
  * @author Brian Cochran
  * This layer finds the center line of the course
- * using UniformCostSearch with costs being the distance
+ * using GridSearch with costs being the distance
  * to the nearest obstacle.
  */
 
@@ -44,6 +45,7 @@ class GlobalCenterPathLayer : public costmap_2d::Layer {
                              { assertions::greater<double>(0) });
         assertions::getParam(private_nh, "wall_thickness", wall_thickness_, { assertions::greater<double>(0) });
         assertions::getParam(private_nh, "scaling_factor", scaling_factor_, { assertions::greater_eq<double>(1.0) });
+        step_cost_ = assertions::param(private_nh, "step_cost", 0.0);
         assertions::getParam(private_nh, "distance_from_start", distance_from_start_,
                              { assertions::greater<double>(0) });
         assertions::getParam(private_nh, "goal_distance_behind_start", goal_distance_behind_start_,
@@ -98,13 +100,14 @@ class GlobalCenterPathLayer : public costmap_2d::Layer {
                 ROS_INFO_STREAM("Center Line Layer: Calculating center path");
 
                 // convert to opencv matrix
-                cv::Mat mat_grid(master_grid.getSizeInCellsX(), master_grid.getSizeInCellsY(), CV_8UC1);
+                cv::Mat mat_grid(master_grid.getSizeInCellsY(), master_grid.getSizeInCellsX(), CV_8UC1);
                 uint8_t* charMap = master_grid.getCharMap();
                 for (int r = 0; r < mat_grid.rows; r++) {
+                    uint8_t* row = mat_grid.ptr<uint8_t>(r);
                     for (int c = 0; c < mat_grid.cols; c++) {
-                        mat_grid.at<uint8_t>(r, c) = (charMap[r * mat_grid.cols + c] != costmap_2d::FREE_SPACE) ?
-                                                           UniformCostSearch::OBSTACLE_SPACE :
-                                                           UniformCostSearch::FREE_SPACE;
+                        row[c] = (charMap[r * mat_grid.cols + c] != costmap_2d::FREE_SPACE) ?
+                                       GridSearch::OBSTACLE_SPACE :
+                                       GridSearch::FREE_SPACE;
                     }
                 }
 
@@ -124,25 +127,18 @@ class GlobalCenterPathLayer : public costmap_2d::Layer {
                 cv::Point2d goalPt =
                       offsetPoint(cv::Point(mx, my), init_robot_yaw, -1.0 * goalDistanceBehindStartPixels);
 
-                int cx;
-                int cy;
-                master_grid.worldToMapEnforceBounds(curr_robot_x, curr_robot_y, cx, cy);
-
-                cv::Mat debug;
-                cv::cvtColor(mat_grid, debug, cv::COLOR_GRAY2BGR);
-                cv::line(debug, wallPtA, wallPtB, CV_RGB(255, 0, 0),
+                cv::line(mat_grid, wallPtA, wallPtB, cv::Scalar(GridSearch::OBSTACLE_SPACE),
                          wallThicknessPixels);  // add wall in between start and end points
 
-                cv::Mat channels[3];
-                cv::split(debug, channels);
-
-                cv::Mat obstacleGrid;
-                cv::resize(channels[2], obstacleGrid,
-                           cv::Size(master_grid.getSizeInCellsX() / scaling_factor_,
-                                    master_grid.getSizeInCellsY() / scaling_factor_));
-                cv::threshold(obstacleGrid, obstacleGrid, 127, UniformCostSearch::OBSTACLE_SPACE,
-                              cv::THRESH_BINARY);  // threshold after scaling because of interpolation (halfway at 127
-                                                   // seems fine)
+                cv::Mat obstacleGrid = mat_grid;
+                if (scaling_factor_ > 1.0) {
+                    cv::resize(mat_grid, obstacleGrid,
+                               cv::Size(master_grid.getSizeInCellsX() / scaling_factor_,
+                                        master_grid.getSizeInCellsY() / scaling_factor_));
+                    cv::threshold(obstacleGrid, obstacleGrid, 127, GridSearch::OBSTACLE_SPACE,
+                                  cv::THRESH_BINARY);  // threshold after scaling because of interpolation (halfway at
+                                                       // 127 seems fine)
+                }
 
                 // Ensures track walls are at least 2 pixels wide (can't sneak through) and adds buffer in case of badly
                 // sensed wall
@@ -162,15 +158,17 @@ class GlobalCenterPathLayer : public costmap_2d::Layer {
                 cv::Point startPt(mx / scaling_factor_, my / scaling_factor_);
                 goalPt.x = goalPt.x / scaling_factor_;
                 goalPt.y = goalPt.y / scaling_factor_;
-                UniformCostSearch ucs(obstacleGrid, distanceGrid, startPt, goalPt);
+                GridSearch gridSearch(obstacleGrid, distanceGrid, GridSearch::Mode::ASTAR, step_cost_);
 
                 // In case start or goal end up in the wall accidentally, find a workable point
-                cv::Point newStartPt = ucs.getNearestFreePointBFS(startPt);
-                ucs.setGoalPoint(newStartPt);
-                cv::Point newGoalPt = ucs.getNearestFreePointBFS(goalPt);
-                ucs.setGoalPoint(newGoalPt);
+                std::optional<cv::Point> newStartPt = gridSearch.getNearestFreePointBFS(startPt);
+                std::optional<cv::Point> newGoalPt = gridSearch.getNearestFreePointBFS(goalPt);
+                if (!newStartPt || !newGoalPt) {
+                    ROS_ERROR_STREAM("Center Line Layer: No free space near the start or goal, no center path");
+                    return;
+                }
 
-                std::vector<cv::Point> pixelPointPath = ucs.search();
+                std::vector<cv::Point> pixelPointPath = gridSearch.search(*newStartPt, *newGoalPt);
 
                 pathMsg.header.stamp = ros::Time::now();
                 pathMsg.header.frame_id = global_frame_;
@@ -220,6 +218,7 @@ class GlobalCenterPathLayer : public costmap_2d::Layer {
     double forward_initial_offset_;
     double goal_distance_behind_start_;
     double scaling_factor_;
+    double step_cost_;
     std::string global_frame_;
     bool lap_completed;
     bool init_is_set;
@@ -0,0 +1,102 @@
+#include <geometry_msgs/TransformStamped.h>
+#include <rr_common/bag_replay.h>
+#include <rr_evgp/binary_bayes_filter.h>
+#include <sensor_msgs/LaserScan.h>
+#include <tf2/exceptions.h>
+#include <tf2/utils.h>
+
+#include <algorithm>
+
+/*
+ * Replays laser scans from a bag through the filter behind BinaryBayesFilterObstacleLayer, without a ROS master or
+ * a costmap node, and reports processing time per scan, peak memory and a digest of the updated cells. The robot
+ * pose at each scan's stamp comes from the bag's /tf, and the map is a fixed window like the global mapper's.
+ * Parameters default to mapping_common.yaml, mapping_global_bayes.yaml and mapping_sim.launch.
+ *
+ * usage: obstacle_layer_benchmark --bag FILE [--topic /scan] [--output FILE] [--max_messages N] [--per_message]
+ *                                 [--param name=value ...]
+ */
+
+int main(int argc, char** argv) {
+    rr::ReplayOptions options;
+    options.topic = "/scan";
+    if (!options.parse(argc, argv)) {
+        return 1;
+    }
+
+    rr::BinaryBayesFilter::Params params{};
+    params.prob_false_pos = 0.2;
+    params.prob_false_neg = 0.3;
+    params.prob_grid_prior = 0.01;
+    params.max_confidence = 0.9999;
+    params.scan_range = 8.0;
+    params.obstacle_depth = 0.5;
+    std::string global_frame = "map";
+    std::string robot_base_frame = "base_footprint";
+    std::string lidar_frame = "lidar";
+    double map_size = 500.0;
+    double resolution = 0.25;
+
+    options.param("prob_false_pos", params.prob_false_pos);
+    options.param("prob_false_neg", params.prob_false_neg);
+    options.param("prob_grid_prior", params.prob_grid_prior);
+    options.param("max_confidence", params.max_confidence);
+    options.param("scan_range", params.scan_range);
+    options.param("obstacle_depth", params.obstacle_depth);
+    options.param("global_frame", global_frame);
+    options.param("robot_base_frame", robot_base_frame);
+    options.param("lidar_frame", lidar_frame);
+    options.param("map_size", map_size);
+    options.param("resolution", resolution);
+
+    const auto cells = static_cast<unsigned int>(map_size / resolution);
+    costmap_2d::Costmap2D costmap(cells, cells, resolution, -map_size / 2, -map_size / 2);
+    rr::BinaryBayesFilter filter(params);
+    filter.matchSize(costmap);
+
+    bool have_lidar_offset = false;
+    int x0 = 0, xn = 0, y0 = 0, yn = 0;
+
+    return rr::replayBag<sensor_msgs::LaserScan>(
+          "binary_bayes_filter_obstacle_layer", options,
+          [&](const sensor_msgs::LaserScanConstPtr& msg, const tf2::BufferCore& tf) {
+              x0 = xn = y0 = yn = 0;
+              geometry_msgs::TransformStamped robot_pose;
+              try {
+                  if (!have_lidar_offset) {
+                      auto offset = tf.lookupTransform(robot_base_frame, lidar_frame, ros::Time(0));
+                      filter.setLidarOffset(offset.transform.translation.x, offset.transform.translation.y,
+                                            tf2::getYaw(offset.transform.rotation));
+                      have_lidar_offset = true;
+                  }
+                  robot_pose = tf.lookupTransform(global_frame, robot_base_frame, msg->header.stamp);
+              } catch (const tf2::TransformException&) {
+                  return;
+              }
+
+              // Same bounds handling as costmap_2d::LayeredCostmap::updateMap
+              double min_x = 1e30, min_y = 1e30, max_x = -1e30, max_y = -1e30;
+              filter.setScan(msg, costmap, robot_pose.transform.translation.x, robot_pose.transform.translation.y,
+                             tf2::getYaw(robot_pose.transform.rotation), &min_x, &min_y, &max_x, &max_y);
+              costmap.worldToMapEnforceBounds(min_x, min_y, x0, y0);
+              costmap.worldToMapEnforceBounds(max_x, max_y, xn, yn);
+              x0 = std::max(0, x0);
+              xn = std::min(static_cast<int>(costmap.getSizeInCellsX()), xn + 1);
+              y0 = std::max(0, y0);
+              yn = std::min(static_cast<int>(costmap.getSizeInCellsY()), yn + 1);
+              if (xn < x0 || yn < y0) {
+                  return;
+              }
+              filter.updateCosts(costmap, x0, y0, xn, yn);
+          },
+          [&](rr::OutputDigest& digest) {
+              digest.addValue(x0);
+              digest.addValue(y0);
+              digest.addValue(xn);
+              digest.addValue(yn);
+              const unsigned char* data = costmap.getCharMap();
+              for (int my = y0; my < yn && x0 < xn; my++) {
+                  digest.add(data + costmap.getIndex(x0, my), xn - x0);
+              }
+          });
+}
@@ -4,12 +4,14 @@
 #include <parameter_assertions/assertions.h>
 #include <pluginlib/class_list_macros.h>
 #include <ros/ros.h>
+#include <rr_evgp/skeletonize.h>
 
+#include <algorithm>
 #include <opencv2/opencv.hpp>
+#include <tuple>
+#include <unordered_map>
 #include <valarray>
 
-#include "skeletonize.hpp"
-
 namespace rr {
 
 class TrackClosingLayer : public costmap_2d::Layer {
@@ -22,6 +24,10 @@ class TrackClosingLayer : public costmap_2d::Layer {
     void updateCosts(costmap_2d::Costmap2D& master_grid, int min_cell_x, int min_cell_y, int max_cell_x,
                      int max_cell_y) override;
 
+    void reset() override {
+        cache_valid_ = false;
+    }
+
   protected:
     void onInitialize() override;
 
@@ -34,14 +40,51 @@ class TrackClosingLayer : public costmap_2d::Layer {
     double extrapolate_distance_;
     double max_angle_between_lines_;
     double max_dist_between_lines_;
+    double max_bridge_length_;
     int wall_output_dilation_;
+    int tile_size_;
+    int halo_size_;
 
     void reconfigureCB(const costmap_2d::GenericPluginConfig& config, uint32_t level) {
+        if (config.enabled && !enabled_) {
+            cache_valid_ = false;  // master grid was not watched while disabled
+        }
         enabled_ = config.enabled;
     }
 
     using WallEndpointContext = std::tuple<cv::Point, cv::Point, double, double>;
+    using Wall = std::pair<cv::Point, cv::Point>;
     bool IsConnectable(const WallEndpointContext& current, const WallEndpointContext& prev);
+    bool FacesEndpoint(const WallEndpointContext& current, const WallEndpointContext& other) const;
+
+    /*
+     * State kept between update cycles. All of it is in master grid cell coordinates and is shifted along with the
+     * master grid when a rolling window moves.
+     */
+    bool cache_valid_ = false;
+    double cache_origin_x_ = 0;
+    double cache_origin_y_ = 0;
+    cv::Mat input_mask_;  // lethal cells written by the layers below this one (0 / 255)
+    cv::Mat thin_;        // thinned input, before anything is pruned (0 / 255)
+    cv::Mat skeleton_;    // pruned track skeleton (0 / 1)
+    cv::Mat dirty_tiles_;
+    std::vector<std::pair<cv::Point, WallEndpointContext>> endpoints_;  // skeleton pixel and its fitted line
+    std::vector<Wall> walls_;
+    cv::Rect pending_bounds_;  // walls that were drawn clipped and need a redraw next cycle
+
+    cv::Rect mapRect() const {
+        return cv::Rect(0, 0, input_mask_.cols, input_mask_.rows);
+    }
+
+    void matchCache(const costmap_2d::Costmap2D& costmap);
+    void shiftCache(int dx, int dy);
+    bool markDirtyTiles(const uint8_t* char_map, const cv::Rect& window);
+    void processRegion(const cv::Rect& region);
+    cv::Rect filterSkeleton(const std::vector<cv::Rect>& regions);
+    void updateEndpoints(const cv::Rect& region);
+    WallEndpointContext fitEndpoint(const cv::Point& endpnt) const;
+    std::vector<Wall> connectEndpoints();
+    void drawWalls(uint8_t* char_map, const cv::Rect& window) const;
 };
 
 PLUGINLIB_EXPORT_CLASS(rr::TrackClosingLayer, costmap_2d::Layer)
@@ -63,6 +106,23 @@ void TrackClosingLayer::onInitialize() {
     assertions::getParam(private_nh, "max_dist_between_lines", max_dist_between_lines_,
                          { assertions::greater<double>(0) });
     assertions::getParam(private_nh, "wall_output_dilation", wall_output_dilation_, { assertions::greater_eq<int>(0) });
+    max_bridge_length_ = assertions::param(private_nh, "max_bridge_length", 60.0);
+    if (max_bridge_length_ <= 0) {
+        ROS_ERROR("[TrackClosingLayer] max_bridge_length must be positive, using 60");
+        max_bridge_length_ = 60;
+    }
+    tile_size_ = assertions::param(private_nh, "tile_size", 32);
+    if (tile_size_ <= 0) {
+        ROS_ERROR("[TrackClosingLayer] tile_size must be positive, using 32");
+        tile_size_ = 32;
+    }
+
+    // Context kept around every region that is thinned again, and how far into neighboring tiles a change is assumed
+    // to matter. It covers the dilation and erosion, which grow blobs by dilate_size_, and the usual reach of thinning
+    // on walls a few cells thick. It is not a bound: Zhang-Suen peels a blob from all of its sides, so a change to a
+    // wide blob can move the skeleton further away, which is then only fixed once those tiles change themselves.
+    // The length based pruning looks along whole walls and runs on whole connected pieces instead.
+    halo_size_ = 2 * dilate_size_ + 2;
 }
 
 void TrackClosingLayer::updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y,
@@ -72,10 +132,112 @@ void TrackClosingLayer::updateBounds(double robot_x, double robot_y, double robo
     }
 
     const costmap_2d::Costmap2D* costmap = layered_costmap_->getCostmap();
-    *min_x = std::min(*min_x, costmap->getOriginX());
-    *min_y = std::min(*min_y, costmap->getOriginY());
-    *max_x = std::max(*max_x, costmap->getOriginX() + costmap->getSizeInMetersX());
-    *max_y = std::max(*max_y, costmap->getOriginY() + costmap->getSizeInMetersY());
+    matchCache(*costmap);
+
+    const double resolution = costmap->getResolution();
+    const double origin_x = costmap->getOriginX();
+    const double origin_y = costmap->getOriginY();
+    cv::Rect bounds = pending_bounds_;
+    pending_bounds_ = cv::Rect();
+
+    if (dirty_tiles_.empty()) {
+        // nothing cached yet, read the whole map
+        bounds = mapRect();
+    } else if (*min_x <= *max_x && *min_y <= *max_y) {
+        // Cells touched by the layers below are thinned again within a tile and a halo of them and the endpoint fits
+        // within a regression box of that. Any wall ending in there may move or disappear, so redraw all of it.
+        // Walls further along a pruned piece that change anyway are asked for through pending_bounds_.
+        int x0, y0, x1, y1;
+        costmap->worldToMapNoBounds(*min_x, *min_y, x0, y0);
+        costmap->worldToMapNoBounds(*max_x, *max_y, x1, y1);
+        const int margin = tile_size_ + halo_size_ + reg_bounding_box_size_ / 2 + 1 + wall_output_dilation_;
+        cv::Rect touched(cv::Point(x0 - margin, y0 - margin), cv::Point(x1 + margin + 1, y1 + margin + 1));
+        touched &= mapRect();
+
+        for (const auto& [a, b] : walls_) {
+            if (touched.contains(a) || touched.contains(b)) {
+                bounds |= cv::Rect(a, b) + cv::Size(1, 1);
+            }
+        }
+        bounds |= touched;
+    }
+
+    if (bounds.empty()) {
+        return;
+    }
+    bounds = (bounds - cv::Point(wall_output_dilation_, wall_output_dilation_) +
+              cv::Size(2 * wall_output_dilation_, 2 * wall_output_dilation_)) &
+             mapRect();
+
+    *min_x = std::min(*min_x, origin_x + bounds.x * resolution);
+    *min_y = std::min(*min_y, origin_y + bounds.y * resolution);
+    *max_x = std::max(*max_x, origin_x + (bounds.x + bounds.width) * resolution);
+    *max_y = std::max(*max_y, origin_y + (bounds.y + bounds.height) * resolution);
+}
+
+void TrackClosingLayer::matchCache(const costmap_2d::Costmap2D& costmap) {
+    const int size_x = costmap.getSizeInCellsX();
+    const int size_y = costmap.getSizeInCellsY();
+
+    if (!cache_valid_ || input_mask_.cols != size_x || input_mask_.rows != size_y) {
+        input_mask_ = cv::Mat(size_y, size_x, CV_8UC1, cv::Scalar(0));
+        thin_ = cv::Mat(size_y, size_x, CV_8UC1, cv::Scalar(0));
+        skeleton_ = cv::Mat(size_y, size_x, CV_8UC1, cv::Scalar(0));
+        dirty_tiles_.release();
+        endpoints_.clear();
+        walls_.clear();
+        pending_bounds_ = cv::Rect();
+        cache_origin_x_ = costmap.getOriginX();
+        cache_origin_y_ = costmap.getOriginY();
+        cache_valid_ = true;
+        return;
+    }
+
+    // A rolling window moves the master grid by whole cells, so move everything we remember with it
+    const int dx = static_cast<int>(std::lround((costmap.getOriginX() - cache_origin_x_) / costmap.getResolution()));
+    const int dy = static_cast<int>(std::lround((costmap.getOriginY() - cache_origin_y_) / costmap.getResolution()));
+    if (dx != 0 || dy != 0) {
+        shiftCache(dx, dy);
+    }
+    cache_origin_x_ = costmap.getOriginX();
+    cache_origin_y_ = costmap.getOriginY();
+}
+
+void TrackClosingLayer::shiftCache(int dx, int dy) {
+    const cv::Point offset(-dx, -dy);
+    const cv::Rect map_rect = mapRect();
+    const cv::Rect dst_rect = (map_rect + offset) & map_rect;
+    const cv::Rect src_rect = dst_rect - offset;
+
+    for (cv::Mat* mat : { &input_mask_, &thin_, &skeleton_ }) {
+        cv::Mat shifted(mat->size(), mat->type(), cv::Scalar(0));
+        if (!dst_rect.empty()) {
+            (*mat)(src_rect).copyTo(shifted(dst_rect));
+        }
+        *mat = shifted;
+    }
+
+    std::vector<std::pair<cv::Point, WallEndpointContext>> shifted_endpoints;
+    for (auto [pixel, context] : endpoints_) {
+        pixel += offset;
+        if (map_rect.contains(pixel)) {
+            std::get<0>(context) += offset;
+            std::get<1>(context) += offset;
+            shifted_endpoints.emplace_back(pixel, context);
+        }
+    }
+    endpoints_ = std::move(shifted_endpoints);
+
+    // the master grid already holds these walls shifted, they only need to be forgotten once an endpoint leaves
+    std::vector<Wall> shifted_walls;
+    for (auto [a, b] : walls_) {
+        a += offset;
+        b += offset;
+        if (map_rect.contains(a) || map_rect.contains(b)) {
+            shifted_walls.emplace_back(a, b);
+        }
+    }
+    walls_ = std::move(shifted_walls);
 }
 
 template <int N>
@@ -102,8 +264,12 @@ bool TrackClosingLayer::IsConnectable(const WallEndpointContext& current, const
 
     double angle_between_lines = 180.0 - (std::acos(vxA * vxB + vyA * vyB) * 180.0 / M_PI);
 
-    cv::Point closest_endB_to_lineA = intersect_point_line(endpntB, pntA, pntA + cv::Point(vxA * 500, vyA * 500), true);
-    cv::Point closest_endA_to_lineB = intersect_point_line(endpntA, pntB, pntB + cv::Point(vxB * 500, vyB * 500), true);
+    // Long enough to reach every endpoint within a bridge of the other, which are the only ones ever compared
+    const double reach = max_bridge_length_ + extrapolate_distance_;
+    cv::Point closest_endB_to_lineA =
+          intersect_point_line(endpntB, pntA, pntA + cv::Point(vxA * reach, vyA * reach), true);
+    cv::Point closest_endA_to_lineB =
+          intersect_point_line(endpntA, pntB, pntB + cv::Point(vxB * reach, vyB * reach), true);
     double dist_a = norm(closest_endA_to_lineB - endpntA);
     double dist_b = norm(closest_endB_to_lineA - endpntB);
 
@@ -111,19 +277,114 @@ bool TrackClosingLayer::IsConnectable(const WallEndpointContext& current, const
            dist_b < max_dist_between_lines_;
 }
 
+/*
+ * Cheap test that other is not behind the extrapolated end of current. IsConnectable can only pass when this holds
+ * both ways, since it measures distances from the ray starting at the extrapolated point.
+ */
+bool TrackClosingLayer::FacesEndpoint(const WallEndpointContext& current, const WallEndpointContext& other) const {
+    const auto& [endpnt, pnt, vx, vy] = current;
+    const cv::Point& other_endpnt = std::get<0>(other);
+    return (other_endpnt.x - pnt.x) * vx + (other_endpnt.y - pnt.y) * vy >= -max_dist_between_lines_;
+}
+
 void TrackClosingLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_cell_x, int min_cell_y, int max_cell_x,
                                     int max_cell_y) {
     if (!enabled_) {
         return;
     }
 
-    // populate OpenCV Mat as grid
-    cv::Mat mat_grid(master_grid.getSizeInCellsX(), master_grid.getSizeInCellsY(), CV_8UC1);
+    matchCache(master_grid);
+    const cv::Rect window = cv::Rect(cv::Point(min_cell_x, min_cell_y), cv::Point(max_cell_x, max_cell_y)) & mapRect();
+    if (window.empty()) {
+        return;
+    }
+
     uint8_t* charMap = master_grid.getCharMap();
-    for (int r = 0; r < mat_grid.rows; r++) {
-        for (int c = 0; c < mat_grid.cols; c++) {
-            mat_grid.at<uint8_t>(r, c) = (charMap[r * mat_grid.cols + c] == costmap_2d::LETHAL_OBSTACLE) ? 255 : 0;
+    if (markDirtyTiles(charMap, window)) {
+        // Tiles within halo_size_ of a changed one are thinned again as well, see halo_size_
+        const int halo_tiles = (halo_size_ + tile_size_ - 1) / tile_size_;
+        auto halo_kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * halo_tiles + 1, 2 * halo_tiles + 1));
+        cv::dilate(dirty_tiles_, dirty_tiles_, halo_kernel);
+
+        // Thin each group of changed tiles, everything else is kept from before
+        cv::Mat labels, stats, centroids;
+        int num_regions = cv::connectedComponentsWithStats(dirty_tiles_, labels, stats, centroids, 8, CV_32S);
+        std::vector<cv::Rect> regions;
+        for (int i = 1; i < num_regions; i++) {
+            cv::Rect region(stats.at<int>(i, cv::CC_STAT_LEFT), stats.at<int>(i, cv::CC_STAT_TOP),
+                            stats.at<int>(i, cv::CC_STAT_WIDTH), stats.at<int>(i, cv::CC_STAT_HEIGHT));
+            region.x *= tile_size_;
+            region.y *= tile_size_;
+            region.width *= tile_size_;
+            region.height *= tile_size_;
+            region &= mapRect();
+            processRegion(region);
+            regions.push_back(region);
         }
+        dirty_tiles_.setTo(0);
+        updateEndpoints(filterSkeleton(regions));
+
+        // Walls that are new or gone and reach outside of this update are only partly drawn or erased. Ask for their
+        // area next cycle.
+        std::vector<Wall> new_walls = connectEndpoints();
+        const cv::Point dilation(wall_output_dilation_, wall_output_dilation_);
+        auto request_outside = [&](const Wall& wall) {
+            cv::Rect wall_rect = (cv::Rect(wall.first, wall.second) + cv::Size(1, 1) - dilation) +
+                                 cv::Size(2 * dilation.x, 2 * dilation.y);
+            if ((wall_rect & window) != wall_rect) {
+                pending_bounds_ |= wall_rect & mapRect();
+            }
+        };
+        for (const Wall& wall : new_walls) {
+            if (std::find(walls_.begin(), walls_.end(), wall) == walls_.end()) {
+                request_outside(wall);
+            }
+        }
+        for (const Wall& wall : walls_) {
+            if (std::find(new_walls.begin(), new_walls.end(), wall) == new_walls.end()) {
+                request_outside(wall);
+            }
+        }
+        walls_ = std::move(new_walls);
+    }
+
+    drawWalls(charMap, window);
+
+    // cv::imshow("closing", skeleton_ * 255);
+    // cv::waitKey(1);
+}
+
+bool TrackClosingLayer::markDirtyTiles(const uint8_t* char_map, const cv::Rect& window) {
+    const int tiles_x = (input_mask_.cols + tile_size_ - 1) / tile_size_;
+    const int tiles_y = (input_mask_.rows + tile_size_ - 1) / tile_size_;
+    if (dirty_tiles_.empty()) {
+        dirty_tiles_ = cv::Mat(tiles_y, tiles_x, CV_8UC1, cv::Scalar(0));
+    }
+
+    bool any_dirty = false;
+    for (int r = window.y; r < window.y + window.height; r++) {
+        const uint8_t* map_row = char_map + r * input_mask_.cols;
+        uint8_t* mask_row = input_mask_.ptr<uint8_t>(r);
+        uint8_t* tile_row = dirty_tiles_.ptr<uint8_t>(r / tile_size_);
+        for (int c = window.x; c < window.x + window.width; c++) {
+            uint8_t value = (map_row[c] == costmap_2d::LETHAL_OBSTACLE) ? 255 : 0;
+            if (mask_row[c] != value) {
+                mask_row[c] = value;
+                tile_row[c / tile_size_] = 255;
+                any_dirty = true;
+            }
+        }
+    }
+    return any_dirty;
+}
+
+void TrackClosingLayer::processRegion(const cv::Rect& region) {
+    const cv::Rect padded = (region - cv::Point(halo_size_, halo_size_) + cv::Size(2 * halo_size_, 2 * halo_size_)) &
+                            mapRect();
+    cv::Mat mat_grid = input_mask_(padded).clone();
+    if (cv::countNonZero(mat_grid) == 0) {
+        thin_(region).setTo(0);
+        return;
     }
 
     if (dilate_size_ > 0) {
@@ -138,106 +399,234 @@ void TrackClosingLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_
         }
     }
 
-    // Make Skeleton
+    // Make Skeleton, only the inside of the region is trusted, the halo was just there for context
     auto skel = rr::thinObstacles(mat_grid);
-    auto branches = rr::removeSmallBranches(skel, branch_pruning_size_);
+    skel(region - padded.tl()).copyTo(thin_(region));
+}
+
+/*
+ * Branch and contour lengths belong to whole walls, which reach well outside of the tiles that changed, so the
+ * skeleton is pruned again over every connected piece of the thinned map that touches a changed region. Returns the
+ * area where the skeleton may have changed.
+ */
+cv::Rect TrackClosingLayer::filterSkeleton(const std::vector<cv::Rect>& regions) {
+    cv::Mat labels, stats, centroids;
+    const int num_labels = cv::connectedComponentsWithStats(thin_, labels, stats, centroids, 8, CV_32S);
+
+    // a piece that was cut in two by a change still touches the region it was cut in
+    std::vector<uint8_t> affected(num_labels, 0);
+    cv::Rect changed;
+    for (const cv::Rect& region : regions) {
+        changed |= region;
+        const cv::Rect border = (region - cv::Point(1, 1) + cv::Size(2, 2)) & mapRect();
+        for (int r = border.y; r < border.y + border.height; r++) {
+            const int* label_row = labels.ptr<int>(r);
+            for (int c = border.x; c < border.x + border.width; c++) {
+                affected[label_row[c]] = 1;
+            }
+        }
+    }
+    for (int i = 1; i < num_labels; i++) {
+        if (affected[i]) {
+            changed |= cv::Rect(stats.at<int>(i, cv::CC_STAT_LEFT), stats.at<int>(i, cv::CC_STAT_TOP),
+                                stats.at<int>(i, cv::CC_STAT_WIDTH), stats.at<int>(i, cv::CC_STAT_HEIGHT));
+        }
+    }
+    if (changed.empty()) {
+        return changed;
+    }
+
+    cv::Mat pieces(changed.size(), CV_8UC1, cv::Scalar(0));
+    for (int r = 0; r < changed.height; r++) {
+        const int* label_row = labels.ptr<int>(r + changed.y) + changed.x;
+        const uint8_t* thin_row = thin_.ptr<uint8_t>(r + changed.y) + changed.x;
+        uint8_t* piece_row = pieces.ptr<uint8_t>(r);
+        for (int c = 0; c < changed.width; c++) {
+            if (label_row[c] > 0 && affected[label_row[c]]) {
+                piece_row[c] = thin_row[c];
+            }
+        }
+    }
 
-    // cv::Mat debug_img;
-    // cv::cvtColor(branches * 255, debug_img, CV_GRAY2BGR);
+    auto branches = rr::removeSmallBranches(pieces, branch_pruning_size_);
 
     // Remove small objects (cars and noise)
     std::vector<std::vector<cv::Point>> contours;
     cv::findContours(branches, contours, cv::RETR_LIST, cv::CHAIN_APPROX_NONE);
-    cv::Mat contour_img(skel.rows, skel.cols, CV_8UC1, cv::Scalar(0));
+    cv::Mat contour_img(pieces.rows, pieces.cols, CV_8UC1, cv::Scalar(0));
     for (size_t i = 0; i < contours.size(); i++) {
         if (cv::arcLength(contours[i], false) >= min_enclosing_radius_) {
             cv::drawContours(contour_img, contours, i, cv::Scalar(1), 1);
         }
     }
 
+    // Pieces that were not affected keep their skeleton, the regions and affected pieces get the new one
+    cv::Mat skeleton = skeleton_(changed);
+    skeleton.setTo(0, pieces);
+    for (const cv::Rect& region : regions) {
+        skeleton_(region).setTo(0);
+    }
+    cv::bitwise_or(skeleton, contour_img, skeleton);
+    return changed;
+}
+
+void TrackClosingLayer::updateEndpoints(const cv::Rect& region) {
+    // endpoints whose regression box overlaps the region have to be refit
+    const int reach = reg_bounding_box_size_ / 2 + 1;
+    const cv::Rect affected = (region - cv::Point(reach, reach) + cv::Size(2 * reach, 2 * reach)) & mapRect();
+
+    endpoints_.erase(std::remove_if(endpoints_.begin(), endpoints_.end(),
+                                    [&affected](const auto& endpoint) { return affected.contains(endpoint.first); }),
+                     endpoints_.end());
+
     // Get end points
+    const cv::Rect padded = (affected - cv::Point(1, 1) + cv::Size(2, 2)) & mapRect();
     cv::Mat line_kernel(3, 3, CV_8UC1, cv::Scalar(1));
     line_kernel.at<uint8_t>(1, 1) = 10;
     cv::Mat filtered;
-    cv::filter2D(contour_img, filtered, CV_16SC1, line_kernel);
+    cv::filter2D(skeleton_(padded), filtered, CV_16SC1, line_kernel);
 
     std::vector<cv::Point> endpoints;
     cv::inRange(filtered, cv::Scalar(11), cv::Scalar(11), filtered);
     cv::findNonZero(filtered, endpoints);
 
-    std::vector<WallEndpointContext> endpnt_line;
-    const size_t half_size = reg_bounding_box_size_ / 2;
+    for (const cv::Point& local_endpnt : endpoints) {
+        cv::Point endpnt = local_endpnt + padded.tl();
+        if (affected.contains(endpnt)) {
+            endpoints_.emplace_back(endpnt, fitEndpoint(endpnt));
+        }
+    }
+}
+
+TrackClosingLayer::WallEndpointContext TrackClosingLayer::fitEndpoint(const cv::Point& endpnt) const {
+    const int half_size = reg_bounding_box_size_ / 2;
     const cv::Point half_size_point(half_size, half_size);
 
-    for (const cv::Point& endpnt : endpoints) {
-        cv::Point tl = endpnt - half_size_point;
-        cv::Point br = endpnt + half_size_point;
-        tl.x = std::max(tl.x, 0);
-        tl.y = std::max(tl.y, 0);
-        br.x = std::min(br.x, contour_img.cols - 1);
-        br.y = std::min(br.y, contour_img.rows - 1);
-
-        // cv::rectangle(debug_img, tl, br, cv::Scalar(255, 0, 0), 1);
-
-        // Find surrounding points
-        cv::Mat endpnt_box = contour_img(cv::Rect(tl, br));
-        std::vector<cv::Point> box_points;
-        cv::findNonZero(endpnt_box, box_points);
-
-        // Get regression line
-        cv::Vec4f line;
-        cv::fitLine(box_points, line, cv::DIST_L2, 0, 0.01, 0.01);
-        double vx = line(0);
-        double vy = line(1);
-        double x = line(2) + tl.x;
-        double y = line(3) + tl.y;
-
-        // Get direction of line from end point
-        cv::Point2d new_endpnt = intersect_point_line(endpnt, cv::Point2d(x, y), cv::Point2d(x + vx, y + vy), false);
-
-        cv::Vec2d avg_pnt;
-        for (const cv::Point& pnt : box_points) {
-            avg_pnt(0) += pnt.x + tl.x;
-            avg_pnt(1) += pnt.y + tl.y;
-        }
-        avg_pnt /= static_cast<double>(box_points.size());
+    cv::Point tl = endpnt - half_size_point;
+    cv::Point br = endpnt + half_size_point;
+    tl.x = std::max(tl.x, 0);
+    tl.y = std::max(tl.y, 0);
+    br.x = std::min(br.x, skeleton_.cols - 1);
+    br.y = std::min(br.y, skeleton_.rows - 1);
+
+    // Find surrounding points
+    cv::Mat endpnt_box = skeleton_(cv::Rect(tl, br));
+    std::vector<cv::Point> box_points;
+    cv::findNonZero(endpnt_box, box_points);
+
+    // Get regression line
+    cv::Vec4f line;
+    cv::fitLine(box_points, line, cv::DIST_L2, 0, 0.01, 0.01);
+    double vx = line(0);
+    double vy = line(1);
+    double x = line(2) + tl.x;
+    double y = line(3) + tl.y;
+
+    // Get direction of line from end point
+    cv::Point2d new_endpnt = intersect_point_line(endpnt, cv::Point2d(x, y), cv::Point2d(x + vx, y + vy), false);
+
+    cv::Vec2d avg_pnt;
+    for (const cv::Point& pnt : box_points) {
+        avg_pnt(0) += pnt.x + tl.x;
+        avg_pnt(1) += pnt.y + tl.y;
+    }
+    avg_pnt /= static_cast<double>(box_points.size());
 
-        cv::Vec2d v(vx, vy);
-        double projection = (cv::Vec2d(new_endpnt) - avg_pnt).dot(v);
-        if (projection < 0) {
-            vx *= -1;
-            vy *= -1;
-        }
+    cv::Vec2d v(vx, vy);
+    double projection = (cv::Vec2d(new_endpnt) - avg_pnt).dot(v);
+    if (projection < 0) {
+        vx *= -1;
+        vy *= -1;
+    }
+
+    cv::Point2d point;
+    point.x = new_endpnt.x + extrapolate_distance_ * vx;
+    point.y = new_endpnt.y + extrapolate_distance_ * vy;
+    return WallEndpointContext(new_endpnt, point, vx, vy);
+}
+
+std::vector<TrackClosingLayer::Wall> TrackClosingLayer::connectEndpoints() {
+    // Bucket endpoints on a grid as coarse as the longest allowed bridge, so only the surrounding buckets hold
+    // candidates for each endpoint. Collinear walls facing each other pass IsConnectable at any gap its rays reach,
+    // so it does not bound the gap by itself; max_bridge_length_ does.
+    auto bucket_of = [this](const cv::Point& p) {
+        return cv::Point(static_cast<int>(std::floor(p.x / max_bridge_length_)),
+                         static_cast<int>(std::floor(p.y / max_bridge_length_)));
+    };
+    auto bucket_key = [](const cv::Point& bucket) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(bucket.x)) << 32) | static_cast<uint32_t>(bucket.y);
+    };
+
+    std::unordered_map<uint64_t, std::vector<size_t>> buckets;
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        buckets[bucket_key(bucket_of(std::get<0>(endpoints_[i].second)))].push_back(i);
+    }
 
-        // cv::circle(debug_img, new_endpnt, 2, cv::Scalar(0, 255, 0));
-        cv::Point2d point;
-        point.x = new_endpnt.x + extrapolate_distance_ * vx;
-        point.y = new_endpnt.y + extrapolate_distance_ * vy;
-        endpnt_line.emplace_back(new_endpnt, point, vx, vy);
-    }
-
-    // Connect end points
-    cv::Mat walls(mat_grid.rows, mat_grid.cols, CV_8UC1, cv::Scalar(0));
-    std::valarray<bool> have_connection(false, endpnt_line.size());
-    for (size_t i = 0; i < endpnt_line.size(); i++) {
-        const auto& curr_line_context = endpnt_line.at(i);
-        for (size_t j = i + 1; j < endpnt_line.size(); j++) {
-            const auto& comp_line_context = endpnt_line.at(j);
-            if (IsConnectable(curr_line_context, comp_line_context)) {
-                have_connection[i] = true;
-                have_connection[j] = true;
-                const auto& point_a = std::get<0>(curr_line_context);
-                const auto& point_b = std::get<0>(comp_line_context);
-                // cv::line(debug_img, point_a, point_b, cv::Scalar(255, 0, 255));
-                cv::line(walls, point_a, point_b, cv::Scalar(255));
+    struct Candidate {
+        double gap;
+        size_t a;
+        size_t b;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < endpoints_.size(); i++) {
+        const auto& curr_line_context = endpoints_[i].second;
+        const cv::Point& curr_endpnt = std::get<0>(curr_line_context);
+        const cv::Point bucket = bucket_of(curr_endpnt);
+
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                auto it = buckets.find(bucket_key(bucket + cv::Point(dx, dy)));
+                if (it == buckets.end()) {
+                    continue;
+                }
+                for (size_t j : it->second) {
+                    if (j <= i) {
+                        continue;
+                    }
+                    const auto& comp_line_context = endpoints_[j].second;
+                    double gap = cv::norm(std::get<0>(comp_line_context) - curr_endpnt);
+                    if (gap <= max_bridge_length_ && FacesEndpoint(curr_line_context, comp_line_context) &&
+                        FacesEndpoint(comp_line_context, curr_line_context) &&
+                        IsConnectable(curr_line_context, comp_line_context)) {
+                        candidates.push_back({ gap, i, j });
+                    }
+                }
             }
         }
+    }
+
+    // Greedily take the shortest bridges so each endpoint is joined to at most one other
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& lhs, const Candidate& rhs) { return lhs.gap < rhs.gap; });
+
+    std::vector<Wall> walls;
+    std::valarray<bool> have_connection(false, endpoints_.size());
+    for (const Candidate& candidate : candidates) {
+        if (!have_connection[candidate.a] && !have_connection[candidate.b]) {
+            have_connection[candidate.a] = true;
+            have_connection[candidate.b] = true;
+            walls.emplace_back(std::get<0>(endpoints_[candidate.a].second),
+                               std::get<0>(endpoints_[candidate.b].second));
+        }
+    }
 
+    for (size_t i = 0; i < endpoints_.size(); i++) {
         if (!have_connection[i]) {
-            const auto& endpnt = std::get<0>(curr_line_context);
-            const auto& extrapolated_pnt = std::get<1>(curr_line_context);
-            // cv::line(debug_img, endpnt, extrapolated_pnt, cv::Scalar(0, 0, 255));
-            cv::line(walls, endpnt, extrapolated_pnt, cv::Scalar(255));
+            const auto& line_context = endpoints_[i].second;
+            walls.emplace_back(std::get<0>(line_context), std::get<1>(line_context));
+        }
+    }
+    return walls;
+}
+
+void TrackClosingLayer::drawWalls(uint8_t* char_map, const cv::Rect& window) const {
+    const cv::Point dilation(wall_output_dilation_, wall_output_dilation_);
+    const cv::Rect padded = (window - dilation + cv::Size(2 * dilation.x, 2 * dilation.y)) & mapRect();
+
+    cv::Mat walls(padded.size(), CV_8UC1, cv::Scalar(0));
+    for (const auto& [a, b] : walls_) {
+        if (((cv::Rect(a, b) + cv::Size(1, 1)) & padded).area() > 0) {
+            cv::line(walls, a - padded.tl(), b - padded.tl(), cv::Scalar(255));
         }
     }
 
@@ -248,17 +637,16 @@ void TrackClosingLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_
         cv::morphologyEx(walls, walls, cv::MORPH_DILATE, wall_dilate_kernel);
     }
 
-    // Make map from image
-    for (int r = 0; r < walls.rows; r++) {
-        for (int c = 0; c < walls.cols; c++) {
-            if (walls.at<uint8_t>(r, c) > 0) {
-                charMap[r * walls.cols + c] = costmap_2d::LETHAL_OBSTACLE;
+    // Make map from image, only inside of the area the costmap is updating
+    for (int r = window.y; r < window.y + window.height; r++) {
+        const uint8_t* wall_row = walls.ptr<uint8_t>(r - padded.y);
+        uint8_t* map_row = char_map + r * input_mask_.cols;
+        for (int c = window.x; c < window.x + window.width; c++) {
+            if (wall_row[c - padded.x] > 0) {
+                map_row[c] = costmap_2d::LETHAL_OBSTACLE;
             }
         }
     }
-
-    // cv::imshow("closing", debug_img);
-    // cv::waitKey(1);
 }
 
 }  // namespace rr
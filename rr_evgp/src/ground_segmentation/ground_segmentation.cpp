@@ -8,14 +8,16 @@
 #include <pcl/io/ply_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl_conversions/pcl_conversions.h>
+#include <rr_common/tracing.h>
 
 #include <utility>
-#include <iostream>
 
 #include "ground_segmenter/ground_segmenter.hpp"
+#include "ground_split.hpp"
 
 int main(int argc, char **argv) {
     ros::init(argc, argv, "ground_segmentation");
+    rr::startTracing(ros::this_node::getName());
     ros::NodeHandle nhp("~");
     ros::NodeHandle nh;
 
@@ -59,46 +61,20 @@ ground_segmentation::ground_segmentation(ros::NodeHandle *nh, GroundSegmenterPar
 }
 
 void ground_segmentation::callback(const sensor_msgs::PointCloud2 &cloud) {
+    rr::TraceSpan span("ground_segmentation", cloud.header.stamp);
+
     pcl::PointCloud<pcl::PointXYZ> pcl_cloud{};
     pcl::fromROSMsg(cloud, pcl_cloud);
 
-    GroundSegmenter segmenter(segmentation_params);
-    pcl::PointCloud<pcl::PointXYZ> cloud_transformed;
-
-    std::string frame_id = cloud.header.frame_id;
-
-    std::vector<int> labels;
-
     // todo: transform cloud so that the vertical axis (z) is always up relative to gravity
     // Eigen::Affine3d tf = Eigen::Affine3d::Identity<double, 3, 2>;
     // pcl::transformPointCloud(pcl_cloud, cloud_transformed, tf);
 
-    for (size_t i = 0; i < pcl_cloud.size(); ++i) {
-        auto pt = pcl_cloud[i];
-        //if (fabs(pt.y) < robot_width && -robot_depth_backward < pt.x && pt.x < robot_depth_forward) continue;
-
-        cloud_transformed.push_back(pt);
-    }
-
-    segmenter.segment(cloud_transformed, &labels);
     pcl::PointCloud<pcl::PointXYZ> ground_cloud, obstacle_cloud;
+    splitGround(segmentation_params, pcl_cloud, ground_cloud, obstacle_cloud);
 
-    ground_cloud.sensor_orientation_ = pcl_cloud.sensor_orientation_;
-    ground_cloud.sensor_origin_ = pcl_cloud.sensor_origin_;
-
-    obstacle_cloud.sensor_orientation_ = pcl_cloud.sensor_orientation_;
-    obstacle_cloud.sensor_origin_ = pcl_cloud.sensor_origin_;
-
-    for (size_t i = 0; i < cloud_transformed.size(); ++i) {
-        if (labels[i] == 1) {
-            ground_cloud.push_back(cloud_transformed[i]);
-        } else {
-            obstacle_cloud.push_back(cloud_transformed[i]);
-        }
-    }
-
-    publishPointCloud(ground_cloud, pcl_ground_pub_, frame_id);
-    publishPointCloud(obstacle_cloud, pcl_obstacle_pub_, frame_id);
+    publishPointCloud(ground_cloud, pcl_ground_pub_, cloud.header);
+    publishPointCloud(obstacle_cloud, pcl_obstacle_pub_, cloud.header);
 
     //pcl::PointCloud<pcl::PointXYZ> cloud2 = pcl::PointCloud<pcl::PointXYZ>(cloud);
     //publishPointCloud(pcl_cloud, pcl_ground_pub_);
@@ -106,13 +82,12 @@ void ground_segmentation::callback(const sensor_msgs::PointCloud2 &cloud) {
     //draw_opponents(&tag_groups);
 }
 
-void ground_segmentation::publishPointCloud(pcl::PointCloud<pcl::PointXYZ> &cloud, ros::Publisher &pub, std::string frame_id) {
+void ground_segmentation::publishPointCloud(pcl::PointCloud<pcl::PointXYZ> &cloud, ros::Publisher &pub,
+                                            const std_msgs::Header &header) {
     sensor_msgs::PointCloud2 outmsg;
     pcl::toROSMsg(cloud, outmsg);
-    outmsg.header.frame_id = frame_id;
+    outmsg.header = header;  // keep the scan's stamp so downstream stages know how old it is
     pub.publish(outmsg);
-
-    //std::cout << "Published cloud with " << cloud.size() << " points to " << pub.getTopic() << std::endl;
 }
 
 tf::Pose ground_segmentation::poseAverage(std::vector<tf::Pose> poses) {
@@ -37,7 +37,7 @@ class ground_segmentation {
 
     GroundSegmenterParams segmentation_params;
 
-    void publishPointCloud(pcl::PointCloud<pcl::PointXYZ> &cloud, ros::Publisher &pub, std::string frame_id);
+    void publishPointCloud(pcl::PointCloud<pcl::PointXYZ> &cloud, ros::Publisher &pub, const std_msgs::Header &header);
     constexpr static const double pose_distance = 0.1;
 
     void callback(const sensor_msgs::PointCloud2 &cloud);
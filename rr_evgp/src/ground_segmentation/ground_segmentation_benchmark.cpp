@@ -0,0 +1,71 @@
+#include <pcl_conversions/pcl_conversions.h>
+#include <rr_common/bag_replay.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include "ground_split.hpp"
+
+/*
+ * Replays velodyne clouds from a bag through splitGround, without a ROS master, and reports processing time per
+ * cloud, peak memory and a digest of the ground and obstacle clouds. Parameters default to
+ * ground_segmentation.launch.
+ *
+ * usage: ground_segmentation_benchmark --bag FILE [--topic /velodyne_points] [--output FILE] [--max_messages N]
+ *                                      [--per_message] [--param name=value ...]
+ */
+
+int main(int argc, char** argv) {
+    rr::ReplayOptions options;
+    options.topic = "/velodyne_points";
+    if (!options.parse(argc, argv)) {
+        return 1;
+    }
+
+    GroundSegmenterParams params{};
+    params.r_min_square = 0.09;
+    params.r_max_square = 300.0;
+    params.n_bins = 30;
+    params.n_segments = 180;
+    params.max_dist_to_line = 0.15;
+    params.min_slope = 0.0;
+    params.max_slope = 1.25;
+    params.max_error_square = 0.015;
+    params.long_threshold = 2.0;
+    params.max_long_height = 0.1;
+    params.max_start_height = 0.25;
+    params.sensor_height = 0.3;
+    params.line_search_angle = 0.3;
+    params.n_threads = 4;
+
+    options.param("r_min_square", params.r_min_square);
+    options.param("r_max_square", params.r_max_square);
+    options.param("n_bins", params.n_bins);
+    options.param("n_segments", params.n_segments);
+    options.param("max_dist_to_line", params.max_dist_to_line);
+    options.param("min_slope", params.min_slope);
+    options.param("max_slope", params.max_slope);
+    options.param("max_error_square", params.max_error_square);
+    options.param("long_threshold", params.long_threshold);
+    options.param("max_long_height", params.max_long_height);
+    options.param("max_start_height", params.max_start_height);
+    options.param("sensor_height", params.sensor_height);
+    options.param("line_search_angle", params.line_search_angle);
+    options.param("n_threads", params.n_threads);
+
+    pcl::PointCloud<pcl::PointXYZ> cloud, ground, obstacles;
+
+    return rr::replayBag<sensor_msgs::PointCloud2>(
+          "ground_segmentation", options,
+          [&](const sensor_msgs::PointCloud2ConstPtr& msg, const tf2::BufferCore&) {
+              pcl::fromROSMsg(*msg, cloud);
+              splitGround(params, cloud, ground, obstacles);
+          },
+          [&](rr::OutputDigest& digest) {
+              digest.addValue(ground.size());
+              for (const pcl::PointXYZ& p : ground) {
+                  digest.addValue(p.x);
+                  digest.addValue(p.y);
+                  digest.addValue(p.z);
+              }
+              digest.addValue(obstacles.size());
+          });
+}
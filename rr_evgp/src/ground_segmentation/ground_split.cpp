@@ -0,0 +1,23 @@
+#include "ground_split.hpp"
+
+#include <vector>
+
+void splitGround(const GroundSegmenterParams& params, const pcl::PointCloud<pcl::PointXYZ>& cloud,
+                 pcl::PointCloud<pcl::PointXYZ>& ground, pcl::PointCloud<pcl::PointXYZ>& obstacles) {
+    GroundSegmenter segmenter(params);
+    std::vector<int> labels;
+    segmenter.segment(cloud, &labels);
+
+    ground.clear();
+    obstacles.clear();
+    ground.sensor_orientation_ = obstacles.sensor_orientation_ = cloud.sensor_orientation_;
+    ground.sensor_origin_ = obstacles.sensor_origin_ = cloud.sensor_origin_;
+
+    for (size_t i = 0; i < cloud.size(); ++i) {
+        if (labels[i] == 1) {
+            ground.push_back(cloud[i]);
+        } else {
+            obstacles.push_back(cloud[i]);
+        }
+    }
+}
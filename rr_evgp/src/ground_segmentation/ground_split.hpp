@@ -0,0 +1,13 @@
+#pragma once
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "ground_segmenter/ground_segmenter.hpp"
+
+/*
+ * Segments cloud with a fresh GroundSegmenter and sorts its points into ground and obstacles. This is all the work
+ * ground_segmentation does per cloud, kept free of ROS so bag replays can call it directly.
+ */
+void splitGround(const GroundSegmenterParams& params, const pcl::PointCloud<pcl::PointXYZ>& cloud,
+                 pcl::PointCloud<pcl::PointXYZ>& ground, pcl::PointCloud<pcl::PointXYZ>& obstacles);
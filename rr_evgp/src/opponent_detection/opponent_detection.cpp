@@ -1,32 +1,45 @@
 #include <geometry_msgs/PoseArray.h>
-#include <pcl/ModelCoefficients.h>
-#include <pcl/common/transforms.h>
-#include <pcl/conversions.h>
-#include <pcl/features/normal_3d.h>
-#include <pcl/filters/extract_indices.h>
-#include <pcl/filters/passthrough.h>
-#include <pcl/kdtree/kdtree.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
-#include <pcl/sample_consensus/method_types.h>
-#include <pcl/sample_consensus/model_types.h>
-#include <pcl/segmentation/extract_clusters.h>
-#include <pcl/segmentation/sac_segmentation.h>
 #include <pcl_conversions/pcl_conversions.h>
-#include <pcl_ros/transforms.h>
 #include <ros/ros.h>
+#include <rr_msgs/opponent_tracks.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <tf/transform_listener.h>
 #include <visualization_msgs/Marker.h>
 #include <visualization_msgs/MarkerArray.h>
 
-double cluster_tolerance_;
-int min_cluster_size_, max_cluster_size_;
-
-ros::Publisher marker_pub, centroid_pub;
+#include <memory>
+
+#include "opponent_detector.hpp"
+
+std::unique_ptr<OpponentDetector> detector;
+OpponentTrackerParams tracker_params;
+std::unique_ptr<tf::TransformListener> tf_listener;
+std::string tracking_frame_;
+
+ros::Publisher marker_pub, centroid_pub, tracks_pub;
+
+// the same color for a track id every frame, hues spread by the golden ratio
+std_msgs::ColorRGBA trackColor(unsigned int id) {
+    double hue = std::fmod(id * 0.618033988749895, 1.0) * 6.0;
+    double x = 1.0 - std::fabs(std::fmod(hue, 2.0) - 1.0);
+    std_msgs::ColorRGBA color;
+    switch (static_cast<int>(hue)) {
+        case 0: color.r = 1, color.g = x; break;
+        case 1: color.r = x, color.g = 1; break;
+        case 2: color.g = 1, color.b = x; break;
+        case 3: color.g = x, color.b = 1; break;
+        case 4: color.r = x, color.b = 1; break;
+        default: color.r = 1, color.b = x; break;
+    }
+    color.a = 1.0;
+    return color;
+}
 
 // adds markers to marker array
 visualization_msgs::Marker makeMarkers(const std::vector<geometry_msgs::Point>& points, int id,
-                                       std_msgs::Header header) {
+                                       std_msgs::Header header, const std_msgs::ColorRGBA& color) {
     visualization_msgs::Marker marker;
 
     marker.header = header;
@@ -38,10 +51,7 @@ visualization_msgs::Marker makeMarkers(const std::vector<geometry_msgs::Point>&
 
     marker.pose.orientation.w = 1.0;
 
-    marker.color.r = rand() / double(RAND_MAX);
-    marker.color.g = rand() / double(RAND_MAX);
-    marker.color.b = rand() / double(RAND_MAX);
-    marker.color.a = 1.0;
+    marker.color = color;
 
     marker.scale.x = 0.05;
     marker.scale.y = 0.05;
@@ -50,72 +60,132 @@ visualization_msgs::Marker makeMarkers(const std::vector<geometry_msgs::Point>&
     return marker;
 }
 
+// arrow from a track's position along its velocity
+visualization_msgs::Marker makeVelocityMarker(const OpponentTracker::Track& track, std_msgs::Header header) {
+    visualization_msgs::Marker marker;
+
+    marker.header = header;
+    marker.ns = "opponent_tracks";
+    marker.id = track.id;
+    marker.type = visualization_msgs::Marker::ARROW;
+    marker.action = visualization_msgs::Marker::ADD;
+
+    geometry_msgs::Point start, end;
+    start.x = track.state(0);
+    start.y = track.state(1);
+    end.x = track.state(0) + track.state(2);
+    end.y = track.state(1) + track.state(3);
+    marker.points = { start, end };
+
+    marker.pose.orientation.w = 1.0;
+    marker.color = trackColor(track.id);
+
+    marker.scale.x = 0.1;
+    marker.scale.y = 0.2;
+    marker.scale.z = 0.2;
+
+    return marker;
+}
+
 // main callback function
 void callback(const sensor_msgs::PointCloud2ConstPtr& cloud_msg) {
-    // Convert from sensor_msgs::PointCloud2 -> pcl::PCLPointCloud2 -> pcl::PointCloud<PointXYZ>
-    pcl::PCLPointCloud2::Ptr pcl_pc2(new pcl::PCLPointCloud2);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-    pcl_conversions::toPCL(*cloud_msg, *pcl_pc2);
-    pcl::fromPCLPointCloud2(*pcl_pc2, *cloud);
-
-    // **CLUSTERING**
-    // Link: https://pcl.readthedocs.io/en/latest/cluster_extraction.html
-
-    pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZ>);
-    tree->setInputCloud(cloud);
-
-    std::vector<pcl::PointIndices> cluster_indices;
-    pcl::EuclideanClusterExtraction<pcl::PointXYZ> ec;
-    ec.setClusterTolerance(cluster_tolerance_);
-    ec.setMinClusterSize(min_cluster_size_);
-    ec.setMaxClusterSize(max_cluster_size_);
-    ec.setSearchMethod(tree);
-    ec.setInputCloud(cloud);
-    ec.extract(cluster_indices);
-
-    std::vector<pcl::PointCloud<pcl::PointXYZ>> cloud_clusters;
-    for (const pcl::PointIndices& point_idx : cluster_indices) {
-        pcl::PointCloud<pcl::PointXYZ> cloud_cluster;
-        for (const int& idx : point_idx.indices) {
-            cloud_cluster.push_back((*cloud)[idx]);
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    pcl::fromROSMsg(*cloud_msg, cloud);
+
+    // velocities only make sense in a frame that does not move with the car
+    std_msgs::Header tracking_header = cloud_msg->header;
+    tf::StampedTransform cloud_to_tracking;
+    cloud_to_tracking.setIdentity();
+    bool tracking = true;
+    if (!tracking_frame_.empty() && tracking_frame_ != cloud_msg->header.frame_id) {
+        tracking_header.frame_id = tracking_frame_;
+        std::string error;
+        tracking = tf_listener->canTransform(tracking_frame_, cloud_msg->header.frame_id, cloud_msg->header.stamp,
+                                             &error);
+        if (tracking) {
+            try {
+                tf_listener->lookupTransform(tracking_frame_, cloud_msg->header.frame_id, cloud_msg->header.stamp,
+                                             cloud_to_tracking);
+            } catch (const tf::TransformException& e) {
+                tracking = false;
+                error = e.what();
+            }
+        }
+        if (!tracking) {
+            ROS_WARN_STREAM_THROTTLE(1.0, "[opponent_detection] Not tracking, no transform: " << error);
         }
-        cloud_clusters.push_back(cloud_cluster);
     }
 
+    // **CLUSTERING AND TRACKING**
+    // Without the transform the clusters and centroids are still published, the tracks just wait for the next cloud
+    if (tracking) {
+        detector->process(cloud, cloud_to_tracking, cloud_msg->header.stamp.toSec());
+    } else {
+        detector->detect(cloud);
+    }
+    const std::vector<std::vector<int>>& clusters = detector->clusters();
+    const std::vector<unsigned int>& track_ids = detector->trackIds();
+
     // **PUBLISHING**
     visualization_msgs::MarkerArray marker_array;
-    std::vector<geometry_msgs::Pose> centroids;
+    visualization_msgs::Marker clear_marker;
+    clear_marker.action = visualization_msgs::Marker::DELETEALL;
+    marker_array.markers.push_back(clear_marker);
 
-    for (int cluster_idx = 0; cluster_idx < cloud_clusters.size(); cluster_idx++) {
-        // Marker Cluster
+    for (size_t cluster_idx = 0; cluster_idx < clusters.size(); cluster_idx++) {
         std::vector<geometry_msgs::Point> marker_cluster;
-        for (const pcl::PointXYZ& point : cloud_clusters[cluster_idx]) {
+        for (int idx : clusters[cluster_idx]) {
             geometry_msgs::Point marker_point;
-            marker_point.x = point.x;
-            marker_point.y = point.y;
-            marker_point.z = point.z;
+            marker_point.x = cloud[idx].x;
+            marker_point.y = cloud[idx].y;
+            marker_point.z = cloud[idx].z;
             marker_cluster.push_back(marker_point);
         }
-        marker_array.markers.push_back(makeMarkers(marker_cluster, cluster_idx, cloud_msg->header));
-
-        // Centroid
-        Eigen::Vector4f centroid_eigen;
-        pcl::compute3DCentroid(cloud_clusters[cluster_idx], centroid_eigen);
-
-        geometry_msgs::Pose centroid;
-        centroid.position.x = centroid_eigen[0];
-        centroid.position.y = centroid_eigen[1];
-        centroid.position.z = centroid_eigen[2];
-        centroid.orientation.w = 1;
-        centroids.push_back(centroid);
+        std_msgs::ColorRGBA color;
+        if (tracking) {
+            color = trackColor(track_ids[cluster_idx]);
+        } else {
+            color.r = color.g = color.b = color.a = 1.0;  // untracked
+        }
+        marker_array.markers.push_back(makeMarkers(marker_cluster, cluster_idx, cloud_msg->header, color));
+    }
+
+    rr_msgs::opponent_tracks tracks_msg;
+    tracks_msg.header = tracking_header;
+    for (const OpponentTracker::Track& track : detector->tracker().tracks()) {
+        if (!tracking || !track.confirmed(tracker_params)) {
+            continue;
+        }
+        rr_msgs::opponent_track track_msg;
+        track_msg.id = track.id;
+        track_msg.x = track.state(0);
+        track_msg.y = track.state(1);
+        track_msg.vx = track.state(2);
+        track_msg.vy = track.state(3);
+        track_msg.position_variance = track.covariance(0, 0) + track.covariance(1, 1);
+        track_msg.hits = track.hits;
+        tracks_msg.tracks.push_back(track_msg);
+
+        marker_array.markers.push_back(makeVelocityMarker(track, tracking_header));
     }
 
     marker_pub.publish(marker_array);
 
     geometry_msgs::PoseArray poses;
     poses.header = cloud_msg->header;
-    poses.poses = centroids;
+    for (const Eigen::Vector3d& centroid : detector->centroids()) {
+        geometry_msgs::Pose pose;
+        pose.position.x = centroid.x();
+        pose.position.y = centroid.y();
+        pose.position.z = centroid.z();
+        pose.orientation.w = 1;
+        poses.poses.push_back(pose);
+    }
     centroid_pub.publish(poses);
+
+    if (tracking) {
+        tracks_pub.publish(tracks_msg);
+    }
 }
 
 int main(int argc, char** argv) {
@@ -124,18 +194,34 @@ int main(int argc, char** argv) {
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
 
-    nhp.getParam("cluster_tolerance", cluster_tolerance_);
-    nhp.getParam("min_cluster_size", min_cluster_size_);
-    nhp.getParam("max_cluster_size", max_cluster_size_);
-
-    std::string input_cloud, output_markers, output_centroids;
+    double cluster_tolerance;
+    int min_cluster_size, max_cluster_size;
+    nhp.getParam("cluster_tolerance", cluster_tolerance);
+    nhp.getParam("min_cluster_size", min_cluster_size);
+    nhp.getParam("max_cluster_size", max_cluster_size);
+
+    nhp.getParam("accel_noise", tracker_params.accel_noise);
+    nhp.getParam("measurement_noise", tracker_params.measurement_noise);
+    nhp.getParam("initial_velocity_stddev", tracker_params.initial_velocity_stddev);
+    nhp.getParam("gate", tracker_params.gate);
+    nhp.getParam("min_hits", tracker_params.min_hits);
+    nhp.getParam("max_misses", tracker_params.max_misses);
+    detector = std::make_unique<OpponentDetector>(
+          VoxelClusterer(cluster_tolerance, min_cluster_size, max_cluster_size), tracker_params);
+
+    nhp.getParam("tracking_frame", tracking_frame_);
+    tf_listener = std::make_unique<tf::TransformListener>();
+
+    std::string input_cloud, output_markers, output_centroids, output_tracks;
     nhp.getParam("input_cloud", input_cloud);
     nhp.getParam("output_markers", output_markers);
     nhp.getParam("output_centroids", output_centroids);
+    nhp.param<std::string>("output_tracks", output_tracks, "/opponent_tracks");
 
     ros::Subscriber sub = nh.subscribe(input_cloud, 1, &callback);
     marker_pub = nh.advertise<visualization_msgs::MarkerArray>(output_markers, 1);
     centroid_pub = nh.advertise<geometry_msgs::PoseArray>(output_centroids, 1);
+    tracks_pub = nh.advertise<rr_msgs::opponent_tracks>(output_tracks, 1);
 
     ros::spin();
     return 0;
@@ -0,0 +1,76 @@
+#include <geometry_msgs/TransformStamped.h>
+#include <pcl_conversions/pcl_conversions.h>
+#include <rr_common/bag_replay.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <tf/transform_datatypes.h>
+#include <tf2/exceptions.h>
+
+#include "opponent_detector.hpp"
+
+/*
+ * Replays lidar clouds from a bag through OpponentDetector, without a ROS master, and reports processing time per
+ * cloud, peak memory and a digest of the clusters and confirmed tracks. The tracking frame transform is looked up
+ * in the bag's /tf at each cloud's stamp; clouds without one are skipped, as the node skips them. Parameters
+ * default to opponent_detection.launch.
+ *
+ * usage: opponent_detection_benchmark --bag FILE [--topic /lidar_up] [--output FILE] [--max_messages N]
+ *                                     [--per_message] [--param name=value ...]
+ */
+
+int main(int argc, char** argv) {
+    rr::ReplayOptions options;
+    options.topic = "/lidar_up";
+    if (!options.parse(argc, argv)) {
+        return 1;
+    }
+
+    double cluster_tolerance = 0.5;
+    int min_cluster_size = 10;
+    int max_cluster_size = 1000000;
+    std::string tracking_frame = "odom";
+    OpponentTrackerParams tracker_params;
+    options.param("cluster_tolerance", cluster_tolerance);
+    options.param("min_cluster_size", min_cluster_size);
+    options.param("max_cluster_size", max_cluster_size);
+    options.param("tracking_frame", tracking_frame);
+    options.param("accel_noise", tracker_params.accel_noise);
+    options.param("measurement_noise", tracker_params.measurement_noise);
+    options.param("initial_velocity_stddev", tracker_params.initial_velocity_stddev);
+    options.param("gate", tracker_params.gate);
+    options.param("min_hits", tracker_params.min_hits);
+    options.param("max_misses", tracker_params.max_misses);
+
+    OpponentDetector detector(VoxelClusterer(cluster_tolerance, min_cluster_size, max_cluster_size), tracker_params);
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+
+    return rr::replayBag<sensor_msgs::PointCloud2>(
+          "opponent_detection", options,
+          [&](const sensor_msgs::PointCloud2ConstPtr& msg, const tf2::BufferCore& tf) {
+              pcl::fromROSMsg(*msg, cloud);
+
+              tf::Transform cloud_to_tracking = tf::Transform::getIdentity();
+              if (!tracking_frame.empty() && tracking_frame != msg->header.frame_id) {
+                  try {
+                      geometry_msgs::TransformStamped transform =
+                            tf.lookupTransform(tracking_frame, msg->header.frame_id, msg->header.stamp);
+                      tf::transformMsgToTF(transform.transform, cloud_to_tracking);
+                  } catch (const tf2::TransformException&) {
+                      return;
+                  }
+              }
+
+              detector.process(cloud, cloud_to_tracking, msg->header.stamp.toSec());
+          },
+          [&](rr::OutputDigest& digest) {
+              digest.addValue(detector.clusters().size());
+              for (unsigned int id : detector.trackIds()) {
+                  digest.addValue(id);
+              }
+              for (const OpponentTracker::Track& track : detector.tracker().tracks()) {
+                  if (track.confirmed(tracker_params)) {
+                      digest.addValue(track.id);
+                      digest.add(track.state.data(), sizeof(double) * track.state.size());
+                  }
+              }
+          });
+}
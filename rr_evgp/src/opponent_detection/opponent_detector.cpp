@@ -0,0 +1,32 @@
+#include "opponent_detector.hpp"
+
+OpponentDetector::OpponentDetector(const VoxelClusterer& clusterer, const OpponentTrackerParams& tracker_params)
+      : clusterer_(clusterer), tracker_(tracker_params) {}
+
+void OpponentDetector::process(const pcl::PointCloud<pcl::PointXYZ>& cloud, const tf::Transform& cloud_to_tracking,
+                               double time) {
+    detect(cloud);
+
+    // velocities only make sense in a frame that does not move with the car
+    detections_.clear();
+    for (const Eigen::Vector3d& centroid : centroids_) {
+        tf::Vector3 p = cloud_to_tracking * tf::Vector3(centroid.x(), centroid.y(), centroid.z());
+        detections_.emplace_back(p.x(), p.y());
+    }
+
+    track_ids_ = tracker_.update(detections_, time);
+}
+
+void OpponentDetector::detect(const pcl::PointCloud<pcl::PointXYZ>& cloud) {
+    clusters_ = clusterer_.cluster(cloud);
+
+    centroids_.clear();
+    for (const std::vector<int>& cluster : clusters_) {
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        for (int idx : cluster) {
+            sum += cloud[idx].getVector3fMap().cast<double>();
+        }
+        centroids_.push_back(sum / cluster.size());
+    }
+    track_ids_.clear();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <tf/transform_datatypes.h>
+
+#include <Eigen/Dense>
+#include <vector>
+
+#include "opponent_tracker.hpp"
+#include "voxel_clusterer.hpp"
+
+/*
+ * Everything opponent_detection does between receiving a cloud and publishing: clusters the cloud, takes each
+ * cluster's centroid as a detection and updates the tracks with them. Needs no ROS, so bag replays can drive it.
+ */
+class OpponentDetector {
+  public:
+    OpponentDetector(const VoxelClusterer& clusterer, const OpponentTrackerParams& tracker_params);
+
+    /*
+     * cloud_to_tracking maps cloud points into the frame tracks are kept in, and time is when the cloud was taken
+     * in seconds.
+     */
+    void process(const pcl::PointCloud<pcl::PointXYZ>& cloud, const tf::Transform& cloud_to_tracking, double time);
+
+    // Clusters and finds centroids without updating the tracks, for clouds that cannot be put in the tracking frame.
+    // No cluster has a track id.
+    void detect(const pcl::PointCloud<pcl::PointXYZ>& cloud);
+
+    // indices into the last cloud for each cluster
+    const std::vector<std::vector<int>>& clusters() const {
+        return clusters_;
+    }
+
+    // mean of each cluster, in the cloud frame
+    const std::vector<Eigen::Vector3d>& centroids() const {
+        return centroids_;
+    }
+
+    // id of the track each cluster was assigned to, empty after detect()
+    const std::vector<unsigned int>& trackIds() const {
+        return track_ids_;
+    }
+
+    const OpponentTracker& tracker() const {
+        return tracker_;
+    }
+
+  private:
+    VoxelClusterer clusterer_;
+    OpponentTracker tracker_;
+
+    std::vector<std::vector<int>> clusters_;
+    std::vector<Eigen::Vector3d> centroids_;
+    std::vector<Eigen::Vector2d> detections_;
+    std::vector<unsigned int> track_ids_;
+};
@@ -0,0 +1,131 @@
+#include "opponent_tracker.hpp"
+
+#include <algorithm>
+
+namespace {
+
+const Eigen::Matrix<double, 2, 4> kObservation = (Eigen::Matrix<double, 2, 4>() << 1, 0, 0, 0, 0, 1, 0, 0).finished();
+
+}  // namespace
+
+OpponentTracker::OpponentTracker(const OpponentTrackerParams& params) : params_(params) {
+    reset();
+}
+
+void OpponentTracker::reset() {
+    tracks_.clear();
+    next_id_ = 0;
+    last_time_ = 0;
+}
+
+void OpponentTracker::predict(Track& track, double dt) const {
+    Eigen::Matrix4d transition = Eigen::Matrix4d::Identity();
+    transition(0, 2) = dt;
+    transition(1, 3) = dt;
+
+    // discrete white noise acceleration, independent in x and y
+    const double q = params_.accel_noise * params_.accel_noise;
+    const double dt2 = dt * dt;
+    Eigen::Matrix4d process_noise = Eigen::Matrix4d::Zero();
+    process_noise(0, 0) = process_noise(1, 1) = q * dt2 * dt2 / 4.0;
+    process_noise(0, 2) = process_noise(2, 0) = process_noise(1, 3) = process_noise(3, 1) = q * dt2 * dt / 2.0;
+    process_noise(2, 2) = process_noise(3, 3) = q * dt2;
+
+    track.state = transition * track.state;
+    track.covariance = transition * track.covariance * transition.transpose() + process_noise;
+}
+
+void OpponentTracker::correct(Track& track, const Eigen::Vector2d& detection) const {
+    const Eigen::Matrix2d measurement_cov =
+          Eigen::Matrix2d::Identity() * params_.measurement_noise * params_.measurement_noise;
+    const Eigen::Matrix2d innovation_cov = kObservation * track.covariance * kObservation.transpose() + measurement_cov;
+    const Eigen::Matrix<double, 4, 2> gain = track.covariance * kObservation.transpose() * innovation_cov.inverse();
+
+    track.state += gain * (detection - kObservation * track.state);
+    track.covariance = (Eigen::Matrix4d::Identity() - gain * kObservation) * track.covariance;
+}
+
+std::vector<unsigned int> OpponentTracker::update(const std::vector<Eigen::Vector2d>& detections, double time) {
+    double dt = time - last_time_;
+    if (last_time_ > 0 && dt < 0) {
+        reset();  // time went backwards (bag restarted), old tracks mean nothing
+        dt = 0;
+    } else if (last_time_ == 0) {
+        dt = 0;
+    }
+    last_time_ = time;
+
+    for (Track& track : tracks_) {
+        predict(track, dt);
+    }
+
+    // every detection / track pair inside the gate, closest first
+    struct Pairing {
+        double distance;
+        size_t track;
+        size_t detection;
+    };
+    std::vector<Pairing> pairings;
+    const Eigen::Matrix2d measurement_cov =
+          Eigen::Matrix2d::Identity() * params_.measurement_noise * params_.measurement_noise;
+    for (size_t t = 0; t < tracks_.size(); t++) {
+        const Track& track = tracks_[t];
+        const Eigen::Matrix2d innovation_cov_inv =
+              (kObservation * track.covariance * kObservation.transpose() + measurement_cov).inverse();
+        for (size_t d = 0; d < detections.size(); d++) {
+            Eigen::Vector2d innovation = detections[d] - kObservation * track.state;
+            double distance = innovation.transpose() * innovation_cov_inv * innovation;
+            if (distance <= params_.gate) {
+                pairings.push_back({ distance, t, d });
+            }
+        }
+    }
+    std::sort(pairings.begin(), pairings.end(),
+              [](const Pairing& lhs, const Pairing& rhs) { return lhs.distance < rhs.distance; });
+
+    std::vector<bool> track_updated(tracks_.size(), false);
+    std::vector<bool> detection_used(detections.size(), false);
+    std::vector<unsigned int> assigned_ids(detections.size());
+    for (const Pairing& pairing : pairings) {
+        if (track_updated[pairing.track] || detection_used[pairing.detection]) {
+            continue;
+        }
+        track_updated[pairing.track] = true;
+        detection_used[pairing.detection] = true;
+
+        Track& track = tracks_[pairing.track];
+        correct(track, detections[pairing.detection]);
+        track.hits++;
+        track.misses = 0;
+        assigned_ids[pairing.detection] = track.id;
+    }
+
+    for (size_t t = 0; t < tracks_.size(); t++) {
+        if (!track_updated[t]) {
+            tracks_[t].misses++;
+        }
+    }
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                                 [this](const Track& track) { return track.misses > params_.max_misses; }),
+                  tracks_.end());
+
+    // anything left over starts a new track at rest
+    for (size_t d = 0; d < detections.size(); d++) {
+        if (detection_used[d]) {
+            continue;
+        }
+        Track track;
+        track.id = next_id_++;
+        track.state << detections[d], 0, 0;
+        track.covariance = Eigen::Matrix4d::Zero();
+        track.covariance.topLeftCorner<2, 2>() = measurement_cov;
+        track.covariance.bottomRightCorner<2, 2>() =
+              Eigen::Matrix2d::Identity() * params_.initial_velocity_stddev * params_.initial_velocity_stddev;
+        track.hits = 1;
+        track.misses = 0;
+        tracks_.push_back(track);
+        assigned_ids[d] = track.id;
+    }
+
+    return assigned_ids;
+}
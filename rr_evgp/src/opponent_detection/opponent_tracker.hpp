@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+struct OpponentTrackerParams {
+    // Standard deviation of the acceleration the constant velocity model does not explain [m/s^2].
+    double accel_noise = 2.0;
+    // Standard deviation of a cluster centroid around the true opponent position [m].
+    double measurement_noise = 0.2;
+    // Velocity uncertainty of a new track [m/s].
+    double initial_velocity_stddev = 3.0;
+    // Squared Mahalanobis distance a detection must be within to update a track (9.21 is 99% for 2 DOF).
+    double gate = 9.21;
+    // Updates before a track is reported.
+    int min_hits = 3;
+    // Consecutive frames without a detection before a track is dropped.
+    int max_misses = 5;
+};
+
+/*
+ * Follows cluster centroids between frames with one constant velocity Kalman filter per opponent. Detections are
+ * gated on Mahalanobis distance to each prediction and associated greedily, closest first.
+ */
+class OpponentTracker {
+  public:
+    struct Track {
+        unsigned int id;
+        Eigen::Vector4d state;  // x, y, vx, vy
+        Eigen::Matrix4d covariance;
+        int hits;
+        int misses;
+
+        bool confirmed(const OpponentTrackerParams& params) const {
+            return hits >= params.min_hits;
+        }
+    };
+
+    explicit OpponentTracker(const OpponentTrackerParams& params);
+
+    /*
+     * Predicts every track forward to time and corrects it with the detections (x, y positions) taken at that time.
+     * Returns the id of the track each detection was assigned to.
+     */
+    std::vector<unsigned int> update(const std::vector<Eigen::Vector2d>& detections, double time);
+
+    void reset();
+
+    const std::vector<Track>& tracks() const {
+        return tracks_;
+    }
+
+  private:
+    OpponentTrackerParams params_;
+    std::vector<Track> tracks_;
+    unsigned int next_id_;
+    double last_time_;
+
+    void predict(Track& track, double dt) const;
+    void correct(Track& track, const Eigen::Vector2d& detection) const;
+};
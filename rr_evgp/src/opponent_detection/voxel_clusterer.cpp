@@ -0,0 +1,153 @@
+#include "voxel_clusterer.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+
+// voxel coordinates packed 21 bits each, covers +-2^20 voxels from the sensor
+constexpr int kCoordBits = 21;
+constexpr int64_t kCoordOffset = int64_t(1) << (kCoordBits - 1);
+constexpr int64_t kCoordMask = (int64_t(1) << kCoordBits) - 1;
+
+inline uint64_t voxelKey(int64_t x, int64_t y, int64_t z) {
+    return (static_cast<uint64_t>((x + kCoordOffset) & kCoordMask) << (2 * kCoordBits)) |
+           (static_cast<uint64_t>((y + kCoordOffset) & kCoordMask) << kCoordBits) |
+           static_cast<uint64_t>((z + kCoordOffset) & kCoordMask);
+}
+
+}  // namespace
+
+VoxelClusterer::VoxelClusterer(double cluster_tolerance, int min_cluster_size, int max_cluster_size)
+      : tolerance_(cluster_tolerance)
+      , voxel_size_(cluster_tolerance / std::sqrt(3.0))
+      , min_cluster_size_(min_cluster_size)
+      , max_cluster_size_(max_cluster_size) {}
+
+int VoxelClusterer::findRoot(int voxel) {
+    while (parents_[voxel] != voxel) {
+        parents_[voxel] = parents_[parents_[voxel]];  // path halving
+        voxel = parents_[voxel];
+    }
+    return voxel;
+}
+
+void VoxelClusterer::join(int a, int b) {
+    a = findRoot(a);
+    b = findRoot(b);
+    if (a == b) {
+        return;
+    }
+    if (sizes_[a] < sizes_[b]) {
+        std::swap(a, b);
+    }
+    parents_[b] = a;
+    sizes_[a] += sizes_[b];
+}
+
+// whether any point of voxel a is within the tolerance of any point of voxel b
+bool VoxelClusterer::withinTolerance(const pcl::PointCloud<pcl::PointXYZ>& cloud, int a, int b) const {
+    const float tolerance_squared = static_cast<float>(tolerance_ * tolerance_);
+    for (int i = voxel_starts_[a]; i < voxel_starts_[a + 1]; i++) {
+        const pcl::PointXYZ& p = cloud[voxel_points_[i]];
+        for (int j = voxel_starts_[b]; j < voxel_starts_[b + 1]; j++) {
+            const pcl::PointXYZ& q = cloud[voxel_points_[j]];
+            const float dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+            if (dx * dx + dy * dy + dz * dz <= tolerance_squared) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<std::vector<int>> VoxelClusterer::cluster(const pcl::PointCloud<pcl::PointXYZ>& cloud) {
+    struct Voxel {
+        int64_t x, y, z;
+    };
+    std::unordered_map<uint64_t, int> voxel_ids;
+    std::vector<Voxel> voxels;
+    voxel_ids.reserve(cloud.size());
+    point_voxels_.assign(cloud.size(), -1);
+
+    for (size_t i = 0; i < cloud.size(); i++) {
+        const pcl::PointXYZ& pt = cloud[i];
+        if (!std::isfinite(pt.x) || !std::isfinite(pt.y) || !std::isfinite(pt.z)) {
+            continue;
+        }
+        Voxel voxel{ static_cast<int64_t>(std::floor(pt.x / voxel_size_)),
+                     static_cast<int64_t>(std::floor(pt.y / voxel_size_)),
+                     static_cast<int64_t>(std::floor(pt.z / voxel_size_)) };
+        auto [it, inserted] = voxel_ids.try_emplace(voxelKey(voxel.x, voxel.y, voxel.z), voxels.size());
+        if (inserted) {
+            voxels.push_back(voxel);
+        }
+        point_voxels_[i] = it->second;
+    }
+
+    parents_.resize(voxels.size());
+    sizes_.assign(voxels.size(), 1);
+    for (size_t v = 0; v < voxels.size(); v++) {
+        parents_[v] = v;
+    }
+
+    // each voxel's points, grouped by a counting sort
+    voxel_starts_.assign(voxels.size() + 1, 0);
+    for (int voxel : point_voxels_) {
+        if (voxel >= 0) {
+            voxel_starts_[voxel + 1]++;
+        }
+    }
+    for (size_t v = 0; v < voxels.size(); v++) {
+        voxel_starts_[v + 1] += voxel_starts_[v];
+    }
+    voxel_points_.resize(voxel_starts_.back());
+    std::vector<int> next(voxel_starts_.begin(), voxel_starts_.end() - 1);
+    for (size_t i = 0; i < cloud.size(); i++) {
+        if (point_voxels_[i] >= 0) {
+            voxel_points_[next[point_voxels_[i]]++] = i;
+        }
+    }
+
+    // compare each voxel with the occupied half of its neighbors up to two voxels away, the other half compare with it
+    for (size_t v = 0; v < voxels.size(); v++) {
+        const Voxel& voxel = voxels[v];
+        for (int dx = -2; dx <= 2; dx++) {
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dz = -2; dz <= 2; dz++) {
+                    if (dx < 0 || (dx == 0 && (dy < 0 || (dy == 0 && dz <= 0)))) {
+                        continue;
+                    }
+                    auto it = voxel_ids.find(voxelKey(voxel.x + dx, voxel.y + dy, voxel.z + dz));
+                    if (it != voxel_ids.end() && findRoot(v) != findRoot(it->second) &&
+                        withinTolerance(cloud, v, it->second)) {
+                        join(v, it->second);
+                    }
+                }
+            }
+        }
+    }
+
+    std::unordered_map<int, size_t> cluster_of_root;
+    std::vector<std::vector<int>> clusters;
+    for (size_t i = 0; i < cloud.size(); i++) {
+        if (point_voxels_[i] < 0) {
+            continue;
+        }
+        auto [it, inserted] = cluster_of_root.try_emplace(findRoot(point_voxels_[i]), clusters.size());
+        if (inserted) {
+            clusters.emplace_back();
+        }
+        clusters[it->second].push_back(i);
+    }
+
+    std::vector<std::vector<int>> sized_clusters;
+    for (auto& cluster : clusters) {
+        if (static_cast<int>(cluster.size()) >= min_cluster_size_ &&
+            static_cast<int>(cluster.size()) <= max_cluster_size_) {
+            sized_clusters.push_back(std::move(cluster));
+        }
+    }
+    return sized_clusters;
+}
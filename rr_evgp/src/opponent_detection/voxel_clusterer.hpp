@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+/*
+ * Euclidean clustering in close to linear time, with the same clusters as pcl::EuclideanClusterExtraction. Points are
+ * hashed into cubic voxels whose diagonal is the cluster tolerance, so the points in a voxel always belong together,
+ * and voxels are joined with a union-find. Points within the tolerance of each other are at most two voxels apart
+ * along each axis, so each voxel is compared with those neighbors, and joined when a pair of their points actually
+ * is within the tolerance.
+ */
+class VoxelClusterer {
+  public:
+    VoxelClusterer(double cluster_tolerance, int min_cluster_size, int max_cluster_size);
+
+    // indices into cloud for each cluster with min_cluster_size to max_cluster_size points
+    std::vector<std::vector<int>> cluster(const pcl::PointCloud<pcl::PointXYZ>& cloud);
+
+  private:
+    double tolerance_;
+    double voxel_size_;
+    int min_cluster_size_;
+    int max_cluster_size_;
+
+    // reused between clouds
+    std::vector<int> point_voxels_;
+    std::vector<int> voxel_starts_;  // voxel v's points are voxel_points_[voxel_starts_[v]] up to voxel v + 1's
+    std::vector<int> voxel_points_;
+    std::vector<int> parents_;
+    std::vector<int> sizes_;
+
+    int findRoot(int voxel);
+    void join(int a, int b);
+    bool withinTolerance(const pcl::PointCloud<pcl::PointXYZ>& cloud, int a, int b) const;
+};
@@ -0,0 +1,239 @@
+#include <rr_evgp/skeletonize.h>
+
+#include <array>
+#include <bitset>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace rr {
+
+namespace {
+
+/*
+ * The 8-neighborhood of a pixel packed into a byte, one bit per neighbor going clockwise from north
+ *  7 0 1
+ *  6 * 2
+ *  5 4 3
+ */
+enum Neighbor : uint8_t {
+    N = 1 << 0,
+    NE = 1 << 1,
+    E = 1 << 2,
+    SE = 1 << 3,
+    S = 1 << 4,
+    SW = 1 << 5,
+    W = 1 << 6,
+    NW = 1 << 7,
+};
+
+inline uint8_t neighborhood(const cv::Mat& grid, int r, int c) {
+    const uint8_t* above = grid.ptr<uint8_t>(r - 1);
+    const uint8_t* row = grid.ptr<uint8_t>(r);
+    const uint8_t* below = grid.ptr<uint8_t>(r + 1);
+    return (above[c] ? N : 0) | (above[c + 1] ? NE : 0) | (row[c + 1] ? E : 0) | (below[c + 1] ? SE : 0) |
+           (below[c] ? S : 0) | (below[c - 1] ? SW : 0) | (row[c - 1] ? W : 0) | (above[c - 1] ? NW : 0);
+}
+
+using DeletionTable = std::array<bool, 256>;
+
+/*
+ * Whether a set pixel with a given neighborhood is removed in one of the two Zhang-Suen subiterations.
+ * ref "A Fast Parallel Algorithm for Thinning Digital Patterns"
+ */
+DeletionTable makeDeletionTable(bool first_subiteration) {
+    DeletionTable table{};
+    for (int code = 0; code < 256; code++) {
+        int num_neighbors = std::bitset<8>(code).count();
+
+        // number of 0 -> 1 transitions going clockwise around the pixel
+        int rising_edges = 0;
+        for (int i = 0; i < 8; i++) {
+            rising_edges += !(code & (1 << i)) && (code & (1 << ((i + 1) % 8)));
+        }
+
+        bool n = code & N, e = code & E, s = code & S, w = code & W;
+        bool pattern = first_subiteration ? !(n && e && s) && !(e && s && w) : !(n && e && w) && !(n && s && w);
+        table[code] = num_neighbors >= 2 && num_neighbors <= 6 && rising_edges == 1 && pattern;
+    }
+    return table;
+}
+
+const std::array<DeletionTable, 2>& deletionTables() {
+    static const std::array<DeletionTable, 2> tables = { makeDeletionTable(true), makeDeletionTable(false) };
+    return tables;
+}
+
+constexpr int kBandRows = 16;
+
+/*
+ * Zhang-Suen thinning in place. The border of grid must be zero.
+ *
+ * Only pixels touching the background can ever be removed, so each band of rows keeps a list of those (the frontier)
+ * and only looks at them. A subiteration first decides deletions for every band in parallel against the unchanged
+ * grid, then each band applies its own deletions and adds the set neighbors of deleted pixels to its frontier. Bands
+ * only write to their own rows, so no locking is needed.
+ */
+void zhangSuenThin(cv::Mat& grid) {
+    const int num_bands = (grid.rows + kBandRows - 1) / kBandRows;
+    std::vector<std::vector<cv::Point>> frontier(num_bands);
+    std::vector<std::vector<cv::Point>> deleted(num_bands);
+    cv::Mat queued(grid.size(), CV_8UC1, cv::Scalar(0));
+
+    cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            for (int r = std::max(1, b * kBandRows); r < std::min(grid.rows - 1, (b + 1) * kBandRows); r++) {
+                const uint8_t* row = grid.ptr<uint8_t>(r);
+                for (int c = 1; c < grid.cols - 1; c++) {
+                    if (row[c] && neighborhood(grid, r, c) != 0xFF) {
+                        frontier[b].emplace_back(c, r);
+                        queued.at<uint8_t>(r, c) = 1;
+                    }
+                }
+            }
+        }
+    });
+
+    bool changed;
+    do {
+        changed = false;
+        for (const DeletionTable& table : deletionTables()) {
+            cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range& range) {
+                for (int b = range.start; b < range.end; b++) {
+                    deleted[b].clear();
+                    for (const cv::Point& p : frontier[b]) {
+                        if (table[neighborhood(grid, p.y, p.x)]) {
+                            deleted[b].push_back(p);
+                        }
+                    }
+                }
+            });
+
+            cv::parallel_for_(cv::Range(0, num_bands), [&](const cv::Range& range) {
+                for (int b = range.start; b < range.end; b++) {
+                    for (const cv::Point& p : deleted[b]) {
+                        grid.at<uint8_t>(p) = 0;
+                    }
+
+                    std::vector<cv::Point>& band_frontier = frontier[b];
+                    size_t kept = 0;
+                    for (const cv::Point& p : band_frontier) {
+                        if (grid.at<uint8_t>(p)) {
+                            band_frontier[kept++] = p;
+                        } else {
+                            queued.at<uint8_t>(p) = 0;
+                        }
+                    }
+                    band_frontier.resize(kept);
+
+                    // neighbors of deleted pixels are now on the boundary, they may come from the bands next to us
+                    for (int other = std::max(0, b - 1); other <= std::min(num_bands - 1, b + 1); other++) {
+                        for (const cv::Point& p : deleted[other]) {
+                            for (int r = p.y - 1; r <= p.y + 1; r++) {
+                                if (r / kBandRows != b) {
+                                    continue;
+                                }
+                                const uint8_t* row = grid.ptr<uint8_t>(r);
+                                uint8_t* queued_row = queued.ptr<uint8_t>(r);
+                                for (int c = p.x - 1; c <= p.x + 1; c++) {
+                                    if (row[c] && !queued_row[c]) {
+                                        queued_row[c] = 1;
+                                        band_frontier.emplace_back(c, r);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+
+            for (const auto& band_deleted : deleted) {
+                changed |= !band_deleted.empty();
+            }
+        }
+    } while (changed);
+}
+
+}  // namespace
+
+cv::Mat thinObstacles(const cv::Mat& grid_in) {
+    cv::Mat grid_skel(grid_in.size(), CV_8U, cv::Scalar(0));
+
+    std::vector<cv::Point> points;
+    cv::findNonZero(grid_in, points);
+    if (points.empty()) {
+        return grid_skel;
+    }
+    cv::Rect r = cv::boundingRect(points);
+
+    cv::Mat grid;
+    grid_in(r).copyTo(grid);
+
+    // eliminate border
+    grid.row(0).setTo(0);
+    grid.row(grid.rows - 1).setTo(0);
+    grid.col(0).setTo(0);
+    grid.col(grid.cols - 1).setTo(0);
+
+    zhangSuenThin(grid);
+
+    // remove staircases
+    // shamelessly borrowed from https://github.com/yati-sagade/zhang-suen-thinning/blob/master/zhangsuen.cpp
+    // this pass works in place, so it stays sequential
+    for (int iter = 0; iter < 2; iter++) {
+        for (int i = 1; i < grid.rows - 1; i++) {
+            const uint8_t* above = grid.ptr<uint8_t>(i - 1);
+            uint8_t* row = grid.ptr<uint8_t>(i);
+            const uint8_t* below = grid.ptr<uint8_t>(i + 1);
+            for (int j = 1; j < grid.cols - 1; j++) {
+                if (!row[j]) {
+                    continue;
+                }
+                int e = row[j + 1], ne = above[j + 1], n = above[j], nw = above[j - 1], w = row[j - 1],
+                    sw = below[j - 1], s = below[j], se = below[j + 1];
+
+                if (iter == 0) {
+                    // North biased staircase removal
+                    if ((n && ((e && !ne && !sw && (!w || !s)) || (w && !nw && !se && (!e || !s))))) {
+                        row[j] = 0;
+                    }
+                } else {
+                    // South bias staircase removal
+                    if ((s && ((e && !se && !nw && (!w || !n)) || (w && !sw && !ne && (!e || !n))))) {
+                        row[j] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    grid.copyTo(grid_skel(r));
+    return grid_skel;
+}
+
+cv::Mat removeSmallBranches(const cv::Mat& img, const int min_branch_length) {
+    cv::Mat line_kernel(3, 3, CV_8U, cv::Scalar(1));
+    line_kernel.at<uint8_t>(1, 1) = 10;
+
+    cv::Mat filtered_img;
+    cv::filter2D(img / 255, filtered_img, CV_16S, line_kernel);
+
+    cv::Mat branches;
+    cv::inRange(filtered_img, cv::Scalar(11), cv::Scalar(12), branches);
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(branches, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    cv::Mat big_branches(img.rows, img.cols, CV_8U, cv::Scalar(0));
+    for (size_t i = 0; i < contours.size(); i++) {
+        if (cv::arcLength(contours[i], false) >= min_branch_length) {
+            cv::drawContours(big_branches, contours, i, cv::Scalar(255), 1);
+        }
+    }
+
+    big_branches.setTo(cv::Scalar(255), filtered_img >= 13);
+
+    return big_branches;
+}
+
+}  // namespace rr
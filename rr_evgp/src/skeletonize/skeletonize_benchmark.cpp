@@ -1,7 +1,23 @@
+#include <rr_evgp/skeletonize.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 #include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/*
+ * Times rr::thinObstacles against the per-pixel implementation it replaced and checks that both give the same
+ * skeleton. Runs on synthetic track maps, plus any images passed on the command line (e.g. the track textures in
+ * rr_gazebo/materials), preprocessed the same way TrackClosingLayer does before thinning.
+ *
+ * usage: skeletonize_benchmark [iterations] [image ...]
+ */
 
-namespace rr {
+namespace reference {
 
+// Zhang-Suen thinning as it was written before the table driven version, kept as a baseline
 cv::Mat thinObstacles(const cv::Mat& grid_in) {
     std::vector<cv::Point> points;
     cv::findNonZero(grid_in, points);
@@ -129,30 +145,113 @@ cv::Mat thinObstacles(const cv::Mat& grid_in) {
     return grid_skel;
 }
 
-cv::Mat removeSmallBranches(const cv::Mat& img, const int min_branch_length) {
-    cv::Mat line_kernel(3, 3, CV_8U, cv::Scalar(1));
-    line_kernel.at<uint8_t>(1, 1) = 10;
+}  // namespace reference
+
+namespace {
 
-    cv::Mat filtered_img;
-    cv::filter2D(img / 255, filtered_img, CV_16S, line_kernel);
+constexpr int kDilateSize = 10;  // TrackClosingLayer dilate_size used on the car
 
-    cv::Mat branches;
-    cv::inRange(filtered_img, cv::Scalar(11), cv::Scalar(12), branches);
+// close gaps between cones / wall segments the way TrackClosingLayer does before skeletonizing
+cv::Mat closeWalls(const cv::Mat& walls) {
+    cv::Mat grid;
+    int kernel_size = 2 * kDilateSize + 1;
+    cv::morphologyEx(walls, grid, cv::MORPH_DILATE,
+                     cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(kernel_size, kernel_size)));
+    kernel_size = 2 * kDilateSize - 1;
+    cv::morphologyEx(grid, grid, cv::MORPH_ERODE,
+                     cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(kernel_size, kernel_size)));
+    return grid;
+}
 
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(branches, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+// two elliptical track walls seen by a lidar, with dropouts
+cv::Mat makeWalledTrack(int size, cv::RNG& rng) {
+    cv::Mat walls(size, size, CV_8UC1, cv::Scalar(0));
+    const cv::Point center(size / 2, size / 2);
+    for (const cv::Size& axes : { cv::Size(size * 2 / 5, size / 3), cv::Size(size * 2 / 5 - 60, size / 3 - 60) }) {
+        for (int angle = 0; angle < 360; angle += 6) {
+            if (rng.uniform(0, 10) > 0) {
+                cv::ellipse(walls, center, axes, 0, angle, angle + 5, cv::Scalar(255), 2);
+            }
+        }
+    }
+    return closeWalls(walls);
+}
 
-    cv::Mat big_branches(img.rows, img.cols, CV_8U, cv::Scalar(0));
-    for (size_t i = 0; i < contours.size(); i++) {
-        if (cv::arcLength(contours[i], false) >= min_branch_length) {
-            cv::drawContours(big_branches, contours, i, cv::Scalar(255), 1);
+// a track marked only by cones, with some noise in the middle
+cv::Mat makeConeTrack(int size, cv::RNG& rng) {
+    cv::Mat walls(size, size, CV_8UC1, cv::Scalar(0));
+    const cv::Point2d center(size / 2.0, size / 2.0);
+    for (double radius : { size * 0.4, size * 0.4 - 60 }) {
+        for (double angle = 0; angle < 2 * CV_PI; angle += 0.08) {
+            cv::Point2d p(center.x + radius * std::cos(angle) + rng.gaussian(1.5),
+                          center.y + 0.8 * radius * std::sin(angle) + rng.gaussian(1.5));
+            cv::circle(walls, p, 2, cv::Scalar(255), cv::FILLED);
         }
     }
+    for (int i = 0; i < 40; i++) {
+        cv::circle(walls, cv::Point(rng.uniform(0, size), rng.uniform(0, size)), 1, cv::Scalar(255), cv::FILLED);
+    }
+    return closeWalls(walls);
+}
+
+cv::Mat loadTrackImage(const std::string& path) {
+    cv::Mat image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+    if (image.empty()) {
+        return image;
+    }
+    // track images have dark lines / walls on a light background
+    cv::Mat walls;
+    cv::threshold(image, walls, 127, 255, cv::THRESH_BINARY_INV);
+    return closeWalls(walls);
+}
+
+template <typename Function>
+double medianMs(Function f, int iterations) {
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+bool runCase(const std::string& name, const cv::Mat& grid, int iterations) {
+    cv::Mat expected = reference::thinObstacles(grid);
+    cv::Mat actual = rr::thinObstacles(grid);
+    bool same = cv::countNonZero(expected != actual) == 0;
 
-    big_branches.setTo(cv::Scalar(255), filtered_img >= 13);
-    thinObstacles(big_branches);
+    double reference_ms = medianMs([&grid]() { reference::thinObstacles(grid); }, iterations);
+    double table_ms = medianMs([&grid]() { rr::thinObstacles(grid); }, iterations);
 
-    return big_branches;
+    std::cout << name << " (" << grid.cols << "x" << grid.rows << ", " << cv::countNonZero(grid) << " px)"
+              << ": reference " << reference_ms << " ms, table " << table_ms << " ms, speedup "
+              << reference_ms / table_ms << "x" << (same ? "" : "  OUTPUT DIFFERS") << std::endl;
+    return same;
 }
 
-}  // namespace rr
+}  // namespace
+
+int main(int argc, char** argv) {
+    int iterations = (argc > 1) ? std::stoi(argv[1]) : 10;
+
+    cv::RNG rng(42);
+    bool ok = true;
+    ok &= runCase("walled track", makeWalledTrack(700, rng), iterations);
+    ok &= runCase("cone track", makeConeTrack(700, rng), iterations);
+    ok &= runCase("large walled track", makeWalledTrack(2000, rng), iterations);
+
+    for (int i = 2; i < argc; i++) {
+        cv::Mat grid = loadTrackImage(argv[i]);
+        if (grid.empty()) {
+            std::cerr << "Could not read " << argv[i] << std::endl;
+            ok = false;
+            continue;
+        }
+        ok &= runCase(argv[i], grid, iterations);
+    }
+
+    return ok ? 0 : 1;
+}
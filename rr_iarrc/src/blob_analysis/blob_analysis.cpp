@@ -0,0 +1,151 @@
+#include "blob_analysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+namespace rr {
+
+namespace {
+
+double circularityOf(int area, double perimeter) {
+    return perimeter > 0 ? 4 * M_PI * area / (perimeter * perimeter) : 0;
+}
+
+}  // namespace
+
+double Blob::orientation() const {
+    return 0.5 * std::atan2(2 * mu11, mu20 - mu02);
+}
+
+cv::RotatedRect Blob::equivalentRect() const {
+    if (area == 0) {
+        return cv::RotatedRect();
+    }
+    // Eigenvalues of the covariance. A uniform bar of length n has variance n^2 / 12, and the extra 1/12 accounts for
+    // the extent of the pixels themselves so that a one pixel wide line comes out one pixel wide.
+    const double a = mu20 / area;
+    const double b = mu11 / area;
+    const double c = mu02 / area;
+    const double mean = (a + c) / 2;
+    const double spread = std::sqrt((a - c) * (a - c) / 4 + b * b);
+    const double major = std::sqrt(12 * (mean + spread) + 1);
+    const double minor = std::sqrt(std::max(12 * (mean - spread) + 1, 0.0));
+    return cv::RotatedRect(cv::Point2f(centroid), cv::Size2f(major, minor), orientation() * 180 / M_PI);
+}
+
+Blob merge(const std::vector<Blob>& blobs) {
+    Blob merged;
+    for (const auto& blob : blobs) {
+        merged.area += blob.area;
+        merged.bbox = merged.bbox.area() == 0 ? blob.bbox : (merged.bbox | blob.bbox);
+        merged.centroid += blob.centroid * blob.area;
+        merged.perimeter += blob.perimeter;
+    }
+    if (merged.area == 0) {
+        return merged;
+    }
+    merged.centroid /= merged.area;
+
+    // Parallel axis theorem: each blob contributes its own moments plus those of its mass about the pooled centroid
+    for (const auto& blob : blobs) {
+        const cv::Point2d d = blob.centroid - merged.centroid;
+        merged.mu20 += blob.mu20 + blob.area * d.x * d.x;
+        merged.mu11 += blob.mu11 + blob.area * d.x * d.y;
+        merged.mu02 += blob.mu02 + blob.area * d.y * d.y;
+    }
+    merged.circularity = circularityOf(merged.area, merged.perimeter);
+    return merged;
+}
+
+const std::vector<Blob>& BlobAnalyzer::analyze(const cv::Mat& mask, const cv::Rect& roi, int min_area) {
+    CV_Assert(mask.type() == CV_8UC1);
+    const cv::Rect frame(0, 0, mask.cols, mask.rows);
+    const cv::Rect region = roi.area() > 0 ? (roi & frame) : frame;
+
+    blobs_.clear();
+    if (region.area() == 0) {
+        return blobs_;
+    }
+
+    // A one pixel background border means every foreground pixel has all eight neighbours, so the moment pass below
+    // needs no bounds checks and components touching the ROI edge still get a closed perimeter.
+    cv::copyMakeBorder(mask(region), padded_, 1, 1, 1, 1, cv::BORDER_CONSTANT, cv::Scalar(0));
+    const int num_labels = cv::connectedComponentsWithStats(padded_, labels_, stats_, centroids_, 8, CV_32S);
+
+    blob_index_.assign(num_labels, -1);
+    sums_.clear();
+    for (int label = 1; label < num_labels; label++) {
+        const int* stat = stats_.ptr<int>(label);
+        if (stat[cv::CC_STAT_AREA] < min_area) {
+            continue;
+        }
+        blob_index_[label] = static_cast<int>(blobs_.size());
+        Blob blob;
+        blob.area = stat[cv::CC_STAT_AREA];
+        blob.bbox = cv::Rect(stat[cv::CC_STAT_LEFT], stat[cv::CC_STAT_TOP], stat[cv::CC_STAT_WIDTH],
+                             stat[cv::CC_STAT_HEIGHT]);
+        blobs_.push_back(blob);
+        sums_.push_back(Sums{});
+    }
+    if (blobs_.empty()) {
+        return blobs_;
+    }
+
+    // Rows outside every kept component can be skipped entirely
+    int first_row = labels_.rows;
+    int last_row = 0;
+    for (const auto& blob : blobs_) {
+        first_row = std::min(first_row, blob.bbox.y);
+        last_row = std::max(last_row, blob.bbox.y + blob.bbox.height);
+    }
+
+    const ptrdiff_t stride = labels_.step1();
+    for (int y = first_row; y < last_row; y++) {
+        const int* row = labels_.ptr<int>(y);
+        for (int x = 1; x < labels_.cols - 1; x++) {
+            const int label = row[x];
+            if (label == 0 || blob_index_[label] < 0) {
+                continue;
+            }
+            const int index = blob_index_[label];
+            Sums& s = sums_[index];
+            const Blob& blob = blobs_[index];
+
+            // Accumulate relative to the bounding box corner to keep the sums small
+            const double dx = x - blob.bbox.x;
+            const double dy = y - blob.bbox.y;
+            s.sx += dx;
+            s.sy += dy;
+            s.sxx += dx * dx;
+            s.sxy += dx * dy;
+            s.syy += dy * dy;
+
+            const int* p = row + x;
+            s.axis_crossings += (p[-1] != label) + (p[1] != label) + (p[-stride] != label) + (p[stride] != label);
+            s.diagonal_crossings += (p[-stride - 1] != label) + (p[-stride + 1] != label) +
+                                    (p[stride - 1] != label) + (p[stride + 1] != label);
+        }
+    }
+
+    const cv::Point offset(region.x - 1, region.y - 1);
+    for (size_t i = 0; i < blobs_.size(); i++) {
+        Blob& blob = blobs_[i];
+        const Sums& s = sums_[i];
+        const double mx = s.sx / blob.area;
+        const double my = s.sy / blob.area;
+        blob.mu20 = s.sxx - s.sx * mx;
+        blob.mu11 = s.sxy - s.sx * my;
+        blob.mu02 = s.syy - s.sy * my;
+        blob.centroid = cv::Point2d(blob.bbox.x + mx + offset.x, blob.bbox.y + my + offset.y);
+        blob.bbox += offset;
+
+        // Cauchy-Crofton with four line directions weighted pi/4 each; diagonal lines are 1/sqrt(2) apart. Exact
+        // for discs, within a few percent for other convex shapes.
+        blob.perimeter = M_PI / 8 * (s.axis_crossings + s.diagonal_crossings / M_SQRT2);
+        blob.circularity = circularityOf(blob.area, blob.perimeter);
+    }
+    return blobs_;
+}
+
+}  // namespace rr
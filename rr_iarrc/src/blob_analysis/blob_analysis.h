@@ -0,0 +1,58 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace rr {
+
+// Shape summary of one connected component of a binary mask. Coordinates are in the frame of the full mask, even
+// when only a region of interest was labeled.
+struct Blob {
+    int area = 0;  // pixel count
+    cv::Rect bbox;
+    cv::Point2d centroid;
+    double mu20 = 0, mu11 = 0, mu02 = 0;  // central second moments, same convention as cv::Moments
+    double perimeter = 0;                 // Crofton estimate over 0, 45, 90 and 135 degree crossings
+    double circularity = 0;               // 4 * pi * area / perimeter^2, close to 1 for a disc
+
+    // Angle of the major axis from +x in radians, in image coordinates (y down), within [-pi/2, pi/2]
+    double orientation() const;
+
+    // Rectangle with the same centroid, orientation and second moments as the blob. For bars and lines this is a
+    // cheap stand-in for cv::minAreaRect; width is along the major axis and angle is in degrees.
+    cv::RotatedRect equivalentRect() const;
+};
+
+// Combines several blobs into one, pooling their moments as if they were a single component
+Blob merge(const std::vector<Blob>& blobs);
+
+// Labels a binary mask with cv::connectedComponentsWithStats and fills in the moments and perimeter of each kept
+// component in a single pass over the label image. Buffers are reused between calls, so keep one analyzer per
+// mask stream.
+class BlobAnalyzer {
+  public:
+    // Analyzes the nonzero pixels of an 8-bit mask inside roi (the whole mask when roi is empty). Components with
+    // fewer than min_area pixels are dropped before the moment pass. The returned reference is valid until the next
+    // call.
+    const std::vector<Blob>& analyze(const cv::Mat& mask, const cv::Rect& roi = cv::Rect(), int min_area = 0);
+
+    const std::vector<Blob>& blobs() const {
+        return blobs_;
+    }
+
+  private:
+    cv::Mat padded_;
+    cv::Mat labels_;
+    cv::Mat stats_;
+    cv::Mat centroids_;
+    std::vector<int> blob_index_;  // label -> index into blobs_, or -1 when pruned
+
+    struct Sums {
+        double sx, sy, sxx, sxy, syy;
+        int axis_crossings, diagonal_crossings;
+    };
+    std::vector<Sums> sums_;
+    std::vector<Blob> blobs_;
+};
+
+}  // namespace rr
@@ -0,0 +1,25 @@
+#include "roi_tracker.h"
+
+namespace rr {
+
+RoiTracker::RoiTracker(int padding, int reacquire_period)
+      : padding_(padding), reacquire_period_(reacquire_period), frames_since_search_(0) {}
+
+cv::Rect RoiTracker::next(const cv::Rect& bounds) {
+    if (!tracking() || (reacquire_period_ > 0 && frames_since_search_ >= reacquire_period_)) {
+        frames_since_search_ = 0;
+        return bounds;
+    }
+    frames_since_search_++;
+
+    cv::Rect padded(target_.x - padding_, target_.y - padding_, target_.width + 2 * padding_,
+                    target_.height + 2 * padding_);
+    padded &= bounds;
+    return padded.area() > 0 ? padded : bounds;
+}
+
+void RoiTracker::update(const cv::Rect& target) {
+    target_ = target;
+}
+
+}  // namespace rr
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+namespace rr {
+
+// Keeps a padded region of interest around a target that barely moves between frames. The full search area is used
+// whenever the target is lost, and also every reacquire_period frames so a better candidate elsewhere is not missed.
+class RoiTracker {
+  public:
+    explicit RoiTracker(int padding = 0, int reacquire_period = 0);
+
+    // Region to process in the next frame, always within bounds. A reacquire_period of 0 disables periodic full
+    // searches.
+    cv::Rect next(const cv::Rect& bounds);
+
+    // Reports where the target was found in the region returned by next(), in full frame coordinates. An empty rect
+    // means it was not found.
+    void update(const cv::Rect& target);
+
+    bool tracking() const {
+        return target_.area() > 0;
+    }
+
+  private:
+    int padding_;
+    int reacquire_period_;
+    int frames_since_search_;
+    cv::Rect target_;
+};
+
+}  // namespace rr
@@ -2,7 +2,6 @@
 
 #include <pluginlib/class_list_macros.h>
 #include <ros/package.h>
-#include <rr_msgs/hsv_tuned.h>
 
 #include <ctime>
 #include <fstream>
@@ -34,40 +33,40 @@ void color_detector::ImageCB(const sensor_msgs::ImageConstPtr &msg) {
 
     const Mat &frameBGR = cv_ptr->image;
     Mat frameBlurred;
-    GaussianBlur(frameBGR, frameBlurred, Size{ 0, 0 }, 1);
-    Mat frameHSV;
-    cvtColor(frameBlurred, frameHSV, CV_BGR2HSV);
+    GaussianBlur(frameBGR(mask), frameBlurred, Size{ 0, 0 }, 1);
 
-    const Mat frame_masked = frameHSV(mask);
-
-    Mat output_white = Mat::zeros(mask.height, mask.width, CV_8UC1);
-
-    auto white_low = Scalar(white_h_low, white_s_low, white_v_low);
-    auto white_high = Scalar(white_h_high, white_s_high, white_v_high);
-    inRange(frame_masked, white_low, white_high, output_white);
+    Mat labels, output_white;
+    classifier.classify(frameBlurred, labels);
+    rr::ColorClassifier::mask(labels, 0, output_white);
 
     erode(output_white, output_white, erosion_kernel_white);
     dilate(output_white, output_white, dilation_kernel_white);
 
-    Mat output = Mat::zeros(frameHSV.rows, frameHSV.cols, CV_8UC1);
+    Mat output = Mat::zeros(frameBGR.rows, frameBGR.cols, CV_8UC1);
     Mat output_masked = output(mask);
     output_masked.setTo(255, output_white);
 
     img_pub.publish(cv_bridge::CvImage{ std_msgs::Header(), "mono8", output }.toImageMsg());
 }
 
-void hsvTunedCallback(const rr_msgs::hsv_tuned::ConstPtr &msg) {
+void color_detector::hsvTunedCallback(const rr_msgs::hsv_tuned::ConstPtr &msg) {
     white_h_low = msg->white_h_low;
     white_s_low = msg->white_s_low;
     white_v_low = msg->white_v_low;
 
-    white_h_low = msg->white_h_low;
-    white_s_low = msg->white_s_low;
-    white_v_low = msg->white_v_low;
+    white_h_high = msg->white_h_high;
+    white_s_high = msg->white_s_high;
+    white_v_high = msg->white_v_high;
 
+    updateClassifier();
     ROS_INFO("Set HSV limits");
 }
 
+void color_detector::updateClassifier() {
+    classifier.setRange(0, rr::ColorClassifier::HSV, Scalar(white_h_low, white_s_low, white_v_low),
+                        Scalar(white_h_high, white_s_high, white_v_high));
+}
+
 void loadValues() {
     string line;
     int value;
@@ -120,8 +119,9 @@ void color_detector::onInit() {
     std::string default_load_file_path = package_path + "/saved_hsv/example.txt";
     pnh.param(std::string("load_file"), load_file_path, default_load_file_path);
     loadValues();
+    updateClassifier();
 
-    ros::Subscriber hsv_tuned_sub = nh.subscribe(hsv_values_topic, 1, hsvTunedCallback);
+    hsv_tuned_sub = nh.subscribe(hsv_values_topic, 1, &color_detector::hsvTunedCallback, this);
 
     mask = Rect(0, 482, 1280, 482);  // x, y, w, h
 
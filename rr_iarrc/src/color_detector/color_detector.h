@@ -2,6 +2,8 @@
 #include <image_transport/image_transport.h>
 #include <nodelet/nodelet.h>
 #include <ros/ros.h>
+#include <rr_common/color_classifier.h>
+#include <rr_msgs/hsv_tuned.h>
 #include <sensor_msgs/Image.h>
 
 namespace rr_iarrc {
@@ -9,6 +11,7 @@ class color_detector : public nodelet::Nodelet {
   private:
     image_transport::Publisher img_pub;
     image_transport::Subscriber img_sub;
+    ros::Subscriber hsv_tuned_sub;
     cv::Rect mask;
 
     cv::Mat erosion_kernel_blue;
@@ -20,7 +23,12 @@ class color_detector : public nodelet::Nodelet {
     cv::Mat dilation_kernel_white;
     cv::Mat dilation_kernel_yellow;
 
+    // White is label 0, rebuilt whenever the limits change
+    rr::ColorClassifier classifier;
+
     void ImageCB(const sensor_msgs::ImageConstPtr &msg);
+    void hsvTunedCallback(const rr_msgs::hsv_tuned::ConstPtr &msg);
+    void updateClassifier();
 
     virtual void onInit();
 };
@@ -1,6 +1,7 @@
 #include <cv_bridge/cv_bridge.h>
 #include <ros/publisher.h>
 #include <ros/ros.h>
+#include <rr_common/color_classifier.h>
 #include <sensor_msgs/Image.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,6 +19,8 @@ int blockSky_height, blockWheels_height, blockBumper_height;
 int originalWidth, originalHeight;
 int decreasedSize = 400;
 
+std::unique_ptr<rr::ColorClassifier> orange_classifier;
+
 cv::Mat kernel(int x, int y) {
     return cv::getStructuringElement(cv::MORPH_RECT, cv::Size(x, y));
 }
@@ -64,9 +67,9 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
     cv::resize(frame, frame, cv::Size(decreasedSize, decreasedSize));
 
     // Get Orange-HSV Cones
-    cv::Mat hsv_frame, orange_found, debug_img;
-    cv::cvtColor(frame, hsv_frame, cv::COLOR_BGR2HSV);
-    cv::inRange(hsv_frame, cv::Scalar(low_H, low_S, low_V), cv::Scalar(high_H, 255, 255), orange_found);
+    cv::Mat labels, orange_found, debug_img;
+    orange_classifier->classify(frame, labels);
+    rr::ColorClassifier::mask(labels, 0, orange_found);
     blockEnvironment(orange_found);
 
     // Gets the Bottom of the Orange Color Thresholding
@@ -102,6 +105,10 @@ int main(int argc, char** argv) {
     nhp.param("orange_low_S", low_S, 140);
     nhp.param("orange_low_V", low_V, 140);
 
+    orange_classifier = std::make_unique<rr::ColorClassifier>();
+    orange_classifier->setRange(0, rr::ColorClassifier::HSV, cv::Scalar(low_H, low_S, low_V),
+                                cv::Scalar(high_H, 255, 255));
+
     nhp.param("blockSky_height", blockSky_height, 220);
     nhp.param("blockWheels_height", blockWheels_height, 200);
     nhp.param("blockBumper_height", blockBumper_height, 200);
@@ -3,6 +3,7 @@
 #include <pcl_ros/point_cloud.h>
 #include <ros/publisher.h>
 #include <ros/ros.h>
+#include <rr_common/color_classifier.h>
 #include <sensor_msgs/CameraInfo.h>
 #include <sensor_msgs/Image.h>
 #include <sensor_msgs/PointCloud2.h>
@@ -17,18 +18,20 @@
 #include <iostream>
 #include <opencv2/opencv.hpp>
 
+#include "blob_analysis.h"
 #include "std_msgs/Float64MultiArray.h"
 
 using namespace std;
 
 // Image Processing
 void blockEnvironment(const cv::Mat&);
-cv::Mat find_orange_in_ROI(const cv::Mat&);
+cv::Rect detection_roi(const cv::Size&);
+cv::Mat find_orange_in_ROI(const cv::Mat&, const cv::Rect&);
 cv::Mat cutSmall(const cv::Mat&, int);
 cv::Mat canny_cut_bodies(const cv::Mat&, const cv::Mat&);
 cv::Mat find_unique_centers(const cv::Mat&, double);
 cv::Mat perform_watershed(const cv::Mat&, const cv::Mat&, const cv::Mat&);
-cv::Mat draw_box_and_calc_dist(const cv::Mat&, const cv::Mat&);
+cv::Mat draw_box_and_calc_dist(const cv::Mat&, const cv::Mat&, const cv::Rect&);
 cv::Mat kernel(int, int);
 void publishImage(ros::Publisher, cv::Mat, std::string);
 
@@ -37,8 +40,10 @@ int blockSky_height, blockWheels_height, blockBumper_height;
 typedef cv::Mat Mat;
 typedef cv::Point Point;
 int low_H, high_H, low_S, low_V;
+std::unique_ptr<rr::ColorClassifier> orange_classifier;
 int canny_cut_min_threshold, minimum_area_cut;
 double percent_max_distance_transform;
+rr::BlobAnalyzer blob_analyzer;
 
 // PointCloud Processing
 pcl::PointCloud<pcl::PointXYZ> draw_cone_circles();
@@ -132,23 +137,20 @@ void publishImage(ros::Publisher pub, Mat img, std::string img_type) {
     }
 }
 
-cv::Mat draw_box_and_calc_dist(const cv::Mat& frame, const cv::Mat& sure_bodies) {
-    vector<vector<Point>> contours;
-    findContours(sure_bodies, contours, CV_RETR_TREE, CV_CHAIN_APPROX_SIMPLE);
-    vector<cv::Rect> rect(contours.size());
+cv::Mat draw_box_and_calc_dist(const cv::Mat& frame, const cv::Mat& sure_bodies, const cv::Rect& roi) {
     cone_points.clear();
 
-    for (int i = 0; i < contours.size(); i++) {
-        rect[i] = boundingRect(contours[i]);
-        if (rect[i].height < 10 || rect[i].width < 5 || rect[i].width > 4 * rect[i].height) {
+    // A blob at least 10 rows tall has at least 10 pixels, so anything smaller can be pruned before the moment pass
+    for (const auto& blob : blob_analyzer.analyze(sure_bodies, roi, 10)) {
+        const cv::Rect& rect = blob.bbox;
+        if (blob.perimeter <= minimum_area_cut || rect.height < 10 || rect.width < 5 || rect.width > 4 * rect.height) {
             continue;
         }
 
-        cv::Moments m = moments(contours[i], true);
-        Point center = Point(m.m10 / m.m00, m.m01 / m.m00);
+        Point center(blob.centroid);
 
         int offset = 0;
-        double distance = (real_cone_height * fy) / rect[i].height;
+        double distance = (real_cone_height * fy) / rect.height;
         int px_horz_dist = frame.cols / 2 - center.x;
         double horz_dist = distance * px_horz_dist / fy;
 
@@ -162,7 +164,7 @@ cv::Mat draw_box_and_calc_dist(const cv::Mat& frame, const cv::Mat& sure_bodies)
         line(frame, Point(frame.cols / 2, 0), Point(frame.cols / 2, frame.rows), (0, 255, 0), 2);
 
         // Debugging Printing
-        // printf("Pixels: (%d, %d) Real: (%.2f, %.2f)\n", rect[i].height,
+        // printf("Pixels: (%d, %d) Real: (%.2f, %.2f)\n", rect.height,
         // px_horz_dist, distance, horz_dist);
 
         stringstream stream_dist, stream_horz_dist;
@@ -170,8 +172,7 @@ cv::Mat draw_box_and_calc_dist(const cv::Mat& frame, const cv::Mat& sure_bodies)
         stream_horz_dist << fixed << setprecision(1) << horz_dist;
         string position = "(" + stream_dist.str() + ", " + stream_horz_dist.str() + ")";
 
-        drawContours(frame, contours, i, cv::Scalar(0, 255), 1, 8, vector<cv::Vec4i>(), 0, Point());
-        rectangle(frame, rect[i].tl(), rect[i].br(), cv::Scalar(0, 255), 3, 8, 0);
+        rectangle(frame, rect.tl(), rect.br(), cv::Scalar(0, 255), 3, 8, 0);
         circle(frame, center, 5, cv::Scalar(255, 0, 255), cv::FILLED, 8, 0);
         putText(frame, position, Point(center.x - 80, center.y - 30), cv::FONT_HERSHEY_SIMPLEX, 1,
                 cv::Scalar(255, 255, 255), 2, true);
@@ -275,13 +276,23 @@ cv::Mat cutSmall(const cv::Mat& color_edges, int size_min) {
     return contours_color;
 }
 
-cv::Mat find_orange_in_ROI(const cv::Mat& img) {
-    cv::Mat hsv_frame, orange_found, frame_cut;
-    frame_cut = img.clone();
-    blockEnvironment(frame_cut);
-    cv::cvtColor(frame_cut, hsv_frame, cv::COLOR_BGR2HSV);
-    cv::inRange(hsv_frame, cv::Scalar(low_H, low_S, low_V), cv::Scalar(high_H, 255, 255), orange_found);
-    orange_found = cutSmall(orange_found, minimum_area_cut);
+cv::Rect detection_roi(const cv::Size& size) {
+    int top = std::clamp(blockSky_height, 0, size.height);
+    int bottom = std::clamp(blockWheels_height, top, size.height);
+    return cv::Rect(0, top, size.width, bottom - top);
+}
+
+cv::Mat find_orange_in_ROI(const cv::Mat& img, const cv::Rect& roi) {
+    // Only the rows between the sky and wheel blocks are classified; the rest of the mask stays empty
+    cv::Mat labels;
+    cv::Mat orange_found = cv::Mat::zeros(img.size(), CV_8UC1);
+    if (roi.area() == 0) {
+        return orange_found;
+    }
+    cv::Mat orange_roi = orange_found(roi);
+    orange_classifier->classify(img(roi), labels);
+    rr::ColorClassifier::mask(labels, 0, orange_roi);
+    blockEnvironment(orange_found);
     return orange_found;
 }
 
@@ -301,7 +312,8 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
     cv::Mat frame = cv_ptr->image;
 
     // Find Orange HSV in Region of interest
-    cv::Mat orange_found = find_orange_in_ROI(frame);
+    cv::Rect roi = detection_roi(frame.size());
+    cv::Mat orange_found = find_orange_in_ROI(frame, roi);
 
     // Cut HSV to find individual cones
     //    cv::Mat detected_bodies = canny_cut_bodies(frame, orange_found);
@@ -309,7 +321,7 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
     //    detected_bodies);
 
     // Find Distance
-    frame = draw_box_and_calc_dist(frame, orange_found);
+    frame = draw_box_and_calc_dist(frame, orange_found, roi);
 
     // publish Images
     publishImage(pub_debug_pos, frame, "bgr8");
@@ -334,6 +346,10 @@ int main(int argc, char** argv) {
     nhp.param("orange_low_S", low_S, 140);
     nhp.param("orange_low_V", low_V, 140);
 
+    orange_classifier = std::make_unique<rr::ColorClassifier>();
+    orange_classifier->setRange(0, rr::ColorClassifier::HSV, cv::Scalar(low_H, low_S, low_V),
+                                cv::Scalar(high_H, 255, 255));
+
     nhp.param("canny_min_threshold", canny_cut_min_threshold, 40);
     nhp.param("percent_max_distance_transform", percent_max_distance_transform, 0.7);
     nhp.param("minimum_area_cut", minimum_area_cut, 40);
@@ -11,6 +11,7 @@
 #include <opencv2/opencv.hpp>
 
 #include "PID.h"
+#include "sliding_window.h"
 
 using namespace std;
 
@@ -32,46 +33,18 @@ PID myPID(&input, &outputSteering, &setpoint, 0.0, 0.0, 0.0, P_ON_E, REVERSE);
 
 double speedGoal;
 bool useHistogramFinder;
+int minWindowPixels;
 
 cv::Mat kernel(int x, int y) {
     return cv::getStructuringElement(cv::MORPH_RECT, cv::Size(x, y));
 }
 
-cv::Mat getColHist(cv::Mat img) {
-    cv::Mat1i pixels(img.cols, 1);
-    for (int x = 0; x < img.cols; x++) {
-        cv::Mat col = img.col(x);
-        pixels(x, 0) = cv::countNonZero(col);
-    }
-    return pixels;
-}
-
-// re-center around the average x coordinate of the line segment
-// returns true if he currCenter changed.
-bool centerOnLineSegment(cv::Mat imGray, cv::Point& currCenter, cv::Point offset, int width, int height) {
-    cv::Point topLeft = currCenter - offset;
-    int sumX = 0;
-    int count = 0;
-    for (int y = topLeft.y; y < topLeft.y + height; y++) {
-        for (int x = topLeft.x; x < topLeft.x + width; x++) {
-            if ((int)imGray.at<unsigned char>(y, x) > 0) {
-                sumX += x;
-                count++;
-            }
-        }
-    }
-    if (count != 0) {  //#TODO: set a minimum threshold of pixels
-        // we found a line segment
-        int avgX = sumX / count;
-        currCenter.x = avgX;
-        return true;
-    }
-
-    return false;
-}
+rr::MaskIntegral integral;
+rr::SlidingWindowTracker leftTracker, rightTracker;
 
 // find the "center line" to follow
-std::vector<cv::Point> createCenterLine(std::vector<cv::Point> leftLine, std::vector<cv::Point> rightLine) {
+std::vector<cv::Point> createCenterLine(const std::vector<cv::Point>& leftLine,
+                                        const std::vector<cv::Point>& rightLine) {
     std::vector<cv::Point> centerLine;
     for (int i = 0; i < leftLine.size(); i++) {
         int x = cvRound((leftLine[i].x + rightLine[i].x) / 2);
@@ -90,9 +63,9 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
     // Convert msg to Mat image
     cv_bridge::CvImagePtr cv_ptr = cv_bridge::toCvCopy(msg, "mono8");
     cv::Mat frame = cv_ptr->image;
-    cv::Mat output;
-    cv::cvtColor(frame, output,
-                 cv::COLOR_GRAY2BGR);  // Doing this just for debugging
+
+    // Every window and histogram bin below is a constant time lookup into these tables
+    integral.compute(frame);
 
     setpoint = frame.cols / 2;  // want our center line on the center of the camera
     cv::Point rightMaxLoc;
@@ -100,18 +73,17 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
 
     if (useHistogramFinder) {
         // locate beginnings of lines by a large number of pixels in the column
-        cv::Mat hist = getColHist(frame);
-        // left line
+        cv::Mat1i hist;
+        integral.columnHistogram(0, frame.rows, hist);
         double max;
         double min;
         cv::Point rightMinLoc;
         cv::Point leftMinLoc;
-        cv::minMaxLoc(hist(cv::Range(0, hist.rows / 2 - 1), cv::Range::all()), &min, &max, &leftMinLoc, &leftMaxLoc);
-        leftMaxLoc.x = leftMaxLoc.y;  // gotta flip x and y
+        cv::minMaxLoc(hist(cv::Range::all(), cv::Range(0, hist.cols / 2 - 1)), &min, &max, &leftMinLoc, &leftMaxLoc);
         leftMaxLoc.y = frame.rows - 1;
-        cv::minMaxLoc(hist(cv::Range(hist.rows / 2, hist.rows - 1), cv::Range::all()), &min, &max, &rightMinLoc,
+        cv::minMaxLoc(hist(cv::Range::all(), cv::Range(hist.cols / 2, hist.cols - 1)), &min, &max, &rightMinLoc,
                       &rightMaxLoc);
-        rightMaxLoc.x = rightMaxLoc.y + hist.rows / 2;
+        rightMaxLoc.x += hist.cols / 2;
         rightMaxLoc.y = frame.rows - 1;
 
         if (rightMaxLoc.x == frame.cols / 2) {
@@ -124,8 +96,10 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
         rightMaxLoc.y = 80;  // 120
         leftMaxLoc.y = 80;
         int w = (frame.cols) / 2;
-        bool rightFound = centerOnLineSegment(frame, rightMaxLoc, cv::Point(w / 2, 32), w - 1, 16);
-        bool leftFound = centerOnLineSegment(frame, leftMaxLoc, cv::Point(w / 2, 32), w - 1, 16);
+        cv::Rect rightSearch(rightMaxLoc.x - w / 2, rightMaxLoc.y - 32, w - 1, 16);
+        cv::Rect leftSearch(leftMaxLoc.x - w / 2, leftMaxLoc.y - 32, w - 1, 16);
+        bool rightFound = integral.meanX(rightSearch, minWindowPixels, rightMaxLoc.x);
+        bool leftFound = integral.meanX(leftSearch, minWindowPixels, leftMaxLoc.x);
         if (!rightFound) {
             rightMaxLoc.x = frame.cols / 2 + 40;
         }
@@ -134,64 +108,18 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
         }
     }
 
-    // debug visualization
-    cv::circle(output, leftMaxLoc, 8, cv::Scalar(0, 0, 255), -1);
-    cv::circle(output, rightMaxLoc, 8, cv::Scalar(0, 255, 255), -1);
-
-    int width = 40;  //#TODO: this will be updated to not be hardcoded.
-    int height = 16;
-
-    cv::Point offset(width / 2, height / 2);
-
-    cv::Point rightCenter = rightMaxLoc;
-    rightCenter.y = frame.rows - height / 2;
-
-    std::vector<cv::Point> rightLinePoints;
-    rightLinePoints.push_back(rightCenter);
-
-    cv::Point leftCenter = leftMaxLoc;
-    leftCenter.y = frame.rows - height / 2;
-
-    std::vector<cv::Point> leftLinePoints;
-    leftLinePoints.push_back(leftCenter);
-
-    while (rightCenter.y >= 0) {
-        centerOnLineSegment(frame, rightCenter, offset, width, height);
-        cv::circle(output, rightCenter, 2, cv::Scalar(0, 0, 255), -1);
-        cv::Point rightBox_topLeft = rightCenter - offset;
-        cv::rectangle(output, rightBox_topLeft, rightCenter + offset, cv::Scalar(0, 255, 0), 1);
-        rightCenter.y -= height;
-
-        rightLinePoints.push_back(rightCenter);
-
-        centerOnLineSegment(frame, leftCenter, offset, width, height);
-        cv::circle(output, leftCenter, 2, cv::Scalar(0, 0, 255), -1);
-        cv::Point leftBox_topLeft = leftCenter - offset;
-        cv::rectangle(output, leftBox_topLeft, leftCenter + offset, cv::Scalar(0, 255, 0), 1);
-        leftCenter.y -= height;
-
-        leftLinePoints.push_back(leftCenter);
-    }
+    const std::vector<cv::Point>& rightLinePoints = rightTracker.track(integral, rightMaxLoc.x);
+    const std::vector<cv::Point>& leftLinePoints = leftTracker.track(integral, leftMaxLoc.x);
 
     std::vector<cv::Point> centerLane = createCenterLine(leftLinePoints, rightLinePoints);
-    cv::polylines(output, centerLane, false, cv::Scalar(255, 0, 0), 2);
 
     // find error, P term. Maybe add curvature and stuff
-    cv::Point goal = centerLane[centerLane.size() / 2];
-    int error = (frame.cols / 2) - goal.x;
+    cv::Point goal = centerLane.empty() ? cv::Point(frame.cols / 2, frame.rows / 2) : centerLane[centerLane.size() / 2];
 
-    // double steering = error * 0.01; //kP
     input = static_cast<double>(goal.x);
     myPID.Compute();
     double steering = outputSteering;
 
-    // debug visualization
-    cv::putText(output, std::to_string(steering), cv::Point(20, 100), cv::FONT_HERSHEY_PLAIN, 1, cv::Scalar(0, 255, 0),
-                1);
-    cv::line(output, cv::Point(frame.cols / 2, 0), cv::Point(frame.cols / 2, frame.rows - 1), cv::Scalar(0, 255, 255),
-             1);                                                                          // center
-    cv::line(output, goal, cv::Point(frame.cols / 2, goal.y), cv::Scalar(0, 0, 255), 1);  // error amount
-
     speed_message.speed = speedGoal;
     steer_message.angle = steering;
     speed_pub.publish(speed_message);
@@ -199,6 +127,25 @@ void img_callback(const sensor_msgs::ImageConstPtr& msg) {
 
     // Publish Message
     if (pub_line_detector.getNumSubscribers() > 0) {
+        cv::Mat output;
+        cv::cvtColor(frame, output, cv::COLOR_GRAY2BGR);
+
+        cv::circle(output, leftMaxLoc, 8, cv::Scalar(0, 0, 255), -1);
+        cv::circle(output, rightMaxLoc, 8, cv::Scalar(0, 255, 255), -1);
+        for (const auto* tracker : { &leftTracker, &rightTracker }) {
+            for (const auto& center : tracker->centers()) {
+                cv::circle(output, center, 2, cv::Scalar(0, 0, 255), -1);
+                cv::rectangle(output, tracker->window(center), cv::Scalar(0, 255, 0), 1);
+            }
+        }
+        cv::polylines(output, centerLane, false, cv::Scalar(255, 0, 0), 2);
+
+        cv::putText(output, std::to_string(steering), cv::Point(20, 100), cv::FONT_HERSHEY_PLAIN, 1,
+                    cv::Scalar(0, 255, 0), 1);
+        cv::line(output, cv::Point(frame.cols / 2, 0), cv::Point(frame.cols / 2, frame.rows - 1),
+                 cv::Scalar(0, 255, 255), 1);                                                 // center
+        cv::line(output, goal, cv::Point(frame.cols / 2, goal.y), cv::Scalar(0, 0, 255), 1);  // error amount
+
         sensor_msgs::Image outmsg;
         cv_ptr->image = output;
         cv_ptr->encoding = "bgr8";
@@ -223,10 +170,19 @@ int main(int argc, char** argv) {
 
     nhp.param("useHistogramFinder", useHistogramFinder, false);
 
+    int windowWidth, windowHeight, pidSampleTime;
+    nhp.param("window_width", windowWidth, 40);
+    nhp.param("window_height", windowHeight, 16);
+    nhp.param("min_window_pixels", minWindowPixels, 1);
+    nhp.param("pid_sample_time_ms", pidSampleTime, 100);
+    leftTracker = rr::SlidingWindowTracker(cv::Size(windowWidth, windowHeight), minWindowPixels);
+    rightTracker = rr::SlidingWindowTracker(cv::Size(windowWidth, windowHeight), minWindowPixels);
+
     double maxTurnLimit;
     nhp.param("maxTurnLimitRadians", maxTurnLimit, 0.44);
 
     // setup PID controllers
+    myPID.SetSampleTime(pidSampleTime);
     myPID.SetTunings(kP, kI, kD);
     myPID.SetMode(AUTOMATIC);
     myPID.SetOutputLimits(-maxTurnLimit, maxTurnLimit);
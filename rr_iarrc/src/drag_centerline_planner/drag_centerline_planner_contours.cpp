@@ -227,7 +227,11 @@ int main(int argc, char** argv) {
 
     nhp.param("maxTurnLimitRadians", maxTurnLimit, 0.44);
 
+    int pidSampleTime;
+    nhp.param("pid_sample_time_ms", pidSampleTime, 100);
+
     // setup PID controllers
+    myPID.SetSampleTime(pidSampleTime);
     myPID.SetTunings(kP, kI, kD);
     myPID.SetMode(AUTOMATIC);
     myPID.SetOutputLimits(-maxTurnLimit, maxTurnLimit);
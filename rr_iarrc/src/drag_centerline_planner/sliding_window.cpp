@@ -0,0 +1,99 @@
+#include "sliding_window.h"
+
+#include <algorithm>
+
+namespace rr {
+
+void MaskIntegral::compute(const cv::Mat& mask) {
+    CV_Assert(mask.type() == CV_8UC1);
+    count_.create(mask.rows + 1, mask.cols + 1);
+    sum_x_.create(mask.rows + 1, mask.cols + 1);
+    count_.row(0).setTo(0);
+    sum_x_.row(0).setTo(0);
+
+    // Both tables in one pass: running sums along the row, added to the table row above
+    for (int y = 0; y < mask.rows; y++) {
+        const uchar* pixels = mask.ptr<uchar>(y);
+        const int* count_above = count_[y];
+        const double* sum_x_above = sum_x_[y];
+        int* count_row = count_[y + 1];
+        double* sum_x_row = sum_x_[y + 1];
+        count_row[0] = 0;
+        sum_x_row[0] = 0;
+
+        int row_count = 0;
+        double row_sum_x = 0;
+        for (int x = 0; x < mask.cols; x++) {
+            if (pixels[x]) {
+                row_count++;
+                row_sum_x += x;
+            }
+            count_row[x + 1] = count_above[x + 1] + row_count;
+            sum_x_row[x + 1] = sum_x_above[x + 1] + row_sum_x;
+        }
+    }
+}
+
+cv::Rect MaskIntegral::clip(const cv::Rect& rect) const {
+    return rect & cv::Rect(cv::Point(0, 0), size());
+}
+
+int MaskIntegral::count(const cv::Rect& rect) const {
+    const cv::Rect r = clip(rect);
+    return r.area() > 0 ? boxSum(count_, r) : 0;
+}
+
+bool MaskIntegral::meanX(const cv::Rect& rect, int min_pixels, int& x) const {
+    const cv::Rect r = clip(rect);
+    if (r.area() == 0) {
+        return false;
+    }
+    const int n = boxSum(count_, r);
+    if (n == 0 || n < min_pixels) {
+        return false;
+    }
+    x = static_cast<int>(boxSum(sum_x_, r) / n);
+    return true;
+}
+
+void MaskIntegral::columnHistogram(int top, int bottom, cv::Mat1i& hist) const {
+    const cv::Size s = size();
+    top = std::max(top, 0);
+    bottom = std::min(bottom, s.height);
+    hist.create(1, s.width);
+    if (bottom <= top) {
+        hist.setTo(0);
+        return;
+    }
+    const int* upper = count_[top];
+    const int* lower = count_[bottom];
+    int* bins = hist[0];
+    for (int x = 0; x < s.width; x++) {
+        bins[x] = (lower[x + 1] - lower[x]) - (upper[x + 1] - upper[x]);
+    }
+}
+
+SlidingWindowTracker::SlidingWindowTracker(cv::Size window, int min_pixels)
+      : window_(window), min_pixels_(min_pixels) {}
+
+const std::vector<cv::Point>& SlidingWindowTracker::track(const MaskIntegral& integral, int start_x) {
+    std::swap(centers_, previous_centers_);
+    std::swap(found_, previous_found_);
+    centers_.clear();
+    found_.clear();
+
+    int x = start_x;
+    bool below_found = true;
+    size_t i = 0;
+    for (int y = integral.size().height - window_.height / 2; y >= 0; y -= window_.height, i++) {
+        if (!below_found && i < previous_found_.size() && previous_found_[i]) {
+            x = previous_centers_[i].x;
+        }
+        below_found = integral.meanX(window(cv::Point(x, y)), min_pixels_, x);
+        centers_.emplace_back(x, y);
+        found_.push_back(below_found);
+    }
+    return centers_;
+}
+
+}  // namespace rr
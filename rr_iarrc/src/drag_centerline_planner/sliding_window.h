@@ -0,0 +1,71 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+namespace rr {
+
+// Summed-area tables of a binary mask and of the x coordinates of its set pixels. After one pass over the mask the
+// pixel count and mean column of any rectangle, and so every sliding window and column histogram bin, cost O(1).
+class MaskIntegral {
+  public:
+    void compute(const cv::Mat& mask);
+
+    cv::Size size() const {
+        return cv::Size(count_.cols - 1, count_.rows - 1);
+    }
+
+    // Number of set pixels in rect, clipped to the mask
+    int count(const cv::Rect& rect) const;
+
+    // Mean column of the set pixels in rect. Returns false, leaving x alone, when there are fewer than min_pixels.
+    bool meanX(const cv::Rect& rect, int min_pixels, int& x) const;
+
+    // Number of set pixels in each column between rows top and bottom, as a 1 x cols row vector
+    void columnHistogram(int top, int bottom, cv::Mat1i& hist) const;
+
+  private:
+    cv::Rect clip(const cv::Rect& rect) const;
+
+    template <typename T>
+    static T boxSum(const cv::Mat_<T>& table, const cv::Rect& r) {
+        return table(r.y + r.height, r.x + r.width) - table(r.y, r.x + r.width) - table(r.y + r.height, r.x) +
+               table(r.y, r.x);
+    }
+
+    cv::Mat1i count_;
+    cv::Mat1d sum_x_;
+};
+
+// Follows one line up the image with a stack of windows, each recentered on the mean column of the pixels inside it.
+// Window positions are kept between frames: when the window below lost the line, a window starts where it found the
+// line on the previous frame rather than carrying on straight up, which bridges gaps in dashed lines.
+class SlidingWindowTracker {
+  public:
+    explicit SlidingWindowTracker(cv::Size window = cv::Size(40, 16), int min_pixels = 1);
+
+    // Runs every window from the bottom of the image, starting at column start_x, and returns their centers from the
+    // bottom up. The reference is valid until the next call.
+    const std::vector<cv::Point>& track(const MaskIntegral& integral, int start_x);
+
+    const std::vector<cv::Point>& centers() const {
+        return centers_;
+    }
+
+    // Whether each window found enough pixels on the last call
+    const std::vector<bool>& found() const {
+        return found_;
+    }
+
+    cv::Rect window(const cv::Point& center) const {
+        return cv::Rect(center.x - window_.width / 2, center.y - window_.height / 2, window_.width, window_.height);
+    }
+
+  private:
+    cv::Size window_;
+    int min_pixels_;
+    std::vector<cv::Point> centers_, previous_centers_;
+    std::vector<bool> found_, previous_found_;
+};
+
+}  // namespace rr
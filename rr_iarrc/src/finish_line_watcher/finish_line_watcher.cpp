@@ -1,7 +1,7 @@
 /*
  * Publishes the number of times the robot has crossed the
  * finish line.
- * Utilize the color_detector and hsv_tuner and contours
+ * Utilize the color_detector and hsv_tuner and blob analysis
  * to detect the finish line.
  */
 
@@ -13,10 +13,14 @@
 #include <sensor_msgs/Image.h>
 #include <std_msgs/Int8.h>
 
+#include <algorithm>
 #include <climits>
 #include <cmath>
 #include <opencv2/opencv.hpp>
 
+#include "blob_analysis.h"
+#include "roi_tracker.h"
+
 using namespace std;
 
 using uchar = unsigned char;
@@ -51,6 +55,9 @@ int state = LOW;
 
 int number_of_crosses = 0;
 
+rr::BlobAnalyzer blob_analyzer;
+rr::RoiTracker roi_tracker;
+
 void blockEnvironment(const cv::Mat& img) {
     cv::rectangle(img, cv::Point(0, 0), cv::Point(img.cols, blockSky_height), cv::Scalar(0), cv::FILLED);
 
@@ -74,28 +81,12 @@ void ImageCB(const sensor_msgs::ImageConstPtr& msg) {
     frame = cv_ptr->image;
     blockEnvironment(frame);
 
-    // Matrix used to draw debug info
-    cv::Mat debugDrawing = cv::Mat::zeros(frame.size(), CV_8UC3);
-    cv::cvtColor(frame, debugDrawing, cv::COLOR_GRAY2BGR);
-
-    // Find contours
-    vector<vector<cv::Point>> contours;
-    cv::findContours(frame, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
-
-    // Filter out very small contours
-    vector<cv::Point> filteredContourPoints;
-    for (int i = 0; i < contours.size(); i++) {
-        cv::Scalar color(0, 0, 255);
-
-        if (cv::contourArea(contours.at(i)) > min_contour_area) {
-            filteredContourPoints.insert(std::end(filteredContourPoints), std::begin(contours.at(i)),
-                                         std::end(contours.at(i)));
-            color = cv::Scalar(0, 255, 0);
-        }
-
-        // Debug draw
-        cv::drawContours(debugDrawing, contours, i, color, 2, 8);
-    }
+    // Only label the rows between the sky and wheel blocks, narrowed to the area around the line once it is found,
+    // and drop very small blobs
+    int top = std::clamp(blockSky_height, 0, frame.rows);
+    int bottom = std::clamp(blockWheels_height, top, frame.rows);
+    cv::Rect roi = roi_tracker.next(cv::Rect(0, top, frame.cols, bottom - top));
+    const vector<rr::Blob>& blobs = blob_analyzer.analyze(frame, roi, static_cast<int>(std::ceil(min_contour_area)));
 
     bool detected = false;
     bool drawRectDebug = false;
@@ -103,24 +94,18 @@ void ImageCB(const sensor_msgs::ImageConstPtr& msg) {
     cv::Size2f size;
     float angle;
 
-    if (filteredContourPoints.size() > 0) {
-        // Fit a rect to the points and detect based on angle and width
-        fitRect = cv::minAreaRect(filteredContourPoints);
+    if (blobs.size() > 0) {
+        // Fit a rect with the same second moments as all the blobs together and detect based on angle and width.
+        // The rect's width is always along the major axis, so the angle is measured from horizontal.
+        rr::Blob stripe = rr::merge(blobs);
+        fitRect = stripe.equivalentRect();
         size = fitRect.size;
         drawRectDebug = true;
-        // Check the detection criteria (must look at both width and height because OpenCV is inconsistent about how it
-        // assigns them)
-        if (size.height > size.width)
-            angle = std::abs(fitRect.angle) - 90;
-        else
-            angle = std::abs(fitRect.angle);
-        detected = std::abs(angle) < angle_cutoff && (size.width > width_cutoff || size.height > width_cutoff);
-
-        cv::Point2f rectPoints[4];
-        fitRect.points(rectPoints);
-
-        for (int i = 0; i < 4; i++)
-            cv::line(debugDrawing, rectPoints[i], rectPoints[(i + 1) % 4], cv::Scalar(255, 0, 0), 2, 12);
+        angle = fitRect.angle;
+        detected = std::abs(angle) < angle_cutoff && size.width > width_cutoff;
+        roi_tracker.update(stripe.bbox);
+    } else {
+        roi_tracker.update(cv::Rect());
     }
 
     auto incrementCrossNum = false;
@@ -150,7 +135,19 @@ void ImageCB(const sensor_msgs::ImageConstPtr& msg) {
 
     if (debug_pub.getNumSubscribers() > 0) {
         // Draw some debug info
+        cv::Mat debugDrawing;
+        cv::cvtColor(frame, debugDrawing, cv::COLOR_GRAY2BGR);
+        cv::rectangle(debugDrawing, roi, cv::Scalar(255, 255, 255), 2);
+        for (const auto& blob : blobs) {
+            cv::rectangle(debugDrawing, blob.bbox, cv::Scalar(0, 255, 0), 2, 8);
+        }
+
         if (drawRectDebug) {
+            cv::Point2f rectPoints[4];
+            fitRect.points(rectPoints);
+            for (int i = 0; i < 4; i++)
+                cv::line(debugDrawing, rectPoints[i], rectPoints[(i + 1) % 4], cv::Scalar(255, 0, 0), 2, 12);
+
             std::string angle_str = std::string("Angle: ") + std::to_string(angle);
             cv::putText(debugDrawing, angle_str, cv::Point(5, 100), cv::FONT_HERSHEY_SIMPLEX, 2,
                         cv::Scalar(0, 143, 143), 2);
@@ -201,6 +198,11 @@ int main(int argc, char** argv) {
     nhp.param("angle_cutoff", angle_cutoff, 20.0);
     nhp.param("width_cutoff", width_cutoff, 275.0);
 
+    int roi_padding, reacquire_period;
+    nhp.param("roi_padding", roi_padding, 100);
+    nhp.param("reacquire_period", reacquire_period, 15);
+    roi_tracker = rr::RoiTracker(roi_padding, reacquire_period);
+
     ROS_INFO("Finish line watching %s", img_topic.c_str());
 
     ros::Subscriber img_saver_sub = nh.subscribe(img_topic, 1, ImageCB);
@@ -0,0 +1,68 @@
+#include <cv_bridge/cv_bridge.h>
+#include <rr_common/bag_replay.h>
+#include <sensor_msgs/Image.h>
+
+#include "line_detector.h"
+
+/*
+ * Replays camera images from a bag through rr::LaplacianLineDetector, without a ROS master, and reports processing
+ * time per frame, peak memory and a digest of the line masks. Parameters default to
+ * laplacian_line_detector_front.launch; pass --param debug=true to include drawing the debug image.
+ *
+ * usage: laplacian_line_detector_benchmark --bag FILE [--topic /camera_center/image_color_rect] [--output FILE]
+ *                                          [--max_messages N] [--per_message] [--param name=value ...]
+ */
+
+int main(int argc, char** argv) {
+    rr::ReplayOptions options;
+    options.topic = "/camera_center/image_color_rect";
+    if (!options.parse(argc, argv)) {
+        return 1;
+    }
+
+    rr::LaplacianLineDetector::Params params;
+    params.min_blob_area = 100;
+    params.laplacian_threshold_min = -280;
+    params.laplacian_threshold_max = -10;
+    params.adaptive_mean_threshold = 0;
+    params.block_sky_height = 560;
+    params.block_wheels_height = 750;
+    params.block_bumper_height = 720;
+    params.ignore_color_low_H = 130;
+    params.ignore_color_high_H = 190;
+    params.ignore_color_low_S = 100;
+    params.ignore_color_high_S = 255;
+    params.ignore_color_low_V = 70;
+    params.ignore_color_high_V = 255;
+    bool debug = false;
+
+    options.param("min_blob_area", params.min_blob_area);
+    options.param("laplacian_threshold_min", params.laplacian_threshold_min);
+    options.param("laplacian_threshold_max", params.laplacian_threshold_max);
+    options.param("ignore_adaptive", params.ignore_adaptive);
+    options.param("adaptive_mean_threshold", params.adaptive_mean_threshold);
+    options.param("blockSky_height", params.block_sky_height);
+    options.param("blockWheels_height", params.block_wheels_height);
+    options.param("blockBumper_height", params.block_bumper_height);
+    options.param("ignore_color_low_H", params.ignore_color_low_H);
+    options.param("ignore_color_high_H", params.ignore_color_high_H);
+    options.param("ignore_color_low_S", params.ignore_color_low_S);
+    options.param("ignore_color_high_S", params.ignore_color_high_S);
+    options.param("ignore_color_low_V", params.ignore_color_low_V);
+    options.param("ignore_color_high_V", params.ignore_color_high_V);
+    options.param("debug", debug);
+
+    rr::LaplacianLineDetector detector(params);
+    cv::Mat lines, img_debug;
+
+    return rr::replayBag<sensor_msgs::Image>(
+          "laplacian_line_detector", options,
+          [&](const sensor_msgs::ImageConstPtr& msg, const tf2::BufferCore&) {
+              lines = detector.detect(cv_bridge::toCvShare(msg, "bgr8")->image, debug ? &img_debug : nullptr);
+          },
+          [&](rr::OutputDigest& digest) {
+              for (int r = 0; r < lines.rows; r++) {
+                  digest.add(lines.ptr(r), lines.cols * lines.elemSize());
+              }
+          });
+}
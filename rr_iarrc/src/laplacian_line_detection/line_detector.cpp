@@ -0,0 +1,162 @@
+#include "line_detector.h"
+
+#include <opencv2/opencv.hpp>
+
+namespace rr {
+
+namespace {
+
+cv::Mat kernel(int x, int y) {
+    return cv::getStructuringElement(cv::MORPH_RECT, cv::Size(x, y));
+}
+
+cv::Mat getBlurredGrayImage(const cv::Mat& frame) {
+    cv::Mat frame_gray, frame_blur;
+    cv::GaussianBlur(frame, frame_blur, cv::Size(5, 5), 0);
+    cv::cvtColor(frame_blur, frame_gray, cv::COLOR_BGR2GRAY);
+    return frame_gray;
+}
+
+cv::Mat floorfillAreas(const cv::Mat& lines, const cv::Mat& color_found) {
+    cv::Mat color_left, lines_found(lines.rows, lines.cols, CV_8UC1, cv::Scalar::all(0));
+    cv::Mat lines_remaining = lines.clone();
+    lines.copyTo(color_left, color_found);
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(color_left, contours, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
+    for (int i = 0; i < contours.size(); i++) {
+        cv::floodFill(lines_remaining, contours[i][0], cv::Scalar(0));
+    }
+    cv::bitwise_xor(lines, lines_remaining, lines_found);
+    return lines_found;
+}
+
+cv::Mat cutSmall(const cv::Mat& color_edges, int size_min) {
+    cv::Mat contours_color(color_edges.rows, color_edges.cols, CV_8UC1, cv::Scalar::all(0));
+    std::vector<std::vector<cv::Point>> contours;
+
+    cv::findContours(color_edges, contours, CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE);
+    for (int i = 0; i < contours.size(); i++) {
+        if (size_min < cv::contourArea(contours[i], false)) {
+            cv::drawContours(contours_color, contours, i, cv::Scalar(255), cv::FILLED, 8);
+        }
+    }
+    return contours_color;
+}
+
+}  // namespace
+
+LaplacianLineDetector::LaplacianLineDetector(const Params& params) : params_(params), original_height_(resize_dim) {
+    ignore_color_classifier_.setRange(
+          0, ColorClassifier::HSV,
+          cv::Scalar(params_.ignore_color_low_H, params_.ignore_color_low_S, params_.ignore_color_low_V),
+          cv::Scalar(params_.ignore_color_high_H, params_.ignore_color_high_S, params_.ignore_color_high_V));
+}
+
+cv::Mat LaplacianLineDetector::getIgnoreColorMask(const cv::Mat& frame) const {
+    cv::Mat labels, ignore_color_mask;
+    ignore_color_classifier_.classify(frame, labels);
+    ColorClassifier::mask(labels, 0, ignore_color_mask);
+    cv::erode(ignore_color_mask, ignore_color_mask, kernel(2, 2));
+    return ignore_color_mask;
+}
+
+void LaplacianLineDetector::blockEnvironment(const cv::Mat& img) const {
+    cv::rectangle(img, cv::Point(0, 0), cv::Point(img.cols, params_.block_sky_height * resize_dim / original_height_),
+                  cv::Scalar(0, 0, 0), cv::FILLED);
+
+    cv::rectangle(img, cv::Point(0, img.rows),
+                  cv::Point(img.cols, params_.block_wheels_height * resize_dim / original_height_), cv::Scalar(0),
+                  cv::FILLED);
+
+    cv::rectangle(img, cv::Point(img.cols / 3, img.rows),
+                  cv::Point(2 * img.cols / 3, params_.block_bumper_height * resize_dim / original_height_),
+                  cv::Scalar(0), cv::FILLED);
+}
+
+cv::Mat LaplacianLineDetector::getAdaptiveThres(const cv::Mat& frame_gray) const {
+    cv::Mat thres;
+    cv::adaptiveThreshold(frame_gray, thres, 255, cv::ADAPTIVE_THRESH_GAUSSIAN_C, cv::THRESH_BINARY, 5,
+                          -params_.adaptive_mean_threshold);
+    blockEnvironment(thres);
+    cv::erode(thres, thres, kernel(3, 1));
+    return thres;
+}
+
+cv::Mat LaplacianLineDetector::createDebugImage(cv::Mat& img_debug, const cv::Mat& adaptive, const cv::Mat& lapl,
+                                                const cv::Mat& cut, const cv::Mat& ignore_color) const {
+    cv::cvtColor(img_debug, img_debug, cv::COLOR_GRAY2BGR);
+
+    // Highlight ROI
+    double alpha = .8;
+    cv::Mat img_ROI(img_debug.rows, img_debug.cols, CV_8UC3, cv::Scalar::all(255));
+    cv::Mat img_ROI_binary, floodfill_pnt;
+    blockEnvironment(img_ROI);
+    cv::cvtColor(img_ROI, img_ROI_binary, cv::COLOR_BGR2GRAY);
+    img_ROI.setTo(cv::Scalar(0, 255, 0), img_ROI_binary == 255);
+    cv::addWeighted(img_debug, alpha, img_ROI, 1 - alpha, 0.0, img_debug);
+
+    // Add highlighted section colors
+    img_debug.setTo(cv::Scalar(0, 0, 130), adaptive != 0);
+    img_debug.setTo(cv::Scalar(130, 0, 50), lapl != 0);
+    img_debug.setTo(cv::Scalar(204, 0, 204), cut != 0);
+    cv::bitwise_and(cut, lapl, floodfill_pnt);
+    img_debug.setTo(cv::Scalar(0, 255, 0), floodfill_pnt != 0);
+    img_debug.setTo(cv::Scalar(0, 255, 255), ignore_color != 0);
+
+    // Add Text
+    cv::putText(img_debug, "Area Visible", cv::Point(5, 20), cv::FONT_HERSHEY_DUPLEX, .7, cv::Scalar(0, 200, 0), 1);
+    cv::putText(img_debug, "Adaptive", cv::Point(5, 40), cv::FONT_HERSHEY_DUPLEX, .7, cv::Scalar(0, 0, 130), 1);
+    cv::putText(img_debug, "Adaptive (Big Enough)", cv::Point(5, 60), cv::FONT_HERSHEY_DUPLEX, .7,
+                cv::Scalar(204, 0, 204), 1);
+    cv::putText(img_debug, "Laplacian", cv::Point(5, 80), cv::FONT_HERSHEY_DUPLEX, .7, cv::Scalar(130, 0, 50), 1);
+    cv::putText(img_debug, "Flood Points (Adpt. && Lapl.)", cv::Point(5, 100), cv::FONT_HERSHEY_DUPLEX, .7,
+                cv::Scalar(0, 255, 0), 1);
+    cv::putText(img_debug, "Color Being Ignored", cv::Point(5, 120), cv::FONT_HERSHEY_DUPLEX, .7,
+                cv::Scalar(0, 255, 255), 1);
+
+    return img_debug;
+}
+
+cv::Mat LaplacianLineDetector::detect(const cv::Mat& input, cv::Mat* debug) {
+    original_height_ = input.rows;
+    const int original_width = input.cols;
+    cv::Mat frame;
+    cv::resize(input, frame, cv::Size(resize_dim * original_width / original_height_, resize_dim));
+
+    cv::Mat ignore_color_mask = getIgnoreColorMask(frame);
+    cv::Mat frame_gray = getBlurredGrayImage(frame);
+
+    cv::Mat lapl, adaptive, true_lines, floodfill_blobs;
+    cv::Laplacian(frame_gray, lapl, CV_16S, 3, 1, 0, cv::BORDER_DEFAULT);
+    inRange(lapl, params_.laplacian_threshold_min, params_.laplacian_threshold_max, lapl);
+    lapl.setTo(cv::Scalar(0, 0, 0), ignore_color_mask);
+
+    if (!params_.ignore_adaptive) {
+        adaptive = getAdaptiveThres(frame_gray);
+        floodfill_blobs = cutSmall(adaptive, params_.min_blob_area);
+
+        cv::Mat fill = floorfillAreas(lapl, floodfill_blobs);
+        true_lines = cutSmall(fill, params_.min_blob_area);
+    } else {
+        cv::Mat lightness;
+        threshold(frame_gray, lightness, 5, 255, 0);
+        lapl.setTo(cv::Scalar(0, 0, 0), lightness == 0);
+
+        cv::erode(lapl, lapl, kernel(3, 1));
+        true_lines = cutSmall(lapl, params_.min_blob_area);
+        cv::dilate(lapl, lapl, kernel(10, 10));
+
+        cv::Mat black(frame.rows, frame.cols, CV_8UC1, cv::Scalar::all(0));
+        adaptive = black;
+        floodfill_blobs = black;
+    }
+
+    if (debug) {
+        *debug = createDebugImage(frame_gray, adaptive, lapl, floodfill_blobs, ignore_color_mask);
+    }
+    cv::resize(true_lines, true_lines, cv::Size(original_width, original_height_));
+    return true_lines;
+}
+
+}  // namespace rr
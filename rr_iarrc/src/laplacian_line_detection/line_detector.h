@@ -0,0 +1,57 @@
+#pragma once
+
+#include <rr_common/color_classifier.h>
+
+#include <opencv2/core.hpp>
+
+namespace rr {
+
+/**
+ * Performs Adaptive Threshold to find areas where we are certain there are lines, then those areas are floodfilled
+ * on a Laplacian that has more noise but the entirety of the line. Frames are processed at a fixed height of
+ * resize_dim rows.
+ */
+class LaplacianLineDetector {
+  public:
+    struct Params {
+        int laplacian_threshold_min = -255;
+        int laplacian_threshold_max = -20;
+        int min_blob_area = 60;
+
+        // Rows of the full size image, the larger the height the lower it is on the screen
+        int block_sky_height = 0;
+        int block_wheels_height = 800;
+        int block_bumper_height = 800;
+
+        bool ignore_adaptive = false;
+        int adaptive_mean_threshold = 1;
+
+        // HSV range that is never a line, -1 everywhere to disable
+        int ignore_color_low_H = -1, ignore_color_high_H = -1;
+        int ignore_color_low_S = -1, ignore_color_high_S = -1;
+        int ignore_color_low_V = -1, ignore_color_high_V = -1;
+    };
+
+    explicit LaplacianLineDetector(const Params& params);
+
+    /**
+     * @param frame bgr8 camera image
+     * @param debug when given, filled with each stage highlighted over the grayscale frame
+     * @return mono8 line mask the size of frame
+     */
+    cv::Mat detect(const cv::Mat& frame, cv::Mat* debug = nullptr);
+
+  private:
+    cv::Mat getIgnoreColorMask(const cv::Mat& frame) const;
+    void blockEnvironment(const cv::Mat& img) const;
+    cv::Mat getAdaptiveThres(const cv::Mat& frame_gray) const;
+    cv::Mat createDebugImage(cv::Mat& img_debug, const cv::Mat& adaptive, const cv::Mat& lapl, const cv::Mat& cut,
+                             const cv::Mat& ignore_color) const;
+
+    Params params_;
+    ColorClassifier ignore_color_classifier_;
+    int original_height_;
+    static constexpr int resize_dim = 400;
+};
+
+}  // namespace rr
@@ -28,13 +28,6 @@ void image_callback(const sensor_msgs::ImageConstPtr &msg) {
     }
 
     Mat &frame = cv_ptr->image;
-    Mat blue_mask;
-    inRange(frame, Scalar(255, 0, 0), Scalar(255, 0, 0), blue_mask);
-
-    blue_mask = ~blue_mask;
-
-    // frame *= blue_mask;
-
     Mat frame_1channel;
 
     cvtColor(frame, frame_1channel, CV_BGR2GRAY);
@@ -2,11 +2,15 @@
 #include <math.h>
 #include <ros/publisher.h>
 #include <ros/ros.h>
+#include <rr_common/color_classifier.h>
 #include <sensor_msgs/Image.h>
 #include <std_msgs/Bool.h>
 
 #include <opencv2/opencv.hpp>
 
+#include "blob_analysis.h"
+#include "roi_tracker.h"
+
 // Determines when the start light changes from red to green
 
 ros::Publisher debug_img_pub;
@@ -31,20 +35,20 @@ cv::Mat kernel(int x, int y) {
     return cv::getStructuringElement(cv::MORPH_RECT, cv::Size(x, y));
 }
 
-std::vector<cv::Point> findCenters(const cv::Mat &color_img) {
-    std::vector<std::vector<cv::Point>> contours;
+rr::BlobAnalyzer blobAnalyzer;
+rr::RoiTracker roiTracker;
+
+enum Label { RED, GREEN };
+std::unique_ptr<rr::ColorClassifier> classifier;
+
+// Finds the centers of round blobs in a mask cut from the frame at offset, and grows found to cover them
+std::vector<cv::Point> findCenters(const cv::Mat &color_img, const cv::Point &offset, cv::Rect &found) {
     std::vector<cv::Point> centers;
-    findContours(color_img, contours, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
-    for (const auto &contour : contours) {
-        double perimeter = cv::arcLength(contour, true);
-        double area = cv::contourArea(contour, false);
-        double circularity = 4 * M_PI * (area / (perimeter * perimeter));
-
-        if (circularityThreshold < circularity && area > minArea) {
-            cv::Moments moments = cv::moments(contour);
-            int centerX = moments.m10 / moments.m00;
-            int centerY = moments.m01 / moments.m00;
-            centers.push_back(cv::Point(centerX, centerY));
+    for (const auto &blob : blobAnalyzer.analyze(color_img, cv::Rect(), minArea + 1)) {
+        if (circularityThreshold < blob.circularity) {
+            centers.push_back(cv::Point(blob.centroid) + offset);
+            cv::Rect bbox = blob.bbox + offset;
+            found = found.area() > 0 ? (found | bbox) : bbox;
         }
     }
     return centers;
@@ -72,12 +76,13 @@ void img_callback(const sensor_msgs::Image::ConstPtr &msg) {
     cv_bridge::CvImagePtr cv_ptr = cv_bridge::toCvCopy(msg, "bgr8");
     cv::Mat frame = cv_ptr->image;
 
-    cv::Mat hsv_frame, red_found, green_found, debugImage;
-    cv::cvtColor(frame, hsv_frame, cv::COLOR_BGR2HSV);
-    cv::inRange(hsv_frame, cv::Scalar(minRedHue, 100, 140), cv::Scalar(maxRedHue, 255, 255), red_found);
-    cv::inRange(hsv_frame, cv::Scalar(minGreenHue, 120, 120), cv::Scalar(maxGreenHue, 255, 255), green_found);
+    // Once the light has been found only the area around it is processed
+    cv::Rect roi = roiTracker.next(cv::Rect(0, 0, frame.cols, frame.rows));
 
-    cv::GaussianBlur(frame, frame, cv::Size(3, 3), 0, 0);
+    cv::Mat labels, red_found, green_found;
+    classifier->classify(frame(roi), labels);
+    rr::ColorClassifier::mask(labels, RED, red_found);
+    rr::ColorClassifier::mask(labels, GREEN, green_found);
 
     cv::morphologyEx(green_found, green_found, cv::MORPH_OPEN, kernel(3, 3));
     cv::morphologyEx(red_found, red_found, cv::MORPH_OPEN, kernel(3, 3));
@@ -85,8 +90,10 @@ void img_callback(const sensor_msgs::Image::ConstPtr &msg) {
     cv::dilate(green_found, green_found, kernel(3, 3));
     cv::dilate(red_found, red_found, kernel(3, 3));
 
-    std::vector<cv::Point> redCenters = findCenters(red_found);
-    std::vector<cv::Point> greenCenters = findCenters(green_found);
+    cv::Rect lights;
+    std::vector<cv::Point> redCenters = findCenters(red_found, roi.tl(), lights);
+    std::vector<cv::Point> greenCenters = findCenters(green_found, roi.tl(), lights);
+    roiTracker.update(lights);
 
     if (redCenters.size() != 0) {
         last_red_time = msg->header.stamp;
@@ -98,20 +105,20 @@ void img_callback(const sensor_msgs::Image::ConstPtr &msg) {
 
     bool_pub.publish(prev_start_msg);
 
-    sensor_msgs::Image outmsg;
-
-    // sets the found pixels in the image to either red or green
-    cv::cvtColor(red_found, red_found, cv::COLOR_GRAY2RGB);
-    red_found.setTo(cv::Scalar(255, 0, 0), red_found);
-    cv::cvtColor(green_found, green_found, cv::COLOR_GRAY2RGB);
-    green_found.setTo(cv::Scalar(0, 255, 0), green_found);
-
-    debugImage = red_found + green_found;
-
-    cv_ptr->image = debugImage;
-    cv_ptr->encoding = "rgb8";
-    cv_ptr->toImageMsg(outmsg);
-    debug_img_pub.publish(outmsg);
+    if (debug_img_pub.getNumSubscribers() > 0) {
+        // sets the found pixels in the image to either red or green, and outlines the processed region
+        cv::Mat debugImage = cv::Mat::zeros(frame.size(), CV_8UC3);
+        cv::Mat debugRoi = debugImage(roi);
+        debugRoi.setTo(cv::Scalar(255, 0, 0), red_found);
+        debugRoi.setTo(cv::Scalar(0, 255, 0), green_found);
+        cv::rectangle(debugImage, roi, cv::Scalar(255, 255, 255), 2);
+
+        sensor_msgs::Image outmsg;
+        cv_ptr->image = debugImage;
+        cv_ptr->encoding = "rgb8";
+        cv_ptr->toImageMsg(outmsg);
+        debug_img_pub.publish(outmsg);
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -130,6 +137,12 @@ int main(int argc, char *argv[]) {
     nhp.param("min_red_hue", minRedHue, 0);
     nhp.param("max_red_hue", maxRedHue, 20);
 
+    classifier = std::make_unique<rr::ColorClassifier>();
+    classifier->setRange(RED, rr::ColorClassifier::HSV, cv::Scalar(minRedHue, 100, 140),
+                         cv::Scalar(maxRedHue, 255, 255));
+    classifier->setRange(GREEN, rr::ColorClassifier::HSV, cv::Scalar(minGreenHue, 120, 120),
+                         cv::Scalar(maxGreenHue, 255, 255));
+
     nhp.param("min_area", minArea, 100);
 
     nhp.param("red_to_green_time", redToGreenTime, 1.0);
@@ -138,6 +151,11 @@ int main(int argc, char *argv[]) {
 
     nhp.param("tolerance", tolerance, 20);
 
+    int roiPadding, reacquirePeriod;
+    nhp.param("roi_padding", roiPadding, 100);
+    nhp.param("reacquire_period", reacquirePeriod, 30);
+    roiTracker = rr::RoiTracker(roiPadding, reacquirePeriod);
+
     // Subscribe to ROS topic with callback
     prev_start_msg.data = false;
     ros::Subscriber img_sub = nhp.subscribe(img_topic, 1, img_callback);
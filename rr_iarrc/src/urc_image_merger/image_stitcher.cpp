@@ -0,0 +1,186 @@
+#include "image_stitcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace rr {
+
+namespace {
+
+cv::Size rotatedSize(const cv::Size& size, int rotation) {
+    if (rotation == cv::ROTATE_90_CLOCKWISE || rotation == cv::ROTATE_90_COUNTERCLOCKWISE) {
+        return cv::Size(size.height, size.width);
+    }
+    return size;
+}
+
+/**
+ * Maps the output pixels of region to pixels of an input of size source that is rotated, scaled and placed at column
+ * placement_x of the output. Columns past the input's sides repeat its edge, for seams; rows below it are black.
+ */
+void buildMaps(const cv::Size& source, int rotation, const cv::Point2d& scale, double placement_x,
+               const cv::Rect& region, bool nearest, cv::Mat& map1, cv::Mat& map2) {
+    const cv::Size rotated = rotatedSize(source, rotation);
+    const int scaled_height = static_cast<int>(std::lround(rotated.height * scale.y));
+
+    cv::Mat map_x(region.size(), CV_32FC1);
+    cv::Mat map_y(region.size(), CV_32FC1);
+    for (int y = 0; y < region.height; y++) {
+        auto* xs = map_x.ptr<float>(y);
+        auto* ys = map_y.ptr<float>(y);
+        const int out_y = region.y + y;
+
+        if (out_y >= scaled_height) {
+            std::fill(xs, xs + region.width, -10.0f);
+            std::fill(ys, ys + region.width, -10.0f);
+            continue;
+        }
+
+        // Sample at pixel centers and clamp to the edge, as cv::resize does
+        const double v = std::clamp((out_y + 0.5) / scale.y - 0.5, 0.0, rotated.height - 1.0);
+        for (int x = 0; x < region.width; x++) {
+            const double u = std::clamp((region.x + x - placement_x + 0.5) / scale.x - 0.5, 0.0, rotated.width - 1.0);
+            double col = u;
+            double row = v;
+            if (rotation == cv::ROTATE_90_CLOCKWISE) {
+                col = v;
+                row = source.height - 1 - u;
+            } else if (rotation == cv::ROTATE_90_COUNTERCLOCKWISE) {
+                col = source.width - 1 - v;
+                row = u;
+            } else if (rotation == cv::ROTATE_180) {
+                col = source.width - 1 - u;
+                row = source.height - 1 - v;
+            }
+            xs[x] = static_cast<float>(col);
+            ys[x] = static_cast<float>(row);
+        }
+    }
+
+    // Fixed point maps are about twice as fast to remap with
+    cv::convertMaps(map_x, map_y, map1, map2, CV_16SC2, nearest);
+}
+
+}  // namespace
+
+class ImageStitcher::StitchBody : public cv::ParallelLoopBody {
+  public:
+    StitchBody(ImageStitcher& stitcher, const std::vector<cv::Mat>& images, cv::Mat& output)
+          : stitcher_(stitcher), images_(images), output_(output) {}
+
+    void operator()(const cv::Range& range) const override {
+        const int interpolation = stitcher_.params_.interpolation;
+        for (int i = range.start; i < range.end; i++) {
+            if (i < static_cast<int>(stitcher_.parts_.size())) {
+                const Part& part = stitcher_.parts_[i];
+                cv::Mat region = output_(part.region);
+                cv::remap(images_[part.input], region, part.map1, part.map2, interpolation, cv::BORDER_CONSTANT);
+            } else {
+                Seam& seam = stitcher_.seams_[i - stitcher_.parts_.size()];
+                cv::remap(images_[seam.left], seam.left_pixels, seam.left_map1, seam.left_map2, interpolation,
+                          cv::BORDER_CONSTANT);
+                cv::remap(images_[seam.left + 1], seam.right_pixels, seam.right_map1, seam.right_map2, interpolation,
+                          cv::BORDER_CONSTANT);
+                cv::Mat region = output_(seam.region);
+                cv::blendLinear(seam.left_pixels, seam.right_pixels, seam.left_weights, seam.right_weights, region);
+            }
+        }
+    }
+
+  private:
+    ImageStitcher& stitcher_;
+    const std::vector<cv::Mat>& images_;
+    cv::Mat& output_;
+};
+
+ImageStitcher::ImageStitcher(const std::vector<int>& rotations, const Params& params)
+      : rotations_(rotations), params_(params) {}
+
+cv::Size ImageStitcher::outputSize(const std::vector<cv::Mat>& images) {
+    CV_Assert(images.size() == rotations_.size());
+    bool same_sizes = input_sizes_.size() == images.size();
+    for (size_t i = 0; same_sizes && i < images.size(); i++) {
+        same_sizes = input_sizes_[i] == images[i].size();
+    }
+    if (!same_sizes) {
+        updateMaps(images);
+    }
+    return output_size_;
+}
+
+void ImageStitcher::updateMaps(const std::vector<cv::Mat>& images) {
+    const int count = static_cast<int>(images.size());
+    input_sizes_.clear();
+    std::vector<cv::Size> rotated;
+    int total_width = 0;
+    int max_height = 1;
+    for (int i = 0; i < count; i++) {
+        input_sizes_.push_back(images[i].size());
+        rotated.push_back(rotatedSize(images[i].size(), rotations_[i]));
+        total_width += rotated[i].width;
+        max_height = std::max(max_height, rotated[i].height);
+    }
+
+    output_size_ = cv::Size(params_.output_height * total_width / max_height, params_.output_height);
+    const cv::Point2d scale(static_cast<double>(output_size_.width) / std::max(total_width, 1),
+                            static_cast<double>(output_size_.height) / max_height);
+
+    // Output column where each input starts, and where the last one ends
+    std::vector<double> placement(count + 1, 0.0);
+    std::vector<int> edges(count + 1, 0);
+    for (int i = 0; i < count; i++) {
+        placement[i + 1] = placement[i] + rotated[i].width * scale.x;
+        edges[i] = static_cast<int>(std::lround(placement[i]));
+    }
+    edges[count] = output_size_.width;
+
+    int blend_width = std::max(0, params_.seam_blend_width);
+    for (int i = 0; i < count; i++) {
+        blend_width = std::min(blend_width, edges[i + 1] - edges[i]);
+    }
+    const int half_blend = blend_width / 2;
+    const bool nearest = params_.interpolation == cv::INTER_NEAREST;
+
+    parts_.clear();
+    for (int i = 0; i < count; i++) {
+        const int start = edges[i] + (i > 0 ? blend_width - half_blend : 0);
+        const int end = edges[i + 1] - (i < count - 1 ? half_blend : 0);
+        if (end <= start) {
+            continue;
+        }
+        Part part;
+        part.input = i;
+        part.region = cv::Rect(start, 0, end - start, output_size_.height);
+        buildMaps(input_sizes_[i], rotations_[i], scale, placement[i], part.region, nearest, part.map1, part.map2);
+        parts_.push_back(std::move(part));
+    }
+
+    seams_.clear();
+    if (blend_width == 0) {
+        return;
+    }
+    cv::Mat ramp(1, blend_width, CV_32FC1);
+    for (int x = 0; x < blend_width; x++) {
+        ramp.at<float>(x) = (x + 0.5f) / blend_width;
+    }
+    for (int i = 0; i + 1 < count; i++) {
+        Seam seam;
+        seam.left = i;
+        seam.region = cv::Rect(edges[i + 1] - half_blend, 0, blend_width, output_size_.height);
+        buildMaps(input_sizes_[i], rotations_[i], scale, placement[i], seam.region, nearest, seam.left_map1,
+                  seam.left_map2);
+        buildMaps(input_sizes_[i + 1], rotations_[i + 1], scale, placement[i + 1], seam.region, nearest,
+                  seam.right_map1, seam.right_map2);
+        cv::repeat(ramp, output_size_.height, 1, seam.right_weights);
+        seam.left_weights = 1.0 - seam.right_weights;
+        seams_.push_back(std::move(seam));
+    }
+}
+
+void ImageStitcher::stitch(const std::vector<cv::Mat>& images, cv::Mat& output) {
+    output.create(outputSize(images), images.front().type());
+    const int jobs = static_cast<int>(parts_.size() + seams_.size());
+    cv::parallel_for_(cv::Range(0, jobs), StitchBody(*this, images, output));
+}
+
+}  // namespace rr
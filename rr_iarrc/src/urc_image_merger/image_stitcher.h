@@ -0,0 +1,71 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <vector>
+
+namespace rr {
+
+/**
+ * Places images side by side, each rotated by a multiple of 90 degrees, and scales the result to a fixed height. The
+ * rotation, placement and scaling of each input are composed into one remap table, built when the input sizes are
+ * first seen, so a frame is one pass over the output with every input written in parallel. Neighbors can be
+ * cross-faded over a band of columns at their seam instead of meeting at a hard edge.
+ *
+ * Inputs shorter than the tallest are aligned to the top with black below, as when merging then resizing.
+ */
+class ImageStitcher {
+  public:
+    static constexpr int no_rotation = -1;
+
+    struct Params {
+        int output_height = 300;
+        int seam_blend_width = 0;  // output columns, 0 for a hard seam
+        int interpolation = cv::INTER_LINEAR;
+    };
+
+    // One cv::RotateFlags or no_rotation per input, left to right
+    ImageStitcher(const std::vector<int>& rotations, const Params& params);
+
+    // Size of the stitched image for these inputs, rebuilding the maps if their sizes changed
+    cv::Size outputSize(const std::vector<cv::Mat>& images);
+
+    /**
+     * @param images one per rotation, all of the same type
+     * @param output filled with the stitched image; only reallocated when it is not already outputSize() and the
+     * inputs' type, so it can wrap a preallocated buffer such as an outgoing message's
+     */
+    void stitch(const std::vector<cv::Mat>& images, cv::Mat& output);
+
+  private:
+    // Output columns filled from one input
+    struct Part {
+        int input;
+        cv::Rect region;
+        cv::Mat map1, map2;
+    };
+
+    // Output columns where inputs left and left + 1 are cross-faded
+    struct Seam {
+        int left;
+        cv::Rect region;
+        cv::Mat left_map1, left_map2, right_map1, right_map2;
+        cv::Mat left_weights, right_weights;
+        cv::Mat left_pixels, right_pixels;
+    };
+
+    class StitchBody;
+
+    void updateMaps(const std::vector<cv::Mat>& images);
+
+    std::vector<int> rotations_;
+    Params params_;
+
+    std::vector<cv::Size> input_sizes_;
+    cv::Size output_size_;
+    std::vector<Part> parts_;
+    std::vector<Seam> seams_;
+};
+
+}  // namespace rr
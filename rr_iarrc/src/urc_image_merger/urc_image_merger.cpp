@@ -4,70 +4,48 @@
 #include <message_filters/synchronizer.h>
 #include <ros/publisher.h>
 #include <ros/ros.h>
-#include <rr_msgs/speed.h>
-#include <rr_msgs/steering.h>
 #include <sensor_msgs/Image.h>
-#include <stdio.h>
-#include <stdlib.h>
+#include <sensor_msgs/image_encodings.h>
 
-#include <iostream>
 #include <opencv2/opencv.hpp>
 
-using namespace std;
+#include "image_stitcher.h"
 
-cv_bridge::CvImagePtr cv_ptr;
 ros::Publisher image_pub;
-
-rr_msgs::speed speed_message;
-rr_msgs::steering steer_message;
-
-cv::Mat mergeImagesSideBySide(cv::Mat leftImg, cv::Mat rightImg) {
-    int outputRows = std::max(leftImg.rows, rightImg.rows);
-    int outputCols = leftImg.cols + rightImg.cols;
-    cv::Mat merged(outputRows, outputCols, leftImg.type(), cv::Scalar(0, 0, 0));
-    cv::Rect leftHalf(0, 0, leftImg.cols, leftImg.rows);
-    cv::Rect rightHalf(leftImg.cols, 0, rightImg.cols, rightImg.rows);
-    leftImg.copyTo(merged(leftHalf));
-    rightImg.copyTo(merged(rightHalf));
-
-    return merged;
-}
-
-void publishMessage(const ros::Publisher pub, const cv::Mat& img, std::string img_type) {
-    if (pub.getNumSubscribers() > 0) {
-        sensor_msgs::Image outmsg;
-        cv_ptr->image = img;
-        cv_ptr->encoding = img_type;
-        cv_ptr->toImageMsg(outmsg);
-        pub.publish(outmsg);
-    }
-}
+std::unique_ptr<rr::ImageStitcher> stitcher;
 
 /**
  * Reads in an image from two side cameras, rotates them, then merges them.
  * The resize is to make it work with the dragrace center line keeper.
  *
+ * The stitcher writes straight into the outgoing message, and the inputs are only shared, so the pixels are touched
+ * once per frame pair.
+ *
  * @param leftMsg image input from left side camera
  * @param rightMsg image input from the right side camera
  */
 void img_callback(const sensor_msgs::ImageConstPtr& leftMsg, const sensor_msgs::ImageConstPtr& rightMsg) {
-    // Convert msg to Mat image
-    cv_ptr = cv_bridge::toCvCopy(leftMsg, "mono8");
-    cv::Mat leftFrame = cv_ptr->image;
-    cv_ptr = cv_bridge::toCvCopy(rightMsg, "mono8");
-    cv::Mat rightFrame = cv_ptr->image;
+    if (image_pub.getNumSubscribers() == 0) {
+        return;
+    }
 
-    cv::rotate(leftFrame, leftFrame, cv::ROTATE_90_COUNTERCLOCKWISE);
-    cv::rotate(rightFrame, rightFrame, cv::ROTATE_90_CLOCKWISE);
+    const std::vector<cv::Mat> frames{ cv_bridge::toCvShare(leftMsg, "mono8")->image,
+                                       cv_bridge::toCvShare(rightMsg, "mono8")->image };
+    const cv::Size size = stitcher->outputSize(frames);
 
-    cv::Mat debug = mergeImagesSideBySide(leftFrame, rightFrame);
+    // Stamped with the older frame, so the age of the merged image covers both
+    auto merged = boost::make_shared<sensor_msgs::Image>();
+    merged->header = leftMsg->header.stamp < rightMsg->header.stamp ? leftMsg->header : rightMsg->header;
+    merged->height = size.height;
+    merged->width = size.width;
+    merged->encoding = sensor_msgs::image_encodings::MONO8;
+    merged->step = size.width;
+    merged->data.resize(merged->step * merged->height);
 
-    int resize_dim = 300;
-    int original_height = debug.rows;
-    int original_width = debug.cols;
-    cv::resize(debug, debug, cv::Size(resize_dim * original_width / original_height, resize_dim));
+    cv::Mat merged_img(size, CV_8UC1, merged->data.data(), merged->step);
+    stitcher->stitch(frames, merged_img);
 
-    publishMessage(image_pub, debug, "mono8");
+    image_pub.publish(merged);
 }
 
 int main(int argc, char** argv) {
@@ -80,6 +58,12 @@ int main(int argc, char** argv) {
     nhp.param("camera_right_subscription", rightCamera_sub_name, std::string("/camera_right/image_color_rect"));
     nhp.param("merged_img_publisher", merged_img_publisher, std::string("/urc_side_lanes"));
 
+    rr::ImageStitcher::Params params;
+    nhp.param("output_height", params.output_height, 300);
+    nhp.param("seam_blend_width", params.seam_blend_width, 0);
+    stitcher = std::make_unique<rr::ImageStitcher>(
+          std::vector<int>{ cv::ROTATE_90_COUNTERCLOCKWISE, cv::ROTATE_90_CLOCKWISE }, params);
+
     message_filters::Subscriber<sensor_msgs::Image> leftCamera_sub(nh, leftCamera_sub_name, 1);
     message_filters::Subscriber<sensor_msgs::Image> rightCamera_sub(nh, rightCamera_sub_name, 1);
 
@@ -0,0 +1,61 @@
+#ifndef CLOCKOFFSETESTIMATOR_H
+#define CLOCKOFFSETESTIMATOR_H
+
+#include <deque>
+#include <limits>
+
+namespace rr {
+
+/*
+ * Maps a device's clock onto the host clock from pairs of (device time, host arrival time).
+ *
+ * Arrival times are the true times plus a transport delay that is never negative but jitters a lot, so the mapping
+ * is a line whose slope (clock skew) comes from a least squares fit over a sliding window and whose offset follows
+ * the lower envelope of the arrivals, i.e. the least delayed samples. Stamps taken from it carry the device's timing
+ * instead of the host's read jitter.
+ */
+class ClockOffsetEstimator {
+  public:
+    // window: seconds of device time used for the fit
+    // max_gap: a longer jump, or device time going backwards, means the device restarted and the estimate is reset
+    // max_skew: bound on |slope - 1|, real clocks are off by parts per million, not percent
+    // max_slip: an arrival later than the estimate by more than this resets it. Device times made up by counting
+    //           samples do not show lost samples, which instead shift every later arrival by a whole period.
+    explicit ClockOffsetEstimator(double window = 10.0, double max_gap = 1.0, double max_skew = 0.01,
+                                  double max_slip = std::numeric_limits<double>::infinity());
+
+    // Adds a pair and returns the host time of device_time
+    double update(double device_time, double host_time);
+
+    // Host time of device_time under the current estimate
+    double toHost(double device_time) const;
+
+    double skew() const {
+        return slope_;
+    }
+
+    void reset();
+
+  private:
+    struct Pair {
+        double device;
+        double host;
+    };
+
+    double window_;
+    double max_gap_;
+    double max_skew_;
+    double max_slip_;
+
+    // times are kept relative to the first pair so the fit does not lose precision
+    double device_ref_ = 0;
+    double host_ref_ = 0;
+    std::deque<Pair> pairs_;
+
+    double slope_ = 1;
+    double offset_ = 0;
+};
+
+}  // namespace rr
+
+#endif  // CLOCKOFFSETESTIMATOR_H
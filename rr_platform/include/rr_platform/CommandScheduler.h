@@ -0,0 +1,66 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace rr {
+
+/*
+ * Decides when an actuator command goes out. A send happens as soon as a new command is notified, unless the last
+ * send was less than min_interval ago, in which case it happens once that interval is up and covers every command
+ * notified in between. Without new commands the last one is resent every keepalive_interval so the firmware watchdog
+ * stays satisfied.
+ *
+ * The send function runs on the scheduler's own thread, so slow writes never hold up the caller.
+ */
+class CommandScheduler {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using SendFunction = std::function<void()>;
+
+    // Time from a command's origin to the end of the send that carried it
+    struct LatencyStats {
+        size_t count = 0;
+        Clock::duration total{ 0 };
+        Clock::duration max{ 0 };
+
+        Clock::duration mean() const {
+            return count > 0 ? total / static_cast<Clock::rep>(count) : Clock::duration(0);
+        }
+    };
+
+    CommandScheduler(Clock::duration min_interval, Clock::duration keepalive_interval, SendFunction send);
+
+    ~CommandScheduler();
+
+    // A new command is ready. origin is when it was created, for latency statistics.
+    void notify(Clock::time_point origin = Clock::now());
+
+    // Statistics since the previous call
+    LatencyStats takeStats();
+
+  private:
+    const Clock::duration min_interval_;
+    const Clock::duration keepalive_interval_;
+    SendFunction send_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_ = true;
+    bool pending_ = false;
+    Clock::time_point oldest_origin_;  // of the commands notified since the last send
+    Clock::time_point last_send_;
+    LatencyStats stats_;
+
+    std::thread thread_;
+
+    void run();
+};
+
+}  // namespace rr
+
+#endif  // COMMANDSCHEDULER_H
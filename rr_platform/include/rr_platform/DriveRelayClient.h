@@ -0,0 +1,110 @@
+#ifndef DRIVERELAYCLIENT_H
+#define DRIVERELAYCLIENT_H
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace rr {
+
+/*
+ * Asynchronous TCP client for drive controllers that acknowledge every message with a response starting with '@'.
+ *
+ * On connecting, the init message is sent first. After that the latest command is sent once per tick of the command
+ * rate, with at most one message awaiting its acknowledgement. Commands set in between ticks replace each other, so a
+ * slow controller only ever receives the newest one. A connection that fails, closes, or does not acknowledge in time
+ * is dropped and retried after a delay.
+ *
+ * All work happens on the io_service given to the constructor, which the caller runs. setCommand may be called from
+ * any thread.
+ */
+class DriveRelayClient {
+  public:
+    struct Options {
+        std::string host;
+        std::string port;
+        std::string init_message;
+        double command_rate = 50.0;      // Hz
+        double response_timeout = 0.1;   // seconds to wait for an acknowledgement
+        double connect_timeout = 1.0;    // seconds
+        double reconnect_delay = 0.5;    // seconds
+    };
+
+    struct Stats {
+        uint64_t connects = 0;
+        uint64_t commands_sent = 0;
+        uint64_t acks = 0;
+        uint64_t ticks_skipped = 0;  // ticks where the previous message was still unacknowledged
+        uint64_t timeouts = 0;
+        std::chrono::steady_clock::duration last_round_trip{ 0 };
+        std::chrono::steady_clock::duration max_round_trip{ 0 };
+    };
+
+    using ConnectionCallback = std::function<void(bool connected, const std::string &reason)>;
+
+    DriveRelayClient(boost::asio::io_service &io_service, Options options);
+
+    void start();
+
+    // Closes the connection and cancels all pending work so the io_service can return
+    void stop();
+
+    void setCommand(const std::string &command);
+
+    void setConnectionCallback(ConnectionCallback callback) {
+        connection_callback_ = std::move(callback);
+    }
+
+    bool connected() const {
+        return state_ == State::RUNNING;
+    }
+
+    // Only consistent when read from the io_service thread, e.g. inside a posted handler
+    const Stats &stats() const {
+        return stats_;
+    }
+
+  private:
+    enum class State { STOPPED, CONNECTING, INITIALIZING, RUNNING, WAITING_TO_RECONNECT };
+
+    using Clock = std::chrono::steady_clock;
+
+    boost::asio::io_service &io_service_;
+    Options options_;
+    boost::asio::ip::tcp::socket socket_;
+    boost::asio::steady_timer command_timer_;
+    boost::asio::steady_timer response_timer_;
+    boost::asio::steady_timer reconnect_timer_;
+    boost::asio::streambuf read_buffer_;
+    Clock::duration command_period_;
+
+    std::atomic<State> state_{ State::STOPPED };
+    uint64_t connection_id_ = 0;  // handlers of earlier connections compare this and bail out
+    uint64_t message_id_ = 0;     // likewise for response timeouts of earlier messages
+    bool awaiting_ack_ = false;
+    Clock::time_point sent_time_;
+    Clock::time_point next_tick_;
+    std::string outgoing_;
+    Stats stats_;
+    ConnectionCallback connection_callback_;
+
+    std::mutex command_mutex_;
+    std::string latest_command_;
+    bool has_command_ = false;
+
+    void connect();
+    void closeConnection();
+    void disconnect(const std::string &reason);
+    void readAck();
+    void send(const std::string &message);
+    void scheduleTick();
+    void tick();
+};
+
+}  // namespace rr
+
+#endif  // DRIVERELAYCLIENT_H
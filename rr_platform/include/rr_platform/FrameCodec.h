@@ -0,0 +1,131 @@
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Wire protocol shared by the microcontroller relays and the IMU.
+ *
+ * Binary frames are COBS encoded and terminated by a zero byte, so a receiver can always resynchronize on the next
+ * zero. Before encoding a frame is
+ *
+ *   type (1) | sequence (1) | sender timestamp in microseconds (4) | payload | CRC-16/CCITT of everything before (2)
+ *
+ * with all multi-byte fields little endian. The sequence number increments by one per frame so dropped frames can be
+ * counted, and the timestamp lets the receiver tell how stale a frame is.
+ *
+ * The text functions speak the original ASCII line protocol for firmware that has not been updated.
+ */
+namespace rr {
+
+enum class FrameType : uint8_t {
+    MOTOR_COMMAND = 1,
+    MOTOR_FEEDBACK = 2,
+    IMU_SAMPLE = 3,
+};
+
+struct MotorCommand {
+    float speed;
+    float steer;
+    float kP;
+    float kI;
+    float kD;
+    int16_t trim;
+};
+
+struct MotorFeedback {
+    float speed;
+    bool mux_autonomous;
+    bool estop_on;
+};
+
+struct ImuSample {
+    std::array<float, 3> accel;        // x, y, z
+    std::array<float, 3> gyro;         // x, y, z
+    std::array<float, 4> orientation;  // x, y, z, w
+    std::array<float, 3> mag;          // x, y, z
+    std::array<float, 3> axes;         // roll, pitch, yaw
+};
+
+struct Frame {
+    static constexpr size_t kMaxPayload = 64;
+
+    FrameType type;
+    uint8_t sequence;
+    uint32_t timestamp_us;
+    std::array<uint8_t, kMaxPayload> payload;
+    size_t payload_size;
+};
+
+uint16_t crc16(const uint8_t *data, size_t size);
+
+// COBS encoding of data without the trailing delimiter
+std::string cobsEncode(const uint8_t *data, size_t size);
+
+// Decodes a COBS frame without its delimiter into out, returning the decoded size or 0 if it is malformed or too long
+size_t cobsDecode(std::string_view encoded, uint8_t *out, size_t capacity);
+
+class FrameEncoder {
+  public:
+    // Each returns the encoded frame including its zero delimiter, ready to be written
+    std::string encode(const MotorCommand &command, uint32_t timestamp_us);
+    std::string encode(const MotorFeedback &feedback, uint32_t timestamp_us);
+    std::string encode(const ImuSample &sample, uint32_t timestamp_us);
+
+  private:
+    uint8_t sequence_ = 0;
+
+    std::string encodeFrame(FrameType type, const uint8_t *payload, size_t payload_size, uint32_t timestamp_us);
+};
+
+class FrameDecoder {
+  public:
+    enum class Result { OK, BAD_ENCODING, BAD_CRC };
+
+    // Decodes one frame, without its zero delimiter
+    Result decode(std::string_view encoded, Frame &frame);
+
+    // Frames missing from the sequence numbers seen so far
+    uint32_t droppedFrames() const {
+        return dropped_frames_;
+    }
+
+    uint32_t corruptFrames() const {
+        return corrupt_frames_;
+    }
+
+  private:
+    bool has_sequence_ = false;
+    uint8_t last_sequence_ = 0;
+    uint32_t dropped_frames_ = 0;
+    uint32_t corrupt_frames_ = 0;
+};
+
+// Payload accessors, false if the frame has a different type or size
+bool unpack(const Frame &frame, MotorCommand &command);
+bool unpack(const Frame &frame, MotorFeedback &feedback);
+bool unpack(const Frame &frame, ImuSample &sample);
+
+namespace text {
+
+// "$speed, steer,kP,kI,kD,trim\n"
+std::string encode(const MotorCommand &command);
+
+// "$speed,mux,estop"
+bool decode(std::string_view line, MotorFeedback &feedback);
+
+enum class ImuField { NONE, ACCEL, GYRO, ORIENTATION, MAG, AXES };
+
+// Lines tagged "ax", "gx", "q0", "mx" or "axes" each carry one part of a sample. The matching part of sample is
+// updated and its field returned, or NONE if the line is not recognized.
+ImuField decode(std::string_view line, ImuSample &sample);
+
+}  // namespace text
+
+}  // namespace rr
+
+#endif  // FRAMECODEC_H
@@ -1,26 +1,108 @@
 #ifndef SERIALPORT_H
 #define SERIALPORT_H
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <thread>
+
+/*
+ * Splits a byte stream into delimiter terminated lines, '\n' by default. Bytes are kept in a fixed size buffer which
+ * is compacted when it fills up, so every line stays contiguous and can be handed out without copying.
+ */
+class LineFramer {
+  public:
+    static constexpr size_t kCapacity = 4096;
+
+    explicit LineFramer(char delimiter = '\n') : delimiter_(delimiter) {}
+
+    void SetDelimiter(char delimiter) {
+        delimiter_ = delimiter;
+    }
+
+    // Where the next bytes should be read to, and how many fit
+    char *WriteBegin();
+    size_t WriteSpace() const;
+
+    // Marks n bytes at WriteBegin() as filled
+    void Commit(size_t n);
+
+    // Next complete line without the delimiter (or "\r\n" for newlines), valid until the next call to anything else.
+    // False if there is no complete line buffered.
+    bool NextLine(std::string_view &line);
+
+    // Unterminated bytes left in the buffer
+    std::string_view Remainder() const;
+
+    void Clear();
+
+    // Number of times a line longer than the buffer had to be thrown away
+    size_t Overflows() const {
+        return overflows_;
+    }
+
+  private:
+    std::array<char, kCapacity> buffer_;
+    char delimiter_;
+    size_t begin_ = 0;  // start of the oldest unconsumed byte
+    size_t scan_ = 0;   // everything in [begin_, scan_) is known to not hold a delimiter
+    size_t end_ = 0;    // one past the newest byte
+    size_t overflows_ = 0;
+};
 
 class SerialPort {
   public:
+    using LineCallback = std::function<void(std::string_view)>;
+
     SerialPort() = default;
 
     ~SerialPort();
 
+    // Both overloads close a port that is already open first
     bool Open(const std::string &device, const unsigned int baud);
 
+    // Takes an already open file descriptor (e.g. a pseudo terminal) without changing its settings
+    bool Open(int fd);
+
     void Close();
 
-    void Write(std::string message);
+    // Byte that ends each line or frame, '\n' unless set otherwise. Only change it while not reading asynchronously.
+    void SetDelimiter(char delimiter) {
+        framer_.SetDelimiter(delimiter);
+    }
 
+    bool Write(const std::string &message);
+
+    // Blocks until a full line arrives, or returns what was read so far on timeout or error.
+    // Not to be used while reading asynchronously.
     std::string ReadLine();
 
+    /*
+     * Reads on a dedicated thread and calls callback from that thread with every line as soon as it arrives.
+     * The line is only valid for the duration of the callback.
+     */
+    bool StartReading(LineCallback callback);
+
+    void StopReading();
+
+    // False once StopReading() is called or the reader stops on its own, e.g. because the device was unplugged
+    bool Reading() const {
+        return reading_;
+    }
+
   private:
-    int port_handle_;
+    int port_handle_ = -1;
+    int stop_event_ = -1;
+    std::thread reader_thread_;
+    std::atomic<bool> reading_{ false };
+    LineFramer framer_;
 
     void SetProperties(unsigned int baud);
+
+    void ReaderLoop(LineCallback callback);
 };
 
 #endif  // SERIALPORT_H
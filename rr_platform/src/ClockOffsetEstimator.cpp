@@ -0,0 +1,68 @@
+#include <rr_platform/ClockOffsetEstimator.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace rr {
+
+ClockOffsetEstimator::ClockOffsetEstimator(double window, double max_gap, double max_skew, double max_slip)
+      : window_(window), max_gap_(max_gap), max_skew_(max_skew), max_slip_(max_slip) {}
+
+void ClockOffsetEstimator::reset() {
+    pairs_.clear();
+    slope_ = 1;
+    offset_ = 0;
+}
+
+double ClockOffsetEstimator::update(double device_time, double host_time) {
+    if (!pairs_.empty()) {
+        double gap = (device_time - device_ref_) - pairs_.back().device;
+        if (gap <= 0 || gap > max_gap_ || host_time - toHost(device_time) > max_slip_) {
+            reset();
+        }
+    }
+    if (pairs_.empty()) {
+        device_ref_ = device_time;
+        host_ref_ = host_time;
+    }
+
+    double d = device_time - device_ref_;
+    pairs_.push_back({ d, host_time - host_ref_ });
+    while (d - pairs_.front().device > window_) {
+        pairs_.pop_front();
+    }
+
+    if (pairs_.size() >= 2) {
+        double mean_d = 0;
+        double mean_h = 0;
+        for (const Pair &p : pairs_) {
+            mean_d += p.device;
+            mean_h += p.host;
+        }
+        mean_d /= pairs_.size();
+        mean_h /= pairs_.size();
+
+        double cov = 0;
+        double var = 0;
+        for (const Pair &p : pairs_) {
+            cov += (p.device - mean_d) * (p.host - mean_h);
+            var += (p.device - mean_d) * (p.device - mean_d);
+        }
+        if (var > 0) {
+            slope_ = std::clamp(cov / var, 1.0 - max_skew_, 1.0 + max_skew_);
+        }
+    }
+
+    offset_ = std::numeric_limits<double>::max();
+    for (const Pair &p : pairs_) {
+        offset_ = std::min(offset_, p.host - slope_ * p.device);
+    }
+
+    return toHost(device_time);
+}
+
+double ClockOffsetEstimator::toHost(double device_time) const {
+    return host_ref_ + offset_ + slope_ * (device_time - device_ref_);
+}
+
+}  // namespace rr
@@ -0,0 +1,69 @@
+#include <rr_platform/CommandScheduler.h>
+
+namespace rr {
+
+CommandScheduler::CommandScheduler(Clock::duration min_interval, Clock::duration keepalive_interval,
+                                   SendFunction send)
+      : min_interval_(min_interval)
+      , keepalive_interval_(keepalive_interval)
+      , send_(std::move(send))
+      , last_send_(Clock::now() - keepalive_interval)
+      , thread_(&CommandScheduler::run, this) {}
+
+CommandScheduler::~CommandScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void CommandScheduler::notify(Clock::time_point origin) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_ || origin < oldest_origin_) {
+            oldest_origin_ = origin;
+        }
+        pending_ = true;
+    }
+    wake_.notify_one();
+}
+
+CommandScheduler::LatencyStats CommandScheduler::takeStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    LatencyStats stats = stats_;
+    stats_ = LatencyStats();
+    return stats;
+}
+
+void CommandScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        Clock::time_point due = last_send_ + (pending_ ? min_interval_ : keepalive_interval_);
+        Clock::time_point start = Clock::now();
+        if (start < due) {
+            wake_.wait_until(lock, due);
+            continue;
+        }
+
+        bool had_command = pending_;
+        Clock::time_point origin = oldest_origin_;
+        pending_ = false;
+        last_send_ = start;
+
+        lock.unlock();
+        send_();
+        Clock::time_point done = Clock::now();
+        lock.lock();
+
+        if (had_command) {
+            Clock::duration latency = done - origin;
+            stats_.count++;
+            stats_.total += latency;
+            stats_.max = std::max(stats_.max, latency);
+        }
+    }
+}
+
+}  // namespace rr
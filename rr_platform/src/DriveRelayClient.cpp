@@ -0,0 +1,208 @@
+#include <rr_platform/DriveRelayClient.h>
+
+using boost::asio::ip::tcp;
+
+namespace rr {
+
+namespace {
+
+std::chrono::steady_clock::duration seconds(double s) {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(s));
+}
+
+}  // namespace
+
+DriveRelayClient::DriveRelayClient(boost::asio::io_service &io_service, Options options)
+      : io_service_(io_service)
+      , options_(std::move(options))
+      , socket_(io_service)
+      , command_timer_(io_service)
+      , response_timer_(io_service)
+      , reconnect_timer_(io_service)
+      , command_period_(seconds(1.0 / options_.command_rate)) {}
+
+void DriveRelayClient::start() {
+    io_service_.post([this] {
+        if (state_ == State::STOPPED) {
+            connect();
+        }
+    });
+}
+
+void DriveRelayClient::stop() {
+    io_service_.post([this] {
+        closeConnection();
+        state_ = State::STOPPED;
+    });
+}
+
+void DriveRelayClient::setCommand(const std::string &command) {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    latest_command_ = command;
+    has_command_ = true;
+}
+
+void DriveRelayClient::connect() {
+    state_ = State::CONNECTING;
+    uint64_t id = ++connection_id_;
+
+    boost::system::error_code error;
+    tcp::resolver resolver(io_service_);
+    auto endpoints = resolver.resolve(tcp::resolver::query(options_.host, options_.port), error);
+    if (error) {
+        disconnect("could not resolve " + options_.host + ": " + error.message());
+        return;
+    }
+
+    response_timer_.expires_from_now(seconds(options_.connect_timeout));
+    response_timer_.async_wait([this, id](const boost::system::error_code &error) {
+        if (!error && id == connection_id_ && state_ == State::CONNECTING) {
+            disconnect("connection timed out");
+        }
+    });
+
+    boost::asio::async_connect(socket_, endpoints, [this, id](const boost::system::error_code &error, auto) {
+        if (id != connection_id_) {
+            return;
+        }
+        if (error) {
+            disconnect("connection failed: " + error.message());
+            return;
+        }
+
+        response_timer_.cancel();
+        boost::system::error_code ignored;
+        socket_.set_option(tcp::no_delay(true), ignored);
+        stats_.connects++;
+        state_ = State::INITIALIZING;
+        readAck();
+        send(options_.init_message);
+    });
+}
+
+void DriveRelayClient::closeConnection() {
+    connection_id_++;
+    boost::system::error_code ignored;
+    socket_.shutdown(tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+    command_timer_.cancel();
+    response_timer_.cancel();
+    reconnect_timer_.cancel();
+    read_buffer_.consume(read_buffer_.size());
+    awaiting_ack_ = false;
+}
+
+void DriveRelayClient::disconnect(const std::string &reason) {
+    closeConnection();
+    state_ = State::WAITING_TO_RECONNECT;
+    if (connection_callback_) {
+        connection_callback_(false, reason);
+    }
+
+    uint64_t id = connection_id_;
+    reconnect_timer_.expires_from_now(seconds(options_.reconnect_delay));
+    reconnect_timer_.async_wait([this, id](const boost::system::error_code &error) {
+        if (!error && id == connection_id_) {
+            connect();
+        }
+    });
+}
+
+void DriveRelayClient::readAck() {
+    uint64_t id = connection_id_;
+    auto on_read = [this, id](const boost::system::error_code &error, size_t n_read) {
+        if (id != connection_id_) {
+            return;
+        }
+        if (error == boost::asio::error::eof) {
+            disconnect("connection closed by controller");
+            return;
+        } else if (error) {
+            disconnect("read failed: " + error.message());
+            return;
+        }
+
+        // Responses start with '@', whatever follows it is status text we have no use for
+        read_buffer_.consume(n_read);
+        if (awaiting_ack_) {
+            awaiting_ack_ = false;
+            response_timer_.cancel();
+            stats_.acks++;
+            stats_.last_round_trip = Clock::now() - sent_time_;
+            stats_.max_round_trip = std::max(stats_.max_round_trip, stats_.last_round_trip);
+
+            if (state_ == State::INITIALIZING) {
+                state_ = State::RUNNING;
+                if (connection_callback_) {
+                    connection_callback_(true, "connected");
+                }
+                next_tick_ = Clock::now();
+                tick();
+            }
+        }
+        readAck();
+    };
+    boost::asio::async_read_until(socket_, read_buffer_, '@', on_read);
+}
+
+void DriveRelayClient::send(const std::string &message) {
+    uint64_t id = connection_id_;
+    uint64_t message_id = ++message_id_;
+    outgoing_ = message;
+    awaiting_ack_ = true;
+    sent_time_ = Clock::now();
+
+    response_timer_.expires_from_now(seconds(options_.response_timeout));
+    response_timer_.async_wait([this, id, message_id](const boost::system::error_code &error) {
+        if (!error && id == connection_id_ && message_id == message_id_ && awaiting_ack_) {
+            stats_.timeouts++;
+            disconnect("no response from controller");
+        }
+    });
+
+    // outgoing_ outlives the write since nothing else is sent until the controller acknowledges this message
+    boost::asio::async_write(socket_, boost::asio::buffer(outgoing_),
+                             [this, id](const boost::system::error_code &error, size_t) {
+                                 if (error && id == connection_id_) {
+                                     disconnect("write failed: " + error.message());
+                                 }
+                             });
+}
+
+void DriveRelayClient::scheduleTick() {
+    // keep a fixed cadence, but don't try to catch up on ticks missed by a long stall
+    next_tick_ += command_period_;
+    Clock::time_point now = Clock::now();
+    if (next_tick_ < now) {
+        next_tick_ = now;
+    }
+
+    uint64_t id = connection_id_;
+    command_timer_.expires_at(next_tick_);
+    command_timer_.async_wait([this, id](const boost::system::error_code &error) {
+        if (!error && id == connection_id_) {
+            tick();
+        }
+    });
+}
+
+void DriveRelayClient::tick() {
+    if (awaiting_ack_) {
+        stats_.ticks_skipped++;
+    } else {
+        std::string command;
+        {
+            std::lock_guard<std::mutex> lock(command_mutex_);
+            if (has_command_) {
+                command = latest_command_;
+            }
+        }
+        if (!command.empty()) {
+            stats_.commands_sent++;
+            send(command);
+        }
+    }
+    scheduleTick();
+}
+
+}  // namespace rr
@@ -0,0 +1,375 @@
+#include <rr_platform/FrameCodec.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace rr {
+
+namespace {
+
+constexpr size_t kHeaderSize = 6;  // type, sequence, timestamp
+constexpr size_t kCrcSize = 2;
+constexpr size_t kMaxFrameSize = kHeaderSize + Frame::kMaxPayload + kCrcSize;
+
+// CRC-16/CCITT-FALSE, polynomial 0x1021
+constexpr std::array<uint16_t, 256> makeCrcTable() {
+    std::array<uint16_t, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = static_cast<uint16_t>(i << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint16_t, 256> kCrcTable = makeCrcTable();
+
+// Little endian serialization independent of the host byte order
+class PayloadWriter {
+  public:
+    explicit PayloadWriter(uint8_t *out) : out_(out), size_(0) {}
+
+    void put(uint8_t value) {
+        out_[size_++] = value;
+    }
+
+    void put(uint16_t value) {
+        put(static_cast<uint8_t>(value));
+        put(static_cast<uint8_t>(value >> 8));
+    }
+
+    void put(uint32_t value) {
+        put(static_cast<uint16_t>(value));
+        put(static_cast<uint16_t>(value >> 16));
+    }
+
+    void put(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put(bits);
+    }
+
+    template <size_t N>
+    void put(const std::array<float, N> &values) {
+        for (float value : values) {
+            put(value);
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+  private:
+    uint8_t *out_;
+    size_t size_;
+};
+
+class PayloadReader {
+  public:
+    explicit PayloadReader(const uint8_t *in) : in_(in), pos_(0) {}
+
+    uint8_t getU8() {
+        return in_[pos_++];
+    }
+
+    uint16_t getU16() {
+        uint16_t low = getU8();
+        return static_cast<uint16_t>(low | (getU8() << 8));
+    }
+
+    uint32_t getU32() {
+        uint32_t low = getU16();
+        return low | (static_cast<uint32_t>(getU16()) << 16);
+    }
+
+    float getFloat() {
+        uint32_t bits = getU32();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    template <size_t N>
+    void get(std::array<float, N> &values) {
+        for (float &value : values) {
+            value = getFloat();
+        }
+    }
+
+  private:
+    const uint8_t *in_;
+    size_t pos_;
+};
+
+constexpr size_t kMotorCommandSize = 5 * 4 + 2;
+constexpr size_t kMotorFeedbackSize = 4 + 1;
+constexpr size_t kImuSampleSize = (3 + 3 + 4 + 3 + 3) * 4;
+static_assert(kImuSampleSize <= Frame::kMaxPayload, "IMU sample does not fit in a frame");
+
+bool expect(const Frame &frame, FrameType type, size_t size) {
+    return frame.type == type && frame.payload_size == size;
+}
+
+// Parses up to n comma separated numbers, returning how many were found
+size_t parseFloats(std::string_view fields, float *out, size_t n) {
+    size_t parsed = 0;
+    while (parsed < n && !fields.empty()) {
+        size_t comma = fields.find(',');
+        std::string_view field = fields.substr(0, comma);
+
+        // strtof needs a terminated string, and a number never needs more than this
+        char buffer[32];
+        if (field.size() >= sizeof(buffer)) {
+            return parsed;
+        }
+        memcpy(buffer, field.data(), field.size());
+        buffer[field.size()] = '\0';
+        char *end;
+        out[parsed] = std::strtof(buffer, &end);
+        if (end == buffer) {
+            return parsed;
+        }
+        parsed++;
+
+        fields = (comma == std::string_view::npos) ? std::string_view() : fields.substr(comma + 1);
+    }
+    return parsed;
+}
+
+template <size_t N>
+bool parseFloats(std::string_view fields, std::array<float, N> &out) {
+    std::array<float, N> values;
+    if (parseFloats(fields, values.data(), N) != N) {
+        return false;
+    }
+    out = values;
+    return true;
+}
+
+}  // namespace
+
+uint16_t crc16(const uint8_t *data, size_t size) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ kCrcTable[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+std::string cobsEncode(const uint8_t *data, size_t size) {
+    std::string out;
+    out.reserve(size + size / 254 + 2);
+
+    size_t code_pos = 0;
+    uint8_t code = 1;
+    out.push_back(0);
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != 0) {
+            out.push_back(static_cast<char>(data[i]));
+            code++;
+        }
+        if (data[i] == 0 || code == 0xFF) {
+            out[code_pos] = static_cast<char>(code);
+            code_pos = out.size();
+            out.push_back(0);
+            code = 1;
+        }
+    }
+    out[code_pos] = static_cast<char>(code);
+    return out;
+}
+
+size_t cobsDecode(std::string_view encoded, uint8_t *out, size_t capacity) {
+    size_t in = 0;
+    size_t n = 0;
+    while (in < encoded.size()) {
+        auto code = static_cast<uint8_t>(encoded[in++]);
+        if (code == 0) {
+            return 0;
+        }
+        for (int i = 1; i < code; i++) {
+            if (in == encoded.size() || encoded[in] == 0 || n == capacity) {
+                return 0;
+            }
+            out[n++] = static_cast<uint8_t>(encoded[in++]);
+        }
+        // every block but the last and the maximum length ones stands for a zero
+        if (code != 0xFF && in < encoded.size()) {
+            if (n == capacity) {
+                return 0;
+            }
+            out[n++] = 0;
+        }
+    }
+    return n;
+}
+
+std::string FrameEncoder::encode(const MotorCommand &command, uint32_t timestamp_us) {
+    std::array<uint8_t, kMotorCommandSize> payload;
+    PayloadWriter writer(payload.data());
+    writer.put(command.speed);
+    writer.put(command.steer);
+    writer.put(command.kP);
+    writer.put(command.kI);
+    writer.put(command.kD);
+    writer.put(static_cast<uint16_t>(command.trim));
+    return encodeFrame(FrameType::MOTOR_COMMAND, payload.data(), writer.size(), timestamp_us);
+}
+
+std::string FrameEncoder::encode(const MotorFeedback &feedback, uint32_t timestamp_us) {
+    std::array<uint8_t, kMotorFeedbackSize> payload;
+    PayloadWriter writer(payload.data());
+    writer.put(feedback.speed);
+    writer.put(static_cast<uint8_t>((feedback.mux_autonomous ? 1 : 0) | (feedback.estop_on ? 2 : 0)));
+    return encodeFrame(FrameType::MOTOR_FEEDBACK, payload.data(), writer.size(), timestamp_us);
+}
+
+std::string FrameEncoder::encode(const ImuSample &sample, uint32_t timestamp_us) {
+    std::array<uint8_t, kImuSampleSize> payload;
+    PayloadWriter writer(payload.data());
+    writer.put(sample.accel);
+    writer.put(sample.gyro);
+    writer.put(sample.orientation);
+    writer.put(sample.mag);
+    writer.put(sample.axes);
+    return encodeFrame(FrameType::IMU_SAMPLE, payload.data(), writer.size(), timestamp_us);
+}
+
+std::string FrameEncoder::encodeFrame(FrameType type, const uint8_t *payload, size_t payload_size,
+                                      uint32_t timestamp_us) {
+    std::array<uint8_t, kMaxFrameSize> frame;
+    PayloadWriter writer(frame.data());
+    writer.put(static_cast<uint8_t>(type));
+    writer.put(sequence_++);
+    writer.put(timestamp_us);
+    memcpy(frame.data() + writer.size(), payload, payload_size);
+    size_t size = writer.size() + payload_size;
+
+    PayloadWriter crc_writer(frame.data() + size);
+    crc_writer.put(crc16(frame.data(), size));
+    size += kCrcSize;
+
+    std::string encoded = cobsEncode(frame.data(), size);
+    encoded.push_back('\0');
+    return encoded;
+}
+
+FrameDecoder::Result FrameDecoder::decode(std::string_view encoded, Frame &frame) {
+    std::array<uint8_t, kMaxFrameSize> decoded;
+    size_t size = cobsDecode(encoded, decoded.data(), decoded.size());
+    if (size < kHeaderSize + kCrcSize) {
+        corrupt_frames_++;
+        return Result::BAD_ENCODING;
+    }
+
+    size_t crc_pos = size - kCrcSize;
+    if (PayloadReader(decoded.data() + crc_pos).getU16() != crc16(decoded.data(), crc_pos)) {
+        corrupt_frames_++;
+        return Result::BAD_CRC;
+    }
+
+    PayloadReader reader(decoded.data());
+    frame.type = static_cast<FrameType>(reader.getU8());
+    frame.sequence = reader.getU8();
+    frame.timestamp_us = reader.getU32();
+    frame.payload_size = crc_pos - kHeaderSize;
+    memcpy(frame.payload.data(), decoded.data() + kHeaderSize, frame.payload_size);
+
+    if (has_sequence_) {
+        dropped_frames_ += static_cast<uint8_t>(frame.sequence - last_sequence_ - 1);
+    }
+    has_sequence_ = true;
+    last_sequence_ = frame.sequence;
+
+    return Result::OK;
+}
+
+bool unpack(const Frame &frame, MotorCommand &command) {
+    if (!expect(frame, FrameType::MOTOR_COMMAND, kMotorCommandSize)) {
+        return false;
+    }
+    PayloadReader reader(frame.payload.data());
+    command.speed = reader.getFloat();
+    command.steer = reader.getFloat();
+    command.kP = reader.getFloat();
+    command.kI = reader.getFloat();
+    command.kD = reader.getFloat();
+    command.trim = static_cast<int16_t>(reader.getU16());
+    return true;
+}
+
+bool unpack(const Frame &frame, MotorFeedback &feedback) {
+    if (!expect(frame, FrameType::MOTOR_FEEDBACK, kMotorFeedbackSize)) {
+        return false;
+    }
+    PayloadReader reader(frame.payload.data());
+    feedback.speed = reader.getFloat();
+    uint8_t flags = reader.getU8();
+    feedback.mux_autonomous = (flags & 1) != 0;
+    feedback.estop_on = (flags & 2) != 0;
+    return true;
+}
+
+bool unpack(const Frame &frame, ImuSample &sample) {
+    if (!expect(frame, FrameType::IMU_SAMPLE, kImuSampleSize)) {
+        return false;
+    }
+    PayloadReader reader(frame.payload.data());
+    reader.get(sample.accel);
+    reader.get(sample.gyro);
+    reader.get(sample.orientation);
+    reader.get(sample.mag);
+    reader.get(sample.axes);
+    return true;
+}
+
+namespace text {
+
+std::string encode(const MotorCommand &command) {
+    return "$" + std::to_string(command.speed) + ", " + std::to_string(command.steer) + "," +
+           std::to_string(command.kP) + "," + std::to_string(command.kI) + "," + std::to_string(command.kD) + "," +
+           std::to_string(command.trim) + "\n";
+}
+
+bool decode(std::string_view line, MotorFeedback &feedback) {
+    if (line.empty() || line[0] != '$') {
+        return false;
+    }
+    std::array<float, 3> values;
+    if (!parseFloats(line.substr(1), values)) {
+        return false;
+    }
+    feedback.speed = values[0];
+    feedback.mux_autonomous = (values[1] == 1);
+    feedback.estop_on = (values[2] == 1);
+    return true;
+}
+
+ImuField decode(std::string_view line, ImuSample &sample) {
+    size_t comma = line.find(',');
+    if (comma == std::string_view::npos) {
+        return ImuField::NONE;
+    }
+    std::string_view tag = line.substr(0, comma);
+    std::string_view fields = line.substr(comma + 1);
+
+    if (tag == "ax") {
+        return parseFloats(fields, sample.accel) ? ImuField::ACCEL : ImuField::NONE;
+    } else if (tag == "gx") {
+        return parseFloats(fields, sample.gyro) ? ImuField::GYRO : ImuField::NONE;
+    } else if (tag == "q0") {
+        return parseFloats(fields, sample.orientation) ? ImuField::ORIENTATION : ImuField::NONE;
+    } else if (tag == "mx") {
+        return parseFloats(fields, sample.mag) ? ImuField::MAG : ImuField::NONE;
+    } else if (tag == "axes") {
+        return parseFloats(fields, sample.axes) ? ImuField::AXES : ImuField::NONE;
+    }
+    return ImuField::NONE;
+}
+
+}  // namespace text
+
+}  // namespace rr
@@ -1,53 +1,252 @@
 #include <fcntl.h>
 #include <rr_platform/SerialPort.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <termio.h>
-#include <zconf.h>
+#include <unistd.h>
 
+#include <cerrno>
 #include <cstring>
 #include <iostream>
 
 using namespace std;
 
+namespace {
+
+// termios wants one of its B* constants rather than the rate itself
+speed_t BaudToSpeed(unsigned int baud) {
+    switch (baud) {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 115200:
+            return B115200;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        default:
+            std::cout << "Unsupported baud rate " << baud << ", using 115200" << std::endl;
+            return B115200;
+    }
+}
+
+}  // namespace
+
+char *LineFramer::WriteBegin() {
+    if (end_ == kCapacity && begin_ > 0) {
+        // move the partial line to the front to make room
+        memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+        scan_ -= begin_;
+        end_ -= begin_;
+        begin_ = 0;
+    } else if (end_ == kCapacity) {
+        // a whole buffer without a delimiter, nothing useful can come of it
+        ++overflows_;
+        Clear();
+    }
+    return buffer_.data() + end_;
+}
+
+size_t LineFramer::WriteSpace() const {
+    return kCapacity - end_;
+}
+
+void LineFramer::Commit(size_t n) {
+    end_ += n;
+}
+
+bool LineFramer::NextLine(std::string_view &line) {
+    // memchr is vectorized by libc, and scan_ means every byte is only searched once
+    auto *delimiter = static_cast<const char *>(memchr(buffer_.data() + scan_, delimiter_, end_ - scan_));
+    if (delimiter == nullptr) {
+        scan_ = end_;
+        return false;
+    }
+
+    size_t delimiter_pos = delimiter - buffer_.data();
+    size_t line_end = delimiter_pos;
+    if (delimiter_ == '\n' && line_end > begin_ && buffer_[line_end - 1] == '\r') {
+        --line_end;
+    }
+    line = std::string_view(buffer_.data() + begin_, line_end - begin_);
+
+    begin_ = scan_ = delimiter_pos + 1;
+    if (begin_ == end_) {
+        begin_ = scan_ = end_ = 0;
+    }
+    return true;
+}
+
+std::string_view LineFramer::Remainder() const {
+    return std::string_view(buffer_.data() + begin_, end_ - begin_);
+}
+
+void LineFramer::Clear() {
+    begin_ = scan_ = end_ = 0;
+}
+
 SerialPort::~SerialPort() {
     Close();
 }
 
 bool SerialPort::Open(const std::string &device, const unsigned int baud) {
+    Close();
     port_handle_ = open(device.c_str(), O_RDWR | O_NOCTTY);
+    if (port_handle_ == -1) {
+        return false;
+    }
 
     SetProperties(baud);
+    framer_.Clear();
 
-    return (port_handle_ != -1);
+    return true;
+}
+
+bool SerialPort::Open(int fd) {
+    if (fd < 0 || fcntl(fd, F_GETFD) == -1) {
+        return false;
+    }
+    if (fd != port_handle_) {
+        Close();
+    } else {
+        StopReading();
+    }
+    port_handle_ = fd;
+    framer_.Clear();
+    return true;
 }
 
 void SerialPort::Close() {
+    StopReading();
     if (port_handle_ != -1) {
         // Flush port to ensure any last minute writes make it to the hardware
         tcflush(port_handle_, TCIFLUSH);
         close(port_handle_);
+        port_handle_ = -1;
     }
 }
 
-void SerialPort::Write(std::string message) {
-    ssize_t n_written = 0;
-    ssize_t spot = 0;
-    const char *msg_data = message.c_str();
-    do {
-        n_written = write(port_handle_, &msg_data[spot], message.size() - n_written);
+bool SerialPort::Write(const std::string &message) {
+    size_t spot = 0;
+    while (spot < message.size()) {
+        ssize_t n_written = write(port_handle_, message.data() + spot, message.size() - spot);
+        if (n_written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n_written <= 0) {
+            return false;
+        }
         spot += n_written;
-    } while (spot < message.size() && n_written > 0);
+    }
+    return true;
 }
 
 std::string SerialPort::ReadLine() {
-    string line;
-    ssize_t n_read = 0;
-    char in;
-    do {
-        n_read = read(port_handle_, &in, 1);
-        if (in != '\n')
-            line += in;
-    } while (in != '\n' && n_read > 0);
-    return line;
+    std::string_view line;
+    while (!framer_.NextLine(line)) {
+        ssize_t n_read = read(port_handle_, framer_.WriteBegin(), framer_.WriteSpace());
+        if (n_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n_read <= 0) {
+            std::string partial(framer_.Remainder());
+            framer_.Clear();
+            return partial;
+        }
+        framer_.Commit(n_read);
+    }
+    return std::string(line);
+}
+
+bool SerialPort::StartReading(LineCallback callback) {
+    if (port_handle_ == -1 || reading_) {
+        return false;
+    }
+    StopReading();  // cleans up after a reader that stopped itself
+
+    stop_event_ = eventfd(0, EFD_CLOEXEC);
+    if (stop_event_ == -1) {
+        return false;
+    }
+
+    reading_ = true;
+    reader_thread_ = std::thread(&SerialPort::ReaderLoop, this, std::move(callback));
+    return true;
+}
+
+void SerialPort::StopReading() {
+    // The reader also stops on its own when the device hangs up, which still leaves its thread and event to clean up
+    if (reading_.exchange(false)) {
+        uint64_t one = 1;
+        if (write(stop_event_, &one, sizeof(one)) < 0) {
+            std::cout << "Error " << errno << " from stopping serial reader: " << strerror(errno) << std::endl;
+        }
+    }
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+    if (stop_event_ != -1) {
+        close(stop_event_);
+        stop_event_ = -1;
+    }
+}
+
+void SerialPort::ReaderLoop(LineCallback callback) {
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = port_handle_;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, port_handle_, &event);
+    event.data.fd = stop_event_;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stop_event_, &event);
+
+    // take everything available in as few reads as the buffer allows
+    auto read_lines = [&]() {
+        ssize_t n_read = read(port_handle_, framer_.WriteBegin(), framer_.WriteSpace());
+        if (n_read <= 0) {
+            return false;
+        }
+        framer_.Commit(n_read);
+
+        std::string_view line;
+        while (framer_.NextLine(line)) {
+            callback(line);
+        }
+        return true;
+    };
+
+    std::array<epoll_event, 2> ready{};
+    while (reading_) {
+        int n_ready = epoll_wait(epoll_fd, ready.data(), ready.size(), -1);
+        if (n_ready < 0 && errno != EINTR) {
+            std::cout << "Error " << errno << " from epoll_wait: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < n_ready; i++) {
+            if (ready[i].data.fd != port_handle_) {
+                continue;  // stop event, the loop condition handles it
+            }
+            if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+                // the device is gone, but what it sent before that is still buffered
+                while (read_lines()) {
+                }
+                reading_ = false;
+                break;
+            }
+            read_lines();
+        }
+    }
+
+    close(epoll_fd);
 }
 
 void SerialPort::SetProperties(unsigned int baud) {
@@ -64,8 +263,8 @@ void SerialPort::SetProperties(unsigned int baud) {
     tty_old = tty;
 
     /* Set Baud Rate */
-    cfsetospeed(&tty, baud);
-    cfsetispeed(&tty, baud);
+    cfsetospeed(&tty, BaudToSpeed(baud));
+    cfsetispeed(&tty, BaudToSpeed(baud));
 
     /* Setting other Port Stuff */
     tty.c_cflag &= ~PARENB;  // Make 8n1
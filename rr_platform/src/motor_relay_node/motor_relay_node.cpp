@@ -1,11 +1,18 @@
 #include <ros/ros.h>
+#include <rr_common/tracing.h>
 #include <rr_msgs/chassis_state.h>
 #include <rr_msgs/speed.h>
 #include <rr_msgs/steering.h>
+#include <rr_platform/ClockOffsetEstimator.h>
+#include <rr_platform/CommandScheduler.h>
+#include <rr_platform/FrameCodec.h>
 #include <rr_platform/SerialPort.h>
 
-double desiredSpeed = 0;
-double desiredSteer = 0;
+#include <atomic>
+
+std::atomic<double> desiredSpeed{ 0 };
+std::atomic<double> desiredSteer{ 0 };
+std::atomic<uint64_t> commandStampNs{ 0 };  // stamp of the newest command, for tracing
 double prevAngle = 0;
 double prevSpeed = 0;
 
@@ -21,50 +28,113 @@ constexpr float s_per_50ms = 0.05f;
 
 ros::Publisher state_pub;
 
-/**
- * @note http://stackoverflow.com/a/27511119
- */
-std::vector<std::string> split(const std::string &s, char delim) {
-    std::stringstream ss(s);
-    std::string item;
-    std::vector<std::string> elems;
-    while (std::getline(ss, item, delim)) {
-        elems.push_back(std::move(item));
+// Binary frames need matching firmware, otherwise the original text lines are used
+bool binary_protocol = false;
+rr::FrameEncoder frame_encoder;
+rr::FrameDecoder frame_decoder;
+ros::WallTime start_time;
+
+// Binary feedback is stamped from the firmware's clock mapped onto ours, like the IMU's samples
+rr::ClockOffsetEstimator clock_estimator;
+bool has_device_timestamp = false;
+uint32_t last_device_timestamp_us = 0;
+uint64_t device_time_us = 0;
+
+std::unique_ptr<rr::CommandScheduler> scheduler;
+
+// Where a command came from in steady clock time. Planned commands carry the stamp of the sensor data they were
+// planned from, so latency covers the whole trip from the sensor.
+rr::CommandScheduler::Clock::time_point commandOrigin(const std_msgs::Header &header) {
+    auto now = rr::CommandScheduler::Clock::now();
+    if (header.stamp.isZero()) {
+        return now;
     }
-    return elems;
+    auto age = std::chrono::nanoseconds((ros::Time::now() - header.stamp).toNSec());
+    return now - std::max(age, std::chrono::nanoseconds(0));
 }
 
 void SpeedCallback(const rr_msgs::speed::ConstPtr &msg) {
     desiredSpeed = msg->speed * ticks_per_meter * s_per_50ms;
+    commandStampNs = msg->header.stamp.toNSec();
+    scheduler->notify(commandOrigin(msg->header));
 }
 
 void SteeringCallback(const rr_msgs::steering::ConstPtr &msg) {
     desiredSteer = msg->angle;
+    commandStampNs = msg->header.stamp.toNSec();
+    scheduler->notify(commandOrigin(msg->header));
 }
 
 void sendCommand(SerialPort &port) {
-    std::string message = "$" + std::to_string(desiredSpeed) + ", " + std::to_string(desiredSteer) + "," +
-                          std::to_string(kP) + "," + std::to_string(kI) + "," + std::to_string(kD) + "," +
-                          std::to_string(trim) + "\n";
+    ros::Time command_stamp;
+    rr::TraceSpan span("motor_relay", command_stamp.fromNSec(commandStampNs));
 
-    port.Write(message);
+    if (desiredSteer != prevAngle || desiredSpeed != prevSpeed) {
+        ROS_INFO("Sending command: servo=%f, motor=%f", desiredSteer.load(), desiredSpeed.load());
+    }
+    prevAngle = desiredSteer;
+    prevSpeed = desiredSpeed;
+
+    rr::MotorCommand command;
+    command.speed = static_cast<float>(desiredSpeed);
+    command.steer = static_cast<float>(desiredSteer);
+    command.kP = static_cast<float>(kP);
+    command.kI = static_cast<float>(kI);
+    command.kD = static_cast<float>(kD);
+    command.trim = static_cast<int16_t>(trim);
+
+    if (binary_protocol) {
+        auto timestamp_us = static_cast<uint32_t>((ros::WallTime::now() - start_time).toNSec() / 1000);
+        port.Write(frame_encoder.encode(command, timestamp_us));
+    } else {
+        port.Write(rr::text::encode(command));
+    }
 }
 
-void publishData(const std::string &line) {
-    if (line.empty()) {
-        return;
-    }
-    std::vector<std::string> data = split(line.substr(1), ',');
+void publishData(const rr::MotorFeedback &feedback, const ros::Time &stamp) {
     rr_msgs::chassis_state msg;
-    msg.header.stamp = ros::Time::now();
-    msg.speed_mps = static_cast<float>(std::stod(data[0]) / (s_per_50ms * ticks_per_meter));
-    msg.mux_autonomous = static_cast<uint8_t>(data[1] == "1");
-    msg.estop_on = static_cast<uint8_t>(data[2] == "1");
+    msg.header.stamp = stamp;
+    msg.speed_mps = static_cast<float>(feedback.speed / (s_per_50ms * ticks_per_meter));
+    msg.mux_autonomous = static_cast<uint8_t>(feedback.mux_autonomous);
+    msg.estop_on = static_cast<uint8_t>(feedback.estop_on);
     state_pub.publish(msg);
 }
 
+void handleLine(std::string_view line) {
+    // ros::Time may be simulated, the estimator needs the clock the bytes actually arrived on
+    ros::WallTime arrival = ros::WallTime::now();
+
+    rr::MotorFeedback feedback;
+    if (!binary_protocol) {
+        if (rr::text::decode(line, feedback)) {
+            publishData(feedback, ros::Time::now());
+        }
+        return;
+    }
+
+    rr::Frame frame;
+    uint32_t dropped = frame_decoder.droppedFrames();
+    if (frame_decoder.decode(line, frame) != rr::FrameDecoder::Result::OK) {
+        ROS_WARN_THROTTLE(1.0, "Motor relay: %u corrupt feedback frames", frame_decoder.corruptFrames());
+        return;
+    }
+    if (frame_decoder.droppedFrames() != dropped) {
+        ROS_WARN_THROTTLE(1.0, "Motor relay: %u feedback frames dropped", frame_decoder.droppedFrames());
+    }
+    if (rr::unpack(frame, feedback)) {
+        // unsigned subtraction unwraps the 32 bit microsecond counter
+        device_time_us += has_device_timestamp ? static_cast<uint32_t>(frame.timestamp_us - last_device_timestamp_us)
+                                               : frame.timestamp_us;
+        has_device_timestamp = true;
+        last_device_timestamp_us = frame.timestamp_us;
+
+        publishData(feedback, ros::Time(clock_estimator.update(device_time_us * 1e-6, arrival.toSec())));
+    }
+}
+
 int main(int argc, char **argv) {
     ros::init(argc, argv, "iarrc_motor_relay_node");
+    rr::startTracing(ros::this_node::getName());
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
 
@@ -82,6 +152,10 @@ int main(int argc, char **argv) {
     nhp.param(std::string("kD"), kD, 0.1);
     nhp.param(std::string("trim"), trim, 0);
 
+    std::string protocol;
+    nhp.param(std::string("protocol"), protocol, std::string("text"));
+    binary_protocol = (protocol == "binary");
+
     state_pub = nh.advertise<rr_msgs::chassis_state>("/chassis_state", 1);
 
     ROS_INFO_STREAM("Listening for speed on " << speed_topic_name);
@@ -96,36 +170,43 @@ int main(int argc, char **argv) {
         ROS_FATAL_STREAM("Unable to open serial port: " << serial_port_name);
         return 1;
     }
+    if (binary_protocol) {
+        serial_port.SetDelimiter('\0');
+    }
+    start_time = ros::WallTime::now();
 
     ROS_INFO("IARRC motor relay node is ready.");
 
-    float hz = 20;
-    ros::Rate rate(hz);
-    int count = 0;
-    int countLimit = (int)(hz / 10);  // Limit motor commands to 10hz regardless of loop rate
-    int sequence = 0;
+    // Commands go out as soon as they arrive but no closer together than the minimum interval, and are repeated
+    // after the keepalive interval like the old fixed 10 Hz loop did
+    double min_command_interval = nhp.param(std::string("min_command_interval"), 0.01);
+    double command_keepalive = nhp.param(std::string("command_keepalive"), 0.1);
 
     ros::Duration(2.0).sleep();
 
-    while (ros::ok()) {
-        ros::spinOnce();
-        if (count == countLimit) {
-            if (desiredSteer != prevAngle || desiredSpeed != prevSpeed) {
-                ROS_INFO("Sending command: servo=%f, motor=%f", desiredSteer, desiredSpeed);
-            }
-
-            prevAngle = desiredSteer;
-            prevSpeed = desiredSpeed;
-            sendCommand(serial_port);
-            publishData(serial_port.ReadLine());
-
-            count = 0;
+    // Feedback is published from the serial port's reader thread as soon as it arrives
+    serial_port.StartReading(handleLine);
+
+    auto toDuration = [](double seconds) {
+        return std::chrono::duration_cast<rr::CommandScheduler::Clock::duration>(
+              std::chrono::duration<double>(seconds));
+    };
+    scheduler = std::make_unique<rr::CommandScheduler>(toDuration(min_command_interval),
+                                                       toDuration(command_keepalive),
+                                                       [&serial_port] { sendCommand(serial_port); });
+
+    auto statsTimer = nh.createWallTimer(ros::WallDuration(10.0), [](const ros::WallTimerEvent &) {
+        auto stats = scheduler->takeStats();
+        if (stats.count > 0) {
+            using ms = std::chrono::duration<double, std::milli>;
+            ROS_INFO("Motor commands: %zu updates sent, latency mean %.2f ms, max %.2f ms", stats.count,
+                     ms(stats.mean()).count(), ms(stats.max).count());
         }
-        count++;
+    });
 
-        rate.sleep();
-    }
+    ros::spin();
 
+    scheduler.reset();
     ROS_INFO("Shutting down IARRC motor relay node.");
     return 0;
 }
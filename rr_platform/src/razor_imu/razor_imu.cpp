@@ -1,73 +1,133 @@
 #include <ros/ros.h>
 #include <rr_msgs/axes.h>
 #include <rr_msgs/chassis_state.h>
+#include <rr_platform/ClockOffsetEstimator.h>
+#include <rr_platform/FrameCodec.h>
 #include <rr_platform/SerialPort.h>
 #include <sensor_msgs/Imu.h>
 #include <sensor_msgs/MagneticField.h>
 
-#include <boost/asio.hpp>
-#include <boost/regex.hpp>
+#include <algorithm>
 
 ros::Publisher imu_pub;
 ros::Publisher mag_pub;
 ros::Publisher axes_pub;
 
-/**
- * @note http://stackoverflow.com/a/27511119
- */
+// Binary frames need matching firmware, otherwise the original text lines are used
+bool binary_protocol = false;
+rr::FrameDecoder frame_decoder;
+
+// Samples are stamped from the device's clock mapped onto ours, rather than with whenever a read returned. Binary
+// frames carry a microsecond timestamp. Text lines have none, so there the device time is the sample count over the
+// nominal rate, and a lost line makes the count fall behind, so the estimate is reset once an arrival is half a period
+// later than it expects.
+rr::ClockOffsetEstimator clock_estimator;
+double device_rate;
+bool has_device_timestamp = false;
+uint32_t last_device_timestamp_us = 0;
+uint64_t device_time_us = 0;
+uint64_t sample_count = 0;
+
+// Only every decimation-th sample is published
+int decimation;
+bool publish_sample = false;
+ros::Time sample_stamp;
+
+rr::ImuSample sample{};
+sensor_msgs::Imu imu_msg;
+sensor_msgs::MagneticField mag_msg;
+rr_msgs::axes axes_msg;
+
+void newSample(double device_time, const ros::WallTime &arrival) {
+    sample_stamp = ros::Time(clock_estimator.update(device_time, arrival.toSec()));
+    publish_sample = (sample_count % decimation == 0);
+    sample_count++;
+}
 
-std::vector<std::string> split(const std::string &s, char delim) {
-    std::stringstream ss(s);
-    std::string item;
-    std::vector<std::string> elems;
-    while (std::getline(ss, item, delim)) {
-        elems.push_back(std::move(item));
-    }
-    return elems;
+void publishImu() {
+    imu_msg.header.stamp = sample_stamp;
+    imu_msg.linear_acceleration.x = sample.accel[0];
+    imu_msg.linear_acceleration.y = sample.accel[1];
+    imu_msg.linear_acceleration.z = sample.accel[2];
+    imu_msg.angular_velocity.x = sample.gyro[0];
+    imu_msg.angular_velocity.y = sample.gyro[1];
+    imu_msg.angular_velocity.z = sample.gyro[2];
+    imu_msg.orientation.x = sample.orientation[0];
+    imu_msg.orientation.y = sample.orientation[1];
+    imu_msg.orientation.z = sample.orientation[2];
+    imu_msg.orientation.w = sample.orientation[3];
+    imu_pub.publish(imu_msg);
 }
 
-bool set_imu(const std::string &line_in, sensor_msgs::Imu &imu_msg) {
-    std::vector<std::string> data = split(line_in, ',');
-    if (data[0] == "ax") {
-        imu_msg.linear_acceleration.x = std::atof(data[1].c_str());
-        imu_msg.linear_acceleration.y = std::atof(data[2].c_str());
-        imu_msg.linear_acceleration.z = std::atof(data[3].c_str());
-    } else if (data[0] == "gx") {
-        imu_msg.angular_velocity.x = std::atof(data[1].c_str());
-        imu_msg.angular_velocity.y = std::atof(data[2].c_str());
-        imu_msg.angular_velocity.z = std::atof(data[3].c_str());
-    } else if (data[0] == "q0") {
-        imu_msg.orientation.x = std::atof(data[1].c_str());
-        imu_msg.orientation.y = std::atof(data[2].c_str());
-        imu_msg.orientation.z = std::atof(data[3].c_str());
-        imu_msg.orientation.w = std::atof(data[4].c_str());
-        return true;
-    } else {
-        return false;
-    }
+void publishMag() {
+    mag_msg.header.stamp = sample_stamp;
+    mag_msg.magnetic_field.x = sample.mag[0];
+    mag_msg.magnetic_field.y = sample.mag[1];
+    mag_msg.magnetic_field.z = sample.mag[2];
+    mag_pub.publish(mag_msg);
 }
 
-bool set_mag(const std::string &line_in, sensor_msgs::MagneticField &mag_msg) {
-    std::vector<std::string> data = split(line_in, ',');
-    if (data[0] == "mx") {
-        mag_msg.magnetic_field.x = std::atof(data[1].c_str());
-        mag_msg.magnetic_field.y = std::atof(data[2].c_str());
-        mag_msg.magnetic_field.z = std::atof(data[3].c_str());
-        return true;
-    } else {
-        return false;
-    }
+void publishAxes() {
+    axes_msg.header.stamp = sample_stamp;
+    axes_msg.roll = sample.axes[0];
+    axes_msg.pitch = sample.axes[1];
+    axes_msg.yaw = sample.axes[2];
+    axes_pub.publish(axes_msg);
 }
 
-bool set_axes(const std::string &line_in, rr_msgs::axes &axes_msg) {
-    std::vector<std::string> data = split(line_in, ',');
-    if (data[0] == "axes") {
-        axes_msg.roll = std::atof(data[1].c_str());
-        axes_msg.pitch = std::atof(data[2].c_str());
-        axes_msg.yaw = std::atof(data[3].c_str());
-        return true;
-    } else {
-        return false;
+void processLine(std::string_view line) {
+    // ros::Time may be simulated, the estimator needs the clock the bytes actually arrived on
+    ros::WallTime arrival = ros::WallTime::now();
+
+    if (binary_protocol) {
+        rr::Frame frame;
+        uint32_t dropped = frame_decoder.droppedFrames();
+        if (frame_decoder.decode(line, frame) != rr::FrameDecoder::Result::OK) {
+            ROS_WARN_THROTTLE(1.0, "IMU: %u corrupt frames", frame_decoder.corruptFrames());
+            return;
+        }
+        if (frame_decoder.droppedFrames() != dropped) {
+            ROS_WARN_THROTTLE(1.0, "IMU: %u frames dropped", frame_decoder.droppedFrames());
+        }
+        if (!rr::unpack(frame, sample)) {
+            return;
+        }
+
+        // unsigned subtraction unwraps the 32 bit microsecond counter
+        device_time_us += has_device_timestamp ? static_cast<uint32_t>(frame.timestamp_us - last_device_timestamp_us)
+                                               : frame.timestamp_us;
+        has_device_timestamp = true;
+        last_device_timestamp_us = frame.timestamp_us;
+
+        newSample(device_time_us * 1e-6, arrival);
+        if (publish_sample) {
+            publishImu();
+            publishMag();
+            publishAxes();
+        }
+        return;
+    }
+
+    // The text protocol spreads a sample over several lines, the orientation line finishes the IMU message
+    switch (rr::text::decode(line, sample)) {
+        case rr::text::ImuField::ORIENTATION:
+            newSample(sample_count / device_rate, arrival);
+            if (publish_sample) {
+                publishImu();
+            }
+            break;
+        case rr::text::ImuField::MAG:
+            if (publish_sample) {
+                publishMag();
+            }
+            break;
+        case rr::text::ImuField::AXES:
+            if (publish_sample) {
+                publishAxes();
+            }
+            break;
+        default:
+            break;
     }
 }
 
@@ -86,14 +146,28 @@ int main(int argc, char **argv) {
     private_handle.param(std::string("serial_port"), serial_port_name, std::string("/dev/razor_imu"));
     SerialPort serial_port;
 
+    std::string protocol;
+    private_handle.param(std::string("protocol"), protocol, std::string("text"));
+    binary_protocol = (protocol == "binary");
+
+    private_handle.param(std::string("device_rate"), device_rate, 50.0);
+    private_handle.param(std::string("decimation"), decimation, 1);
+    decimation = std::max(decimation, 1);
+    double clock_window;
+    private_handle.param(std::string("clock_window"), clock_window, 10.0);
+    if (binary_protocol) {
+        clock_estimator = rr::ClockOffsetEstimator(clock_window);
+    } else {
+        clock_estimator = rr::ClockOffsetEstimator(clock_window, 1.0, 0.01, 0.5 / device_rate);
+    }
+
     if (!serial_port.Open(serial_port_name, 115200)) {
         ROS_FATAL_STREAM("Unable to open serial port: " << serial_port_name);
         return 1;
     }
-
-    sensor_msgs::Imu imu_msg;
-    sensor_msgs::MagneticField mag_msg;
-    rr_msgs::axes axes_msg;
+    if (binary_protocol) {
+        serial_port.SetDelimiter('\0');
+    }
 
     imu_msg.header.frame_id = "imu";
     mag_msg.header.frame_id = "mag";
@@ -102,30 +176,13 @@ int main(int argc, char **argv) {
 
     ros::Duration(2.0).sleep();
 
-    while (ros::ok()) {
-        ros::spinOnce();
-
-        auto line_in = serial_port.ReadLine();
-        if (!line_in.empty()) {
-            if (set_imu(line_in, imu_msg)) {
-                sensor_msgs::Imu publishable_copy = imu_msg;
-                publishable_copy.header.stamp = ros::Time::now();
-                imu_pub.publish(publishable_copy);
-            }
-
-            if (set_mag(line_in, mag_msg)) {
-                sensor_msgs::MagneticField publishable_copy = mag_msg;
-                publishable_copy.header.stamp = ros::Time::now();
-                mag_pub.publish(publishable_copy);
-            }
-
-            if (set_axes(line_in, axes_msg)) {
-                rr_msgs::axes publishable_copy = axes_msg;
-                publishable_copy.header.stamp = ros::Time::now();
-                axes_pub.publish(publishable_copy);
-            }
-        }
+    // Lines are handled on the serial port's reader thread as soon as they arrive
+    if (!serial_port.StartReading(processLine)) {
+        ROS_FATAL_STREAM("Unable to read from serial port: " << serial_port_name);
+        return 1;
     }
 
+    ros::spin();
+
     return 0;
 }
@@ -0,0 +1,78 @@
+#include "scan_projector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace rr_platform {
+
+namespace {
+
+// Same layout as pcl::PointXYZ, so PCL can copy it without remapping fields
+constexpr uint32_t kPointStep = 16;
+
+void setFields(sensor_msgs::PointCloud2 &cloud) {
+    if (cloud.fields.size() == 3) {
+        return;
+    }
+    cloud.fields.resize(3);
+    const char *names[] = { "x", "y", "z" };
+    for (size_t i = 0; i < 3; i++) {
+        cloud.fields[i].name = names[i];
+        cloud.fields[i].offset = static_cast<uint32_t>(i * sizeof(float));
+        cloud.fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+        cloud.fields[i].count = 1;
+    }
+    cloud.is_bigendian = false;
+    cloud.point_step = kPointStep;
+}
+
+}  // namespace
+
+void ScanProjector::updateTables(const sensor_msgs::LaserScan &scan) {
+    if (scan.angle_min == angle_min_ && scan.angle_increment == angle_increment_ && scan.ranges.size() == cos_.size()) {
+        return;
+    }
+
+    angle_min_ = scan.angle_min;
+    angle_increment_ = scan.angle_increment;
+    cos_.resize(scan.ranges.size());
+    sin_.resize(scan.ranges.size());
+    for (size_t i = 0; i < scan.ranges.size(); i++) {
+        double angle = static_cast<double>(scan.angle_min) + static_cast<double>(i) * scan.angle_increment;
+        cos_[i] = static_cast<float>(std::cos(angle));
+        sin_[i] = static_cast<float>(std::sin(angle));
+    }
+}
+
+void ScanProjector::project(const sensor_msgs::LaserScan &scan, sensor_msgs::PointCloud2 &cloud) {
+    updateTables(scan);
+    setFields(cloud);
+
+    cloud.header = scan.header;
+    cloud.height = 1;
+    cloud.is_dense = true;
+    cloud.data.resize(scan.ranges.size() * kPointStep);
+
+    const float min_range = std::max(scan.range_min, min_point_dist_);
+    const float max_range = scan.range_max;
+    uint8_t *out = cloud.data.data();
+    for (size_t i = 0; i < scan.ranges.size(); i++) {
+        float range = scan.ranges[i];
+        // false for NaN too
+        if (!(range >= min_range && range < max_range)) {
+            continue;
+        }
+        // z and the padding are written too, uninitialized bytes would otherwise be published
+        float point[4] = { range * cos_[i], range * sin_[i], 0.0f, 0.0f };
+        memcpy(out, point, kPointStep);
+        out += kPointStep;
+    }
+
+    size_t n_points = (out - cloud.data.data()) / kPointStep;
+    cloud.data.resize(n_points * kPointStep);
+    cloud.width = static_cast<uint32_t>(n_points);
+    cloud.row_step = cloud.width * kPointStep;
+}
+
+}  // namespace rr_platform
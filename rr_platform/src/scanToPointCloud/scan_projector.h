@@ -0,0 +1,33 @@
+#pragma once
+
+#include <sensor_msgs/LaserScan.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <vector>
+
+namespace rr_platform {
+
+/*
+ * Converts laser scans to PointXYZ clouds, dropping returns outside the scan's valid range or closer than a minimum
+ * distance. The sin/cos of every beam is cached and only recomputed when the scan geometry changes, and points are
+ * written straight into the output buffer in a single pass.
+ */
+class ScanProjector {
+  public:
+    explicit ScanProjector(double min_point_dist) : min_point_dist_(static_cast<float>(min_point_dist)) {}
+
+    // Reuses the capacity of cloud.data, so passing the same message every time avoids allocating
+    void project(const sensor_msgs::LaserScan &scan, sensor_msgs::PointCloud2 &cloud);
+
+  private:
+    float min_point_dist_;
+
+    float angle_min_ = 0;
+    float angle_increment_ = 0;
+    std::vector<float> cos_;
+    std::vector<float> sin_;
+
+    void updateTables(const sensor_msgs::LaserScan &scan);
+};
+
+}  // namespace rr_platform
@@ -0,0 +1,44 @@
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <ros/ros.h>
+
+#include "scan_projector.h"
+
+namespace rr_platform {
+
+/*
+ * Nodelet version of scanToPointCloud. Subscribers in the same manager receive the published cloud without it being
+ * serialized, so every scan gets a fresh message instead of the reused buffer of the standalone node.
+ */
+class ScanToPointCloudNodelet : public nodelet::Nodelet {
+  private:
+    ros::Publisher pc_pub_;
+    ros::Subscriber scan_sub_;
+    std::unique_ptr<ScanProjector> projector_;
+    size_t last_size_ = 0;
+
+    void scanCallback(const sensor_msgs::LaserScanConstPtr &msg) {
+        sensor_msgs::PointCloud2Ptr cloud(new sensor_msgs::PointCloud2);
+        cloud->data.reserve(last_size_);
+        projector_->project(*msg, *cloud);
+        last_size_ = cloud->data.size();
+        pc_pub_.publish(cloud);
+    }
+
+    void onInit() override {
+        ros::NodeHandle &nh = getNodeHandle();
+        ros::NodeHandle &nhp = getPrivateNodeHandle();
+
+        double filtering_distance;
+        nhp.param("min_point_dist", filtering_distance, double(1.0));
+        NODELET_INFO_STREAM("[ScanToPointCloud] using min distance " << filtering_distance);
+        projector_ = std::make_unique<ScanProjector>(filtering_distance);
+
+        pc_pub_ = nh.advertise<sensor_msgs::PointCloud2>("scan/pointcloud", 1);
+        scan_sub_ = nh.subscribe("scan", 1, &ScanToPointCloudNodelet::scanCallback, this);
+    }
+};
+
+}  // namespace rr_platform
+
+PLUGINLIB_EXPORT_CLASS(rr_platform::ScanToPointCloudNodelet, nodelet::Nodelet)
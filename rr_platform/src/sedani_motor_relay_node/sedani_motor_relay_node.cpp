@@ -95,6 +95,12 @@ int main(int argc, char **argv) {
 
     ros::Duration(2.0).sleep();
 
+    // Feedback is published from the serial port's reader thread as soon as it arrives
+    serial_port.StartReading([](std::string_view line) {
+        ROS_INFO_STREAM("motor relay received " << line);
+        publishData(std::string(line));
+    });
+
     while (ros::ok()) {
         ros::spinOnce();
         if (desiredSteer != prevAngle || desiredSpeed != prevSpeed) {
@@ -106,9 +112,6 @@ int main(int argc, char **argv) {
 
         sendCommand(serial_port);
 
-        auto ret = serial_port.ReadLine();
-        ROS_INFO_STREAM("motor relay received " << ret);
-        publishData(ret);
         rate.sleep();
     }
 
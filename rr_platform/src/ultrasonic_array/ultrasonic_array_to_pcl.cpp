@@ -1,15 +1,19 @@
-#include <pcl_conversions/pcl_conversions.h>
-#include <pcl_ros/transforms.h>
-#include <ros/publisher.h>
 #include <ros/ros.h>
+#include <rr_platform/SerialPort.h>
 #include <sensor_msgs/PointCloud2.h>
 #include <tf/transform_listener.h>
 
-#include <algorithm>
-#include <boost/algorithm/string.hpp>
-#include <boost/asio.hpp>
-#include <boost/math/constants/constants.hpp>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
 
 using namespace std;
 
@@ -20,98 +24,112 @@ using namespace std;
   then outputing a point cloud. Ultrasonic sensors defined in
   urdf and uses that for transforming points.
   Requires a tf tree being published.
+
+  Each line from the array is one sweep with a distance per sensor. The sensor
+  transforms are static, so they are looked up once at startup and every sweep
+  is written straight into a single cloud in the base frame. A sensor sees
+  anything inside its beam, so each reading becomes an arc of points spanning
+  the sensor's cone angle at the measured distance.
 */
 
 // defaults for launch file paramenters
 #define NUM_SENSORS_DEFAULT 6
-#define DRAW_METHOD_DEFAULT 0       // 0 = Single Point, 1 = wall, 2 = circle, 3 = semicircle
-#define NUM_POINTS_DEFAULT 12       //# minimum points for each semicircle/circle/wall
-#define RADIUS_DEFAULT 0.1f         // radius of semicircle/circle in meters
-#define LENGTH_DEFAULT 0.1f         // length of wall
+#define CONE_ANGLE_DEFAULT 0.0      // full beam width in radians, 0 for a single point per reading
+#define NUM_POINTS_DEFAULT 12       // points on each arc
 #define DISTANCE_CLIP_DEFAULT 5.0f  // distance beyond which we ignore point in meters
 #define BAUD_RATE_DEFAULT 9600      // rate of transfer. Needs to match Arduino
 
-const double pi = boost::math::constants::pi<double>();
-
-string readLine(boost::asio::serial_port &port) {
-    string line = "";
-    bool inLine = false;
-    while (true) {
-        char in;
-        try {
-            boost::asio::read(port, boost::asio::buffer(&in, 1));
-            if (in == '\n') {
-                return line;
-            }
-            line += in;
-        } catch (boost::exception_detail::clone_impl<
-                 boost::exception_detail::error_info_injector<boost::system::system_error>> &err) {
-            ROS_ERROR("Error reading serial port.");
-            ROS_ERROR_STREAM(err.what());
-        }
+// Same layout as pcl::PointXYZ
+constexpr uint32_t point_step = 16;
+
+struct SensorModel {
+    bool valid = false;
+    array<float, 3> origin;              // sensor position in the base frame
+    vector<array<float, 3>> directions;  // unit vectors in the base frame, one per arc point
+};
+
+ros::Publisher pub;
+vector<SensorModel> sensors;
+float distance_clip;
+string sensor_base_link;
+sensor_msgs::PointCloud2 cloud;
+
+SensorModel buildSensorModel(const tf::StampedTransform &transform, double cone_angle, int num_points) {
+    SensorModel model;
+    model.valid = true;
+    const tf::Vector3 &origin = transform.getOrigin();
+    model.origin = { static_cast<float>(origin.x()), static_cast<float>(origin.y()), static_cast<float>(origin.z()) };
+
+    int n = (cone_angle > 0) ? max(num_points, 2) : 1;
+    for (int i = 0; i < n; i++) {
+        double angle = (n == 1) ? 0.0 : -cone_angle / 2.0 + cone_angle * i / (n - 1);
+        tf::Vector3 direction = transform.getBasis() * tf::Vector3(cos(angle), sin(angle), 0.0);
+        model.directions.push_back({ static_cast<float>(direction.x()), static_cast<float>(direction.y()),
+                                     static_cast<float>(direction.z()) });
     }
+    return model;
 }
 
-vector<double> parseLine(string line) {
-    vector<string> strs;
-    boost::split(strs, line, boost::is_any_of(","));
-
-    vector<double> dist(strs.size());
-    std::transform(strs.begin(), strs.end(), dist.begin(),
-                   [](const auto &s) { return std::stod(s); });  // convert string to double
-
-    return dist;
-}
-
-void drawWall(pcl::PointCloud<pcl::PointXYZ> &cloud, pcl::PointXYZ center, float length, int numPoints) {
-    length = (length + 1) / 2.0;  //@Note: adds one to ensure we get at least the numPoints desired
-    float step = length / (float)numPoints / 2.0;
-    float dist = step;
-    for (int i = 0; i < numPoints / 2; i++) {
-        // draw half the line and mirror
-        pcl::PointXYZ point1(center.x, dist,
-                             0);  //#TODO: might need to swap x and y
-        pcl::PointXYZ point2(center.x, -dist,
-                             0);  //#TODO: might need to swap x and y
-
-        cloud.push_back(point1);
-        cloud.push_back(point2);
-        dist = dist + step;
+bool parseDistance(string_view field, float &distance) {
+    while (!field.empty() && field.front() == ' ') {
+        field.remove_prefix(1);
     }
-}
-
-void drawSemiCircle(pcl::PointCloud<pcl::PointXYZ> &cloud, pcl::PointXYZ point, float radius, int numPoints) {
-    numPoints = (numPoints + 1) / 2;  //@Note: adds one to ensure we get at least the numPoints desired
-    float angleStep = (pi / 2.0) / numPoints;
-
-    float angle = 0.0;  //#TODO: may need to shift this start angle
-
-    for (int i = 0; i < numPoints; i++) {
-        // draw a quarter of a cicle and mirror
-        float x = radius * cos(angle);
-        float y = radius * sin(angle);
-
-        cloud.push_back(pcl::PointXYZ(point.x + radius - x, y, 0));
-        cloud.push_back(pcl::PointXYZ(point.x + radius - x, -y, 0));
-
-        angle = angle + angleStep;
+#if defined(__cpp_lib_to_chars)
+    auto result = from_chars(field.data(), field.data() + field.size(), distance);
+    return result.ec == errc();
+#else
+    // no floating point from_chars in this standard library
+    char buffer[32];
+    if (field.empty() || field.size() >= sizeof(buffer)) {
+        return false;
     }
+    memcpy(buffer, field.data(), field.size());
+    buffer[field.size()] = '\0';
+    char *end;
+    distance = strtof(buffer, &end);
+    return end != buffer;
+#endif
 }
 
-void drawCircle(pcl::PointCloud<pcl::PointXYZ> &cloud, pcl::PointXYZ point, double radius, int numPoints) {
-    double angleStep = (2.0 * pi) / numPoints;
+void sweepCallback(string_view line) {
+    ros::Time stamp = ros::Time::now();
+    ROS_DEBUG_STREAM(line);
 
-    double angle = 0;  // start angle
-
-    for (int i = 0; i < numPoints; i++) {
-        // draw a circle
-        double x = radius * cos(angle);
-        double y = radius * sin(angle);
+    size_t max_points = 0;
+    for (const auto &sensor : sensors) {
+        max_points += sensor.directions.size();
+    }
+    cloud.data.resize(max_points * point_step);
+    uint8_t *out = cloud.data.data();
+
+    for (size_t i = 0; i < sensors.size() && !line.empty(); i++) {
+        size_t comma = line.find(',');
+        string_view field = line.substr(0, comma);
+        line = (comma == string_view::npos) ? string_view() : line.substr(comma + 1);
+
+        float distance;
+        if (!parseDistance(field, distance)) {
+            ROS_WARN_THROTTLE(1.0, "Ultrasonic array: bad reading for sensor %zu", i);
+            continue;
+        }
 
-        cloud.push_back(pcl::PointXYZ(point.x + radius + x, y,
-                                      0));  // point.x + radius is center of circle
-        angle = angle + angleStep;
+        const SensorModel &sensor = sensors[i];
+        if (!sensor.valid || !(distance < distance_clip)) {
+            continue;
+        }
+        for (const auto &direction : sensor.directions) {
+            float point[4] = { sensor.origin[0] + distance * direction[0], sensor.origin[1] + distance * direction[1],
+                               sensor.origin[2] + distance * direction[2], 0.0f };
+            memcpy(out, point, point_step);
+            out += point_step;
+        }
     }
+
+    cloud.data.resize(out - cloud.data.data());
+    cloud.header.stamp = stamp;
+    cloud.width = static_cast<uint32_t>(cloud.data.size() / point_step);
+    cloud.row_step = cloud.width * point_step;
+    pub.publish(cloud);
 }
 
 int main(int argc, char **argv) {
@@ -120,110 +138,78 @@ int main(int argc, char **argv) {
     ros::NodeHandle nh;
     ros::NodeHandle nhp("~");
 
-    ros::Publisher pub = nh.advertise<sensor_msgs::PointCloud2>("/ultrasonic_array", 1);
+    pub = nh.advertise<sensor_msgs::PointCloud2>("/ultrasonic_array", 1);
 
     // Roslaunch file
-    string sensor_base_link;
     string sensor_link;
-    float update_rate;
     string serial_port_name;
-    float distance_clip;
-    float length;
-    float radius;
     int num_sensors;
     int num_points;
-    int draw_method;
     int baud_rate;
+    double cone_angle;
+    vector<double> cone_angles;
     nhp.param(string("serial_port_name"), serial_port_name, string("/dev/ttyUSB0"));
     nhp.param(string("sensor_base_link"), sensor_base_link, string("ultrasonic_array_base"));
     nhp.param(string("sensor_link_prefix"), sensor_link, string("ultrasonic_"));
-    nhp.param(string("update_rate"), update_rate, 10.0f);
     nhp.param(string("number_of_sensors"), num_sensors, NUM_SENSORS_DEFAULT);
     nhp.param(string("baud_rate"), baud_rate, BAUD_RATE_DEFAULT);
     nhp.param(string("distance_clip"), distance_clip, DISTANCE_CLIP_DEFAULT);
-    nhp.param(string("draw_method"), draw_method, DRAW_METHOD_DEFAULT);
-    nhp.param(string("wall_length"), length, LENGTH_DEFAULT);
-    nhp.param(string("circle_radius"), radius, RADIUS_DEFAULT);
     nhp.param(string("number_of_points"), num_points, NUM_POINTS_DEFAULT);
-
-    // Connect serial
-    ROS_INFO_STREAM("Connecting to serial at port: " + serial_port_name);
-    boost::asio::io_service io_service;
-    boost::asio::serial_port serial(io_service, serial_port_name);
-    serial.set_option(boost::asio::serial_port_base::baud_rate(baud_rate));
-
-    // wait for microcontroller to start
-    ros::Duration(2.0).sleep();
-
-    ros::Rate rate(update_rate);
-
-    // Transforms
-    tf::TransformListener tf_listener;
-    tf::StampedTransform tf_transform;
-    pcl::PointCloud<pcl::PointXYZ> compiled_cloud;
+    // one cone angle for every sensor, or a list with one per sensor
+    nhp.param(string("cone_angle"), cone_angle, CONE_ANGLE_DEFAULT);
+    nhp.param(string("cone_angles"), cone_angles, vector<double>(num_sensors, cone_angle));
+    if (cone_angles.size() != static_cast<size_t>(num_sensors)) {
+        ROS_FATAL("cone_angles has %zu entries for %d sensors", cone_angles.size(), num_sensors);
+        return 1;
+    }
 
     // lookup transforms and store them as they do not change
-    vector<tf::StampedTransform> tf_transform_vector;
+    tf::TransformListener tf_listener;
     for (int i = 0; i < num_sensors; i++) {
-        if (tf_listener.waitForTransform(sensor_base_link, sensor_link + to_string(i), ros::Time(0),
-                                         ros::Duration(5.0))) {
-            tf_listener.lookupTransform(sensor_base_link, sensor_link + to_string(i), ros::Time(0), tf_transform);
+        tf::StampedTransform tf_transform;
+        string link = sensor_link + to_string(i);
+        try {
+            tf_listener.waitForTransform(sensor_base_link, link, ros::Time(0), ros::Duration(5.0));
+            tf_listener.lookupTransform(sensor_base_link, link, ros::Time(0), tf_transform);
+            sensors.push_back(buildSensorModel(tf_transform, cone_angles[i], num_points));
+        } catch (tf::TransformException &ex) {
+            ROS_ERROR_STREAM("No transform for " << link << ", its readings will be ignored: " << ex.what());
+            sensors.emplace_back();
         }
-
-        tf_transform_vector.push_back(tf_transform);
     }
 
-    function<void(pcl::PointCloud<pcl::PointXYZ> & a, pcl::PointXYZ & b)> draw;
-    switch (draw_method) {
-        default:
-        case 0:
-            draw = [](pcl::PointCloud<pcl::PointXYZ> a, pcl::PointXYZ b) {};
-            break;
-        case 1:
-            draw = bind(drawWall, _1, _2, length, num_points);
-            break;
-        case 2:
-            draw = bind(drawCircle, _1, _2, radius, num_points);
-            break;
-        case 3:
-            draw = bind(drawSemiCircle, _1, _2, radius, num_points);
-            break;
+    cloud.header.frame_id = sensor_base_link;
+    cloud.height = 1;
+    cloud.is_dense = true;
+    cloud.is_bigendian = false;
+    cloud.point_step = point_step;
+    cloud.fields.resize(3);
+    const char *names[] = { "x", "y", "z" };
+    for (size_t i = 0; i < 3; i++) {
+        cloud.fields[i].name = names[i];
+        cloud.fields[i].offset = static_cast<uint32_t>(i * sizeof(float));
+        cloud.fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+        cloud.fields[i].count = 1;
     }
 
-    while (ros::ok() && serial.is_open()) {
-        ros::spinOnce();
-
-        string line = readLine(serial);
-        ROS_INFO_STREAM(line);
-        vector<double> distances = parseLine(line);
-
-        for (int i = 0; i < num_sensors; i++) {
-            pcl::PointCloud<pcl::PointXYZ> cloud;
-
-            if (distances[i] < distance_clip) {
-                pcl::PointXYZ point(distances[i], 0.0, 0.0);
-
-                cloud.push_back(point);  // add point direct from Arduino sensor
-                draw(cloud, point);
-
-                pcl_ros::transformPointCloud(cloud, cloud, tf_transform_vector[i]);
+    // Connect serial
+    ROS_INFO_STREAM("Connecting to serial at port: " + serial_port_name);
+    SerialPort serial_port;
+    if (!serial_port.Open(serial_port_name, baud_rate)) {
+        ROS_FATAL_STREAM("Unable to open serial port: " << serial_port_name);
+        return 1;
+    }
 
-                // add point cloud to the output cloud
-                compiled_cloud += cloud;
-            }
-        }
+    // wait for microcontroller to start
+    ros::Duration(2.0).sleep();
 
-        sensor_msgs::PointCloud2 outmsg;
-        pcl::toROSMsg(compiled_cloud, outmsg);
-        outmsg.header.frame_id = sensor_base_link;
+    // Every sweep is turned into a cloud on the serial reader thread as soon as it arrives
+    serial_port.StartReading(sweepCallback);
 
-        pub.publish(outmsg);
-        compiled_cloud.clear();  // remove old data for next round
-        rate.sleep();
-    }
+    ros::spin();
 
     ROS_INFO_STREAM("Shutting down Ultrasonic Array");
-    serial.close();
+    serial_port.Close();
 
     return 0;
 }
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <rr_platform/ClockOffsetEstimator.h>
+
+#include <cmath>
+#include <random>
+
+// A device sampling at 100 Hz whose clock runs 100 ppm fast and started 1000 s after the host's
+struct SimulatedDevice {
+    static constexpr double kPeriod = 0.01;
+    static constexpr double kSkew = 1.0001;
+    static constexpr double kOffset = 1000.0;
+    static constexpr double kMinDelay = 0.001;
+
+    double deviceTime(int i) const {
+        return i * kPeriod * kSkew;
+    }
+
+    double trueHostTime(int i) const {
+        return kOffset + i * kPeriod;
+    }
+};
+
+TEST(ClockOffsetEstimatorTest, RemovesArrivalJitter) {
+    SimulatedDevice device;
+    rr::ClockOffsetEstimator estimator;
+    std::mt19937 rng(42);
+    std::exponential_distribution<double> jitter(1.0 / 0.003);  // mean 3 ms on top of the minimum delay
+
+    double max_error = 0;
+    double max_step_error = 0;
+    double previous = 0;
+    for (int i = 0; i < 3000; i++) {
+        double arrival = device.trueHostTime(i) + SimulatedDevice::kMinDelay + jitter(rng);
+        double stamp = estimator.update(device.deviceTime(i), arrival);
+
+        if (i >= 500) {
+            // stamps land on the least delayed arrivals and are evenly spaced
+            max_error = std::max(max_error, std::abs(stamp - (device.trueHostTime(i) + SimulatedDevice::kMinDelay)));
+            max_step_error = std::max(max_step_error, std::abs((stamp - previous) - SimulatedDevice::kPeriod));
+        }
+        previous = stamp;
+    }
+
+    // the arrivals themselves are off by several milliseconds
+    EXPECT_LT(max_error, 0.001);
+    EXPECT_LT(max_step_error, 0.0003);
+    EXPECT_NEAR(estimator.skew(), 1.0 / SimulatedDevice::kSkew, 3e-5);
+}
+
+TEST(ClockOffsetEstimatorTest, ResetsWhenDeviceRestarts) {
+    SimulatedDevice device;
+    rr::ClockOffsetEstimator estimator;
+    for (int i = 0; i < 200; i++) {
+        estimator.update(device.deviceTime(i), device.trueHostTime(i));
+    }
+
+    // the device counter starts over while host time carries on
+    double stamp = estimator.update(0.0, device.trueHostTime(200));
+    EXPECT_NEAR(stamp, device.trueHostTime(200), 1e-9);
+    EXPECT_NEAR(estimator.update(SimulatedDevice::kPeriod, device.trueHostTime(201)), device.trueHostTime(201), 1e-6);
+}
+
+TEST(ClockOffsetEstimatorTest, LimitsSkew) {
+    rr::ClockOffsetEstimator estimator(10.0, 1.0, 0.01);
+    // arrivals that make the device look 10% slow are not believed
+    estimator.update(0.0, 0.0);
+    estimator.update(0.1, 0.11);
+    EXPECT_NEAR(estimator.skew(), 1.01, 1e-12);
+}
+
+TEST(ClockOffsetEstimatorTest, FollowsLostSamples) {
+    // a 50 Hz device without a clock, timed by counting the samples that arrive, loses one now and then
+    constexpr double kPeriod = 0.02;
+    rr::ClockOffsetEstimator estimator(10.0, 1.0, 0.01, kPeriod / 2);
+    std::mt19937 rng(7);
+    std::exponential_distribution<double> jitter(1.0 / 0.001);
+
+    int received = 0;
+    double max_lag = 0;
+    double max_lead = 0;
+    for (int i = 0; i < 3000; i++) {
+        if (i % 97 == 50) {
+            continue;
+        }
+        double arrival = 1000.0 + i * kPeriod + 0.001 + jitter(rng);
+        double stamp = estimator.update(received * kPeriod, arrival);
+        received++;
+        max_lag = std::max(max_lag, arrival - stamp);
+        max_lead = std::max(max_lead, stamp - arrival);
+    }
+
+    // without the reset every lost sample would leave later stamps another period behind
+    EXPECT_LE(max_lag, kPeriod / 2);
+    EXPECT_LE(max_lead, 1e-9);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
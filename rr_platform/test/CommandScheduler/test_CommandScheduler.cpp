@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <rr_platform/CommandScheduler.h>
+
+#include <atomic>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Clock = rr::CommandScheduler::Clock;
+
+class CommandSchedulerTestSuite : public testing::Test {
+  protected:
+    void send() {
+        std::lock_guard<std::mutex> lock(mutex);
+        sends.push_back(Clock::now());
+    }
+
+    std::vector<Clock::time_point> sendTimes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sends;
+    }
+
+    std::mutex mutex;
+    std::vector<Clock::time_point> sends;
+};
+
+TEST_F(CommandSchedulerTestSuite, SendsImmediatelyWhenIdle) {
+    rr::CommandScheduler scheduler(20ms, 1s, [this] { send(); });
+    std::this_thread::sleep_for(50ms);  // let the initial keepalive go out
+    size_t before = sendTimes().size();
+
+    Clock::time_point notified = Clock::now();
+    scheduler.notify(notified);
+    std::this_thread::sleep_for(20ms);
+
+    auto times = sendTimes();
+    ASSERT_EQ(times.size(), before + 1);
+    EXPECT_LT(times.back() - notified, 10ms);
+
+    auto stats = scheduler.takeStats();
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_LT(stats.max, 10ms);
+    EXPECT_EQ(scheduler.takeStats().count, 0u);
+}
+
+TEST_F(CommandSchedulerTestSuite, RespectsMinimumInterval) {
+    rr::CommandScheduler scheduler(20ms, 1s, [this] { send(); });
+    std::this_thread::sleep_for(30ms);
+
+    // a command every millisecond for 200 ms may only be sent every 20 ms
+    Clock::time_point start = Clock::now();
+    while (Clock::now() - start < 200ms) {
+        scheduler.notify();
+        std::this_thread::sleep_for(1ms);
+    }
+    std::this_thread::sleep_for(30ms);
+
+    auto times = sendTimes();
+    ASSERT_GE(times.size(), 2u);
+    for (size_t i = 1; i < times.size(); i++) {
+        EXPECT_GE(times[i] - times[i - 1], 20ms);
+    }
+    EXPECT_LE(times.size(), 1u + 200 / 20 + 1);
+    EXPECT_GE(times.size(), 200 / 20 / 2);
+
+    // everything notified was covered by some send, none waited much longer than the interval
+    auto stats = scheduler.takeStats();
+    EXPECT_LT(stats.max, 30ms);
+}
+
+TEST_F(CommandSchedulerTestSuite, ResendsAfterKeepalive) {
+    {
+        rr::CommandScheduler scheduler(5ms, 40ms, [this] { send(); });
+        std::this_thread::sleep_for(190ms);
+    }
+    auto times = sendTimes();
+    EXPECT_GE(times.size(), 4u);
+    EXPECT_LE(times.size(), 6u);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <rr_platform/DriveRelayClient.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using boost::asio::ip::tcp;
+using namespace std::chrono_literals;
+
+/*
+ * Local stand-in for the drive controller. It records every message per connection and, depending on the
+ * policy, acknowledges it, stays silent, or hangs up.
+ */
+class ControllerStandIn {
+  public:
+    enum class Reply { ACK, SILENT, CLOSE };
+
+    // Decides what to do with message number message_index of connection number connection_index
+    using Policy = std::function<Reply(size_t connection_index, size_t message_index)>;
+
+    explicit ControllerStandIn(Policy policy)
+          : policy_(std::move(policy))
+          , acceptor_(io_service_, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)) {
+        accept();
+        thread_ = std::thread([this] { io_service_.run(); });
+    }
+
+    ~ControllerStandIn() {
+        io_service_.stop();
+        thread_.join();
+    }
+
+    std::string port() const {
+        return std::to_string(acceptor_.local_endpoint().port());
+    }
+
+    std::vector<std::vector<std::string>> connections() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connections_;
+    }
+
+    // Waits until predicate holds for the messages received so far
+    bool waitFor(std::function<bool(const std::vector<std::vector<std::string>> &)> predicate,
+                 std::chrono::milliseconds timeout = 3000ms) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, timeout, [&] { return predicate(connections_); });
+    }
+
+  private:
+    struct Connection {
+        explicit Connection(boost::asio::io_service &io_service) : socket(io_service) {}
+        tcp::socket socket;
+        std::array<char, 256> buffer;
+        size_t index;
+    };
+
+    Policy policy_;
+    boost::asio::io_service io_service_;
+    tcp::acceptor acceptor_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::vector<std::string>> connections_;
+
+    void accept() {
+        auto connection = std::make_shared<Connection>(io_service_);
+        acceptor_.async_accept(connection->socket, [this, connection](const boost::system::error_code &error) {
+            if (error) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connection->index = connections_.size();
+                connections_.emplace_back();
+            }
+            changed_.notify_all();
+            read(connection);
+            accept();
+        });
+    }
+
+    void read(const std::shared_ptr<Connection> &connection) {
+        auto on_read = [this, connection](const boost::system::error_code &error, size_t n) {
+            if (error) {
+                return;
+            }
+            size_t message_index;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto &messages = connections_[connection->index];
+                messages.emplace_back(connection->buffer.data(), n);
+                message_index = messages.size() - 1;
+            }
+            changed_.notify_all();
+
+            Reply reply = policy_(connection->index, message_index);
+            if (reply == Reply::CLOSE) {
+                connection->socket.close();
+                return;
+            }
+            if (reply == Reply::ACK) {
+                boost::asio::write(connection->socket, boost::asio::buffer(std::string("@OK")));
+            }
+            read(connection);
+        };
+        connection->socket.async_read_some(boost::asio::buffer(connection->buffer), on_read);
+    }
+};
+
+class DriveRelayClientTestSuite : public testing::Test {
+  protected:
+    void startClient(const std::string &port, double command_rate,
+                     rr::DriveRelayClient::ConnectionCallback callback = nullptr) {
+        rr::DriveRelayClient::Options options;
+        options.host = "127.0.0.1";
+        options.port = port;
+        options.init_message = "#1 0 0";
+        options.command_rate = command_rate;
+        options.response_timeout = 0.05;
+        options.reconnect_delay = 0.05;
+        client = std::make_unique<rr::DriveRelayClient>(io_service, options);
+        client->setConnectionCallback(std::move(callback));
+        client->start();
+        io_thread = std::thread([this] { io_service.run(); });
+    }
+
+    void TearDown() override {
+        if (client) {
+            client->stop();
+        }
+        if (io_thread.joinable()) {
+            io_thread.join();
+        }
+    }
+
+    boost::asio::io_service io_service;
+    std::unique_ptr<rr::DriveRelayClient> client;
+    std::thread io_thread;
+};
+
+TEST_F(DriveRelayClientTestSuite, SendsLatestCommandAtRate) {
+    ControllerStandIn controller([](size_t, size_t) { return ControllerStandIn::Reply::ACK; });
+    startClient(controller.port(), 200.0);
+    client->setCommand("$0.000000 0.000000");
+
+    ASSERT_TRUE(controller.waitFor([](const auto &c) { return c.size() == 1 && c[0].size() > 40; }));
+    auto messages = controller.connections()[0];
+    EXPECT_EQ(messages[0], "#1 0 0");
+    EXPECT_EQ(messages[1], "$0.000000 0.000000");
+
+    // A burst of commands is coalesced, only the newest matters
+    size_t sent_before = controller.connections()[0].size();
+    for (int i = 0; i <= 1000; i++) {
+        client->setCommand("$" + std::to_string(i) + " 0");
+    }
+    ASSERT_TRUE(controller.waitFor([](const auto &c) { return c[0].back() == "$1000 0"; }));
+    EXPECT_LT(controller.connections()[0].size() - sent_before, 100u);
+}
+
+TEST_F(DriveRelayClientTestSuite, ReconnectsWhenControllerGoesSilent) {
+    // The first connection stops answering after a few messages
+    ControllerStandIn controller([](size_t connection, size_t message) {
+        return (connection == 0 && message >= 3) ? ControllerStandIn::Reply::SILENT : ControllerStandIn::Reply::ACK;
+    });
+    std::atomic<int> disconnects{ 0 };
+    startClient(controller.port(), 100.0, [&](bool connected, const std::string &) {
+        if (!connected) {
+            disconnects++;
+        }
+    });
+    client->setCommand("$1 0");
+
+    ASSERT_TRUE(controller.waitFor([](const auto &c) { return c.size() == 2 && c[1].size() >= 3; }));
+    auto connections = controller.connections();
+    EXPECT_EQ(connections[0].size(), 4u);  // nothing more was sent while waiting for the acknowledgement
+    EXPECT_EQ(connections[1][0], "#1 0 0");
+    EXPECT_EQ(connections[1][1], "$1 0");
+    EXPECT_GE(disconnects, 1);
+}
+
+TEST_F(DriveRelayClientTestSuite, ReconnectsWhenControllerHangsUp) {
+    ControllerStandIn controller([](size_t connection, size_t message) {
+        return (connection < 2 && message == 2) ? ControllerStandIn::Reply::CLOSE : ControllerStandIn::Reply::ACK;
+    });
+    startClient(controller.port(), 100.0);
+    client->setCommand("$2 0.5");
+
+    ASSERT_TRUE(controller.waitFor([](const auto &c) { return c.size() == 3 && c[2].size() >= 5; }));
+    for (const auto &messages : controller.connections()) {
+        EXPECT_EQ(messages[0], "#1 0 0");
+    }
+    EXPECT_TRUE(client->connected());
+}
+
+TEST_F(DriveRelayClientTestSuite, RetriesUntilControllerListens) {
+    // find a free port, then leave it closed for a while
+    std::string port;
+    {
+        boost::asio::io_service probe_service;
+        tcp::acceptor probe(probe_service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        port = std::to_string(probe.local_endpoint().port());
+    }
+    startClient(port, 100.0);
+    client->setCommand("$3 0");
+    std::this_thread::sleep_for(200ms);
+    EXPECT_FALSE(client->connected());
+
+    boost::asio::io_service server_service;
+    tcp::acceptor acceptor(server_service);
+    tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), static_cast<uint16_t>(std::stoi(port)));
+    acceptor.open(endpoint.protocol());
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+    acceptor.bind(endpoint);
+    acceptor.listen();
+    tcp::socket socket(server_service);
+    acceptor.accept(socket);
+
+    std::array<char, 64> buffer;
+    size_t n = socket.read_some(boost::asio::buffer(buffer));
+    EXPECT_EQ(std::string(buffer.data(), n), "#1 0 0");
+    boost::asio::write(socket, boost::asio::buffer(std::string("@PID Received")));
+    n = socket.read_some(boost::asio::buffer(buffer));
+    EXPECT_EQ(std::string(buffer.data(), n), "$3 0");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <pty.h>
+#include <rr_platform/FrameCodec.h>
+#include <rr_platform/SerialPort.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using namespace rr;
+
+// strips the zero delimiter the way the serial framer does
+std::string_view body(const std::string &encoded) {
+    return std::string_view(encoded.data(), encoded.size() - 1);
+}
+
+TEST(FrameCodecTest, CrcMatchesReference) {
+    const std::string check = "123456789";
+    EXPECT_EQ(crc16(reinterpret_cast<const uint8_t *>(check.data()), check.size()), 0x29B1);
+}
+
+TEST(FrameCodecTest, CobsRoundTrip) {
+    std::vector<std::vector<uint8_t>> inputs = {
+        {}, { 0 }, { 0, 0 }, { 1, 2, 3 }, { 0, 1, 0, 2, 0 }, std::vector<uint8_t>(254, 7), std::vector<uint8_t>(600, 9),
+    };
+    inputs.back()[300] = 0;
+
+    for (const auto &input : inputs) {
+        std::string encoded = cobsEncode(input.data(), input.size());
+        EXPECT_EQ(encoded.find('\0'), std::string::npos);
+
+        std::vector<uint8_t> decoded(input.size() + 1);
+        EXPECT_EQ(cobsDecode(encoded, decoded.data(), decoded.size()), input.size());
+        decoded.resize(input.size());
+        EXPECT_EQ(decoded, input);
+    }
+}
+
+TEST(FrameCodecTest, MessagesRoundTrip) {
+    FrameEncoder encoder;
+    FrameDecoder decoder;
+    Frame frame;
+
+    MotorCommand command{ 4.3125f, -0.25f, 0.05f, 0.0f, 0.08f, -4 };
+    ASSERT_EQ(decoder.decode(body(encoder.encode(command, 1234)), frame), FrameDecoder::Result::OK);
+    EXPECT_EQ(frame.timestamp_us, 1234u);
+    MotorCommand command_out{};
+    ASSERT_TRUE(unpack(frame, command_out));
+    EXPECT_EQ(command_out.speed, command.speed);
+    EXPECT_EQ(command_out.steer, command.steer);
+    EXPECT_EQ(command_out.kD, command.kD);
+    EXPECT_EQ(command_out.trim, command.trim);
+
+    MotorFeedback feedback_out{};
+    EXPECT_FALSE(unpack(frame, feedback_out));
+
+    ImuSample sample{};
+    sample.orientation = { 0.0f, 0.0f, 0.70710678f, 0.70710678f };
+    sample.accel = { 0.0f, 0.0f, 9.81f };
+    ASSERT_EQ(decoder.decode(body(encoder.encode(sample, 0xFFFFFFFF)), frame), FrameDecoder::Result::OK);
+    EXPECT_EQ(frame.timestamp_us, 0xFFFFFFFF);
+    ImuSample sample_out{};
+    ASSERT_TRUE(unpack(frame, sample_out));
+    EXPECT_EQ(sample_out.orientation, sample.orientation);
+    EXPECT_EQ(sample_out.accel, sample.accel);
+
+    EXPECT_EQ(decoder.droppedFrames(), 0u);
+}
+
+TEST(FrameCodecTest, DetectsCorruptionAndDrops) {
+    FrameEncoder encoder;
+    FrameDecoder decoder;
+    Frame frame;
+    MotorFeedback feedback{ 12.0f, true, false };
+
+    // flip a payload bit underneath the COBS layer
+    std::string encoded = encoder.encode(feedback, 0);
+    std::array<uint8_t, 32> raw;
+    size_t raw_size = cobsDecode(body(encoded), raw.data(), raw.size());
+    raw[7] ^= 0x10;
+    EXPECT_EQ(decoder.decode(cobsEncode(raw.data(), raw_size), frame), FrameDecoder::Result::BAD_CRC);
+    EXPECT_EQ(decoder.decode("", frame), FrameDecoder::Result::BAD_ENCODING);
+    EXPECT_EQ(decoder.corruptFrames(), 2u);
+
+    ASSERT_EQ(decoder.decode(body(encoder.encode(feedback, 0)), frame), FrameDecoder::Result::OK);
+    encoder.encode(feedback, 0);
+    encoder.encode(feedback, 0);
+    ASSERT_EQ(decoder.decode(body(encoder.encode(feedback, 0)), frame), FrameDecoder::Result::OK);
+    EXPECT_EQ(decoder.droppedFrames(), 2u);
+
+    MotorFeedback feedback_out{};
+    ASSERT_TRUE(unpack(frame, feedback_out));
+    EXPECT_EQ(feedback_out.speed, 12.0f);
+    EXPECT_TRUE(feedback_out.mux_autonomous);
+    EXPECT_FALSE(feedback_out.estop_on);
+}
+
+TEST(FrameCodecTest, TextFallback) {
+    MotorCommand command{ 4.0f, -0.25f, 0.05f, 0.0f, 0.08f, 4 };
+    EXPECT_EQ(text::encode(command), "$4.000000, -0.250000,0.050000,0.000000,0.080000,4\n");
+
+    MotorFeedback feedback{};
+    ASSERT_TRUE(text::decode("$12.5,1,0", feedback));
+    EXPECT_EQ(feedback.speed, 12.5f);
+    EXPECT_TRUE(feedback.mux_autonomous);
+    EXPECT_FALSE(feedback.estop_on);
+    EXPECT_FALSE(text::decode("$12.5,1", feedback));
+    EXPECT_FALSE(text::decode("", feedback));
+
+    ImuSample sample{};
+    EXPECT_EQ(text::decode("q0,0.1,0.2,0.3,0.9", sample), text::ImuField::ORIENTATION);
+    EXPECT_EQ(sample.orientation[3], 0.9f);
+    EXPECT_EQ(text::decode("axes,1,2,3", sample), text::ImuField::AXES);
+    EXPECT_EQ(sample.axes[2], 3.0f);
+    EXPECT_EQ(text::decode("gx,1,2", sample), text::ImuField::NONE);
+    EXPECT_EQ(text::decode("hello", sample), text::ImuField::NONE);
+}
+
+// Frames written by a stand-in device on the other end of a pseudo terminal come back intact through SerialPort
+TEST(FrameCodecTest, SerialLoopback) {
+    int master = -1;
+    int slave = -1;
+    ASSERT_EQ(openpty(&master, &slave, nullptr, nullptr, nullptr), 0);
+    termios tty{};
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    SerialPort port;
+    ASSERT_TRUE(port.Open(slave));
+    port.SetDelimiter('\0');
+
+    std::mutex mutex;
+    std::condition_variable received;
+    FrameDecoder decoder;
+    std::vector<MotorFeedback> feedbacks;
+    ASSERT_TRUE(port.StartReading([&](std::string_view encoded) {
+        Frame frame;
+        MotorFeedback feedback;
+        if (decoder.decode(encoded, frame) == FrameDecoder::Result::OK && unpack(frame, feedback)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            feedbacks.push_back(feedback);
+            received.notify_one();
+        }
+    }));
+
+    constexpr int kFrames = 200;
+    FrameEncoder device;
+    std::string stream = std::string("garbage before the first delimiter") + '\0';
+    for (int i = 0; i < kFrames; i++) {
+        stream += device.encode(MotorFeedback{ static_cast<float>(i), i % 2 == 0, false }, i);
+    }
+    ASSERT_EQ(write(master, stream.data(), stream.size()), static_cast<ssize_t>(stream.size()));
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(received.wait_for(lock, std::chrono::seconds(5), [&] { return feedbacks.size() == kFrames; }));
+        for (int i = 0; i < kFrames; i++) {
+            EXPECT_EQ(feedbacks[i].speed, static_cast<float>(i));
+        }
+    }
+    port.Close();
+    close(master);
+
+    EXPECT_EQ(decoder.droppedFrames(), 0u);
+    EXPECT_EQ(decoder.corruptFrames(), 1u);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
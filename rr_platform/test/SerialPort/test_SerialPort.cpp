@@ -0,0 +1,212 @@
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <pty.h>
+#include <rr_platform/SerialPort.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+class SerialPortTestSuite : public testing::Test {
+  protected:
+    void SetUp() override {
+        int slave = -1;
+        ASSERT_EQ(openpty(&master, &slave, nullptr, nullptr, nullptr), 0);
+
+        // the line discipline would otherwise echo and translate newlines
+        termios tty{};
+        tcgetattr(slave, &tty);
+        cfmakeraw(&tty);
+        tcsetattr(slave, TCSANOW, &tty);
+
+        ASSERT_TRUE(port.Open(slave));
+    }
+
+    void TearDown() override {
+        port.Close();
+        if (master != -1) {
+            close(master);
+        }
+    }
+
+    void DeviceWrite(const std::string &data) {
+        ASSERT_EQ(write(master, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    }
+
+    std::string DeviceRead(size_t n) {
+        std::string data(n, '\0');
+        size_t n_read = 0;
+        while (n_read < n) {
+            ssize_t got = read(master, &data[n_read], n - n_read);
+            if (got <= 0) {
+                break;
+            }
+            n_read += got;
+        }
+        data.resize(n_read);
+        return data;
+    }
+
+    int master = -1;
+    SerialPort port;
+};
+
+TEST(LineFramerTest, SplitsLinesAcrossChunks) {
+    LineFramer framer;
+    auto push = [&framer](const std::string &data) {
+        memcpy(framer.WriteBegin(), data.data(), data.size());
+        framer.Commit(data.size());
+    };
+
+    std::string_view line;
+    push("$1.0,2");
+    EXPECT_FALSE(framer.NextLine(line));
+    push(".0\r\n$3.0");
+    ASSERT_TRUE(framer.NextLine(line));
+    EXPECT_EQ(line, "$1.0,2.0");
+    EXPECT_FALSE(framer.NextLine(line));
+    EXPECT_EQ(framer.Remainder(), "$3.0");
+    push("\n\n");
+    ASSERT_TRUE(framer.NextLine(line));
+    EXPECT_EQ(line, "$3.0");
+    ASSERT_TRUE(framer.NextLine(line));
+    EXPECT_EQ(line, "");
+    EXPECT_FALSE(framer.NextLine(line));
+}
+
+TEST(LineFramerTest, CompactsAndDropsOverlongLines) {
+    LineFramer framer;
+    std::string_view line;
+
+    // a full buffer ending in a partial line, which has to be moved to the front to make room
+    std::string data = std::string(LineFramer::kCapacity - 6, 'a') + "\n01234";
+    memcpy(framer.WriteBegin(), data.data(), data.size());
+    framer.Commit(data.size());
+    ASSERT_TRUE(framer.NextLine(line));
+    EXPECT_EQ(line.size(), LineFramer::kCapacity - 6);
+    EXPECT_FALSE(framer.NextLine(line));
+    EXPECT_EQ(framer.WriteSpace(), 0u);
+    char *write_begin = framer.WriteBegin();
+    ASSERT_EQ(framer.WriteSpace(), LineFramer::kCapacity - 5);
+    memcpy(write_begin, "56789\n", 6);
+    framer.Commit(6);
+    ASSERT_TRUE(framer.NextLine(line));
+    EXPECT_EQ(line, "0123456789");
+
+    std::string overlong(LineFramer::kCapacity, 'b');
+    memcpy(framer.WriteBegin(), overlong.data(), framer.WriteSpace());
+    framer.Commit(LineFramer::kCapacity);
+    EXPECT_FALSE(framer.NextLine(line));
+    framer.WriteBegin();
+    EXPECT_EQ(framer.Overflows(), 1u);
+    EXPECT_EQ(framer.Remainder(), "");
+}
+
+TEST_F(SerialPortTestSuite, WritesWholeMessage) {
+    std::string message = "$" + std::string(2000, '5') + "\n";
+    ASSERT_TRUE(port.Write(message));
+    EXPECT_EQ(DeviceRead(message.size()), message);
+}
+
+TEST_F(SerialPortTestSuite, BlockingReadLine) {
+    DeviceWrite("first\nsecond\r\nthi");
+    EXPECT_EQ(port.ReadLine(), "first");
+    EXPECT_EQ(port.ReadLine(), "second");
+    DeviceWrite("rd\n");
+    EXPECT_EQ(port.ReadLine(), "third");
+}
+
+TEST_F(SerialPortTestSuite, AsyncReadingDeliversLinesInOrder) {
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<std::string> lines;
+
+    ASSERT_TRUE(port.StartReading([&](std::string_view line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.emplace_back(line);
+        received.notify_one();
+    }));
+
+    constexpr int kLines = 500;
+    for (int i = 0; i < kLines; i++) {
+        // split every line across two writes to exercise partial reads
+        DeviceWrite("$" + std::to_string(i));
+        DeviceWrite(",x\n");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(received.wait_for(lock, std::chrono::seconds(5), [&] { return lines.size() == kLines; }));
+    for (int i = 0; i < kLines; i++) {
+        EXPECT_EQ(lines[i], "$" + std::to_string(i) + ",x");
+    }
+    lock.unlock();
+
+    port.StopReading();
+}
+
+TEST_F(SerialPortTestSuite, SurvivesDeviceHangup) {
+    ASSERT_TRUE(port.StartReading([](std::string_view) {}));
+
+    close(master);
+    master = -1;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (port.Reading() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(port.Reading());
+
+    // the finished reader still has to be joined by whichever of these runs first
+    port.StopReading();
+    port.Close();
+}
+
+TEST(SerialPortTest, DeliversLinesBufferedBeforeHangup) {
+    int pipe_fds[2];
+    ASSERT_EQ(pipe(pipe_fds), 0);
+    ASSERT_EQ(write(pipe_fds[1], "first\nlast\n", 11), 11);
+    close(pipe_fds[1]);
+
+    SerialPort port;
+    ASSERT_TRUE(port.Open(pipe_fds[0]));
+    std::vector<std::string> lines;
+    ASSERT_TRUE(port.StartReading([&](std::string_view line) { lines.emplace_back(line); }));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (port.Reading() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    port.StopReading();
+
+    EXPECT_EQ(lines, (std::vector<std::string>{ "first", "last" }));
+}
+
+TEST(SerialPortTest, ReopeningClosesThePreviousDescriptor) {
+    int first[2];
+    int second[2];
+    ASSERT_EQ(pipe(first), 0);
+    ASSERT_EQ(pipe(second), 0);
+
+    SerialPort port;
+    ASSERT_TRUE(port.Open(first[0]));
+    ASSERT_TRUE(port.StartReading([](std::string_view) {}));
+    ASSERT_TRUE(port.Open(second[0]));
+    EXPECT_FALSE(port.Reading());
+    EXPECT_EQ(fcntl(first[0], F_GETFD), -1);
+
+    port.Close();
+    close(first[1]);
+    close(second[1]);
+}
+
+TEST(SerialPortTest, RejectsInvalidDescriptor) {
+    SerialPort port;
+    EXPECT_FALSE(port.Open(-1));
+    EXPECT_FALSE(port.Open(12345));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,6 +4,9 @@
 #include <sensor_msgs/LaserScan.h>
 #include <sensor_msgs/PointCloud2.h>
 
+#include <atomic>
+#include <limits>
+
 class ScanToPointCloudTestSuite : public testing::Test {
   public:
     ScanToPointCloudTestSuite()
@@ -13,6 +16,9 @@ class ScanToPointCloudTestSuite : public testing::Test {
 
     void cloudCallback(const sensor_msgs::PointCloud2ConstPtr &msg) {
         cloud_msg = *msg;
+        if (msg->width == expected_width) {
+            clouds_with_expected_width++;
+        }
         cloud_received = true;
     }
 
@@ -34,6 +40,8 @@ class ScanToPointCloudTestSuite : public testing::Test {
     ros::Subscriber pc_sub;
     volatile bool cloud_received = false;
     sensor_msgs::PointCloud2 cloud_msg;
+    std::atomic<uint32_t> expected_width{ 0 };
+    std::atomic<int> clouds_with_expected_width{ 0 };
 };
 
 TEST_F(ScanToPointCloudTestSuite, EmptyScan) {
@@ -149,6 +157,74 @@ TEST_F(ScanToPointCloudTestSuite, NormalScan) {
     EXPECT_NEAR(-1.0, cloud[6].y, 0.1);
 }
 
+TEST_F(ScanToPointCloudTestSuite, GeometryChange) {
+    // A scan with a different layout than the previous ones must not reuse their angles
+
+    cloud_received = false;
+
+    sensor_msgs::LaserScan scan;
+    scan.header.stamp = ros::Time::now();
+    scan.header.frame_id = "/laser";
+    scan.angle_min = 0.0f;
+    scan.angle_max = 4.712389f;
+    scan.angle_increment = 1.570796f;
+    scan.range_min = 0.05f;
+    scan.range_max = 10.0f;
+    scan.ranges = { 2.0f, 2.0f, std::numeric_limits<float>::quiet_NaN(), 12.0f };
+
+    scan_pub.publish(scan);
+
+    while (!cloud_received) {
+        ros::spinOnce();
+    }
+
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    pcl::fromROSMsg(cloud_msg, cloud);
+
+    ASSERT_EQ(2, cloud.size());
+
+    EXPECT_NEAR(2.0, cloud[0].x, 0.01);
+    EXPECT_NEAR(0.0, cloud[0].y, 0.01);
+
+    EXPECT_NEAR(0.0, cloud[1].x, 0.01);
+    EXPECT_NEAR(2.0, cloud[1].y, 0.01);
+}
+
+TEST_F(ScanToPointCloudTestSuite, HighRateScans) {
+    // 1080 beam scans at 40 Hz, as from a 0.25 degree lidar, should all make it through
+
+    constexpr int num_beams = 1080;
+    constexpr int num_scans = 80;
+    expected_width = num_beams;
+    clouds_with_expected_width = 0;
+
+    sensor_msgs::LaserScan scan;
+    scan.header.frame_id = "/laser";
+    scan.angle_min = -2.356194f;
+    scan.angle_increment = 0.004363323f;
+    scan.angle_max = scan.angle_min + (num_beams - 1) * scan.angle_increment;
+    scan.time_increment = 1.0f / (40.0f * num_beams);
+    scan.scan_time = 1.0f / 40.0f;  // 40 Hz.
+    scan.range_min = 0.05f;
+    scan.range_max = 30.0f;
+    scan.ranges.resize(num_beams);
+
+    ros::Rate rate(40);
+    for (int i = 0; i < num_scans; i++) {
+        for (int j = 0; j < num_beams; j++) {
+            scan.ranges[j] = 2.0f + 0.01f * ((i + j) % 100);
+        }
+        scan.header.stamp = ros::Time::now();
+        scan_pub.publish(scan);
+        rate.sleep();
+    }
+    ros::Duration(0.5).sleep();
+
+    // Queues of one can drop the odd scan when the test machine hiccups, but not more than that
+    EXPECT_GE(clouds_with_expected_width, num_scans * 9 / 10);
+    EXPECT_EQ(num_beams, cloud_msg.width);
+}
+
 int main(int argc, char **argv) {
     ros::init(argc, argv, "test_scanToPointCloud");
     testing::InitGoogleTest(&argc, argv);
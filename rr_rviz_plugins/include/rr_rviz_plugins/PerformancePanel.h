@@ -0,0 +1,99 @@
+#ifndef CATKIN_WS_PERFORMANCEPANEL_H
+#define CATKIN_WS_PERFORMANCEPANEL_H
+
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <ros/ros.h>
+#include <rviz/panel.h>
+
+#include <QLineEdit>
+#include <QTimer>
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rr_rviz_plugins {
+
+/*
+ * Shows what the nodes publish through rr::NodeMetrics on /diagnostics: each stage's latency with a sparkline of its
+ * recent p99, the planner's cycle time against its deadline, and topic rates against the rates they are expected to
+ * have. Stages over their deadline, topics slower than expected or dropping messages, and nodes that went quiet are
+ * highlighted.
+ *
+ * Expected rates are set in the panel as "topic=hz" pairs and saved with the rviz config. Messages only update the
+ * rows, which are allocated once per stage or topic; drawing happens on a timer, at most twice a second.
+ */
+class PerformancePanel : public rviz::Panel {
+    Q_OBJECT
+  public:
+    explicit PerformancePanel(QWidget *parent = nullptr);
+
+    void save(rviz::Config config) const override;
+    void load(const rviz::Config &config) override;
+
+    static constexpr size_t history_length = 60;  // one sample per diagnostics message, i.e. a minute
+
+    // Last history_length values, oldest first once full
+    struct History {
+        std::array<float, history_length> values{};
+        size_t next = 0;
+        size_t size = 0;
+
+        void push(float value);
+        float operator[](size_t i) const;
+        float max() const;
+    };
+
+    struct StageRow {
+        std::string node;
+        std::string name;
+        float p50_ms = 0;
+        float p99_ms = 0;
+        float max_ms = 0;
+        float deadline_ms = 0;
+        History p99_history;
+        ros::WallTime updated;
+    };
+
+    struct TopicRow {
+        std::string node;
+        std::string topic;
+        bool is_input = true;
+        float rate_hz = 0;
+        float age_p50_ms = 0;
+        float dropped = 0;
+        ros::WallTime updated;
+    };
+
+    // Paints the rows; called by the view widget
+    void paintRows(QWidget *view);
+
+  protected:
+    ros::NodeHandle nh;
+    ros::Subscriber diagnostics_sub;
+
+  private Q_SLOTS:
+    void refresh();
+    void updateExpectedRates();
+
+  private:
+    void diagnosticsCallback(const diagnostic_msgs::DiagnosticArrayConstPtr &msg);
+
+    StageRow &findStage(const std::string &node, std::string_view name);
+    TopicRow &findTopic(const std::string &node, std::string_view topic, bool is_input);
+
+    QLineEdit *expected_rates_edit_;
+    QWidget *view_;
+    QTimer refresh_timer_;
+
+    std::mutex mutex_;  // guards everything below
+    std::vector<StageRow> stages_;
+    std::vector<TopicRow> topics_;
+    std::map<std::string, float, std::less<>> expected_rates_;
+};
+
+}  // namespace rr_rviz_plugins
+
+#endif  // CATKIN_WS_PERFORMANCEPANEL_H
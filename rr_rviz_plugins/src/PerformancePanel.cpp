@@ -0,0 +1,301 @@
+#include <pluginlib/class_list_macros.h>
+#include <rr_rviz_plugins/PerformancePanel.h>
+#include <rviz/config.h>
+
+#include <QFontMetrics>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace rr_rviz_plugins {
+
+namespace {
+
+constexpr int refresh_ms = 500;
+constexpr double stale_seconds = 3.0;  // nodes publish every second, so three missed means it is gone or stuck
+constexpr float slow_rate_fraction = 0.8f;
+
+// Column positions in pixels
+constexpr int name_x = 4;
+constexpr int name_width = 200;
+constexpr int value_width = 60;
+constexpr int spark_width = 120;
+
+const QColor overrun_color(255, 0, 0, 70);
+const QColor slow_color(255, 160, 0, 70);
+
+class PerformanceView : public QWidget {
+  public:
+    explicit PerformanceView(PerformancePanel *panel) : panel_(panel) {}
+
+  protected:
+    void paintEvent(QPaintEvent *) override {
+        panel_->paintRows(this);
+    }
+
+  private:
+    PerformancePanel *panel_;
+};
+
+QString formatValue(float value, int precision = 1) {
+    return QString::number(value, 'f', precision);
+}
+
+}  // namespace
+
+void PerformancePanel::History::push(float value) {
+    values[next] = value;
+    next = (next + 1) % history_length;
+    size = std::min(size + 1, history_length);
+}
+
+float PerformancePanel::History::operator[](size_t i) const {
+    return values[(next + history_length - size + i) % history_length];
+}
+
+float PerformancePanel::History::max() const {
+    float result = 0;
+    for (size_t i = 0; i < size; i++) {
+        result = std::max(result, values[i]);
+    }
+    return result;
+}
+
+PerformancePanel::PerformancePanel(QWidget *parent) : rviz::Panel(parent) {
+    stages_.reserve(64);
+    topics_.reserve(64);
+
+    expected_rates_edit_ = new QLineEdit;
+    expected_rates_edit_->setPlaceholderText("/camera/image_color_rect=30 /scan=10");
+    connect(expected_rates_edit_, &QLineEdit::editingFinished, this, &PerformancePanel::updateExpectedRates);
+
+    auto *rates_layout = new QHBoxLayout;
+    rates_layout->addWidget(new QLabel("Expected rates"));
+    rates_layout->addWidget(expected_rates_edit_);
+
+    view_ = new PerformanceView(this);
+
+    auto *layout = new QVBoxLayout;
+    layout->addLayout(rates_layout);
+    layout->addWidget(view_);
+    layout->addStretch();
+    setLayout(layout);
+
+    diagnostics_sub = nh.subscribe("/diagnostics", 10, &PerformancePanel::diagnosticsCallback, this);
+
+    connect(&refresh_timer_, &QTimer::timeout, this, &PerformancePanel::refresh);
+    refresh_timer_.start(refresh_ms);
+}
+
+void PerformancePanel::save(rviz::Config config) const {
+    rviz::Panel::save(config);
+    config.mapSetValue("ExpectedRates", expected_rates_edit_->text());
+}
+
+void PerformancePanel::load(const rviz::Config &config) {
+    rviz::Panel::load(config);
+    QString text;
+    if (config.mapGetString("ExpectedRates", &text)) {
+        expected_rates_edit_->setText(text);
+        updateExpectedRates();
+    }
+}
+
+void PerformancePanel::updateExpectedRates() {
+    std::istringstream pairs(expected_rates_edit_->text().replace(',', ' ').toStdString());
+    std::lock_guard<std::mutex> lock(mutex_);
+    expected_rates_.clear();
+    std::string pair;
+    while (pairs >> pair) {
+        auto equals = pair.find('=');
+        if (equals != std::string::npos) {
+            expected_rates_[pair.substr(0, equals)] = std::strtof(pair.c_str() + equals + 1, nullptr);
+        }
+    }
+}
+
+PerformancePanel::StageRow &PerformancePanel::findStage(const std::string &node, std::string_view name) {
+    for (StageRow &row : stages_) {
+        if (row.name == name && row.node == node) {
+            return row;
+        }
+    }
+    StageRow &row = stages_.emplace_back();
+    row.node = node;
+    row.name = name;
+    return row;
+}
+
+PerformancePanel::TopicRow &PerformancePanel::findTopic(const std::string &node, std::string_view topic,
+                                                        bool is_input) {
+    for (TopicRow &row : topics_) {
+        if (row.is_input == is_input && row.topic == topic && row.node == node) {
+            return row;
+        }
+    }
+    TopicRow &row = topics_.emplace_back();
+    row.node = node;
+    row.topic = topic;
+    row.is_input = is_input;
+    return row;
+}
+
+void PerformancePanel::diagnosticsCallback(const diagnostic_msgs::DiagnosticArrayConstPtr &msg) {
+    const auto now = ros::WallTime::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Keys are "<kind>:<name>:<field>", see rr::NodeMetrics. Other diagnostics on the topic are skipped.
+    for (const auto &status : msg->status) {
+        for (const auto &key_value : status.values) {
+            const std::string_view key = key_value.key;
+            const size_t first = key.find(':');
+            const size_t last = key.rfind(':');
+            if (first == std::string_view::npos || first == last) {
+                continue;
+            }
+            const std::string_view kind = key.substr(0, first);
+            const std::string_view name = key.substr(first + 1, last - first - 1);
+            const std::string_view field = key.substr(last + 1);
+            const float value = std::strtof(key_value.value.c_str(), nullptr);
+
+            if (kind == "stage") {
+                StageRow &row = findStage(status.name, name);
+                row.updated = now;
+                if (field == "p50_ms") {
+                    row.p50_ms = value;
+                } else if (field == "p99_ms") {
+                    row.p99_ms = value;
+                    row.p99_history.push(value);
+                } else if (field == "max_ms") {
+                    row.max_ms = value;
+                } else if (field == "deadline_ms") {
+                    row.deadline_ms = value;
+                }
+            } else if (kind == "input" || kind == "output") {
+                TopicRow &row = findTopic(status.name, name, kind == "input");
+                row.updated = now;
+                if (field == "rate_hz") {
+                    row.rate_hz = value;
+                } else if (field == "age_p50_ms") {
+                    row.age_p50_ms = value;
+                } else if (field == "dropped") {
+                    row.dropped = value;
+                }
+            }
+        }
+    }
+}
+
+void PerformancePanel::refresh() {
+    size_t rows;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rows = stages_.size() + topics_.size() + 2;
+    }
+    const int line_height = QFontMetrics(view_->font()).height() + 4;
+    view_->setMinimumHeight(static_cast<int>(rows) * line_height + 8);
+    view_->update();
+}
+
+void PerformancePanel::paintRows(QWidget *view) {
+    QPainter painter(view);
+    painter.setRenderHint(QPainter::Antialiasing);
+    const QFontMetrics font_metrics(painter.font());
+    const int line_height = font_metrics.height() + 4;
+    const QColor text_color = view->palette().color(QPalette::WindowText);
+    const QColor stale_color = view->palette().color(QPalette::Disabled, QPalette::WindowText);
+    const auto now = ros::WallTime::now();
+
+    int x = name_x + name_width;
+    int y = line_height;
+    auto drawHeader = [&](const char *name, const char *a, const char *b, const char *c, const char *d) {
+        QFont bold = painter.font();
+        bold.setBold(true);
+        painter.setFont(bold);
+        painter.setPen(text_color);
+        painter.drawText(name_x, y, name);
+        painter.drawText(x, y, a);
+        painter.drawText(x + value_width, y, b);
+        painter.drawText(x + 2 * value_width, y, c);
+        painter.drawText(x + 2 * value_width + spark_width + 8, y, d);
+        bold.setBold(false);
+        painter.setFont(bold);
+        y += line_height;
+    };
+    auto drawName = [&](const std::string &node, const std::string &name) {
+        const QString text = QString::fromStdString(node + " " + name);
+        painter.drawText(name_x, y, font_metrics.elidedText(text, Qt::ElideLeft, name_width - 8));
+    };
+    auto highlight = [&](const QColor &color) {
+        painter.fillRect(0, y - font_metrics.ascent() - 2, view->width(), line_height, color);
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    drawHeader("Stage", "p50 ms", "p99 ms", "p99, last minute", "deadline");
+    for (const StageRow &row : stages_) {
+        const bool stale = (now - row.updated).toSec() > stale_seconds;
+        const bool overrun = row.deadline_ms > 0 && row.p99_ms > row.deadline_ms;
+        if (overrun && !stale) {
+            highlight(overrun_color);
+        }
+        painter.setPen(stale ? stale_color : text_color);
+        drawName(row.node, row.name);
+        painter.drawText(x, y, formatValue(row.p50_ms, 2));
+        painter.drawText(x + value_width, y, formatValue(row.p99_ms, 2));
+
+        // Sparkline of p99, scaled to fit the deadline if there is one
+        const QRectF spark(x + 2 * value_width, y - font_metrics.ascent(), spark_width, font_metrics.ascent());
+        const float scale = std::max({ row.p99_history.max(), row.deadline_ms, 1e-3f });
+        std::array<QPointF, history_length> points;
+        const size_t count = row.p99_history.size;
+        for (size_t i = 0; i < count; i++) {
+            points[i] = QPointF(spark.left() + spark.width() * i / (history_length - 1),
+                                spark.bottom() - spark.height() * row.p99_history[i] / scale);
+        }
+        painter.drawPolyline(points.data(), static_cast<int>(count));
+
+        // The cycle time against the deadline, as a bar that turns red past it
+        if (row.deadline_ms > 0) {
+            const double deadline_y = spark.bottom() - spark.height() * row.deadline_ms / scale;
+            painter.setPen(QPen(Qt::red, 1, Qt::DotLine));
+            painter.drawLine(QPointF(spark.left(), deadline_y), QPointF(spark.right(), deadline_y));
+
+            const QRectF bar(spark.right() + 8, spark.top() + 2, value_width, spark.height() - 4);
+            const double fill = std::min(1.0, row.p99_ms / row.deadline_ms / 1.5);
+            painter.setPen(stale ? stale_color : text_color);
+            painter.drawRect(bar);
+            painter.fillRect(QRectF(bar.left(), bar.top(), bar.width() * fill, bar.height()),
+                             overrun ? Qt::red : Qt::darkGreen);
+            painter.drawText(static_cast<int>(bar.right()) + 6, y, formatValue(row.deadline_ms));
+        }
+        y += line_height;
+    }
+
+    y += line_height / 2;
+    drawHeader("Topic", "Hz", "expected", "age p50 ms", "dropped");
+    for (const TopicRow &row : topics_) {
+        const bool stale = (now - row.updated).toSec() > stale_seconds;
+        auto expected = expected_rates_.find(row.topic);
+        const float expected_hz = expected != expected_rates_.end() ? expected->second : 0;
+        const bool slow = expected_hz > 0 && row.rate_hz < slow_rate_fraction * expected_hz;
+        if (!stale && (slow || row.dropped > 0)) {
+            highlight(slow ? overrun_color : slow_color);
+        }
+        painter.setPen(stale ? stale_color : text_color);
+        drawName(row.node, (row.is_input ? "<- " : "-> ") + row.topic);
+        painter.drawText(x, y, formatValue(row.rate_hz));
+        painter.drawText(x + value_width, y, expected_hz > 0 ? formatValue(expected_hz) : QString("-"));
+        painter.drawText(x + 2 * value_width, y, row.is_input ? formatValue(row.age_p50_ms, 2) : QString("-"));
+        painter.drawText(x + 2 * value_width + spark_width + 8, y, formatValue(row.dropped, 0));
+        y += line_height;
+    }
+}
+
+}  // namespace rr_rviz_plugins
+
+PLUGINLIB_EXPORT_CLASS(rr_rviz_plugins::PerformancePanel, rviz::Panel)
@@ -0,0 +1,81 @@
+import json
+import os
+import sys
+
+
+"""
+    Compares the JSON results of bag replay benchmarks (laplacian_line_detector_benchmark,
+    opponent_detection_benchmark, ground_segmentation_benchmark, obstacle_layer_benchmark) from two commits.
+    Each argument is a results file or a directory of them. Results are matched by benchmark, bag and topic.
+
+    Prints the change in latency and peak memory, and flags any benchmark whose output digest changed,
+    meaning the node no longer produces identical output for the same bag. Exits nonzero if any digest
+    changed or any p50 got slower by more than max_slowdown (default 0.10, i.e. 10%).
+
+    Ex:
+        python compare_replay_benchmarks.py results_before/ results_after/
+        python compare_replay_benchmarks.py before.json after.json max_slowdown=0.05
+"""
+
+
+def load_results(path):
+    files = [path]
+    if os.path.isdir(path):
+        files = [os.path.join(path, f) for f in sorted(os.listdir(path)) if f.endswith(".json")]
+
+    results = {}
+    for f in files:
+        with open(f) as result_file:
+            result = json.load(result_file)
+        results[(result["benchmark"], result["bag"], result["topic"])] = result
+    return results
+
+
+def change(before, after):
+    if before == 0:
+        return "n/a"
+    return "{:+.1f}%".format(100.0 * (after - before) / before)
+
+
+def do_comparison():
+    if len(sys.argv) < 3:
+        print("Please specify the baseline and candidate results")
+        return 2
+
+    max_slowdown = 0.10
+    for arg in sys.argv[3:]:
+        if "max_slowdown=" in arg:
+            max_slowdown = float(arg.split("=")[1])
+
+    baseline = load_results(sys.argv[1])
+    candidate = load_results(sys.argv[2])
+
+    failed = False
+    row = "{:<36} {:>10} {:>10} {:>9} {:>10} {:>10} {:>9} {:>9}  {}"
+    print(row.format("benchmark", "p50 ms", "p50 new", "change", "p99 ms", "p99 new", "change", "rss", "output"))
+    for key in sorted(set(baseline) & set(candidate)):
+        before = baseline[key]
+        after = candidate[key]
+        same_output = before["output_digest"] == after["output_digest"]
+        if before["messages"] != after["messages"]:
+            same_output = False
+        slowdown = (after["p50_ms"] - before["p50_ms"]) / before["p50_ms"] if before["p50_ms"] > 0 else 0
+        if not same_output or slowdown > max_slowdown:
+            failed = True
+
+        print(row.format(key[0][:36],
+                         "{:.3f}".format(before["p50_ms"]), "{:.3f}".format(after["p50_ms"]),
+                         change(before["p50_ms"], after["p50_ms"]),
+                         "{:.3f}".format(before["p99_ms"]), "{:.3f}".format(after["p99_ms"]),
+                         change(before["p99_ms"], after["p99_ms"]),
+                         change(before["peak_rss_kb"], after["peak_rss_kb"]),
+                         "same" if same_output else "CHANGED"))
+
+    for key in sorted(set(baseline) ^ set(candidate)):
+        print("{} on {} {} only has results on one side".format(key[0], key[1], key[2]))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(do_comparison())
@@ -0,0 +1,92 @@
+import json
+import os
+import sys
+
+
+"""
+    Merges the per-node traces written with RR_TRACE_DIR set into one file for chrome://tracing or
+    https://ui.perfetto.dev, and prints how old the sensor data is by the end of each stage.
+    Each argument is a trace file or a directory of them. Traces of nodes that were killed lack the closing
+    bracket or end partway through an event, which is fine.
+
+    Ex:
+        RR_TRACE_DIR=/tmp/traces roslaunch iarrc circuit.launch
+        python merge_traces.py /tmp/traces output=run.json
+"""
+
+
+def load_events(path):
+    with open(path) as trace_file:
+        text = trace_file.read().rstrip()
+    if not text.endswith("]"):
+        text = text.rstrip(",") + "]"
+    try:
+        return json.loads(text)
+    except ValueError:
+        pass
+
+    # A node killed mid-write leaves a partial last event, keep every event before it
+    decoder = json.JSONDecoder()
+    events = []
+    position = text.find("[") + 1
+    while True:
+        while position < len(text) and text[position] in " \t\r\n,":
+            position += 1
+        if position >= len(text) or text[position] == "]":
+            break
+        try:
+            event, position = decoder.raw_decode(text, position)
+        except ValueError:
+            print("Warning: {} ends in an incomplete event, skipped it".format(path))
+            break
+        events.append(event)
+    return events
+
+
+def percentile(values, p):
+    rank = int(p * len(values) + 0.999999)
+    return values[min(max(rank, 1), len(values)) - 1]
+
+
+def do_merge():
+    output = "trace.json"
+    paths = []
+    for arg in sys.argv[1:]:
+        if "output=" in arg:
+            output = arg.split("=")[1]
+        elif os.path.isdir(arg):
+            paths += [os.path.join(arg, f) for f in sorted(os.listdir(arg)) if f.endswith(".json")]
+        else:
+            paths.append(arg)
+
+    if not paths:
+        print("Please specify the trace files or a directory of them")
+        return 2
+
+    events = []
+    for path in paths:
+        events += load_events(path)
+
+    with open(output, "w") as output_file:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, output_file)
+    print("Wrote {} events from {} traces to {}".format(len(events), len(paths), output))
+
+    # Age of the origin when each stage finished with it
+    ages = {}
+    for event in events:
+        if event.get("ph") == "X" and "origin_age_ms" in event.get("args", {}):
+            age = event["args"]["origin_age_ms"] + event["dur"] / 1000.0
+            ages.setdefault(event["name"], []).append(age)
+
+    row = "{:<28} {:>8} {:>12} {:>12} {:>12}"
+    print(row.format("stage", "spans", "age p50 ms", "age p99 ms", "age max ms"))
+    for name, stage_ages in sorted(ages.items(), key=lambda item: sorted(item[1])[len(item[1]) // 2]):
+        stage_ages.sort()
+        print(row.format(name[:28], len(stage_ages), "{:.2f}".format(percentile(stage_ages, 0.5)),
+                         "{:.2f}".format(percentile(stage_ages, 0.99)), "{:.2f}".format(stage_ages[-1])))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(do_merge())